@@ -937,6 +937,25 @@ Shader* Renderer::CreateShader(char const* shaderPath, char const* shaderSource,
 			ERROR_AND_DIE(Stringf("Could not create Vertex_PCUTBN layout."));
 		}
 	}break;
+	case VertexType::Vertex_Voxel:
+	{
+		D3D11_INPUT_ELEMENT_DESC inputElementDesc[] = {
+			{"POSITION", 0, DXGI_FORMAT_R32_UINT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+			{"TEXCOORD", 0, DXGI_FORMAT_R32_UINT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		};
+
+		numElements = ARRAYSIZE(inputElementDesc);
+		hr = m_device->CreateInputLayout(
+			inputElementDesc, numElements,
+			vertexShaderByteCode.data(),
+			vertexShaderByteCode.size(),
+			&newShader->m_inputLayoutForVertex);
+
+		if (!SUCCEEDED(hr))
+		{
+			ERROR_AND_DIE(Stringf("Could not create Vertex_Voxel layout."));
+		}
+	}break;
 	}
 
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
@@ -2,6 +2,7 @@
 #include "Engine/core/Rgba8.hpp"
 #include "Engine/core/Vertex_PCU.hpp"
 #include "Engine/core/Vertex_PCUTBN.hpp"
+#include "Engine/core/Vertex_Voxel.hpp"
 #include "Engine/Renderer/Camera.hpp"
 #include "Engine/Renderer/BitmapFont.hpp"
 #include "Engine/Renderer/Shader.hpp"
@@ -57,6 +58,7 @@ enum class VertexType
 {
 	Vertex_PCU,
 	Vertex_PCUTBN,
+	Vertex_Voxel,
 	COUNT
 };
 
@@ -0,0 +1,208 @@
+#include "Engine/core/CompressionUtils.hpp"
+#include <cstring>
+
+constexpr int LZ_MIN_MATCH_LENGTH = 4;
+constexpr int LZ_MAX_OFFSET = 65535;
+constexpr int LZ_HASH_BITS = 12;
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+void AppendVarUInt(std::vector<uint8_t>& buffer, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		buffer.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	buffer.push_back((uint8_t)value);
+}
+
+bool ReadVarUInt(uint8_t const* data, int dataSize, int& inout_readIndex, uint32_t& out_value)
+{
+	out_value = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		if (inout_readIndex >= dataSize)
+		{
+			return false;
+		}
+		uint8_t byte = data[inout_readIndex++];
+		out_value |= (uint32_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false; // more than 5 bytes could not be a uint32
+}
+
+uint32_t ComputeChecksum32(uint8_t const* data, int dataSize)
+{
+	uint32_t hash = 2166136261u;
+	for (int i = 0; i < dataSize; ++i)
+	{
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+static uint32_t Read32(uint8_t const* bytes)
+{
+	uint32_t value;
+	memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+static void AppendLZLength(std::vector<uint8_t>& out_compressed, int extraLength)
+{
+	while (extraLength >= 255)
+	{
+		out_compressed.push_back(255);
+		extraLength -= 255;
+	}
+	out_compressed.push_back((uint8_t)extraLength);
+}
+
+static void AppendLZSequence(std::vector<uint8_t>& out_compressed, uint8_t const* literals, int numLiterals, int matchOffset, int matchLength)
+{
+	int literalNibble = numLiterals < 15 ? numLiterals : 15;
+	int matchNibble = 0;
+	if (matchLength > 0)
+	{
+		matchNibble = (matchLength - LZ_MIN_MATCH_LENGTH) < 15 ? (matchLength - LZ_MIN_MATCH_LENGTH) : 15;
+	}
+	out_compressed.push_back((uint8_t)((literalNibble << 4) | matchNibble));
+	if (literalNibble == 15)
+	{
+		AppendLZLength(out_compressed, numLiterals - 15);
+	}
+	out_compressed.insert(out_compressed.end(), literals, literals + numLiterals);
+
+	// the last sequence has no match, the stream simply ends after its literals
+	if (matchLength > 0)
+	{
+		out_compressed.push_back((uint8_t)(matchOffset & 0xFF));
+		out_compressed.push_back((uint8_t)(matchOffset >> 8));
+		if (matchNibble == 15)
+		{
+			AppendLZLength(out_compressed, matchLength - LZ_MIN_MATCH_LENGTH - 15);
+		}
+	}
+}
+
+// greedy, one candidate per hash slot, good enough for save data that is mostly repeating patterns
+void CompressLZ(uint8_t const* data, int dataSize, std::vector<uint8_t>& out_compressed)
+{
+	out_compressed.clear();
+	out_compressed.reserve(dataSize / 2 + 16);
+
+	int hashTable[1 << LZ_HASH_BITS];
+	for (int i = 0; i < (1 << LZ_HASH_BITS); ++i)
+	{
+		hashTable[i] = -1;
+	}
+
+	int literalStart = 0;
+	int readIndex = 0;
+	while (readIndex + LZ_MIN_MATCH_LENGTH <= dataSize)
+	{
+		uint32_t sequence = Read32(data + readIndex);
+		uint32_t hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+		int candidate = hashTable[hash];
+		hashTable[hash] = readIndex;
+
+		if (candidate < 0 || readIndex - candidate > LZ_MAX_OFFSET || Read32(data + candidate) != sequence)
+		{
+			++readIndex;
+			continue;
+		}
+
+		int matchLength = LZ_MIN_MATCH_LENGTH;
+		while (readIndex + matchLength < dataSize && data[candidate + matchLength] == data[readIndex + matchLength])
+		{
+			++matchLength;
+		}
+
+		AppendLZSequence(out_compressed, data + literalStart, readIndex - literalStart, readIndex - candidate, matchLength);
+		readIndex += matchLength;
+		literalStart = readIndex;
+	}
+
+	AppendLZSequence(out_compressed, data + literalStart, dataSize - literalStart, 0, 0);
+}
+
+static bool ReadLZLength(uint8_t const* compressed, int compressedSize, int& inout_readIndex, int& inout_length)
+{
+	uint8_t extraByte = 255;
+	while (extraByte == 255)
+	{
+		if (inout_readIndex >= compressedSize)
+		{
+			return false;
+		}
+		extraByte = compressed[inout_readIndex++];
+		inout_length += extraByte;
+	}
+	return true;
+}
+
+bool DecompressLZ(uint8_t const* compressed, int compressedSize, std::vector<uint8_t>& out_decompressed, int decompressedSize)
+{
+	out_decompressed.resize(decompressedSize);
+	uint8_t* writePtr = out_decompressed.data();
+	int writeIndex = 0;
+	int readIndex = 0;
+
+	while (readIndex < compressedSize)
+	{
+		uint8_t token = compressed[readIndex++];
+
+		int numLiterals = token >> 4;
+		if (numLiterals == 15 && !ReadLZLength(compressed, compressedSize, readIndex, numLiterals))
+		{
+			return false;
+		}
+		if (numLiterals > compressedSize - readIndex || numLiterals > decompressedSize - writeIndex)
+		{
+			return false;
+		}
+		if (numLiterals > 0)
+		{
+			memcpy(writePtr + writeIndex, compressed + readIndex, numLiterals);
+		}
+		readIndex += numLiterals;
+		writeIndex += numLiterals;
+
+		if (readIndex == compressedSize)
+		{
+			break; // the last sequence
+		}
+
+		if (readIndex + 2 > compressedSize)
+		{
+			return false;
+		}
+		int matchOffset = compressed[readIndex] | (compressed[readIndex + 1] << 8);
+		readIndex += 2;
+		int matchLength = (token & 0x0F) + LZ_MIN_MATCH_LENGTH;
+		if ((token & 0x0F) == 15 && !ReadLZLength(compressed, compressedSize, readIndex, matchLength))
+		{
+			return false;
+		}
+		if (matchOffset == 0 || matchOffset > writeIndex || matchLength > decompressedSize - writeIndex)
+		{
+			return false;
+		}
+
+		// byte by byte, the match could overlap what it is writing, e.g. a run of one repeated byte
+		uint8_t const* matchPtr = writePtr + writeIndex - matchOffset;
+		for (int i = 0; i < matchLength; ++i)
+		{
+			writePtr[writeIndex + i] = matchPtr[i];
+		}
+		writeIndex += matchLength;
+	}
+
+	return writeIndex == decompressedSize;
+}
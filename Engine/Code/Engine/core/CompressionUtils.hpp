@@ -0,0 +1,18 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// small helpers for save files
+
+// unsigned LEB128, 7 bits per byte and the high bit says another byte follows, values below 128 take 1 byte
+void AppendVarUInt(std::vector<uint8_t>& buffer, uint32_t value);
+bool ReadVarUInt(uint8_t const* data, int dataSize, int& inout_readIndex, uint32_t& out_value); // false if it runs past the end
+
+// FNV-1a, cheap enough to run over every save, catches torn writes and flipped bits, not meant against tampering
+uint32_t ComputeChecksum32(uint8_t const* data, int dataSize);
+
+// byte oriented LZ77 in the spirit of LZ4, every sequence is a token, its literals, then a back reference of at least 4 bytes
+// decompressing never writes past out_decompressed's expected size, a bad stream returns false instead
+void CompressLZ(uint8_t const* data, int dataSize, std::vector<uint8_t>& out_compressed);
+bool DecompressLZ(uint8_t const* compressed, int compressedSize, std::vector<uint8_t>& out_decompressed, int decompressedSize);
@@ -5,6 +5,13 @@
 #include <Windows.h>
 #include <fstream>
 
+thread_local int t_numFileOperations = 0;
+
+int GetNumFileOperationsOnThisThread()
+{
+	return t_numFileOperations;
+}
+
 // if this chunk have a different version save file, skip
 bool IfThisFileCouldBeRead(std::string const& filePath)
 {
@@ -12,6 +19,7 @@ bool IfThisFileCouldBeRead(std::string const& filePath)
 	errno_t err;
 	FILE* pFile; // like a cursor in the word document
 	char const* filePathName = filePath.c_str();
+	++t_numFileOperations;
 
 	// open the file
 	err = fopen_s(&pFile, filePathName, "r");
@@ -33,6 +41,7 @@ int FileReadToBuffer(std::vector<uint8_t>& outBuffer, std::string const& filePat
 	errno_t err;
 	FILE* pFile; // like a cursor in the word document
 	char const* filePathName = filePath.c_str();
+	++t_numFileOperations;
 
 	// open the file
 	err = fopen_s(&pFile, filePathName, "rb"); // b: _O_BINARY
@@ -86,6 +95,7 @@ int FileReadToString(std::string& outString, std::string const& filePath)
 bool CreateFolder(std::string filePathName)
 {
 	errno_t err;
+	++t_numFileOperations;
 
 	// todo:??? what is the difference between CreateDirectoryA and CreateDirectory
 	err = CreateDirectoryA(LPCSTR(filePathName.c_str()), NULL);
@@ -114,6 +124,7 @@ bool FileWriteFromBuffer(std::vector<uint8_t> inBuffer, std::string const& fileP
 	errno_t err;
 	FILE* pFile; // like a cursor in the word document
 	char const* filePath = filePathName.c_str();
+	++t_numFileOperations;
 
 	// open the file
 	err = fopen_s(&pFile, filePath, "wb");
@@ -130,3 +141,84 @@ bool FileWriteFromBuffer(std::vector<uint8_t> inBuffer, std::string const& fileP
 		return true;
 	}
 }
+
+int FileReadRangeToBuffer(std::vector<uint8_t>& outBuffer, std::string const& filePath, int byteOffset, int numBytes)
+{
+	FILE* pFile;
+	++t_numFileOperations;
+
+	errno_t err = fopen_s(&pFile, filePath.c_str(), "rb");
+	if (err != 0)
+	{
+		outBuffer.clear();
+		return -1;
+	}
+
+	// the range could go past the end of the file, only what is there gets read
+	outBuffer.resize(numBytes);
+	fseek(pFile, byteOffset, SEEK_SET);
+	int numBytesRead = (int)fread(outBuffer.data(), 1, numBytes, pFile);
+	outBuffer.resize(numBytesRead);
+
+	fclose(pFile);
+	return numBytesRead;
+}
+
+bool FileWriteFromBufferAtOffset(std::vector<uint8_t> const& inBuffer, std::string const& filePathName, int byteOffset)
+{
+	FILE* pFile = nullptr;
+	++t_numFileOperations;
+
+	// "r+b" keeps what is already in the file but fails when there is no file yet
+	errno_t err = fopen_s(&pFile, filePathName.c_str(), "r+b");
+	if (err != 0)
+	{
+		err = fopen_s(&pFile, filePathName.c_str(), "w+b");
+		if (err != 0)
+		{
+			return false;
+		}
+	}
+
+	fseek(pFile, byteOffset, SEEK_SET);
+	size_t numBytesWritten = fwrite(inBuffer.data(), 1, inBuffer.size(), pFile);
+	fclose(pFile);
+	return numBytesWritten == inBuffer.size();
+}
+
+bool FileReplace(std::string const& sourceFilePath, std::string const& destFilePath)
+{
+	++t_numFileOperations;
+	return MoveFileExA(sourceFilePath.c_str(), destFilePath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+bool FileDelete(std::string const& filePath)
+{
+	++t_numFileOperations;
+	return DeleteFileA(filePath.c_str()) != 0;
+}
+
+std::vector<std::string> GetFileNamesInFolder(std::string const& folderPath, std::string const& fileNamePattern)
+{
+	std::vector<std::string> fileNames;
+	++t_numFileOperations;
+
+	WIN32_FIND_DATAA findData;
+	std::string searchPath = folderPath + "/" + fileNamePattern;
+	HANDLE findHandle = FindFirstFileA(searchPath.c_str(), &findData);
+	if (findHandle == INVALID_HANDLE_VALUE)
+	{
+		return fileNames; // no match, or the folder does not exist
+	}
+
+	do
+	{
+		if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+		{
+			fileNames.push_back(findData.cFileName);
+		}
+	} while (FindNextFileA(findHandle, &findData));
+
+	FindClose(findHandle);
+	return fileNames;
+}
@@ -6,4 +6,14 @@ bool IfThisFileCouldBeRead(std::string const& filePath);
 int FileReadToBuffer(std::vector<uint8_t>& outBuffer, std::string const& filePath);
 int FileReadToString(std::string& outString, std::string const& filePath);
 bool FileWriteFromBuffer(std::vector<uint8_t> inBuffer, std::string const& filePathName);
-bool CreateFolder(std::string filePathName);
\ No newline at end of file
+bool CreateFolder(std::string filePathName);
+
+// partial reads and writes for container files, e.g. many chunks packed into one region file
+int FileReadRangeToBuffer(std::vector<uint8_t>& outBuffer, std::string const& filePath, int byteOffset, int numBytes); // -1 if the file could not be opened
+bool FileWriteFromBufferAtOffset(std::vector<uint8_t> const& inBuffer, std::string const& filePathName, int byteOffset); // creates the file if it does not exist
+bool FileReplace(std::string const& sourceFilePath, std::string const& destFilePath); // moves the source over the dest, the dest is never half written
+bool FileDelete(std::string const& filePath);
+std::vector<std::string> GetFileNamesInFolder(std::string const& folderPath, std::string const& fileNamePattern); // e.g. "*.chunk", names without the folder
+
+// every function above counts as one file operation of the calling thread, used to check that a thread stays off the disk
+int GetNumFileOperationsOnThisThread();
\ No newline at end of file
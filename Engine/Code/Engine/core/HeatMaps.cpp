@@ -1,6 +1,7 @@
 #include "Engine/core/HeatMaps.hpp"
 #include "Engine/Math/MathUtils.hpp"
 #include "Engine/core/VertexUtils.hpp"
+#include <utility>
 
 TileHeatMap::TileHeatMap(IntVec2 const& dimensions)
 	:m_dimensions(dimensions)
@@ -96,3 +97,214 @@ int TileHeatMap::GetTileIndexForTileCoords(IntVec2 tileCoords)
 	int tileIndex = tileCoords.x + tileCoords.y * m_dimensions.x;
 	return tileIndex;
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// <distance field builder>
+TileDistanceFieldBuilder::TileDistanceFieldBuilder(IntVec2 const& dimensions)
+{
+	SetDimensions(dimensions);
+}
+
+void TileDistanceFieldBuilder::SetDimensions(IntVec2 const& dimensions)
+{
+	m_dimensions = dimensions;
+	SetAllTilesOpen();
+	SetAllTileCostsToOne();
+}
+
+void TileDistanceFieldBuilder::SetAllTilesOpen()
+{
+	int numTiles = m_dimensions.x * m_dimensions.y;
+	m_blockedTileBits.assign((numTiles + 63) / 64, 0);
+}
+
+void TileDistanceFieldBuilder::SetTileBlocked(int tileIndex, bool isBlocked)
+{
+	uint64_t tileBit = uint64_t(1) << (tileIndex & 63);
+	if (isBlocked)
+	{
+		m_blockedTileBits[tileIndex >> 6] |= tileBit;
+	}
+	else
+	{
+		m_blockedTileBits[tileIndex >> 6] &= ~tileBit;
+	}
+}
+
+bool TileDistanceFieldBuilder::IsTileBlocked(int tileIndex) const
+{
+	return (m_blockedTileBits[tileIndex >> 6] >> (tileIndex & 63)) & 1;
+}
+
+void TileDistanceFieldBuilder::SetTileCost(int tileIndex, int cost)
+{
+	cost = (cost < 1) ? 1 : ((cost > 255) ? 255 : cost);
+	if (m_tileCosts.empty())
+	{
+		if (cost == 1)
+		{
+			return;
+		}
+		m_tileCosts.assign(m_dimensions.x * m_dimensions.y, 1);
+	}
+	m_tileCosts[tileIndex] = (unsigned char)cost;
+	if (cost > m_maxTileCost)
+	{
+		m_maxTileCost = cost;
+	}
+}
+
+void TileDistanceFieldBuilder::SetAllTileCostsToOne()
+{
+	m_tileCosts.clear();
+	m_maxTileCost = 1;
+}
+
+float TileDistanceFieldBuilder::PopulateDistanceField(TileHeatMap& out_distanceField, IntVec2 startCoords, float maxCost, IntVec2 targetCoords)
+{
+	out_distanceField.m_dimensions = m_dimensions;
+	out_distanceField.SetDefaultHeatValueForAllTiles(maxCost);
+	float* distances = out_distanceField.m_values.data();
+	int startIndex = startCoords.x + startCoords.y * m_dimensions.x;
+	distances[startIndex] = 0.f;
+
+	bool hasTarget = targetCoords.x >= 0 && targetCoords.x < m_dimensions.x && targetCoords.y >= 0 && targetCoords.y < m_dimensions.y;
+	int targetIndex = hasTarget ? targetCoords.x + targetCoords.y * m_dimensions.x : -1;
+
+	// one bucket more than the highest step cost, so nothing is ever added to the bucket being taken
+	int numBuckets = m_maxTileCost + 1;
+	if ((int)m_buckets.size() < numBuckets)
+	{
+		m_buckets.resize(numBuckets);
+	}
+	for (int bucketIndex = 0; bucketIndex < (int)m_buckets.size(); ++bucketIndex)
+	{
+		m_buckets[bucketIndex].clear();
+	}
+	m_buckets[0].push_back(startIndex);
+	int numWaitingTiles = 1;
+
+	unsigned char const* tileCosts = m_tileCosts.empty() ? nullptr : m_tileCosts.data();
+	int distance = 0;
+	auto reachNeighbor = [&](int neighborIndex)
+		{
+			if (IsTileBlocked(neighborIndex))
+			{
+				return;
+			}
+			int neighborDistance = distance + (tileCosts ? tileCosts[neighborIndex] : 1);
+			if ((float)neighborDistance < distances[neighborIndex])
+			{
+				distances[neighborIndex] = (float)neighborDistance;
+				m_buckets[neighborDistance % numBuckets].push_back(neighborIndex);
+				++numWaitingTiles;
+			}
+		};
+
+	for (; numWaitingTiles > 0; ++distance)
+	{
+		std::vector<int>& bucket = m_buckets[distance % numBuckets];
+		for (int i = 0; i < (int)bucket.size(); ++i)
+		{
+			int tileIndex = bucket[i];
+			// a tile could be waiting in more than one bucket, only the one for the distance it ended up with counts
+			if (distances[tileIndex] != (float)distance)
+			{
+				continue;
+			}
+			if (tileIndex == targetIndex)
+			{
+				return (float)distance;
+			}
+			int tileX = tileIndex % m_dimensions.x;
+			int tileY = tileIndex / m_dimensions.x;
+			if (tileX + 1 < m_dimensions.x)
+			{
+				reachNeighbor(tileIndex + 1);
+			}
+			if (tileX > 0)
+			{
+				reachNeighbor(tileIndex - 1);
+			}
+			if (tileY > 0)
+			{
+				reachNeighbor(tileIndex - m_dimensions.x);
+			}
+			if (tileY + 1 < m_dimensions.y)
+			{
+				reachNeighbor(tileIndex + m_dimensions.x);
+			}
+		}
+		numWaitingTiles -= (int)bucket.size();
+		bucket.clear();
+	}
+	return hasTarget ? distances[targetIndex] : maxCost;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+void TileConnectivity::SetDimensions(IntVec2 const& dimensions)
+{
+	m_dimensions = dimensions;
+	m_parents.assign(m_dimensions.x * m_dimensions.y, -1);
+	m_setSizes.assign(m_dimensions.x * m_dimensions.y, 0);
+}
+
+void TileConnectivity::OpenTile(int tileIndex)
+{
+	if (IsTileOpen(tileIndex))
+	{
+		return;
+	}
+	m_parents[tileIndex] = tileIndex;
+	m_setSizes[tileIndex] = 1;
+
+	int tileX = tileIndex % m_dimensions.x;
+	int tileY = tileIndex / m_dimensions.x;
+	int neighborIndices[4] = { tileIndex + 1, tileIndex - 1, tileIndex - m_dimensions.x, tileIndex + m_dimensions.x };
+	bool isNeighborInGrid[4] = { tileX + 1 < m_dimensions.x, tileX > 0, tileY > 0, tileY + 1 < m_dimensions.y };
+	for (int neighbor = 0; neighbor < 4; ++neighbor)
+	{
+		if (!isNeighborInGrid[neighbor] || !IsTileOpen(neighborIndices[neighbor]))
+		{
+			continue;
+		}
+		// the smaller set goes under the root of the bigger one, so the trees stay shallow
+		int rootA = FindRootTile(tileIndex);
+		int rootB = FindRootTile(neighborIndices[neighbor]);
+		if (rootA == rootB)
+		{
+			continue;
+		}
+		if (m_setSizes[rootA] < m_setSizes[rootB])
+		{
+			std::swap(rootA, rootB);
+		}
+		m_parents[rootB] = rootA;
+		m_setSizes[rootA] += m_setSizes[rootB];
+	}
+}
+
+bool TileConnectivity::AreTilesConnected(int tileIndexA, int tileIndexB)
+{
+	if (!IsTileOpen(tileIndexA) || !IsTileOpen(tileIndexB))
+	{
+		return false;
+	}
+	return FindRootTile(tileIndexA) == FindRootTile(tileIndexB);
+}
+
+int TileConnectivity::GetNumOpenTilesConnectedTo(int tileIndex)
+{
+	return IsTileOpen(tileIndex) ? m_setSizes[FindRootTile(tileIndex)] : 0;
+}
+
+// every tile on the way is pointed at its grandparent, which halves the path for the next time
+int TileConnectivity::FindRootTile(int tileIndex)
+{
+	while (m_parents[tileIndex] != tileIndex)
+	{
+		m_parents[tileIndex] = m_parents[m_parents[tileIndex]];
+		tileIndex = m_parents[tileIndex];
+	}
+	return tileIndex;
+}
@@ -5,6 +5,7 @@
 #include "Engine/Math/AABB2.hpp"
 #include "Engine/Math/FloatRange.hpp"
 #include <vector>
+#include <cstdint>
 
 class Map;
 
@@ -31,4 +32,63 @@ public:
 	IntVec2 m_dimensions;
 	float	m_maxHeatValue = 0.f;
 	std::vector<float> m_values;
-};
\ No newline at end of file
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// builds distance fields on a grid of tiles with a bucket queue, Dial's version of Dijkstra: the tiles waiting to be settled sit in a bucket
+// for their distance and the buckets are taken in order, so every tile is settled once at its final distance
+// with every tile costing 1 it is a breadth first search, the blocked tiles are a bit mask set up once before building the fields
+class TileDistanceFieldBuilder
+{
+public:
+	TileDistanceFieldBuilder() = default;
+	TileDistanceFieldBuilder(IntVec2 const& dimensions);
+	~TileDistanceFieldBuilder() {};
+
+public:
+	void	SetDimensions(IntVec2 const& dimensions); // every tile open and costing 1
+	void	SetAllTilesOpen();
+	void	SetTileBlocked(int tileIndex, bool isBlocked);
+	bool	IsTileBlocked(int tileIndex) const;
+	void	SetTileCost(int tileIndex, int cost); // the cost of stepping onto the tile, 1 to 255
+	void	SetAllTileCostsToOne();
+
+	// the field is maxCost on every tile but the start, which is 0 even when blocked, then every tile reached for less than maxCost gets its distance
+	// with a target in the grid it stops once the target is settled, the tiles farther away than the target may be left unfinished
+	// returns the target's distance, maxCost when there is no target or it could not be reached
+	float	PopulateDistanceField(TileHeatMap& out_distanceField, IntVec2 startCoords, float maxCost, IntVec2 targetCoords = IntVec2(-1, -1));
+
+	IntVec2						m_dimensions;
+	std::vector<uint64_t>		m_blockedTileBits;	// bit (tileIndex & 63) of word (tileIndex >> 6)
+	std::vector<unsigned char>	m_tileCosts;		// empty while every tile costs 1
+	int							m_maxTileCost = 1;
+
+private:
+	std::vector<std::vector<int>> m_buckets; // the tiles waiting at distance d are in bucket d % m_buckets.size(), kept between fields
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// which open tiles of a grid are connected, 4 neighbors, as a union-find over the tile indices
+// tiles only ever open, each joining the sets of its open neighbors, so whether two tiles are connected is known as the tiles change
+// instead of flooding the grid again
+class TileConnectivity
+{
+public:
+	TileConnectivity() = default;
+	~TileConnectivity() {};
+
+public:
+	void	SetDimensions(IntVec2 const& dimensions); // every tile closed
+	void	OpenTile(int tileIndex);
+	bool	IsTileOpen(int tileIndex) const { return m_parents[tileIndex] >= 0; }
+	bool	AreTilesConnected(int tileIndexA, int tileIndexB); // false when either is closed
+	int		GetNumOpenTilesConnectedTo(int tileIndex);
+
+	IntVec2	m_dimensions;
+
+private:
+	int		FindRootTile(int tileIndex);
+
+	std::vector<int> m_parents;		// -1 for closed tiles, a root tile is its own parent
+	std::vector<int> m_setSizes;	// only up to date on the root tiles
+};
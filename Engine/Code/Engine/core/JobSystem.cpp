@@ -1,47 +1,213 @@
 #include "Engine/core/JobSystem.hpp"
+#include "Engine/core/ErrorWarningAssert.hpp"
 
+static std::atomic<unsigned int> s_nextJobSystemID = 1;
 
+// every thread remembers which deque it pushes into, so QueueJobs does not need to look it up under a lock
+thread_local JobWorkerThread*		t_currentWorker = nullptr;
+thread_local unsigned int			t_cachedDequeSystemID = 0;
+thread_local JobWorkStealingDeque*	t_cachedDeque = nullptr;
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+JobWorkStealingDeque::RingBuffer::RingBuffer(int64_t capacity)
+	: m_capacity(capacity)
+	, m_mask(capacity - 1)
+{
+	m_slots = new std::atomic<Job*>[(size_t)capacity];
+}
+
+JobWorkStealingDeque::RingBuffer::~RingBuffer()
+{
+	delete[] m_slots;
+}
+
+JobWorkStealingDeque::JobWorkStealingDeque(int initialCapacity)
+{
+	// the capacity must be power of 2 so the index could wrap with a mask
+	int64_t capacity = 1;
+	while (capacity < initialCapacity)
+	{
+		capacity <<= 1;
+	}
+	m_buffer.store(new RingBuffer(capacity), std::memory_order_relaxed);
+}
+
+JobWorkStealingDeque::~JobWorkStealingDeque()
+{
+	delete m_buffer.load(std::memory_order_relaxed);
+	for (int i = 0; i < (int)m_retiredBuffers.size(); ++i)
+	{
+		delete m_retiredBuffers[i];
+	}
+}
+
+void JobWorkStealingDeque::Push(Job* job)
+{
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+	int64_t top = m_top.load(std::memory_order_acquire);
+	RingBuffer* buffer = m_buffer.load(std::memory_order_relaxed);
+
+	if ((bottom - top) > (buffer->m_capacity - 1)) // full
+	{
+		buffer = Grow(buffer, bottom, top);
+	}
+
+	buffer->Put(bottom, job);
+	std::atomic_thread_fence(std::memory_order_release); // the job must be visible before thieves could see the new bottom
+	m_bottom.store(bottom + 1, std::memory_order_relaxed);
+}
+
+Job* JobWorkStealingDeque::Take()
+{
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	RingBuffer* buffer = m_buffer.load(std::memory_order_relaxed);
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = m_top.load(std::memory_order_relaxed);
+
+	if (top > bottom) // empty, restore the bottom
+	{
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = buffer->Get(bottom);
+	if (top == bottom)
+	{
+		// this is the last job, race against the thieves for it
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			job = nullptr;
+		}
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* JobWorkStealingDeque::Steal()
+{
+	int64_t top = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+	if (top >= bottom)
+	{
+		return nullptr;
+	}
+
+	RingBuffer* buffer = m_buffer.load(std::memory_order_acquire);
+	Job* job = buffer->Get(top);
+	if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		return nullptr; // lost the race to another thief or the owner
+	}
+	return job;
+}
+
+bool JobWorkStealingDeque::IsEmpty() const
+{
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+	int64_t top = m_top.load(std::memory_order_relaxed);
+	return top >= bottom;
+}
+
+JobWorkStealingDeque::RingBuffer* JobWorkStealingDeque::Grow(RingBuffer* oldBuffer, int64_t bottom, int64_t top)
+{
+	RingBuffer* newBuffer = new RingBuffer(oldBuffer->m_capacity * 2);
+	for (int64_t i = top; i < bottom; ++i)
+	{
+		newBuffer->Put(i, oldBuffer->Get(i));
+	}
+	m_retiredBuffers.push_back(oldBuffer);
+	m_buffer.store(newBuffer, std::memory_order_release);
+	return newBuffer;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
 JobWorkerThread::JobWorkerThread(int id, JobSystem* jobSystem)
 	: m_Id(id)
 	, m_jobSystem(jobSystem)
-{	
-	m_thread = new std::thread(&JobWorkerThread::ThreadMain, this);
+{
 }
 
 JobWorkerThread::~JobWorkerThread()
 {
-	m_thread->join(); 
+	if (m_thread)
+	{
+		if (m_thread->joinable())
+		{
+			m_thread->join();
+		}
+		delete m_thread;
+		m_thread = nullptr;
+	}
 }
 
 void JobWorkerThread::ThreadMain()
 {
-	// Spins continuously, looking for unclaimed Job work to claim 
+	t_currentWorker = this;
+	int numIdleSpins = 0;
+
+	// Keeps looking for unclaimed Job work in its own deque first, then steals from the others
+	// when there is nothing to do for a while, the worker parks itself until new jobs are queued
 	// repeating this until signaled to stop looping and exit
 	while (!m_jobSystem->m_isShuttingDown)
 	{
-		Job* jobToExecute = m_jobSystem->ClaimJob();
+		Job* jobToExecute = m_jobSystem->ClaimJob(this);
 		if (jobToExecute)
 		{
+			numIdleSpins = 0;
 			jobToExecute->Execute();
 			m_jobSystem->ReceiveCompletedJob(jobToExecute);
 		}
+		else if (numIdleSpins < m_jobSystem->m_config.numIdleSpinsBeforeParking)
+		{
+			++numIdleSpins;
+			std::this_thread::yield();
+		}
 		else
 		{
-			// there is also std::chrono::hours, minutes, seconds, milliseconds, microseconds, nanoseconds to use
-			std::this_thread::sleep_for((std::chrono::microseconds(1))); // sleeping for 1ms if none job is found
+			numIdleSpins = 0;
+			m_jobSystem->ParkWorkerUntilThereIsWork();
 		}
 	}
+
+	t_currentWorker = nullptr;
 }
 
+// I/O workers do not register as t_currentWorker, jobs they queue go into an external deque where the other workers could steal them
+void JobWorkerThread::IOThreadMain()
+{
+	while (!m_jobSystem->m_isShuttingDown)
+	{
+		Job* jobToExecute = m_jobSystem->ClaimIOJob();
+		if (jobToExecute)
+		{
+			jobToExecute->Execute();
+			m_jobSystem->ReceiveCompletedJob(jobToExecute);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
 JobSystem::JobSystem(JobSystemConfig const& config)
 	: m_config(config)
 {
-
+	m_systemID = s_nextJobSystemID++;
 }
 
 JobSystem::~JobSystem()
 {
+	if (!m_workers.empty() || !m_ioWorkers.empty())
+	{
+		ShutDown();
+	}
 
+	for (int i = 0; i < m_numExternalDeques; ++i)
+	{
+		delete m_externalDeques[i].m_deque;
+		m_externalDeques[i].m_deque = nullptr;
+	}
 }
 
 void JobSystem::Startup()
@@ -55,111 +221,698 @@ void JobSystem::Startup()
 	{
 		CreateWorkers(m_config.numberOfWorkers);
 	}
+	CreateIOWorkers(m_config.numIOWorkers);
 }
 
 void JobSystem::ShutDown()
 {
 	m_isShuttingDown = true;
+
+	// parked workers will not notice the flag by themselves
+	m_parkingMutex.lock();
+	m_parkingMutex.unlock();
+	m_parkingCondition.notify_all();
+	m_queuedIOJobsMutex.lock();
+	m_queuedIOJobsMutex.unlock();
+	m_queuedIOJobsCondition.notify_all();
+
+	DestroyAllWorkers();
 }
 
+// workers are only created during start up, all of them must exist before any of them starts stealing from the others
 void JobSystem::CreateWorkers(int numWorkers)
 {
+	int firstNewWorker = (int)m_workers.size();
 	for (int workerIndex = 0; workerIndex < numWorkers; ++workerIndex)
 	{
-		JobWorkerThread* worker = new JobWorkerThread(workerIndex, this);
+		JobWorkerThread* worker = new JobWorkerThread(firstNewWorker + workerIndex, this);
 		m_workers.push_back(worker);
 	}
+
+	for (int workerIndex = firstNewWorker; workerIndex < (int)m_workers.size(); ++workerIndex)
+	{
+		JobWorkerThread* worker = m_workers[workerIndex];
+		worker->m_thread = new std::thread(&JobWorkerThread::ThreadMain, worker);
+	}
+}
+
+void JobSystem::CreateIOWorkers(int numIOWorkers)
+{
+	for (int workerIndex = 0; workerIndex < numIOWorkers; ++workerIndex)
+	{
+		JobWorkerThread* ioWorker = new JobWorkerThread((int)m_ioWorkers.size(), this);
+		ioWorker->m_isIOWorker = true;
+		ioWorker->m_thread = new std::thread(&JobWorkerThread::IOThreadMain, ioWorker);
+		m_ioWorkers.push_back(ioWorker);
+	}
 }
 
 void JobSystem::DestroyAllWorkers()
 {
+	// every thread has to stop before any worker is deleted, the others may still be stealing from its deque
+	for (int i = 0; i < (int)m_workers.size(); ++i)
+	{
+		m_workers[i]->m_thread->join();
+	}
+
 	for (int i = 0; i < (int)m_workers.size(); ++i)
 	{
 		delete m_workers[i];
 		m_workers[i] = nullptr;
 	}
+	m_workers.clear();
+
+	for (int i = 0; i < (int)m_ioWorkers.size(); ++i)
+	{
+		delete m_ioWorkers[i]; // joins the thread
+		m_ioWorkers[i] = nullptr;
+	}
+	m_ioWorkers.clear();
 }
 
+// called by a thread which is not one of the workers, e.g. the main thread
+// prioritized jobs are left to the workers, they are the long background ones (chunk generation, meshing) nobody should wait behind
 Job* JobSystem::ClaimJob()
-{ 
-	m_queuedJobsMutex.lock();
-	if (!m_queuedJobs.empty())
-	{
-		Job* claimedJob = m_queuedJobs.front();
-		m_queuedJobs.pop_front();
-		m_queuedJobsMutex.unlock();
-		claimedJob->m_jobStatus = JobStatus::CLAIMED; // todo: job status should be changed after mutex unlock?
-		return claimedJob;
+{
+	if (t_currentWorker && t_currentWorker->m_jobSystem == this)
+	{
+		return ClaimJob(t_currentWorker);
 	}
-	else
+
+	Job* claimedJob = nullptr;
+	if (t_cachedDequeSystemID == m_systemID)
+	{
+		claimedJob = t_cachedDeque->Take();
+	}
+
+	if (!claimedJob)
+	{
+		claimedJob = StealJob(0);
+	}
+
+	if (claimedJob)
+	{
+		--m_numQueuedJobs;
+		claimedJob->m_jobStatus = JobStatus::CLAIMED;
+	}
+	return claimedJob;
+}
+
+Job* JobSystem::ClaimJob(JobWorkerThread* worker)
+{
+	// the newest job in my own deque first since it is the one most likely to still be in cache, then steal
+	// the deques hold fork-join work (e.g. ParallelFor ranges) somebody is waiting for, so the prioritized backlog comes last
+	Job* claimedJob = worker->m_localJobs.Take();
+	if (!claimedJob)
+	{
+		claimedJob = StealJob(worker->m_Id + 1);
+	}
+	if (!claimedJob)
+	{
+		claimedJob = ClaimPrioritizedJob();
+	}
+
+	if (claimedJob)
+	{
+		--m_numQueuedJobs;
+		claimedJob->m_jobStatus = JobStatus::CLAIMED;
+	}
+	return claimedJob;
+}
+
+// WaitFor() only helps with work that can not hold it up: never a prioritized job
+// a non-worker thread only runs the handle's own jobs out of its own deque, anything else it queued earlier stays for the workers
+Job* JobSystem::ClaimJobToHelpWith(JobHandle const& handle)
+{
+	if (t_currentWorker && t_currentWorker->m_jobSystem == this)
 	{
-		m_queuedJobsMutex.unlock();
-		Job* claimedJob = nullptr;
+		Job* claimedJob = t_currentWorker->m_localJobs.Take();
+		if (!claimedJob)
+		{
+			claimedJob = StealJob(t_currentWorker->m_Id + 1);
+		}
+		if (claimedJob)
+		{
+			--m_numQueuedJobs;
+			claimedJob->m_jobStatus = JobStatus::CLAIMED;
+		}
 		return claimedJob;
 	}
+
+	if (t_cachedDequeSystemID != m_systemID)
+	{
+		return nullptr;
+	}
+
+	Job* claimedJob = t_cachedDeque->Take();
+	if (claimedJob && claimedJob->m_handle != &handle)
+	{
+		// the handle's jobs were pushed last, so the rest of them are already claimed, put this one back where it was
+		t_cachedDeque->Push(claimedJob);
+		return nullptr;
+	}
+
+	if (claimedJob)
+	{
+		--m_numQueuedJobs;
+		claimedJob->m_jobStatus = JobStatus::CLAIMED;
+	}
+	return claimedJob;
+}
+
+// go through the external deques first since that is where the main thread feeds in new work, then the other workers
+Job* JobSystem::StealJob(int firstVictimIndex)
+{
+	int numExternalDeques = m_numExternalDeques.load(std::memory_order_acquire);
+	for (int i = 0; i < numExternalDeques; ++i)
+	{
+		Job* stolenJob = m_externalDeques[i].m_deque->Steal();
+		if (stolenJob)
+		{
+			return stolenJob;
+		}
+	}
+
+	int numWorkers = (int)m_workers.size();
+	for (int i = 0; i < numWorkers; ++i)
+	{
+		JobWorkerThread* victim = m_workers[(firstVictimIndex + i) % numWorkers];
+		if (victim == t_currentWorker)
+		{
+			continue;
+		}
+
+		Job* stolenJob = victim->m_localJobs.Steal();
+		if (stolenJob)
+		{
+			return stolenJob;
+		}
+	}
+
+	return nullptr;
 }
 
 void JobSystem::ReceiveCompletedJob(Job* job)
 {
-	m_completedJobsMutex.lock();
-	m_completedJobs.push_back(job);
-	m_completedJobsMutex.unlock();
+	// everything that touches the job has to happen before it goes into the completed list, its owner may delete it right after
+	JobHandle* handle = job->m_handle;
+	job->m_handle = nullptr;
+	job->m_numBlockers = 1; // ready to be queued again
+	ReleaseContinuations(job);
+
 	job->m_jobStatus = JobStatus::COMPLETED;
+	if (job->m_needsRetrieving)
+	{
+		std::atomic<Job*>& completedJobStack = m_completedJobStacks[job->m_jobType];
+		Job* topJob = completedJobStack.load(std::memory_order_relaxed);
+		do
+		{
+			job->m_nextCompletedJob = topJob;
+		} while (!completedJobStack.compare_exchange_weak(topJob, job, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	// the handle goes last, whoever waits on it may destroy the job and the handle as soon as it is finished
+	if (handle)
+	{
+		--handle->m_numUnfinishedJobs;
+	}
 }
 
+// kept for callers that poll one job at a time, it moves everything completed into a deque so a specific job could be found
 Job* JobSystem::RetrieveCompletedJobs(Job* requestedJob)
 {
+	m_completedJobsMutex.lock();
+	for (int jobType = 0; jobType < MAX_JOB_TYPES; ++jobType)
+	{
+		Job* job = SwapOutCompletedJobStack(jobType);
+		while (job)
+		{
+			Job* nextJob = job->m_nextCompletedJob;
+			job->m_nextCompletedJob = nullptr;
+			m_completedJobs.push_back(job);
+			++m_numJobsInCompletedDeque;
+			job = nextJob;
+		}
+	}
+
+	Job* retrievedJob = nullptr;
 	if (requestedJob) // request a specific job
 	{
-		m_completedJobsMutex.lock();
 		std::deque<Job*>::iterator iter;
 		for (iter = m_completedJobs.begin(); iter != m_completedJobs.end(); ++iter)
 		{
 			if (*iter == requestedJob)
 			{
-				Job* retrievedjob = *iter;
-				retrievedjob->m_jobStatus = JobStatus::RETRIEVED;
-				m_completedJobsMutex.unlock();
-				return retrievedjob;
+				retrievedJob = *iter;
+				m_completedJobs.erase(iter);
+				break;
 			}
 		}
-		m_completedJobsMutex.unlock(); 
-		return nullptr; // did not find the specific job
 	}
-	else
+	else if (!m_completedJobs.empty()) // not requested specific job, return the oldest one
+	{
+		retrievedJob = m_completedJobs.front();
+		m_completedJobs.pop_front();
+	}
+
+	if (retrievedJob)
+	{
+		--m_numJobsInCompletedDeque;
+		retrievedJob->m_jobStatus = JobStatus::RETRIEVED;
+	}
+	m_completedJobsMutex.unlock();
+	return retrievedJob; // null when nothing (or not the specific job) has completed yet
+}
+
+void JobSystem::RetrieveAllCompletedJobs(std::vector<Job*>& out_completedJobs, int jobType)
+{
+	Job* job = TakeCompletedJobList(jobType);
+	while (job)
+	{
+		Job* nextJob = job->m_nextCompletedJob;
+		job->m_nextCompletedJob = nullptr;
+		job->m_jobStatus = JobStatus::RETRIEVED;
+		out_completedJobs.push_back(job);
+		job = nextJob;
+	}
+}
+
+// takes the whole stack in one swap and reverses it, so the returned list starts from the oldest job
+Job* JobSystem::SwapOutCompletedJobStack(int jobType)
+{
+	Job* newestFirst = m_completedJobStacks[jobType].exchange(nullptr, std::memory_order_acquire);
+	Job* oldestFirst = nullptr;
+	while (newestFirst)
+	{
+		Job* nextJob = newestFirst->m_nextCompletedJob;
+		newestFirst->m_nextCompletedJob = oldestFirst;
+		oldestFirst = newestFirst;
+		newestFirst = nextJob;
+	}
+	return oldestFirst;
+}
+
+Job* JobSystem::TakeCompletedJobList(int jobType)
+{
+	Job* oldestFirst = SwapOutCompletedJobStack(jobType);
+
+	// jobs RetrieveCompletedJobs() has already moved into the deque are older than anything still in the stack
+	if (m_numJobsInCompletedDeque.load() > 0)
 	{
-		// not requested specific job
+		Job* dequeFirst = nullptr;
+		Job* dequeLast = nullptr;
+
 		m_completedJobsMutex.lock();
-		if (!m_completedJobs.empty()) // return the front one when the deque is not empty
+		std::deque<Job*>::iterator iter = m_completedJobs.begin();
+		while (iter != m_completedJobs.end())
 		{
-			Job* retrievedjob = m_completedJobs.front();
-			m_completedJobs.pop_front();
-			retrievedjob->m_jobStatus = JobStatus::RETRIEVED;
-			m_completedJobsMutex.unlock();
-			return retrievedjob;
+			Job* job = *iter;
+			if (job->m_jobType != jobType)
+			{
+				++iter;
+				continue;
+			}
+
+			if (dequeLast)
+			{
+				dequeLast->m_nextCompletedJob = job;
+			}
+			else
+			{
+				dequeFirst = job;
+			}
+			dequeLast = job;
+			iter = m_completedJobs.erase(iter);
+			--m_numJobsInCompletedDeque;
 		}
-		else
+		m_completedJobsMutex.unlock();
+
+		if (dequeLast)
 		{
-			// return null when the completed job deque is empty
-			m_completedJobsMutex.unlock();
-			return nullptr;
+			dequeLast->m_nextCompletedJob = oldestFirst;
+			oldestFirst = dequeFirst;
 		}
 	}
+	return oldestFirst;
 }
 
 int JobSystem::GetNumQueuedJobs() const
 {
-	m_queuedJobsMutex.lock();
-	int numJobs = (int)m_queuedJobs.size();
-	m_queuedJobsMutex.unlock();
-	return numJobs;
+	return m_numQueuedJobs.load();
+}
+
+int JobSystem::GetNumQueuedIOJobs() const
+{
+	return m_numQueuedIOJobs.load();
+}
+
+int JobSystem::GetNumWorkers() const
+{
+	return (int)m_workers.size();
 }
 
 void JobSystem::QueueJobs(Job* jobToQueue)
 {
-	m_queuedJobsMutex.lock();
-	m_queuedJobs.push_back(jobToQueue);
-	m_queuedJobsMutex.unlock();
+	GUARANTEE_OR_DIE(jobToQueue->m_jobType >= 0 && jobToQueue->m_jobType < MAX_JOB_TYPES, "Job type is out of range");
+	jobToQueue->m_jobStatus = JobStatus::QUEUED;
+
+	// under the same lock ReleaseContinuations() sets it and AddPrerequisite() reads it with, a re-queued job may still be
+	// looked at as a prerequisite from another thread
+	jobToQueue->m_continuationsMutex.lock();
+	jobToQueue->m_hasFinished = false;
+	jobToQueue->m_continuationsMutex.unlock();
+
+	// queuing removes the first blocker, a job with unfinished prerequisites is pushed later by the last of them to complete
+	if (jobToQueue->m_numBlockers.fetch_sub(1) == 1)
+	{
+		PushJobIntoDeque(jobToQueue);
+	}
+}
+
+void JobSystem::QueueJobs(Job* jobToQueue, JobHandle& handle)
+{
+	++handle.m_numUnfinishedJobs;
+	jobToQueue->m_handle = &handle;
+	QueueJobs(jobToQueue);
+}
+
+void JobSystem::PushJobIntoDeque(Job* job)
+{
+	if (job->m_isIOJob)
+	{
+		m_queuedIOJobsMutex.lock();
+		m_queuedIOJobs.push_back(job);
+		++m_numQueuedIOJobs;
+		m_queuedIOJobsMutex.unlock();
+		m_queuedIOJobsCondition.notify_one();
+		return; // the general workers do not need to wake up for it
+	}
+
+	if (job->m_isPrioritized)
+	{
+		m_prioritizedJobsMutex.lock();
+		m_prioritizedJobs.push_back(job);
+		++m_numPrioritizedJobs;
+		m_prioritizedJobsMutex.unlock();
+	}
+	else if (t_currentWorker && t_currentWorker->m_jobSystem == this)
+	{
+		t_currentWorker->m_localJobs.Push(job);
+	}
+	else
+	{
+		GetOrCreateDequeForThisThread()->Push(job);
+	}
+
+	++m_numQueuedJobs;
+	WakeParkedWorkers(1);
+}
+
+void JobSystem::ReleaseContinuations(Job* job)
+{
+	std::vector<Job*> continuations;
+	job->m_continuationsMutex.lock();
+	job->m_hasFinished = true;
+	continuations.swap(job->m_continuations);
+	job->m_continuationsMutex.unlock();
+
+	for (int i = 0; i < (int)continuations.size(); ++i)
+	{
+		if (continuations[i]->m_numBlockers.fetch_sub(1) == 1)
+		{
+			PushJobIntoDeque(continuations[i]);
+		}
+	}
+}
+
+void JobSystem::AddPrerequisite(Job* continuation, Job* prerequisite)
+{
+	JobStatus continuationStatus = continuation->m_jobStatus;
+	GUARANTEE_OR_DIE(continuationStatus != JobStatus::QUEUED && continuationStatus != JobStatus::CLAIMED, "A prerequisite could only be added before the continuation is queued");
+
+	prerequisite->m_continuationsMutex.lock();
+	if (!prerequisite->m_hasFinished)
+	{
+		++continuation->m_numBlockers;
+		prerequisite->m_continuations.push_back(continuation);
+	}
+	prerequisite->m_continuationsMutex.unlock();
+}
+
+void JobSystem::QueuePrioritizedJob(Job* jobToQueue, int priority)
+{
+	jobToQueue->m_priority = priority;
+	jobToQueue->m_isPrioritized = true;
+	QueueJobs(jobToQueue);
+}
+
+void JobSystem::QueuePrioritizedJob(Job* jobToQueue, int priority, JobHandle& handle)
+{
+	jobToQueue->m_priority = priority;
+	jobToQueue->m_isPrioritized = true;
+	QueueJobs(jobToQueue, handle);
+}
+
+bool JobSystem::CancelJob(Job* job)
+{
+	bool wasCancelled = false;
+	if (job->m_isIOJob)
+	{
+		m_queuedIOJobsMutex.lock();
+		for (std::deque<Job*>::iterator iter = m_queuedIOJobs.begin(); iter != m_queuedIOJobs.end(); ++iter)
+		{
+			if (*iter == job)
+			{
+				m_queuedIOJobs.erase(iter);
+				--m_numQueuedIOJobs;
+				wasCancelled = true;
+				break;
+			}
+		}
+		m_queuedIOJobsMutex.unlock();
+	}
+	else if (!job->m_isPrioritized)
+	{
+		return false; // jobs in the work stealing deques could not be taken out again
+	}
+	else
+	{
+		m_prioritizedJobsMutex.lock();
+		for (int i = 0; i < (int)m_prioritizedJobs.size(); ++i)
+		{
+			if (m_prioritizedJobs[i] == job)
+			{
+				m_prioritizedJobs[i] = m_prioritizedJobs.back();
+				m_prioritizedJobs.pop_back();
+				--m_numPrioritizedJobs;
+				--m_numQueuedJobs;
+				wasCancelled = true;
+				break;
+			}
+		}
+		m_prioritizedJobsMutex.unlock();
+	}
+
+	if (!wasCancelled)
+	{
+		return false; // already claimed, or still waiting for its prerequisites
+	}
+
+	// whatever waits on it should not wait forever
+	JobHandle* handle = job->m_handle;
+	job->m_handle = nullptr;
+	job->m_numBlockers = 1;
+	ReleaseContinuations(job);
+	job->m_jobStatus = JobStatus::CANCELLED;
+	if (handle)
+	{
+		--handle->m_numUnfinishedJobs;
+	}
+	return true;
+}
+
+Job* JobSystem::ClaimPrioritizedJob()
+{
+	if (m_numPrioritizedJobs.load(std::memory_order_relaxed) == 0)
+	{
+		return nullptr;
+	}
+
+	Job* claimedJob = nullptr;
+	m_prioritizedJobsMutex.lock();
+	int bestIndex = -1;
+	int bestPriority = 0;
+	for (int i = 0; i < (int)m_prioritizedJobs.size(); ++i)
+	{
+		int priority = m_prioritizedJobs[i]->m_priority.load(std::memory_order_relaxed);
+		if (bestIndex < 0 || priority < bestPriority)
+		{
+			bestIndex = i;
+			bestPriority = priority;
+		}
+	}
+	if (bestIndex >= 0)
+	{
+		claimedJob = m_prioritizedJobs[bestIndex];
+		m_prioritizedJobs[bestIndex] = m_prioritizedJobs.back();
+		m_prioritizedJobs.pop_back();
+		--m_numPrioritizedJobs;
+	}
+	m_prioritizedJobsMutex.unlock();
+	return claimedJob;
+}
+
+Job* JobSystem::ClaimIOJob()
+{
+	std::unique_lock<std::mutex> ioJobsLock(m_queuedIOJobsMutex);
+	m_queuedIOJobsCondition.wait(ioJobsLock, [this]() { return !m_queuedIOJobs.empty() || m_isShuttingDown; });
+	if (m_queuedIOJobs.empty())
+	{
+		return nullptr;
+	}
+
+	Job* claimedJob = m_queuedIOJobs.front();
+	m_queuedIOJobs.pop_front();
+	--m_numQueuedIOJobs;
+	claimedJob->m_jobStatus = JobStatus::CLAIMED;
+	return claimedJob;
+}
+
+void JobSystem::WaitFor(JobHandle const& handle)
+{
+	while (!handle.IsFinished())
+	{
+		Job* jobToExecute = ClaimJobToHelpWith(handle);
+		if (jobToExecute)
+		{
+			jobToExecute->Execute();
+			ReceiveCompletedJob(jobToExecute);
+		}
+		else
+		{
+			// the remaining jobs are running on other threads or waiting for their prerequisites
+			std::this_thread::yield();
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+class ParallelForJob : public Job
+{
+public:
+	void Execute() override
+	{
+		(*m_function)(m_beginIndex, m_endIndex);
+	}
+
+	int m_beginIndex = 0;
+	int m_endIndex = 0;
+	std::function<void(int, int)> const* m_function = nullptr;
+};
+
+void JobSystem::ParallelFor(int beginIndex, int endIndex, int grainSize, std::function<void(int, int)> const& function)
+{
+	if (endIndex <= beginIndex)
+	{
+		return;
+	}
+	if (grainSize < 1)
+	{
+		grainSize = 1;
+	}
+
+	int numRanges = (endIndex - beginIndex + grainSize - 1) / grainSize;
+	if (numRanges == 1)
+	{
+		function(beginIndex, endIndex);
+		return;
+	}
+
+	// the jobs live on this stack frame until WaitFor returns, so they never go into the completed list
+	std::vector<ParallelForJob> rangeJobs(numRanges);
+	JobHandle handle;
+	for (int rangeIndex = 0; rangeIndex < numRanges; ++rangeIndex)
+	{
+		ParallelForJob& rangeJob = rangeJobs[rangeIndex];
+		rangeJob.m_beginIndex = beginIndex + rangeIndex * grainSize;
+		rangeJob.m_endIndex = (rangeJob.m_beginIndex + grainSize < endIndex) ? rangeJob.m_beginIndex + grainSize : endIndex;
+		rangeJob.m_function = &function;
+		rangeJob.m_needsRetrieving = false;
+		QueueJobs(&rangeJob, handle);
+	}
+
+	WaitFor(handle);
+}
+
+JobWorkStealingDeque* JobSystem::GetOrCreateDequeForThisThread()
+{
+	if (t_cachedDequeSystemID == m_systemID)
+	{
+		return t_cachedDeque;
+	}
+
+	std::thread::id threadID = std::this_thread::get_id();
+	JobWorkStealingDeque* deque = nullptr;
+
+	m_externalDequesMutex.lock();
+	int numExternalDeques = m_numExternalDeques.load(std::memory_order_relaxed);
+	for (int i = 0; i < numExternalDeques; ++i)
+	{
+		if (m_externalDeques[i].m_threadId == threadID)
+		{
+			deque = m_externalDeques[i].m_deque;
+			break;
+		}
+	}
+
+	if (!deque)
+	{
+		if (numExternalDeques >= MAX_EXTERNAL_DEQUES)
+		{
+			// a deque could only have one owner pushing into it, so the producer threads could not share one
+			m_externalDequesMutex.unlock();
+			ERROR_AND_DIE("Too many non-worker threads are queuing jobs into the same job system");
+		}
+
+		deque = new JobWorkStealingDeque();
+		m_externalDeques[numExternalDeques].m_threadId = threadID;
+		m_externalDeques[numExternalDeques].m_deque = deque;
+		m_numExternalDeques.store(numExternalDeques + 1, std::memory_order_release);
+	}
+	m_externalDequesMutex.unlock();
+
+	t_cachedDequeSystemID = m_systemID;
+	t_cachedDeque = deque;
+	return deque;
+}
+
+// a worker only goes to sleep when no job is queued anywhere, checking the count again under the lock means a job queued
+// in between could not be missed: either the worker sees the new count or QueueJobs sees the parked worker
+void JobSystem::ParkWorkerUntilThereIsWork()
+{
+	std::unique_lock<std::mutex> parkingLock(m_parkingMutex);
+	++m_numParkedWorkers;
+	m_parkingCondition.wait(parkingLock, [this]() { return m_numQueuedJobs.load() > 0 || m_isShuttingDown; });
+	--m_numParkedWorkers;
+}
+
+void JobSystem::WakeParkedWorkers(int numJobsQueued)
+{
+	if (m_numParkedWorkers.load() == 0)
+	{
+		return;
+	}
+
+	m_parkingMutex.lock();
+	m_parkingMutex.unlock();
+	if (numJobsQueued > 1)
+	{
+		m_parkingCondition.notify_all();
+	}
+	else
+	{
+		m_parkingCondition.notify_one();
+	}
 }
 
 Job::~Job()
@@ -3,6 +3,12 @@
 #include <thread>
 #include <mutex>
 #include <deque>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+
+class JobWorkerThread;
+class JobSystem;
 
 enum class JobStatus
 {
@@ -11,30 +17,124 @@ enum class JobStatus
 	CLAIMED,
 	COMPLETED,
 	RETRIEVED,
+	CANCELLED, // taken out of the queue before any worker claimed it, never executed
 
 	NUM_STATE
 };
 
+// every job kind has its own completed list, so the owner could pick up its own jobs without casting
+// the game defines its job types after the generic one
+constexpr int JOB_TYPE_GENERIC = 0;
+constexpr int MAX_JOB_TYPES = 16;
+
 struct JobSystemConfig
 {
 	int numberOfWorkers = -1; // if it equals -1, create 1 worker thread per core
+	int numIdleSpinsBeforeParking = 64; // how many empty claim attempts a worker yields through before it goes to sleep
+	int numIOWorkers = 1; // disk I/O jobs only run on these, so a slow read never holds up the workers the frame is waiting for
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// a handle to a group of jobs, it is finished when every job queued with it has completed
+// whoever owns the handle keeps it alive until it is finished, e.g. on the stack around WaitFor()
+class JobHandle
+{
+	friend class JobSystem;
+
+public:
+	JobHandle() {}
+	JobHandle(JobHandle const& copyFrom) = delete;
+
+	bool IsFinished() const			{ return m_numUnfinishedJobs.load() == 0; }
+	int GetNumUnfinishedJobs() const	{ return m_numUnfinishedJobs.load(); }
+
+private:
+	std::atomic<int> m_numUnfinishedJobs = 0;
 };
 
 class Job
 {
 	friend class JobWorkerThread;
+	friend class JobSystem;
 
 public:
 
+	static constexpr int JOB_TYPE = JOB_TYPE_GENERIC; // derived jobs hide it with their own and pass it to the constructor
+
 	Job() {}
+	Job(int jobType) : m_jobType(jobType) {}
 	virtual ~Job();
 
 	virtual void Execute() = 0;
 	std::atomic <JobStatus> m_jobStatus = JobStatus::NUM_STATE; // todo: or this should be in the derived job class?
+	int m_jobType = JOB_TYPE_GENERIC;
+
+	// jobs that are waited on through a handle could skip the completed list, then nobody has to retrieve them
+	bool m_needsRetrieving = true;
+
+	// only used by prioritized jobs, lower values are claimed first, could be changed at any time while the job is queued
+	std::atomic<int> m_priority = 0;
+
+	// I/O jobs (loading and saving files) run on the I/O workers only, in the order they were queued
+	bool m_isIOJob = false;
+
+private:
+	// 1 for not being queued yet + 1 for every unfinished prerequisite, the job goes into a deque when it reaches 0
+	std::atomic<int>	m_numBlockers = 1;
+	JobHandle*			m_handle = nullptr;
+
+	// jobs that wait for this one, released when this one completes
+	std::vector<Job*>	m_continuations;
+	std::mutex			m_continuationsMutex;
+	bool				m_hasFinished = false; // only touched with m_continuationsMutex locked
+
+	bool				m_isPrioritized = false;
+
+	Job*				m_nextCompletedJob = nullptr; // intrusive link in the completed list of its type
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// Chase-Lev work stealing deque
+// only the owner thread pushes and takes at the bottom end, any other thread could steal from the top end without a lock
+// the ring buffer grows when it is full, retired buffers are kept until the deque dies because a thief may still be reading them
+class JobWorkStealingDeque
+{
+public:
+	JobWorkStealingDeque(int initialCapacity = 1024);
+	~JobWorkStealingDeque();
+
+	void Push(Job* job);	// owner thread only
+	Job* Take();			// owner thread only, LIFO
+	Job* Steal();			// any thread, FIFO
+
+	bool IsEmpty() const;
+
+private:
+	struct RingBuffer
+	{
+		RingBuffer(int64_t capacity);
+		~RingBuffer();
+
+		Job* Get(int64_t index) const		{ return m_slots[index & m_mask].load(std::memory_order_relaxed); }
+		void Put(int64_t index, Job* job)	{ m_slots[index & m_mask].store(job, std::memory_order_relaxed); }
+
+		int64_t				m_capacity = 0;
+		int64_t				m_mask = 0;
+		std::atomic<Job*>*	m_slots = nullptr;
+	};
+
+	RingBuffer* Grow(RingBuffer* oldBuffer, int64_t bottom, int64_t top);
+
+	alignas(64) std::atomic<int64_t>	m_top = 0;
+	alignas(64) std::atomic<int64_t>	m_bottom = 0;
+	alignas(64) std::atomic<RingBuffer*> m_buffer = nullptr;
+	std::vector<RingBuffer*>			m_retiredBuffers; // only touched by the owner thread
 };
 
 class JobSystem
 {
+	friend class JobWorkerThread;
+
 public:
 	JobSystem(JobSystemConfig const& config);
 	~JobSystem();
@@ -43,32 +143,124 @@ public:
 	void ShutDown();
 
 	void CreateWorkers(int numWorkers);
+	void CreateIOWorkers(int numIOWorkers);
 	void DestroyAllWorkers(); // todo: do I need to let the job system destroy all thread workers?
 
 	void QueueJobs(Job* jobToQueue);
+	void QueueJobs(Job* jobToQueue, JobHandle& handle); // the handle is finished when this job (and the others queued with it) completes
+
+	// prioritized jobs are claimed by the workers once the deques are empty, the lowest m_priority first
+	// the deques hold fork-join work somebody is waiting for, and WaitFor() never runs a prioritized job
+	// a queued prioritized job could still be cancelled, e.g. a chunk that went out of range before it got generated
+	void QueuePrioritizedJob(Job* jobToQueue, int priority);
+	void QueuePrioritizedJob(Job* jobToQueue, int priority, JobHandle& handle);
+	bool CancelJob(Job* job); // true if the job was taken out before any worker claimed it, it will never execute or be completed
+							  // works for prioritized jobs and I/O jobs
 	Job* ClaimJob();
 	Job* ClaimJob(JobWorkerThread* worker); // specific workers will claim specific jobs
 	void ReceiveCompletedJob(Job* job);
 	Job* RetrieveCompletedJobs(Job* requestedJob); // Retrieve any completed job, or a specific job
 
+	// hands back every completed job of one type at once, oldest first, the list is taken with a single atomic swap
+	void RetrieveAllCompletedJobs(std::vector<Job*>& out_completedJobs, int jobType);
+	template <typename JobType>
+	void RetrieveAllCompletedJobs(std::vector<JobType*>& out_completedJobs); // e.g. std::vector<ChunkGenerateJob*>
+
 	int GetNumQueuedJobs() const;
+	int GetNumQueuedIOJobs() const;
+	int GetNumWorkers() const;
+
+	// the continuation is held back until the prerequisite completes, this has to be called before the continuation is queued
+	// the prerequisite must still be alive, if it has already completed there is nothing to wait for
+	void AddPrerequisite(Job* continuation, Job* prerequisite);
+
+	// executes queued jobs on this thread until the handle is finished instead of blocking, works on workers inside a job too
+	// a non-worker thread only helps with the handle's own jobs
+	void WaitFor(JobHandle const& handle);
+
+	// splits [beginIndex, endIndex) into ranges of grainSize and runs function(rangeBegin, rangeEnd) for them on the workers
+	// returns when every range is done, the calling thread helps
+	void ParallelFor(int beginIndex, int endIndex, int grainSize, std::function<void(int, int)> const& function);
 
 	JobSystemConfig m_config;
 
 	std::atomic <bool> m_isShuttingDown = false;
 
-	std::deque <Job*>		m_queuedJobs;
-	mutable std::mutex		m_queuedJobsMutex;	
-	
 	std::deque <Job*>		m_claimedJobs;
 	mutable std::mutex		m_claimedJobsMutex;
 
+	// only used by RetrieveCompletedJobs(), which looks through all types, everything else goes through the lock free lists
 	std::deque <Job*>		m_completedJobs;
 	mutable std::mutex		m_completedJobsMutex;
+	std::atomic<int>		m_numJobsInCompletedDeque = 0;
 
 	std::vector<JobWorkerThread*> m_workers;
+	std::vector<JobWorkerThread*> m_ioWorkers; // never claim from the deques, and nobody steals from them
+
+private:
+	void PushJobIntoDeque(Job* job);
+	void ReleaseContinuations(Job* job);
+	Job* SwapOutCompletedJobStack(int jobType);
+	Job* TakeCompletedJobList(int jobType);
+	Job* ClaimPrioritizedJob();
+	Job* ClaimJobToHelpWith(JobHandle const& handle); // only used by WaitFor()
+	Job* ClaimIOJob(); // blocks until there is an I/O job, null when the system is shutting down
+	JobWorkStealingDeque* GetOrCreateDequeForThisThread();
+	Job* StealJob(int firstVictimIndex);
+
+	void ParkWorkerUntilThereIsWork();
+	void WakeParkedWorkers(int numJobsQueued);
+
+	// non-worker threads (e.g. the main thread) that queue jobs each get a deque of their own, workers steal from them
+	static constexpr int MAX_EXTERNAL_DEQUES = 8;
+	struct ExternalDeque
+	{
+		std::thread::id			m_threadId;
+		JobWorkStealingDeque*	m_deque = nullptr;
+	};
+	ExternalDeque				m_externalDeques[MAX_EXTERNAL_DEQUES];
+	std::atomic<int>			m_numExternalDeques = 0;
+	std::mutex					m_externalDequesMutex;
+
+	unsigned int				m_systemID = 0; // tells the thread local deque caches of different job systems apart
+
+	std::atomic<int>			m_numQueuedJobs = 0; // queued but not claimed yet, across all deques and the prioritized list
+
+	// not sorted, the claiming thread looks for the lowest priority because priorities keep changing while jobs wait
+	std::vector<Job*>			m_prioritizedJobs;
+	std::mutex					m_prioritizedJobsMutex;
+	std::atomic<int>			m_numPrioritizedJobs = 0;
+
+	// workers push completed jobs on top, the retrieving thread swaps the whole stack out, newest first
+	std::atomic<Job*>			m_completedJobStacks[MAX_JOB_TYPES] = {};
+
+	// idle workers sleep on this instead of spinning
+	std::mutex					m_parkingMutex;
+	std::condition_variable		m_parkingCondition;
+	std::atomic<int>			m_numParkedWorkers = 0;
+
+	// the I/O lane is a plain FIFO, there are only a few I/O workers and they spend their time waiting for the disk anyway
+	std::deque<Job*>			m_queuedIOJobs;
+	std::mutex					m_queuedIOJobsMutex;
+	std::condition_variable		m_queuedIOJobsCondition;
+	std::atomic<int>			m_numQueuedIOJobs = 0;
 };
 
+template <typename JobType>
+void JobSystem::RetrieveAllCompletedJobs(std::vector<JobType*>& out_completedJobs)
+{
+	// the type tag tells which derived job it is, so a static_cast is enough
+	Job* job = TakeCompletedJobList(JobType::JOB_TYPE);
+	while (job)
+	{
+		Job* nextJob = job->m_nextCompletedJob;
+		job->m_nextCompletedJob = nullptr;
+		job->m_jobStatus = JobStatus::RETRIEVED;
+		out_completedJobs.push_back(static_cast<JobType*>(job));
+		job = nextJob;
+	}
+}
+
 class JobWorkerThread
 {
 	friend class JobSystem;
@@ -78,8 +270,11 @@ public:
 	~JobWorkerThread();
 
 	void ThreadMain();
+	void IOThreadMain();
 
 	int m_Id = 0;
+	bool m_isIOWorker = false;
 	JobSystem* m_jobSystem = nullptr;
 	std::thread* m_thread = nullptr;
-};
\ No newline at end of file
+	JobWorkStealingDeque m_localJobs;
+};
@@ -0,0 +1,735 @@
+#include "Engine/core/TilePathfinding.hpp"
+#include <algorithm>
+
+// the entries of the open lists, the lowest estimated total cost comes out first
+struct TilePathOpenEntry
+{
+	float	m_estimatedCost = 0.f;
+	float	m_cost = 0.f;
+	int		m_index = 0;
+};
+
+static bool IsOpenEntryWorse(TilePathOpenEntry const& a, TilePathOpenEntry const& b)
+{
+	if (a.m_estimatedCost != b.m_estimatedCost)
+	{
+		return a.m_estimatedCost > b.m_estimatedCost;
+	}
+	return a.m_cost < b.m_cost; // on a tie the one farther along goes first
+}
+
+static void PushOpenEntry(std::vector<TilePathOpenEntry>& openHeap, float estimatedCost, float cost, int index)
+{
+	TilePathOpenEntry entry;
+	entry.m_estimatedCost = estimatedCost;
+	entry.m_cost = cost;
+	entry.m_index = index;
+	openHeap.push_back(entry);
+	std::push_heap(openHeap.begin(), openHeap.end(), IsOpenEntryWorse);
+}
+
+static TilePathOpenEntry PopOpenEntry(std::vector<TilePathOpenEntry>& openHeap)
+{
+	std::pop_heap(openHeap.begin(), openHeap.end(), IsOpenEntryWorse);
+	TilePathOpenEntry entry = openHeap.back();
+	openHeap.pop_back();
+	return entry;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// per thread, so the searches never share anything they write
+// the costs and parents are per tile plus the start and goal slots of the portal search, a tile only counts as seen when its stamp is this search's,
+// so nothing has to be cleared between searches
+struct TilePathfinder::SearchScratch
+{
+	void BeginSearch(int numSlots)
+	{
+		if ((int)m_stamps.size() < numSlots)
+		{
+			m_costs.resize(numSlots);
+			m_parents.resize(numSlots);
+			m_stamps.assign(numSlots, 0);
+			m_stamp = 0;
+		}
+		++m_stamp;
+		if (m_stamp == 0)
+		{
+			std::fill(m_stamps.begin(), m_stamps.end(), 0);
+			m_stamp = 1;
+		}
+		m_openHeap.clear();
+	}
+
+	float GetCost(int slot) const
+	{
+		return (m_stamps[slot] == m_stamp) ? m_costs[slot] : TILE_PATH_UNREACHABLE_COST;
+	}
+
+	void SetCost(int slot, float cost, int parentSlot)
+	{
+		m_stamps[slot] = m_stamp;
+		m_costs[slot] = cost;
+		m_parents[slot] = parentSlot;
+	}
+
+	std::vector<float>				m_costs;
+	std::vector<int>				m_parents;
+	std::vector<uint32_t>			m_stamps;
+	uint32_t						m_stamp = 0;
+	std::vector<TilePathOpenEntry>	m_openHeap;
+
+	// for the searches inside one cluster
+	std::vector<float>				m_clusterTileCosts;
+	std::vector<TilePathOpenEntry>	m_clusterOpenHeap;
+	std::vector<float>				m_startNodeCosts;
+	std::vector<float>				m_goalNodeCosts;
+	std::vector<int>				m_portalPath;
+};
+
+TilePathfinder::SearchScratch& TilePathfinder::GetSearchScratchForThisThread()
+{
+	thread_local SearchScratch s_scratch;
+	return s_scratch;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+TilePathfinder::TilePathfinder(IntVec2 const& dimensions, int clusterSize)
+	: m_dimensions(dimensions)
+	, m_clusterSize(clusterSize)
+{
+	int numTiles = m_dimensions.x * m_dimensions.y;
+	m_blockedTileBits.assign((numTiles + 63) / 64, 0);
+	m_tileCosts.assign(numTiles, 1);
+
+	m_numClusters = IntVec2((m_dimensions.x + m_clusterSize - 1) / m_clusterSize, (m_dimensions.y + m_clusterSize - 1) / m_clusterSize);
+	int numClusters = m_numClusters.x * m_numClusters.y;
+	m_clusters.resize(numClusters);
+	for (int clusterY = 0; clusterY < m_numClusters.y; ++clusterY)
+	{
+		for (int clusterX = 0; clusterX < m_numClusters.x; ++clusterX)
+		{
+			Cluster& cluster = m_clusters[clusterX + clusterY * m_numClusters.x];
+			cluster.m_mins = IntVec2(clusterX * m_clusterSize, clusterY * m_clusterSize);
+			cluster.m_maxs = IntVec2(std::min(cluster.m_mins.x + m_clusterSize, m_dimensions.x) - 1, std::min(cluster.m_mins.y + m_clusterSize, m_dimensions.y) - 1);
+		}
+	}
+
+	// everything is built on the first rebuild
+	m_eastBorderPortals.resize(numClusters);
+	m_northBorderPortals.resize(numClusters);
+	m_isClusterDirty.assign(numClusters, 1);
+	m_isEastBorderDirty.assign(numClusters, 1);
+	m_isNorthBorderDirty.assign(numClusters, 1);
+	m_hasDirtyClusters = true;
+}
+
+void TilePathfinder::SetTileBlocked(IntVec2 tileCoords, bool isBlocked)
+{
+	int tileIndex = tileCoords.x + tileCoords.y * m_dimensions.x;
+	if (IsTileBlocked(tileIndex) == isBlocked)
+	{
+		return;
+	}
+	uint64_t tileBit = uint64_t(1) << (tileIndex & 63);
+	if (isBlocked)
+	{
+		m_blockedTileBits[tileIndex >> 6] |= tileBit;
+	}
+	else
+	{
+		m_blockedTileBits[tileIndex >> 6] &= ~tileBit;
+	}
+	MarkTileChanged(tileCoords);
+}
+
+void TilePathfinder::SetTileCost(IntVec2 tileCoords, int cost)
+{
+	int tileIndex = tileCoords.x + tileCoords.y * m_dimensions.x;
+	cost = (cost < 1) ? 1 : ((cost > 255) ? 255 : cost);
+	if (m_tileCosts[tileIndex] == (unsigned char)cost)
+	{
+		return;
+	}
+	m_tileCosts[tileIndex] = (unsigned char)cost;
+	MarkTileChanged(tileCoords);
+}
+
+bool TilePathfinder::IsTileBlocked(int tileIndex) const
+{
+	return (m_blockedTileBits[tileIndex >> 6] >> (tileIndex & 63)) & 1;
+}
+
+// the tile's cluster has to find the costs between its portals again, and the borders the tile lies on their portals
+void TilePathfinder::MarkTileChanged(IntVec2 tileCoords)
+{
+	int clusterX = tileCoords.x / m_clusterSize;
+	int clusterY = tileCoords.y / m_clusterSize;
+	int clusterIndex = clusterX + clusterY * m_numClusters.x;
+	Cluster const& cluster = m_clusters[clusterIndex];
+	m_isClusterDirty[clusterIndex] = 1;
+	if (tileCoords.x == cluster.m_mins.x && clusterX > 0)
+	{
+		m_isEastBorderDirty[clusterIndex - 1] = 1;
+	}
+	if (tileCoords.x == cluster.m_maxs.x && clusterX + 1 < m_numClusters.x)
+	{
+		m_isEastBorderDirty[clusterIndex] = 1;
+	}
+	if (tileCoords.y == cluster.m_mins.y && clusterY > 0)
+	{
+		m_isNorthBorderDirty[clusterIndex - m_numClusters.x] = 1;
+	}
+	if (tileCoords.y == cluster.m_maxs.y && clusterY + 1 < m_numClusters.y)
+	{
+		m_isNorthBorderDirty[clusterIndex] = 1;
+	}
+	m_hasDirtyClusters = true;
+}
+
+void TilePathfinder::RebuildDirtyClusters(JobSystem* jobSystem)
+{
+	if (!m_hasDirtyClusters)
+	{
+		return;
+	}
+
+	// a border's portals belong to the clusters on both sides of it, so both of those are rebuilt after it
+	std::vector<int> dirtyBorders; // east borders as their cluster index, north borders after them as numClusters + their cluster index
+	int numClusters = (int)m_clusters.size();
+	for (int clusterIndex = 0; clusterIndex < numClusters; ++clusterIndex)
+	{
+		int clusterX = clusterIndex % m_numClusters.x;
+		int clusterY = clusterIndex / m_numClusters.x;
+		if (m_isEastBorderDirty[clusterIndex])
+		{
+			m_isEastBorderDirty[clusterIndex] = 0;
+			if (clusterX + 1 < m_numClusters.x)
+			{
+				dirtyBorders.push_back(clusterIndex);
+				m_isClusterDirty[clusterIndex] = 1;
+				m_isClusterDirty[clusterIndex + 1] = 1;
+			}
+		}
+		if (m_isNorthBorderDirty[clusterIndex])
+		{
+			m_isNorthBorderDirty[clusterIndex] = 0;
+			if (clusterY + 1 < m_numClusters.y)
+			{
+				dirtyBorders.push_back(numClusters + clusterIndex);
+				m_isClusterDirty[clusterIndex] = 1;
+				m_isClusterDirty[clusterIndex + m_numClusters.x] = 1;
+			}
+		}
+	}
+	std::vector<int> dirtyClusters;
+	for (int clusterIndex = 0; clusterIndex < numClusters; ++clusterIndex)
+	{
+		if (m_isClusterDirty[clusterIndex])
+		{
+			m_isClusterDirty[clusterIndex] = 0;
+			dirtyClusters.push_back(clusterIndex);
+		}
+	}
+
+	// every border and every cluster only writes its own portals, so they could all be rebuilt at once
+	auto rebuildBorders = [this, &dirtyBorders, numClusters](int beginIndex, int endIndex)
+		{
+			for (int i = beginIndex; i < endIndex; ++i)
+			{
+				bool isEastBorder = dirtyBorders[i] < numClusters;
+				RebuildBorder(isEastBorder ? dirtyBorders[i] : dirtyBorders[i] - numClusters, isEastBorder);
+			}
+		};
+	auto rebuildClusters = [this, &dirtyClusters](int beginIndex, int endIndex)
+		{
+			for (int i = beginIndex; i < endIndex; ++i)
+			{
+				RebuildCluster(dirtyClusters[i]);
+			}
+		};
+	if (jobSystem)
+	{
+		jobSystem->ParallelFor(0, (int)dirtyBorders.size(), TILE_PATH_CLUSTERS_PER_JOB, rebuildBorders);
+		jobSystem->ParallelFor(0, (int)dirtyClusters.size(), TILE_PATH_CLUSTERS_PER_JOB, rebuildClusters);
+	}
+	else
+	{
+		rebuildBorders(0, (int)dirtyBorders.size());
+		rebuildClusters(0, (int)dirtyClusters.size());
+	}
+	m_hasDirtyClusters = false;
+}
+
+// every stretch of tiles open on both sides of the border gets a portal in its middle, or one at each end when it is long
+void TilePathfinder::RebuildBorder(int borderIndex, bool isEastBorder)
+{
+	Cluster const& cluster = m_clusters[borderIndex];
+	std::vector<BorderPortal>& portals = isEastBorder ? m_eastBorderPortals[borderIndex] : m_northBorderPortals[borderIndex];
+	portals.clear();
+
+	int firstAlongBorder = isEastBorder ? cluster.m_mins.y : cluster.m_mins.x;
+	int lastAlongBorder = isEastBorder ? cluster.m_maxs.y : cluster.m_maxs.x;
+	auto getPortal = [this, &cluster, isEastBorder](int alongBorder)
+		{
+			BorderPortal portal;
+			if (isEastBorder)
+			{
+				portal.m_tileIndexA = cluster.m_maxs.x + alongBorder * m_dimensions.x;
+				portal.m_tileIndexB = portal.m_tileIndexA + 1;
+			}
+			else
+			{
+				portal.m_tileIndexA = alongBorder + cluster.m_maxs.y * m_dimensions.x;
+				portal.m_tileIndexB = portal.m_tileIndexA + m_dimensions.x;
+			}
+			return portal;
+		};
+
+	int openingStart = -1;
+	for (int alongBorder = firstAlongBorder; alongBorder <= lastAlongBorder + 1; ++alongBorder)
+	{
+		bool isOpen = false;
+		if (alongBorder <= lastAlongBorder)
+		{
+			BorderPortal portal = getPortal(alongBorder);
+			isOpen = !IsTileBlocked(portal.m_tileIndexA) && !IsTileBlocked(portal.m_tileIndexB);
+		}
+		if (isOpen && openingStart < 0)
+		{
+			openingStart = alongBorder;
+		}
+		else if (!isOpen && openingStart >= 0)
+		{
+			int openingEnd = alongBorder - 1;
+			if (openingEnd - openingStart + 1 <= TILE_PATH_MAX_SINGLE_PORTAL_LENGTH)
+			{
+				portals.push_back(getPortal((openingStart + openingEnd) / 2));
+			}
+			else
+			{
+				portals.push_back(getPortal(openingStart));
+				portals.push_back(getPortal(openingEnd));
+			}
+			openingStart = -1;
+		}
+	}
+}
+
+void TilePathfinder::RebuildCluster(int clusterIndex)
+{
+	Cluster& cluster = m_clusters[clusterIndex];
+	cluster.m_nodeTileIndices.clear();
+	cluster.m_nodeExitTileIndices.clear();
+
+	auto addPortal = [this, &cluster](int nodeTileIndex, int exitTileIndex)
+		{
+			int nodeIndex = GetNodeIndexInCluster(cluster, nodeTileIndex);
+			if (nodeIndex < 0)
+			{
+				nodeIndex = (int)cluster.m_nodeTileIndices.size();
+				cluster.m_nodeTileIndices.push_back(nodeTileIndex);
+				cluster.m_nodeExitTileIndices.insert(cluster.m_nodeExitTileIndices.end(), 4, -1);
+			}
+			for (int exitSlot = 0; exitSlot < 4; ++exitSlot)
+			{
+				int& exitTileIndexInSlot = cluster.m_nodeExitTileIndices[nodeIndex * 4 + exitSlot];
+				if (exitTileIndexInSlot < 0)
+				{
+					exitTileIndexInSlot = exitTileIndex;
+					break;
+				}
+			}
+		};
+
+	int clusterX = clusterIndex % m_numClusters.x;
+	int clusterY = clusterIndex / m_numClusters.x;
+	if (clusterX > 0)
+	{
+		for (BorderPortal const& portal : m_eastBorderPortals[clusterIndex - 1])
+		{
+			addPortal(portal.m_tileIndexB, portal.m_tileIndexA);
+		}
+	}
+	if (clusterX + 1 < m_numClusters.x)
+	{
+		for (BorderPortal const& portal : m_eastBorderPortals[clusterIndex])
+		{
+			addPortal(portal.m_tileIndexA, portal.m_tileIndexB);
+		}
+	}
+	if (clusterY > 0)
+	{
+		for (BorderPortal const& portal : m_northBorderPortals[clusterIndex - m_numClusters.x])
+		{
+			addPortal(portal.m_tileIndexB, portal.m_tileIndexA);
+		}
+	}
+	if (clusterY + 1 < m_numClusters.y)
+	{
+		for (BorderPortal const& portal : m_northBorderPortals[clusterIndex])
+		{
+			addPortal(portal.m_tileIndexA, portal.m_tileIndexB);
+		}
+	}
+
+	// one Dijkstra inside the cluster from every portal gives its costs to all the others
+	int numNodes = (int)cluster.m_nodeTileIndices.size();
+	cluster.m_nodeCosts.assign(numNodes * numNodes, TILE_PATH_UNREACHABLE_COST);
+	SearchScratch& scratch = GetSearchScratchForThisThread();
+	int clusterWidth = cluster.m_maxs.x - cluster.m_mins.x + 1;
+	for (int fromNode = 0; fromNode < numNodes; ++fromNode)
+	{
+		FindCostsInCluster(cluster, cluster.m_nodeTileIndices[fromNode], false, scratch, scratch.m_clusterTileCosts);
+		for (int toNode = 0; toNode < numNodes; ++toNode)
+		{
+			int toTileIndex = cluster.m_nodeTileIndices[toNode];
+			int localIndex = (toTileIndex % m_dimensions.x - cluster.m_mins.x) + (toTileIndex / m_dimensions.x - cluster.m_mins.y) * clusterWidth;
+			cluster.m_nodeCosts[fromNode * numNodes + toNode] = scratch.m_clusterTileCosts[localIndex];
+		}
+	}
+}
+
+int TilePathfinder::GetNumPortalTiles() const
+{
+	int numPortalTiles = 0;
+	for (int clusterIndex = 0; clusterIndex < (int)m_clusters.size(); ++clusterIndex)
+	{
+		numPortalTiles += (int)m_clusters[clusterIndex].m_nodeTileIndices.size();
+	}
+	return numPortalTiles;
+}
+
+int TilePathfinder::GetClusterIndexForTile(int tileIndex) const
+{
+	int tileX = tileIndex % m_dimensions.x;
+	int tileY = tileIndex / m_dimensions.x;
+	return (tileX / m_clusterSize) + (tileY / m_clusterSize) * m_numClusters.x;
+}
+
+int TilePathfinder::GetNodeIndexInCluster(Cluster const& cluster, int tileIndex) const
+{
+	for (int nodeIndex = 0; nodeIndex < (int)cluster.m_nodeTileIndices.size(); ++nodeIndex)
+	{
+		if (cluster.m_nodeTileIndices[nodeIndex] == tileIndex)
+		{
+			return nodeIndex;
+		}
+	}
+	return -1;
+}
+
+void TilePathfinder::FindCostsInCluster(Cluster const& cluster, int sourceTileIndex, bool isReversed, SearchScratch& scratch, std::vector<float>& out_costs) const
+{
+	int clusterWidth = cluster.m_maxs.x - cluster.m_mins.x + 1;
+	int clusterHeight = cluster.m_maxs.y - cluster.m_mins.y + 1;
+	out_costs.assign(clusterWidth * clusterHeight, TILE_PATH_UNREACHABLE_COST);
+	std::vector<TilePathOpenEntry>& openHeap = scratch.m_clusterOpenHeap;
+	openHeap.clear();
+
+	int sourceLocalIndex = (sourceTileIndex % m_dimensions.x - cluster.m_mins.x) + (sourceTileIndex / m_dimensions.x - cluster.m_mins.y) * clusterWidth;
+	out_costs[sourceLocalIndex] = 0.f;
+	PushOpenEntry(openHeap, 0.f, 0.f, sourceLocalIndex);
+	while (!openHeap.empty())
+	{
+		TilePathOpenEntry entry = PopOpenEntry(openHeap);
+		if (entry.m_cost > out_costs[entry.m_index])
+		{
+			continue;
+		}
+		int localX = entry.m_index % clusterWidth;
+		int localY = entry.m_index / clusterWidth;
+		int tileIndex = (cluster.m_mins.x + localX) + (cluster.m_mins.y + localY) * m_dimensions.x;
+		int neighborLocalIndices[4] = { entry.m_index + 1, entry.m_index - 1, entry.m_index - clusterWidth, entry.m_index + clusterWidth };
+		int neighborTileIndices[4] = { tileIndex + 1, tileIndex - 1, tileIndex - m_dimensions.x, tileIndex + m_dimensions.x };
+		bool isNeighborInCluster[4] = { localX + 1 < clusterWidth, localX > 0, localY > 0, localY + 1 < clusterHeight };
+		for (int neighbor = 0; neighbor < 4; ++neighbor)
+		{
+			if (!isNeighborInCluster[neighbor] || IsTileBlocked(neighborTileIndices[neighbor]))
+			{
+				continue;
+			}
+			// reversed, the step goes from the neighbor onto this tile
+			float stepCost = (float)(isReversed ? m_tileCosts[tileIndex] : m_tileCosts[neighborTileIndices[neighbor]]);
+			float cost = entry.m_cost + stepCost;
+			if (cost < out_costs[neighborLocalIndices[neighbor]])
+			{
+				out_costs[neighborLocalIndices[neighbor]] = cost;
+				PushOpenEntry(openHeap, cost, cost, neighborLocalIndices[neighbor]);
+			}
+		}
+	}
+}
+
+float TilePathfinder::FindPathInBounds(int startTileIndex, int goalTileIndex, IntVec2 const& boundsMins, IntVec2 const& boundsMaxs, SearchScratch& scratch, std::vector<IntVec2>* out_path) const
+{
+	if (startTileIndex == goalTileIndex)
+	{
+		return 0.f;
+	}
+	scratch.BeginSearch(m_dimensions.x * m_dimensions.y + 2);
+	int goalX = goalTileIndex % m_dimensions.x;
+	int goalY = goalTileIndex / m_dimensions.x;
+	scratch.SetCost(startTileIndex, 0.f, -1);
+	PushOpenEntry(scratch.m_openHeap, 0.f, 0.f, startTileIndex);
+	while (!scratch.m_openHeap.empty())
+	{
+		TilePathOpenEntry entry = PopOpenEntry(scratch.m_openHeap);
+		if (entry.m_cost > scratch.GetCost(entry.m_index))
+		{
+			continue;
+		}
+		if (entry.m_index == goalTileIndex)
+		{
+			break;
+		}
+		int tileX = entry.m_index % m_dimensions.x;
+		int tileY = entry.m_index / m_dimensions.x;
+		int neighborTileIndices[4] = { entry.m_index + 1, entry.m_index - 1, entry.m_index - m_dimensions.x, entry.m_index + m_dimensions.x };
+		bool isNeighborInBounds[4] = { tileX + 1 <= boundsMaxs.x, tileX - 1 >= boundsMins.x, tileY - 1 >= boundsMins.y, tileY + 1 <= boundsMaxs.y };
+		for (int neighbor = 0; neighbor < 4; ++neighbor)
+		{
+			int neighborTileIndex = neighborTileIndices[neighbor];
+			if (!isNeighborInBounds[neighbor] || IsTileBlocked(neighborTileIndex))
+			{
+				continue;
+			}
+			float cost = entry.m_cost + (float)m_tileCosts[neighborTileIndex];
+			if (cost < scratch.GetCost(neighborTileIndex))
+			{
+				scratch.SetCost(neighborTileIndex, cost, entry.m_index);
+				int neighborX = neighborTileIndex % m_dimensions.x;
+				int neighborY = neighborTileIndex / m_dimensions.x;
+				float estimatedCostToGoal = (float)(abs(goalX - neighborX) + abs(goalY - neighborY)); // every step costs at least 1
+				PushOpenEntry(scratch.m_openHeap, cost + estimatedCostToGoal, cost, neighborTileIndex);
+			}
+		}
+	}
+
+	float goalCost = scratch.GetCost(goalTileIndex);
+	if (out_path && goalCost != TILE_PATH_UNREACHABLE_COST)
+	{
+		int firstAppended = (int)out_path->size();
+		for (int tileIndex = goalTileIndex; tileIndex != startTileIndex; tileIndex = scratch.m_parents[tileIndex])
+		{
+			out_path->push_back(IntVec2(tileIndex % m_dimensions.x, tileIndex / m_dimensions.x));
+		}
+		std::reverse(out_path->begin() + firstAppended, out_path->end());
+	}
+	return goalCost;
+}
+
+void TilePathfinder::FindPathThroughClusters(TilePathRequest const& request, SearchScratch& scratch, TilePathResponse& out_response) const
+{
+	int numTiles = m_dimensions.x * m_dimensions.y;
+	int startSlot = numTiles;
+	int goalSlot = numTiles + 1;
+	int startTileIndex = request.m_start.x + request.m_start.y * m_dimensions.x;
+	int goalTileIndex = request.m_goal.x + request.m_goal.y * m_dimensions.x;
+	int startClusterIndex = GetClusterIndexForTile(startTileIndex);
+	int goalClusterIndex = GetClusterIndexForTile(goalTileIndex);
+	Cluster const& startCluster = m_clusters[startClusterIndex];
+	Cluster const& goalCluster = m_clusters[goalClusterIndex];
+
+	// what it costs to get from the start to the portals of its cluster, and from the portals of the goal's cluster to the goal
+	int startClusterWidth = startCluster.m_maxs.x - startCluster.m_mins.x + 1;
+	FindCostsInCluster(startCluster, startTileIndex, false, scratch, scratch.m_clusterTileCosts);
+	float directCost = TILE_PATH_UNREACHABLE_COST;
+	if (startClusterIndex == goalClusterIndex)
+	{
+		directCost = scratch.m_clusterTileCosts[(request.m_goal.x - startCluster.m_mins.x) + (request.m_goal.y - startCluster.m_mins.y) * startClusterWidth];
+	}
+	bool isAnyStartNodeReached = false;
+	scratch.m_startNodeCosts.resize(startCluster.m_nodeTileIndices.size());
+	for (int nodeIndex = 0; nodeIndex < (int)startCluster.m_nodeTileIndices.size(); ++nodeIndex)
+	{
+		int nodeTileIndex = startCluster.m_nodeTileIndices[nodeIndex];
+		scratch.m_startNodeCosts[nodeIndex] = scratch.m_clusterTileCosts[(nodeTileIndex % m_dimensions.x - startCluster.m_mins.x) + (nodeTileIndex / m_dimensions.x - startCluster.m_mins.y) * startClusterWidth];
+		isAnyStartNodeReached |= (scratch.m_startNodeCosts[nodeIndex] != TILE_PATH_UNREACHABLE_COST);
+	}
+	int goalClusterWidth = goalCluster.m_maxs.x - goalCluster.m_mins.x + 1;
+	FindCostsInCluster(goalCluster, goalTileIndex, true, scratch, scratch.m_clusterTileCosts);
+	bool isAnyGoalNodeReached = false;
+	scratch.m_goalNodeCosts.resize(goalCluster.m_nodeTileIndices.size());
+	for (int nodeIndex = 0; nodeIndex < (int)goalCluster.m_nodeTileIndices.size(); ++nodeIndex)
+	{
+		int nodeTileIndex = goalCluster.m_nodeTileIndices[nodeIndex];
+		scratch.m_goalNodeCosts[nodeIndex] = scratch.m_clusterTileCosts[(nodeTileIndex % m_dimensions.x - goalCluster.m_mins.x) + (nodeTileIndex / m_dimensions.x - goalCluster.m_mins.y) * goalClusterWidth];
+		isAnyGoalNodeReached |= (scratch.m_goalNodeCosts[nodeIndex] != TILE_PATH_UNREACHABLE_COST);
+	}
+
+	// walled in inside its cluster, without this the portal search would go through everything it could reach before giving up
+	if (directCost == TILE_PATH_UNREACHABLE_COST && (!isAnyStartNodeReached || !isAnyGoalNodeReached))
+	{
+		return;
+	}
+
+	// A* from portal to portal, the start and the goal have slots of their own after the tiles
+	scratch.BeginSearch(numTiles + 2);
+	scratch.SetCost(startSlot, 0.f, -1);
+	auto reachSlot = [this, &scratch, &request, goalSlot](int slot, float cost, int parentSlot)
+		{
+			if (cost < scratch.GetCost(slot))
+			{
+				scratch.SetCost(slot, cost, parentSlot);
+				float estimatedCostToGoal = 0.f;
+				if (slot != goalSlot)
+				{
+					estimatedCostToGoal = (float)(abs(request.m_goal.x - slot % m_dimensions.x) + abs(request.m_goal.y - slot / m_dimensions.x));
+				}
+				PushOpenEntry(scratch.m_openHeap, cost + estimatedCostToGoal, cost, slot);
+			}
+		};
+	if (directCost != TILE_PATH_UNREACHABLE_COST)
+	{
+		reachSlot(goalSlot, directCost, startSlot);
+	}
+	for (int nodeIndex = 0; nodeIndex < (int)startCluster.m_nodeTileIndices.size(); ++nodeIndex)
+	{
+		if (scratch.m_startNodeCosts[nodeIndex] != TILE_PATH_UNREACHABLE_COST)
+		{
+			reachSlot(startCluster.m_nodeTileIndices[nodeIndex], scratch.m_startNodeCosts[nodeIndex], startSlot);
+		}
+	}
+	while (!scratch.m_openHeap.empty())
+	{
+		TilePathOpenEntry entry = PopOpenEntry(scratch.m_openHeap);
+		if (entry.m_cost > scratch.GetCost(entry.m_index))
+		{
+			continue;
+		}
+		if (entry.m_index == goalSlot)
+		{
+			break;
+		}
+		int clusterIndex = GetClusterIndexForTile(entry.m_index);
+		Cluster const& cluster = m_clusters[clusterIndex];
+		int nodeIndex = GetNodeIndexInCluster(cluster, entry.m_index);
+		int numNodes = (int)cluster.m_nodeTileIndices.size();
+		for (int toNode = 0; toNode < numNodes; ++toNode)
+		{
+			float costToNode = cluster.m_nodeCosts[nodeIndex * numNodes + toNode];
+			if (toNode != nodeIndex && costToNode != TILE_PATH_UNREACHABLE_COST)
+			{
+				reachSlot(cluster.m_nodeTileIndices[toNode], entry.m_cost + costToNode, entry.m_index);
+			}
+		}
+		for (int exitSlot = 0; exitSlot < 4; ++exitSlot)
+		{
+			int exitTileIndex = cluster.m_nodeExitTileIndices[nodeIndex * 4 + exitSlot];
+			if (exitTileIndex >= 0)
+			{
+				reachSlot(exitTileIndex, entry.m_cost + (float)m_tileCosts[exitTileIndex], entry.m_index);
+			}
+		}
+		if (clusterIndex == goalClusterIndex && scratch.m_goalNodeCosts[nodeIndex] != TILE_PATH_UNREACHABLE_COST)
+		{
+			reachSlot(goalSlot, entry.m_cost + scratch.m_goalNodeCosts[nodeIndex], entry.m_index);
+		}
+	}
+
+	float cost = scratch.GetCost(goalSlot);
+	if (cost == TILE_PATH_UNREACHABLE_COST)
+	{
+		return;
+	}
+
+	// the portals it goes through, then tile by tile between them: across a border it is a single step, inside a cluster A* within its bounds
+	std::vector<int>& portalPath = scratch.m_portalPath;
+	portalPath.clear();
+	for (int slot = goalSlot; slot >= 0; slot = scratch.m_parents[slot])
+	{
+		portalPath.push_back((slot == goalSlot) ? goalTileIndex : ((slot == startSlot) ? startTileIndex : slot));
+	}
+	std::reverse(portalPath.begin(), portalPath.end());
+
+	out_response.m_path.push_back(request.m_start);
+	for (int i = 0; i + 1 < (int)portalPath.size(); ++i)
+	{
+		int fromTileIndex = portalPath[i];
+		int toTileIndex = portalPath[i + 1];
+		int fromClusterIndex = GetClusterIndexForTile(fromTileIndex);
+		if (fromClusterIndex != GetClusterIndexForTile(toTileIndex))
+		{
+			out_response.m_path.push_back(IntVec2(toTileIndex % m_dimensions.x, toTileIndex / m_dimensions.x));
+		}
+		else
+		{
+			Cluster const& cluster = m_clusters[fromClusterIndex];
+			FindPathInBounds(fromTileIndex, toTileIndex, cluster.m_mins, cluster.m_maxs, scratch, &out_response.m_path);
+		}
+	}
+	out_response.m_cost = cost;
+	out_response.m_isFound = true;
+}
+
+void TilePathfinder::FindPath(TilePathRequest const& request, TilePathResponse& out_response) const
+{
+	out_response.m_isFound = false;
+	out_response.m_cost = TILE_PATH_UNREACHABLE_COST;
+	out_response.m_path.clear();
+
+	bool isStartInGrid = request.m_start.x >= 0 && request.m_start.x < m_dimensions.x && request.m_start.y >= 0 && request.m_start.y < m_dimensions.y;
+	bool isGoalInGrid = request.m_goal.x >= 0 && request.m_goal.x < m_dimensions.x && request.m_goal.y >= 0 && request.m_goal.y < m_dimensions.y;
+	if (!isStartInGrid || !isGoalInGrid)
+	{
+		return;
+	}
+	int startTileIndex = request.m_start.x + request.m_start.y * m_dimensions.x;
+	int goalTileIndex = request.m_goal.x + request.m_goal.y * m_dimensions.x;
+	if (startTileIndex == goalTileIndex)
+	{
+		out_response.m_path.push_back(request.m_start);
+		out_response.m_cost = 0.f;
+		out_response.m_isFound = true;
+		return;
+	}
+	if (IsTileBlocked(goalTileIndex))
+	{
+		return;
+	}
+
+	// the portals are no good while a cluster is dirty, so it falls back to the plain A* then
+	// so it does from a blocked start, which could step straight across a border where there is no portal
+	SearchScratch& scratch = GetSearchScratchForThisThread();
+	if (request.m_useClusters && !m_hasDirtyClusters && !IsTileBlocked(startTileIndex))
+	{
+		FindPathThroughClusters(request, scratch, out_response);
+		return;
+	}
+	out_response.m_path.push_back(request.m_start);
+	float cost = FindPathInBounds(startTileIndex, goalTileIndex, IntVec2(0, 0), m_dimensions - IntVec2(1, 1), scratch, &out_response.m_path);
+	if (cost == TILE_PATH_UNREACHABLE_COST)
+	{
+		out_response.m_path.clear();
+		return;
+	}
+	out_response.m_cost = cost;
+	out_response.m_isFound = true;
+}
+
+void TilePathfinder::FindPaths(TilePathRequest const* requests, int numRequests, TilePathResponse* out_responses, JobSystem* jobSystem) const
+{
+	if (!jobSystem)
+	{
+		for (int requestIndex = 0; requestIndex < numRequests; ++requestIndex)
+		{
+			FindPath(requests[requestIndex], out_responses[requestIndex]);
+		}
+		return;
+	}
+
+	jobSystem->ParallelFor(0, numRequests, TILE_PATH_REQUESTS_PER_JOB, [this, requests, out_responses](int beginIndex, int endIndex)
+		{
+			for (int requestIndex = beginIndex; requestIndex < endIndex; ++requestIndex)
+			{
+				FindPath(requests[requestIndex], out_responses[requestIndex]);
+			}
+		});
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+void TilePathJob::Execute()
+{
+	m_responses.resize(m_requests.size());
+	m_pathfinder->FindPaths(m_requests.data(), (int)m_requests.size(), m_responses.data());
+}
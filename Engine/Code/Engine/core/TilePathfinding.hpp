@@ -0,0 +1,123 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/core/JobSystem.hpp"
+#include <vector>
+#include <cstdint>
+
+constexpr float TILE_PATH_UNREACHABLE_COST = 1e30f;
+constexpr int	TILE_PATH_DEFAULT_CLUSTER_SIZE = 16;
+constexpr int	TILE_PATH_REQUESTS_PER_JOB = 16;
+constexpr int	TILE_PATH_CLUSTERS_PER_JOB = 32;
+constexpr int	TILE_PATH_MAX_SINGLE_PORTAL_LENGTH = 5; // an opening along a cluster border longer than this gets a portal at each end instead of one in the middle
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// pathfinding on a grid of tiles laid out like TileHeatMap, 4 neighbors, stepping onto a tile costs 1 unless SetTileCost says otherwise
+// plain A* over the whole grid finds the shortest path, the hierarchical search (HPA*) finds a path that is nearly as short a lot faster:
+// the grid is cut into square clusters, the openings along every cluster border get portal tiles, and the costs between the portals
+// of a cluster are cached, so a long route is searched portal to portal and only refined tile by tile inside the clusters it goes through
+// changing a tile only marks its cluster (and the borders it lies on) dirty, RebuildDirtyClusters redoes just those
+
+struct TilePathRequest
+{
+	IntVec2 m_start;
+	IntVec2 m_goal;
+	bool	m_useClusters = true; // false runs A* over the whole grid
+};
+
+struct TilePathResponse
+{
+	bool					m_isFound = false;
+	float					m_cost = TILE_PATH_UNREACHABLE_COST;
+	std::vector<IntVec2>	m_path; // from the start to the goal, both included
+};
+
+class TilePathfinder
+{
+public:
+	TilePathfinder(IntVec2 const& dimensions, int clusterSize = TILE_PATH_DEFAULT_CLUSTER_SIZE);
+	~TilePathfinder() {};
+
+public:
+	// changing the grid, nothing is searched again until RebuildDirtyClusters
+	void	SetTileBlocked(IntVec2 tileCoords, bool isBlocked);
+	void	SetTileCost(IntVec2 tileCoords, int cost); // 1 to 255
+	bool	IsTileBlocked(int tileIndex) const;
+	int		GetTileCost(int tileIndex) const { return m_tileCosts[tileIndex]; }
+
+	// finds the portals and the costs between them for every cluster touched since the last rebuild, every cluster the first time
+	// the clusters are split between the workers when there is a job system
+	void	RebuildDirtyClusters(JobSystem* jobSystem = nullptr);
+	bool	HasDirtyClusters() const { return m_hasDirtyClusters; }
+	int		GetNumPortalTiles() const;
+
+	// any number of queries could run at the same time on any threads, as long as the grid does not change and no cluster is dirty
+	// the start could be any tile, the goal has to be open, from a blocked start it is always the plain A*
+	void	FindPath(TilePathRequest const& request, TilePathResponse& out_response) const;
+
+	// out_responses[i] is for requests[i], ranges of TILE_PATH_REQUESTS_PER_JOB requests go to the workers when there is a job system,
+	// returns when every request is done
+	void	FindPaths(TilePathRequest const* requests, int numRequests, TilePathResponse* out_responses, JobSystem* jobSystem = nullptr) const;
+
+	IntVec2	m_dimensions;
+	int		m_clusterSize = TILE_PATH_DEFAULT_CLUSTER_SIZE;
+	IntVec2	m_numClusters;
+
+private:
+	// a pair of open tiles facing each other across a cluster border, the first one in the western or southern cluster
+	struct BorderPortal
+	{
+		int m_tileIndexA = 0;
+		int m_tileIndexB = 0;
+	};
+
+	struct Cluster
+	{
+		IntVec2				m_mins;
+		IntVec2				m_maxs; // inclusive
+		std::vector<int>	m_nodeTileIndices;		// its tiles that are portals, each once
+		std::vector<int>	m_nodeExitTileIndices;	// 4 per node, the tiles across the borders it leads to, -1 for none
+		std::vector<float>	m_nodeCosts;			// from node i to node j inside the cluster at [i * numNodes + j]
+	};
+
+	struct SearchScratch;
+	static SearchScratch& GetSearchScratchForThisThread(); // sized for the largest grid this thread has searched
+
+	int		GetClusterIndexForTile(int tileIndex) const;
+	int		GetNodeIndexInCluster(Cluster const& cluster, int tileIndex) const;
+	void	MarkTileChanged(IntVec2 tileCoords);
+	void	RebuildBorder(int borderIndex, bool isEastBorder);
+	void	RebuildCluster(int clusterIndex);
+
+	// Dijkstra inside the cluster from the tile, out_costs is per tile of the cluster, reversed gives the cost of getting to the tile instead
+	void	FindCostsInCluster(Cluster const& cluster, int sourceTileIndex, bool isReversed, SearchScratch& scratch, std::vector<float>& out_costs) const;
+
+	// A* between two tiles without leaving the bounds, appends the tiles after the start to out_path
+	float	FindPathInBounds(int startTileIndex, int goalTileIndex, IntVec2 const& boundsMins, IntVec2 const& boundsMaxs, SearchScratch& scratch, std::vector<IntVec2>* out_path) const;
+	void	FindPathThroughClusters(TilePathRequest const& request, SearchScratch& scratch, TilePathResponse& out_response) const;
+
+	std::vector<uint64_t>		m_blockedTileBits;	// bit (tileIndex & 63) of word (tileIndex >> 6)
+	std::vector<unsigned char>	m_tileCosts;
+
+	std::vector<Cluster>					m_clusters;
+	std::vector<std::vector<BorderPortal>>	m_eastBorderPortals;	// between a cluster and the one east of it, by the western cluster's index
+	std::vector<std::vector<BorderPortal>>	m_northBorderPortals;	// between a cluster and the one north of it, by the southern cluster's index
+	std::vector<unsigned char>				m_isClusterDirty;
+	std::vector<unsigned char>				m_isEastBorderDirty;
+	std::vector<unsigned char>				m_isNorthBorderDirty;
+	bool									m_hasDirtyClusters = true;
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// the requests as a job, for when the answers could come back a frame or more later
+// the pathfinder must not change until the job has completed
+class TilePathJob : public Job
+{
+public:
+	TilePathJob(TilePathfinder const* pathfinder, int jobType = JOB_TYPE_GENERIC) : Job(jobType), m_pathfinder(pathfinder) {}
+
+	virtual void Execute() override;
+
+	TilePathfinder const*			m_pathfinder = nullptr;
+	std::vector<TilePathRequest>	m_requests;
+	std::vector<TilePathResponse>	m_responses; // filled by Execute, one per request
+};
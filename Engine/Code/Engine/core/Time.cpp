@@ -32,3 +32,45 @@ double GetCurrentTimeSeconds()
 }
 
 
+//-----------------------------------------------------------------------------------------------
+// FILETIME counts in 100-nanosecond intervals
+static double GetCPUSecondsFromFileTimes( FILETIME const& kernelTime, FILETIME const& userTime )
+{
+	ULARGE_INTEGER kernelCount;
+	kernelCount.LowPart = kernelTime.dwLowDateTime;
+	kernelCount.HighPart = kernelTime.dwHighDateTime;
+	ULARGE_INTEGER userCount;
+	userCount.LowPart = userTime.dwLowDateTime;
+	userCount.HighPart = userTime.dwHighDateTime;
+	return static_cast< double >( kernelCount.QuadPart + userCount.QuadPart ) * 1e-7;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+double GetCurrentProcessCPUSeconds()
+{
+	FILETIME creationTime;
+	FILETIME exitTime;
+	FILETIME kernelTime;
+	FILETIME userTime;
+	if( !GetProcessTimes( GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime ) )
+	{
+		return 0.0;
+	}
+	return GetCPUSecondsFromFileTimes( kernelTime, userTime );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+double GetThreadCPUSeconds( void* nativeThreadHandle )
+{
+	FILETIME creationTime;
+	FILETIME exitTime;
+	FILETIME kernelTime;
+	FILETIME userTime;
+	if( !GetThreadTimes( static_cast< HANDLE >( nativeThreadHandle ), &creationTime, &exitTime, &kernelTime, &userTime ) )
+	{
+		return 0.0;
+	}
+	return GetCPUSecondsFromFileTimes( kernelTime, userTime );
+}
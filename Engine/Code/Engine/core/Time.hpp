@@ -6,5 +6,6 @@
 
 //-----------------------------------------------------------------------------------------------
 double GetCurrentTimeSeconds();
+double GetCurrentProcessCPUSeconds(); // user + kernel time spent by all threads of this process
+double GetThreadCPUSeconds( void* nativeThreadHandle ); // user + kernel time of one thread, e.g. std::thread::native_handle()
 
-	
\ No newline at end of file
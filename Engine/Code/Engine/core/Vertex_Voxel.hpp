@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+
+// 8 bytes for a vertex of a block world mesh, two words the game packs and its shader unpacks
+// the renderer only knows there are two uints, a_packedPosition : POSITION and a_packedTexture : TEXCOORD
+struct Vertex_Voxel
+{
+public:
+	Vertex_Voxel() = default;
+	Vertex_Voxel(uint32_t packedPosition, uint32_t packedTexture)
+		: m_packedPosition(packedPosition)
+		, m_packedTexture(packedTexture)
+	{}
+
+	uint32_t m_packedPosition = 0;
+	uint32_t m_packedTexture = 0;
+};
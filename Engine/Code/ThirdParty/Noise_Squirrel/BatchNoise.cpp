@@ -0,0 +1,255 @@
+//-----------------------------------------------------------------------------------------------
+// BatchNoise.cpp
+//
+#include "ThirdParty/Noise_Squirrel/BatchNoise.hpp"
+#include <smmintrin.h>						// SSE4.1, for _mm_mullo_epi32, _mm_floor_ps and _mm_blendv_ps
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+// Every lane helper below is the scalar function it is named after, written four wide.
+//	The grid functions walk the grid four samples at a time in row-major order, so a row that
+//	is not a multiple of four wide just continues into the next row; only the very last group
+//	can be partial, and its extra lanes are computed and thrown away.
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+//-----------------------------------------------------------------------------------------------
+// Get1dNoiseUint, four wide
+//
+static inline __m128i Get1dNoiseUint4( __m128i positionX, __m128i seed )
+{
+	const __m128i BIT_NOISE1 = _mm_set1_epi32( (int) 0xd2a80a23 );
+	const __m128i BIT_NOISE2 = _mm_set1_epi32( (int) 0xa884f197 );
+	const __m128i BIT_NOISE3 = _mm_set1_epi32( (int) 0x1b56c4e9 );
+
+	__m128i mangledBits = _mm_mullo_epi32( positionX, BIT_NOISE1 );
+	mangledBits = _mm_add_epi32( mangledBits, seed );
+	mangledBits = _mm_xor_si128( mangledBits, _mm_srli_epi32( mangledBits, 7 ) );
+	mangledBits = _mm_add_epi32( mangledBits, BIT_NOISE2 );
+	mangledBits = _mm_xor_si128( mangledBits, _mm_srli_epi32( mangledBits, 8 ) );
+	mangledBits = _mm_mullo_epi32( mangledBits, BIT_NOISE3 );
+	mangledBits = _mm_xor_si128( mangledBits, _mm_srli_epi32( mangledBits, 11 ) );
+	return mangledBits;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// Get2dNoiseUint, four wide
+//
+static inline __m128i Get2dNoiseUint4( __m128i indexX, __m128i indexY, __m128i seed )
+{
+	const __m128i PRIME_NUMBER = _mm_set1_epi32( 198491317 );
+	return Get1dNoiseUint4( _mm_add_epi32( indexX, _mm_mullo_epi32( PRIME_NUMBER, indexY ) ), seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// (float)( ONE_OVER_MAX_UINT * (double) noise ) for four unsigned ints, the same double math as Get2dNoiseZeroToOne
+//
+static inline __m128 UintToZeroToOne4( __m128i noise )
+{
+	const __m128d ONE_OVER_MAX_UINT = _mm_set1_pd( 1.0 / (double) 0xFFFFFFFF );
+	const __m128d TWO_TO_THE_32 = _mm_set1_pd( 4294967296.0 );
+	const __m128d ZERO = _mm_setzero_pd();
+
+	// the conversion is signed, the lanes with the top bit set come out 2^32 too low
+	__m128d lowHalf = _mm_cvtepi32_pd( noise );
+	__m128d highHalf = _mm_cvtepi32_pd( _mm_shuffle_epi32( noise, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+	lowHalf = _mm_add_pd( lowHalf, _mm_and_pd( _mm_cmplt_pd( lowHalf, ZERO ), TWO_TO_THE_32 ) );
+	highHalf = _mm_add_pd( highHalf, _mm_and_pd( _mm_cmplt_pd( highHalf, ZERO ), TWO_TO_THE_32 ) );
+
+	__m128 lowFloats = _mm_cvtpd_ps( _mm_mul_pd( ONE_OVER_MAX_UINT, lowHalf ) );
+	__m128 highFloats = _mm_cvtpd_ps( _mm_mul_pd( ONE_OVER_MAX_UINT, highHalf ) );
+	return _mm_movelh_ps( lowFloats, highFloats );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// SmoothStep3 as Easing.cpp has it, A * (1 - t) + B * t with A = t^3 and B = 1 - (1 - t)^3
+//
+static inline __m128 SmoothStep3_4( __m128 t )
+{
+	const __m128 ONE = _mm_set1_ps( 1.f );
+	__m128 easeIn = _mm_mul_ps( _mm_mul_ps( t, t ), t );
+	__m128 s = _mm_sub_ps( ONE, t );
+	__m128 easeOut = _mm_sub_ps( ONE, _mm_mul_ps( _mm_mul_ps( s, s ), s ) );
+	return _mm_add_ps( _mm_mul_ps( easeIn, _mm_sub_ps( ONE, t ) ), _mm_mul_ps( easeOut, t ) );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// The gradients table of Compute2dPerlinNoise without a lookup: for index i the components are
+//	+-0.923879533 or +-0.382683432, x takes the big one when bit 0 == bit 1 and y when they differ,
+//	x is negative for i in [2,5] and y for i in [4,7]
+//
+static inline void GetPerlinGradient4( __m128i noise, __m128& out_gradientX, __m128& out_gradientY )
+{
+	const __m128 BIG = _mm_set1_ps( 0.923879533f );
+	const __m128 SMALL = _mm_set1_ps( 0.382683432f );
+	const __m128i ONE = _mm_set1_epi32( 1 );
+	const __m128i TWO = _mm_set1_epi32( 2 );
+	const __m128i FOUR = _mm_set1_epi32( 4 );
+
+	__m128i bitsDiffer = _mm_and_si128( _mm_xor_si128( noise, _mm_srli_epi32( noise, 1 ) ), ONE );
+	__m128 yIsBig = _mm_castsi128_ps( _mm_cmpeq_epi32( bitsDiffer, ONE ) );
+	__m128 magnitudeX = _mm_blendv_ps( BIG, SMALL, yIsBig );
+	__m128 magnitudeY = _mm_blendv_ps( SMALL, BIG, yIsBig );
+
+	__m128i signX = _mm_slli_epi32( _mm_and_si128( _mm_add_epi32( noise, TWO ), FOUR ), 29 );
+	__m128i signY = _mm_slli_epi32( _mm_and_si128( noise, FOUR ), 29 );
+	out_gradientX = _mm_xor_ps( magnitudeX, _mm_castsi128_ps( signX ) );
+	out_gradientY = _mm_xor_ps( magnitudeY, _mm_castsi128_ps( signY ) );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// The integer positions of the next four samples of the grid, in row-major order
+//
+static inline void GetGridPositions4( int firstSample, int startX, int startY, int numX, __m128i& out_indexX, __m128i& out_indexY )
+{
+	alignas( 16 ) int indexX[ 4 ];
+	alignas( 16 ) int indexY[ 4 ];
+	for( int lane = 0; lane < 4; ++ lane )
+	{
+		int sample = firstSample + lane;
+		indexX[ lane ] = startX + (sample % numX);
+		indexY[ lane ] = startY + (sample / numX);
+	}
+	out_indexX = _mm_load_si128( (__m128i const*) indexX );
+	out_indexY = _mm_load_si128( (__m128i const*) indexY );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Get2dNoiseUintGrid( unsigned int* out_noise, int startX, int startY, int numX, int numY, unsigned int seed )
+{
+	int numSamples = numX * numY;
+	__m128i seed4 = _mm_set1_epi32( (int) seed );
+	for( int firstSample = 0; firstSample < numSamples; firstSample += 4 )
+	{
+		__m128i indexX, indexY;
+		GetGridPositions4( firstSample, startX, startY, numX, indexX, indexY );
+
+		alignas( 16 ) unsigned int noise[ 4 ];
+		_mm_store_si128( (__m128i*) noise, Get2dNoiseUint4( indexX, indexY, seed4 ) );
+		for( int lane = 0; lane < 4 && firstSample + lane < numSamples; ++ lane )
+		{
+			out_noise[ firstSample + lane ] = noise[ lane ];
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Get2dNoiseZeroToOneGrid( float* out_noise, int startX, int startY, int numX, int numY, unsigned int seed )
+{
+	int numSamples = numX * numY;
+	__m128i seed4 = _mm_set1_epi32( (int) seed );
+	for( int firstSample = 0; firstSample < numSamples; firstSample += 4 )
+	{
+		__m128i indexX, indexY;
+		GetGridPositions4( firstSample, startX, startY, numX, indexX, indexY );
+
+		alignas( 16 ) float noise[ 4 ];
+		_mm_store_ps( noise, UintToZeroToOne4( Get2dNoiseUint4( indexX, indexY, seed4 ) ) );
+		for( int lane = 0; lane < 4 && firstSample + lane < numSamples; ++ lane )
+		{
+			out_noise[ firstSample + lane ] = noise[ lane ];
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// Compute2dPerlinNoise, see SmoothNoise.cpp; the amplitudes and the seed are the same for every lane
+//
+void Compute2dPerlinNoiseGrid( float* out_noise, int startX, int startY, int numX, int numY, float scale, unsigned int numOctaves,
+	float octavePersistence, float octaveScale, bool renormalize, unsigned int seed )
+{
+	const float OCTAVE_OFFSET = 0.636764989593174f; // Translation/bias to add to each octave
+	const __m128 ONE = _mm_set1_ps( 1.f );
+	const __m128 PERLIN_RANGE_SCALE = _mm_set1_ps( 1.f / 0.662578106f );
+	const __m128 OCTAVE_OFFSET4 = _mm_set1_ps( OCTAVE_OFFSET );
+	const __m128 OCTAVE_SCALE4 = _mm_set1_ps( octaveScale );
+	const __m128 INV_SCALE4 = _mm_set1_ps( 1.f / scale );
+
+	int numSamples = numX * numY;
+	for( int firstSample = 0; firstSample < numSamples; firstSample += 4 )
+	{
+		__m128i sampleX, sampleY;
+		GetGridPositions4( firstSample, startX, startY, numX, sampleX, sampleY );
+
+		float totalAmplitude = 0.f;
+		float currentAmplitude = 1.f;
+		unsigned int octaveSeed = seed;
+		__m128 totalNoise = _mm_setzero_ps();
+		__m128 currentPosX = _mm_mul_ps( _mm_cvtepi32_ps( sampleX ), INV_SCALE4 );
+		__m128 currentPosY = _mm_mul_ps( _mm_cvtepi32_ps( sampleY ), INV_SCALE4 );
+
+		for( unsigned int octaveNum = 0; octaveNum < numOctaves; ++ octaveNum )
+		{
+			// Determine random unit "gradient vectors" for surrounding corners
+			__m128 cellMinsX = _mm_floor_ps( currentPosX );
+			__m128 cellMinsY = _mm_floor_ps( currentPosY );
+			__m128 cellMaxsX = _mm_add_ps( cellMinsX, ONE );
+			__m128 cellMaxsY = _mm_add_ps( cellMinsY, ONE );
+			__m128i indexWestX = _mm_cvttps_epi32( cellMinsX );
+			__m128i indexSouthY = _mm_cvttps_epi32( cellMinsY );
+			__m128i indexEastX = _mm_add_epi32( indexWestX, _mm_set1_epi32( 1 ) );
+			__m128i indexNorthY = _mm_add_epi32( indexSouthY, _mm_set1_epi32( 1 ) );
+
+			__m128i seed4 = _mm_set1_epi32( (int) octaveSeed );
+			__m128 gradientSWX, gradientSWY, gradientSEX, gradientSEY, gradientNWX, gradientNWY, gradientNEX, gradientNEY;
+			GetPerlinGradient4( Get2dNoiseUint4( indexWestX, indexSouthY, seed4 ), gradientSWX, gradientSWY );
+			GetPerlinGradient4( Get2dNoiseUint4( indexEastX, indexSouthY, seed4 ), gradientSEX, gradientSEY );
+			GetPerlinGradient4( Get2dNoiseUint4( indexWestX, indexNorthY, seed4 ), gradientNWX, gradientNWY );
+			GetPerlinGradient4( Get2dNoiseUint4( indexEastX, indexNorthY, seed4 ), gradientNEX, gradientNEY );
+
+			// Dot each corner's gradient with displacement from corner to position
+			__m128 displacementWestX = _mm_sub_ps( currentPosX, cellMinsX );
+			__m128 displacementEastX = _mm_sub_ps( currentPosX, cellMaxsX );
+			__m128 displacementSouthY = _mm_sub_ps( currentPosY, cellMinsY );
+			__m128 displacementNorthY = _mm_sub_ps( currentPosY, cellMaxsY );
+
+			__m128 dotSouthWest = _mm_add_ps( _mm_mul_ps( gradientSWX, displacementWestX ), _mm_mul_ps( gradientSWY, displacementSouthY ) );
+			__m128 dotSouthEast = _mm_add_ps( _mm_mul_ps( gradientSEX, displacementEastX ), _mm_mul_ps( gradientSEY, displacementSouthY ) );
+			__m128 dotNorthWest = _mm_add_ps( _mm_mul_ps( gradientNWX, displacementWestX ), _mm_mul_ps( gradientNWY, displacementNorthY ) );
+			__m128 dotNorthEast = _mm_add_ps( _mm_mul_ps( gradientNEX, displacementEastX ), _mm_mul_ps( gradientNEY, displacementNorthY ) );
+
+			// Do a smoothed (nonlinear) weighted average of dot results
+			__m128 weightEast = SmoothStep3_4( displacementWestX );
+			__m128 weightNorth = SmoothStep3_4( displacementSouthY );
+			__m128 weightWest = _mm_sub_ps( ONE, weightEast );
+			__m128 weightSouth = _mm_sub_ps( ONE, weightNorth );
+
+			__m128 blendSouth = _mm_add_ps( _mm_mul_ps( weightEast, dotSouthEast ), _mm_mul_ps( weightWest, dotSouthWest ) );
+			__m128 blendNorth = _mm_add_ps( _mm_mul_ps( weightEast, dotNorthEast ), _mm_mul_ps( weightWest, dotNorthWest ) );
+			__m128 blendTotal = _mm_add_ps( _mm_mul_ps( weightSouth, blendSouth ), _mm_mul_ps( weightNorth, blendNorth ) );
+			__m128 noiseThisOctave = _mm_mul_ps( blendTotal, PERLIN_RANGE_SCALE );
+
+			// Accumulate results and prepare for next octave (if any)
+			totalNoise = _mm_add_ps( totalNoise, _mm_mul_ps( noiseThisOctave, _mm_set1_ps( currentAmplitude ) ) );
+			totalAmplitude += currentAmplitude;
+			currentAmplitude *= octavePersistence;
+			currentPosX = _mm_add_ps( _mm_mul_ps( currentPosX, OCTAVE_SCALE4 ), OCTAVE_OFFSET4 );
+			currentPosY = _mm_add_ps( _mm_mul_ps( currentPosY, OCTAVE_SCALE4 ), OCTAVE_OFFSET4 );
+			++ octaveSeed;
+		}
+
+		// Re-normalize total noise to within [-1,1] and fix octaves pulling us far away from limits
+		if( renormalize && totalAmplitude > 0.f )
+		{
+			totalNoise = _mm_div_ps( totalNoise, _mm_set1_ps( totalAmplitude ) );
+			totalNoise = _mm_add_ps( _mm_mul_ps( totalNoise, _mm_set1_ps( 0.5f ) ), _mm_set1_ps( 0.5f ) );
+			totalNoise = SmoothStep3_4( totalNoise );
+			totalNoise = _mm_sub_ps( _mm_mul_ps( totalNoise, _mm_set1_ps( 2.f ) ), ONE );
+		}
+
+		alignas( 16 ) float noise[ 4 ];
+		_mm_store_ps( noise, totalNoise );
+		for( int lane = 0; lane < 4 && firstSample + lane < numSamples; ++ lane )
+		{
+			out_noise[ firstSample + lane ] = noise[ lane ];
+		}
+	}
+}
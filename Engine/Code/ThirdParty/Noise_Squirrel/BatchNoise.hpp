@@ -0,0 +1,31 @@
+//-----------------------------------------------------------------------------------------------
+// BatchNoise.hpp
+//
+#pragma once
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+// Batched versions of the SquirrelNoise4 raw noise and of Compute2dPerlinNoise
+//
+// These fill a whole grid of integer sample positions at once, four samples per SSE4.1 lane
+//	group, and give bit-identical results to calling the scalar function on every sample:
+//	every lane does the same float operations in the same order as RawNoise.hpp and
+//	SmoothNoise.cpp, only side by side (no FMA contraction, no reordering).
+//
+// The grids are row major, sample (x, y) of a numX by numY grid is at out[ y * numX + x ] and
+//	sits at the integer position (startX + x, startY + y).
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+//-----------------------------------------------------------------------------------------------
+// Same as Get2dNoiseUint / Get2dNoiseZeroToOne for every sample of the grid
+//
+void Get2dNoiseUintGrid( unsigned int* out_noise, int startX, int startY, int numX, int numY, unsigned int seed=0 );
+void Get2dNoiseZeroToOneGrid( float* out_noise, int startX, int startY, int numX, int numY, unsigned int seed=0 );
+
+
+//-----------------------------------------------------------------------------------------------
+// Same as Compute2dPerlinNoise( float(startX + x), float(startY + y), ... ) for every sample of the grid
+//
+void Compute2dPerlinNoiseGrid( float* out_noise, int startX, int startY, int numX, int numY, float scale=1.f, unsigned int numOctaves=1,
+	float octavePersistence=0.5f, float octaveScale=2.f, bool renormalize=true, unsigned int seed=0 );
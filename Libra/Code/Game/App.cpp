@@ -11,8 +11,11 @@
 #include "Engine/core/Image.hpp"
 #include "Engine/core/Timer.hpp"
 #include "Engine/core/Clock.hpp"
+#include "Engine/core/JobSystem.hpp"
+#include "Engine/core/TilePathfinding.hpp"
 #include "Game/Game.hpp"
 #include "Game/PlayerTank.hpp"
+#include "Game/Map.hpp"
 #include "Game/ShiningTriangle.hpp"
 #include <math.h>
 #include <iostream>
@@ -90,6 +93,11 @@ void App :: Startup ()
 	// testing the event system
 	g_gameConfigBlackboard.SetValue("playerHealth", "999");
 	g_theEventSystem->SubscribeEventCallbackFunction("playerInvincible", EventSystemTesting_SetPlayerInvincible); // todo: I could only assign standalone functions to event system?
+	g_theEventSystem->SubscribeEventCallbackFunction("DistanceFieldBenchmark", Command_DistanceFieldBenchmark);
+	g_theEventSystem->SubscribeEventCallbackFunction("FlowFieldStress", Command_FlowFieldStress);
+	g_theEventSystem->SubscribeEventCallbackFunction("PathfindingBenchmark", Command_PathfindingBenchmark);
+	g_theEventSystem->SubscribeEventCallbackFunction("MapGenerationBenchmark", Command_MapGenerationBenchmark);
+	g_theEventSystem->SubscribeEventCallbackFunction("BulletHellStress", Command_BulletHellStress);
 
 	// testing the development console
 	g_theDevConsole->AddLine("Testing", DevConsole::INFO_ERROR);
@@ -102,6 +110,434 @@ bool App::EventSystemTesting_SetPlayerInvincible(EventArgs& eventArgs)
 	return false;
 }
 
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// distance field benchmark
+// usage in dev console: "DistanceFieldBenchmark fields=2 scorpios=16"
+// makes a 256x256 and a 1024x1024 map from the first map definition, worms scaled up with the area and only scorpios on it,
+// then builds distance fields from random open tiles with the old sweep and with the bucket queue, water and scorpios solid like the entities ask for
+// the fields have to match exactly, on the 256x256 map also for the other three ways of treating water and scorpios,
+// and the bucket queue stopping at the exit tile has to give the same distance to it as the full field
+bool App::Command_DistanceFieldBenchmark(EventArgs& args)
+{
+	if (MapDefinition::s_mapDefs.empty())
+	{
+		g_theDevConsole->AddLine("DistanceFieldBenchmark needs the map definitions, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+	int numFields = args.GetValue("fields", 2);
+	int numScorpios = args.GetValue("scorpios", 16);
+	if (numFields < 1 || numScorpios < 0)
+	{
+		g_theDevConsole->AddLine("DistanceFieldBenchmark needs fields >= 1 and scorpios >= 0", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	constexpr float MAX_COST = 999999.f;
+	int const mapSizes[2] = { 256, 1024 };
+	bool passed = true;
+	for (int sizeIndex = 0; sizeIndex < 2; ++sizeIndex)
+	{
+		MapDefinition mapDef = MapDefinition::s_mapDefs[0];
+		int areaScale = (mapSizes[sizeIndex] * mapSizes[sizeIndex]) / (mapDef.mapSize.x * mapDef.mapSize.y);
+		mapDef.mapSize = IntVec2(mapSizes[sizeIndex], mapSizes[sizeIndex]);
+		mapDef.numWorm_1 *= areaScale;
+		mapDef.numWorm_2 *= areaScale;
+		for (int entityType = 0; entityType < NUM_ENTITY_TYPES; ++entityType)
+		{
+			mapDef.m_entitySpawnCounts[entityType] = 0;
+		}
+		mapDef.m_entitySpawnCounts[ENTITY_TYPE_EVIL_SCORPIO] = numScorpios;
+		Map* map = new Map(mapDef);
+		IntVec2 exitCoords(map->m_dimensions.x - 2, map->m_dimensions.y - 2);
+
+		TileHeatMap sweptField(map->m_dimensions);
+		TileHeatMap queuedField(map->m_dimensions);
+		double sweepSeconds = 0.0;
+		double queueSeconds = 0.0;
+		double queueToExitSeconds = 0.0;
+		int numDifferentFields = 0;
+		int numWrongExitDistances = 0;
+		for (int fieldIndex = 0; fieldIndex < numFields; ++fieldIndex)
+		{
+			IntVec2 startCoords = map->GetTileCoordsInMap_For_WorldPos(map->GetRandomNotSolidNotWaterTilePos());
+
+			double timeAtStart = GetCurrentTimeSeconds();
+			map->PopulateDistanceFieldBySweeping(sweptField, startCoords, MAX_COST, true, true);
+			sweepSeconds += GetCurrentTimeSeconds() - timeAtStart;
+
+			timeAtStart = GetCurrentTimeSeconds();
+			map->PopulateDistanceField(queuedField, startCoords, MAX_COST, true, true);
+			queueSeconds += GetCurrentTimeSeconds() - timeAtStart;
+
+			if (sweptField.m_values != queuedField.m_values)
+			{
+				++numDifferentFields;
+			}
+
+			timeAtStart = GetCurrentTimeSeconds();
+			map->SetUpDistanceFieldBlockedTiles(true, true);
+			float exitDistance = map->m_distanceFieldBuilder.PopulateDistanceField(queuedField, startCoords, MAX_COST, exitCoords);
+			queueToExitSeconds += GetCurrentTimeSeconds() - timeAtStart;
+			if (exitDistance != sweptField.GetHeatValueAt(exitCoords))
+			{
+				++numWrongExitDistances;
+			}
+		}
+
+		// the other ways of treating water and scorpios, only on the small map as the sweep takes a while
+		if (sizeIndex == 0)
+		{
+			IntVec2 startCoords = map->GetTileCoordsInMap_For_WorldPos(map->GetRandomNotSolidNotWaterTilePos());
+			for (int settings = 0; settings < 3; ++settings)
+			{
+				bool treatWaterAsSolid = (settings & 1) != 0;
+				bool treatScorpioAsSolid = (settings & 2) != 0;
+				map->PopulateDistanceFieldBySweeping(sweptField, startCoords, MAX_COST, treatWaterAsSolid, treatScorpioAsSolid);
+				map->PopulateDistanceField(queuedField, startCoords, MAX_COST, treatWaterAsSolid, treatScorpioAsSolid);
+				if (sweptField.m_values != queuedField.m_values)
+				{
+					++numDifferentFields;
+				}
+			}
+		}
+		delete map;
+
+		g_theDevConsole->AddLine(Stringf("DistanceFieldBenchmark: %ix%i map, %i fields", mapSizes[sizeIndex], mapSizes[sizeIndex], numFields), DevConsole::INFO_MAJOR);
+		g_theDevConsole->AddLine(Stringf("  sweep: %.3f ms/field, bucket queue: %.3f ms/field, %.1fx faster", sweepSeconds * 1000.0 / numFields,
+			queueSeconds * 1000.0 / numFields, sweepSeconds / queueSeconds), DevConsole::INFO_MINOR);
+		g_theDevConsole->AddLine(Stringf("  bucket queue stopping at the exit: %.3f ms/field", queueToExitSeconds * 1000.0 / numFields), DevConsole::INFO_MINOR);
+		g_theDevConsole->AddLine(Stringf("  %i fields different, %i exit distances wrong", numDifferentFields, numWrongExitDistances), DevConsole::INFO_MINOR);
+		passed = passed && (numDifferentFields == 0) && (numWrongExitDistances == 0);
+	}
+
+	g_theDevConsole->AddLine(Stringf("DistanceFieldBenchmark %s", passed ? "PASSED" : "FAILED"), passed ? DevConsole::INFO_MAJOR : DevConsole::INFO_ERROR);
+	return passed;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// flow field stress test
+// usage in dev console: "FlowFieldStress leos=200 aries=200 frames=300"
+// spawns the Leos and Aries on random open tiles of the current map, then times the updates of every Leo, Aries and Capricorn for the frames
+// and reports the AI milliseconds per frame, how many flow fields were built and how often they were shared,
+// and checks every step of every cached field leads one tile closer to its goal
+// "playerInvincible playerHealth = 999" keeps the player alive through it
+bool App::Command_FlowFieldStress(EventArgs& args)
+{
+	if (!g_theGame || !g_theGame->m_currentMap)
+	{
+		g_theDevConsole->AddLine("FlowFieldStress needs a map, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+	int numLeos = args.GetValue("leos", 200);
+	int numAries = args.GetValue("aries", 200);
+	int numFrames = args.GetValue("frames", 300);
+	if (numLeos < 0 || numAries < 0 || numFrames < 1)
+	{
+		g_theDevConsole->AddLine("FlowFieldStress needs leos >= 0, aries >= 0 and frames >= 1", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	Map* map = g_theGame->m_currentMap;
+	for (int i = 0; i < numLeos; ++i)
+	{
+		map->SpawnNewEntity(ENTITY_TYPE_EVIL_LEO, map->GetRandomNotSolidNotWaterTilePos(), g_rng->RollRandomFloatInRange(0.f, 360.f));
+	}
+	for (int i = 0; i < numAries; ++i)
+	{
+		map->SpawnNewEntity(ENTITY_TYPE_EVIL_ARIES, map->GetRandomNotSolidNotWaterTilePos(), g_rng->RollRandomFloatInRange(0.f, 360.f));
+	}
+	map->StartAIStressTest(numFrames);
+	g_theDevConsole->AddLine(Stringf("FlowFieldStress: spawned %i Leos and %i Aries, timing %i frames", numLeos, numAries, numFrames), DevConsole::INFO_MAJOR);
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// bullet hell stress test
+// usage in dev console: "BulletHellStress bullets=3000 actors=200 frames=300"
+// spawns the Leos and Aries on random open tiles of the current map and keeps that many bullets of both factions flying for the frames,
+// timing the pushes and bullet hits every other frame through the broadphase and every other frame the old brute force way
+// every frame both ways have to find the same colliding pairs
+// "playerInvincible playerHealth = 999" keeps the player alive through it
+bool App::Command_BulletHellStress(EventArgs& args)
+{
+	if (!g_theGame || !g_theGame->m_currentMap)
+	{
+		g_theDevConsole->AddLine("BulletHellStress needs a map, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+	int numBullets = args.GetValue("bullets", 3000);
+	int numActors = args.GetValue("actors", 200);
+	int numFrames = args.GetValue("frames", 300);
+	if (numBullets < 0 || numActors < 0 || numFrames < 2)
+	{
+		g_theDevConsole->AddLine("BulletHellStress needs bullets >= 0, actors >= 0 and frames >= 2", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	Map* map = g_theGame->m_currentMap;
+	for (int i = 0; i < numActors; ++i)
+	{
+		EntityType actorType = (i % 2 == 0) ? ENTITY_TYPE_EVIL_LEO : ENTITY_TYPE_EVIL_ARIES;
+		map->SpawnNewEntity(actorType, map->GetRandomNotSolidNotWaterTilePos(), g_rng->RollRandomFloatInRange(0.f, 360.f));
+	}
+	map->StartCollisionStressTest(numBullets, numFrames);
+	g_theDevConsole->AddLine(Stringf("BulletHellStress: spawned %i actors, keeping %i bullets flying for %i frames", numActors, numBullets, numFrames), DevConsole::INFO_MAJOR);
+	return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// pathfinding benchmark
+// usage in dev console: "PathfindingBenchmark queries=500"
+// makes a 1024x1024 map from the first map definition like DistanceFieldBenchmark, solid and water tiles blocked, and paths between random open tiles
+// with plain A*, with the clusters on this thread and with the clusters on the workers of a job system, reporting queries per second
+// the clusters have to find a path exactly when A* does, never shorter than A*'s and every one a walk over open tiles, the same on the workers,
+// and after changing some tiles the incremental rebuild has to give the same paths as building everything again
+bool App::Command_PathfindingBenchmark(EventArgs& args)
+{
+	if (MapDefinition::s_mapDefs.empty())
+	{
+		g_theDevConsole->AddLine("PathfindingBenchmark needs the map definitions, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+	int numQueries = args.GetValue("queries", 500);
+	if (numQueries < 1)
+	{
+		g_theDevConsole->AddLine("PathfindingBenchmark needs queries >= 1", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	constexpr int MAP_SIZE = 1024;
+	constexpr int NUM_CHANGED_TILES = 64;
+	MapDefinition mapDef = MapDefinition::s_mapDefs[0];
+	int areaScale = (MAP_SIZE * MAP_SIZE) / (mapDef.mapSize.x * mapDef.mapSize.y);
+	mapDef.mapSize = IntVec2(MAP_SIZE, MAP_SIZE);
+	mapDef.numWorm_1 *= areaScale;
+	mapDef.numWorm_2 *= areaScale;
+	for (int entityType = 0; entityType < NUM_ENTITY_TYPES; ++entityType)
+	{
+		mapDef.m_entitySpawnCounts[entityType] = 0;
+	}
+	Map* map = new Map(mapDef);
+
+	TilePathfinder* pathfinder = new TilePathfinder(map->m_dimensions);
+	for (int tileY = 0; tileY < map->m_dimensions.y; ++tileY)
+	{
+		for (int tileX = 0; tileX < map->m_dimensions.x; ++tileX)
+		{
+			IntVec2 tileCoords(tileX, tileY);
+			pathfinder->SetTileBlocked(tileCoords, map->IsTileSolid(tileCoords) || map->IsTileWater(tileCoords));
+		}
+	}
+	double timeAtStart = GetCurrentTimeSeconds();
+	pathfinder->RebuildDirtyClusters();
+	double buildSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	std::vector<TilePathRequest> requests(numQueries);
+	for (int queryIndex = 0; queryIndex < numQueries; ++queryIndex)
+	{
+		requests[queryIndex].m_start = map->GetTileCoordsInMap_For_WorldPos(map->GetRandomNotSolidNotWaterTilePos());
+		requests[queryIndex].m_goal = map->GetTileCoordsInMap_For_WorldPos(map->GetRandomNotSolidNotWaterTilePos());
+		requests[queryIndex].m_useClusters = false;
+	}
+	std::vector<TilePathResponse> plainResponses(numQueries);
+	std::vector<TilePathResponse> clusterResponses(numQueries);
+	std::vector<TilePathResponse> workerResponses(numQueries);
+
+	timeAtStart = GetCurrentTimeSeconds();
+	pathfinder->FindPaths(requests.data(), numQueries, plainResponses.data());
+	double plainSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	for (int queryIndex = 0; queryIndex < numQueries; ++queryIndex)
+	{
+		requests[queryIndex].m_useClusters = true;
+	}
+	timeAtStart = GetCurrentTimeSeconds();
+	pathfinder->FindPaths(requests.data(), numQueries, clusterResponses.data());
+	double clusterSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	JobSystemConfig jobSystemConfig;
+	JobSystem* jobSystem = new JobSystem(jobSystemConfig);
+	jobSystem->Startup();
+	timeAtStart = GetCurrentTimeSeconds();
+	pathfinder->FindPaths(requests.data(), numQueries, workerResponses.data(), jobSystem);
+	double workerSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	// a path is good when it goes from the start to the goal one open tile at a time and its tiles add up to its cost
+	auto isPathGood = [pathfinder](TilePathRequest const& request, TilePathResponse const& response)
+		{
+			if (!response.m_isFound)
+			{
+				return response.m_path.empty();
+			}
+			if (response.m_path.empty() || response.m_path.front() != request.m_start || response.m_path.back() != request.m_goal)
+			{
+				return false;
+			}
+			float cost = 0.f;
+			for (int pathIndex = 1; pathIndex < (int)response.m_path.size(); ++pathIndex)
+			{
+				IntVec2 step = response.m_path[pathIndex] - response.m_path[pathIndex - 1];
+				int tileIndex = response.m_path[pathIndex].x + response.m_path[pathIndex].y * pathfinder->m_dimensions.x;
+				if (abs(step.x) + abs(step.y) != 1 || pathfinder->IsTileBlocked(tileIndex))
+				{
+					return false;
+				}
+				cost += (float)pathfinder->GetTileCost(tileIndex);
+			}
+			return cost == response.m_cost;
+		};
+	int numBadPaths = 0;
+	int numFound = 0;
+	double clusterCostRatioSum = 0.0;
+	for (int queryIndex = 0; queryIndex < numQueries; ++queryIndex)
+	{
+		TilePathResponse const& plainResponse = plainResponses[queryIndex];
+		TilePathResponse const& clusterResponse = clusterResponses[queryIndex];
+		bool isGood = isPathGood(requests[queryIndex], plainResponse) && isPathGood(requests[queryIndex], clusterResponse);
+		isGood = isGood && (clusterResponse.m_isFound == plainResponse.m_isFound) && (clusterResponse.m_cost >= plainResponse.m_cost);
+		isGood = isGood && (workerResponses[queryIndex].m_path == clusterResponse.m_path);
+		if (!isGood)
+		{
+			++numBadPaths;
+		}
+		if (plainResponse.m_isFound && plainResponse.m_cost > 0.f)
+		{
+			++numFound;
+			clusterCostRatioSum += clusterResponse.m_cost / plainResponse.m_cost;
+		}
+	}
+
+	// flip some tiles, rebuild only what they touched on the workers and compare with a pathfinder built from scratch
+	for (int changeIndex = 0; changeIndex < NUM_CHANGED_TILES; ++changeIndex)
+	{
+		IntVec2 tileCoords = map->GetTileCoordsInMap_For_WorldPos(map->GetRandomNotSolidNotWaterTilePos());
+		pathfinder->SetTileBlocked(tileCoords, true);
+	}
+	timeAtStart = GetCurrentTimeSeconds();
+	pathfinder->RebuildDirtyClusters(jobSystem);
+	double rebuildSeconds = GetCurrentTimeSeconds() - timeAtStart;
+	TilePathfinder* freshPathfinder = new TilePathfinder(map->m_dimensions);
+	for (int tileIndex = 0; tileIndex < map->m_dimensions.x * map->m_dimensions.y; ++tileIndex)
+	{
+		freshPathfinder->SetTileBlocked(IntVec2(tileIndex % map->m_dimensions.x, tileIndex / map->m_dimensions.x), pathfinder->IsTileBlocked(tileIndex));
+	}
+	freshPathfinder->RebuildDirtyClusters(jobSystem);
+	pathfinder->FindPaths(requests.data(), numQueries, clusterResponses.data(), jobSystem);
+	freshPathfinder->FindPaths(requests.data(), numQueries, workerResponses.data(), jobSystem);
+	int numDifferentAfterRebuild = (pathfinder->GetNumPortalTiles() == freshPathfinder->GetNumPortalTiles()) ? 0 : 1;
+	for (int queryIndex = 0; queryIndex < numQueries; ++queryIndex)
+	{
+		if (clusterResponses[queryIndex].m_path != workerResponses[queryIndex].m_path)
+		{
+			++numDifferentAfterRebuild;
+		}
+	}
+
+	jobSystem->ShutDown();
+	delete jobSystem;
+	delete freshPathfinder;
+	delete pathfinder;
+	delete map;
+
+	g_theDevConsole->AddLine(Stringf("PathfindingBenchmark: %ix%i map, %i queries, %i found", MAP_SIZE, MAP_SIZE, numQueries, numFound), DevConsole::INFO_MAJOR);
+	g_theDevConsole->AddLine(Stringf("  clusters built in %.1f ms, rebuilt after %i tiles changed in %.2f ms", buildSeconds * 1000.0, NUM_CHANGED_TILES, rebuildSeconds * 1000.0), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  A*: %.0f queries/s, clusters: %.0f queries/s, clusters on the workers: %.0f queries/s", numQueries / plainSeconds,
+		numQueries / clusterSeconds, numQueries / workerSeconds), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  cluster paths %.2f%% longer on average", numFound > 0 ? (clusterCostRatioSum / numFound - 1.0) * 100.0 : 0.0), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  %i bad paths, %i paths different after the rebuild", numBadPaths, numDifferentAfterRebuild), DevConsole::INFO_MINOR);
+	bool passed = (numBadPaths == 0) && (numDifferentAfterRebuild == 0);
+	g_theDevConsole->AddLine(Stringf("PathfindingBenchmark %s", passed ? "PASSED" : "FAILED"), passed ? DevConsole::INFO_MAJOR : DevConsole::INFO_ERROR);
+	return passed;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// map generation benchmark
+// usage in dev console: "MapGenerationBenchmark maps=100 size=256"
+// generates the maps of every map definition at the size, worms scaled with the area, once per seed, with the worms undone until the exit is
+// connected and with the old regenerating until the exit is reachable, and reports the milliseconds per map and how many times maps were thrown away
+// every generated map has to have the exit reachable from the entry
+bool App::Command_MapGenerationBenchmark(EventArgs& args)
+{
+	if (MapDefinition::s_mapDefs.empty())
+	{
+		g_theDevConsole->AddLine("MapGenerationBenchmark needs the map definitions, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+	int numMaps = args.GetValue("maps", 100);
+	int mapSize = args.GetValue("size", 256);
+	if (numMaps < 1 || mapSize < 13)
+	{
+		g_theDevConsole->AddLine("MapGenerationBenchmark needs maps >= 1 and size >= 13", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	constexpr int NUM_RETRY_BUCKETS = 5; // 0, 1, 2, 3 and 4 or more maps thrown away
+	unsigned int seedBefore = g_rng->m_seed;
+	int positionBefore = g_rng->m_position;
+	bool passed = true;
+	for (int mapDefIndex = 0; mapDefIndex < (int)MapDefinition::s_mapDefs.size(); ++mapDefIndex)
+	{
+		MapDefinition mapDef = MapDefinition::s_mapDefs[mapDefIndex];
+		float areaScale = (float)(mapSize * mapSize) / (float)(mapDef.mapSize.x * mapDef.mapSize.y);
+		mapDef.mapSize = IntVec2(mapSize, mapSize);
+		mapDef.numWorm_1 = (int)((float)mapDef.numWorm_1 * areaScale);
+		mapDef.numWorm_2 = (int)((float)mapDef.numWorm_2 * areaScale);
+		for (int entityType = 0; entityType < NUM_ENTITY_TYPES; ++entityType)
+		{
+			mapDef.m_entitySpawnCounts[entityType] = 0;
+		}
+
+		double undoSeconds = 0.0;
+		double regenerateSeconds = 0.0;
+		double worstUndoSeconds = 0.0;
+		double worstRegenerateSeconds = 0.0;
+		int undoRetryCounts[NUM_RETRY_BUCKETS] = {};
+		int regenerateRetryCounts[NUM_RETRY_BUCKETS] = {};
+		int numWormStepsUndone = 0;
+		int numUnsolvableMaps = 0;
+		for (int seed = 0; seed < numMaps; ++seed)
+		{
+			g_rng->SetSeed((unsigned int)seed);
+			double timeAtStart = GetCurrentTimeSeconds();
+			Map* map = new Map(mapDef);
+			double seconds = GetCurrentTimeSeconds() - timeAtStart;
+			undoSeconds += seconds;
+			worstUndoSeconds = (seconds > worstUndoSeconds) ? seconds : worstUndoSeconds;
+			++undoRetryCounts[(map->m_numMapRegenerations < NUM_RETRY_BUCKETS - 1) ? map->m_numMapRegenerations : NUM_RETRY_BUCKETS - 1];
+			numWormStepsUndone += map->m_numWormStepsUndone;
+			if (map->m_exitDistanceField->GetHeatValueAt(map->m_dimensions - IntVec2(2, 2)) == 999999.f)
+			{
+				++numUnsolvableMaps;
+			}
+
+			g_rng->SetSeed((unsigned int)seed);
+			timeAtStart = GetCurrentTimeSeconds();
+			int numRegeneratedMaps = map->GenerateTilesByRegenerating() - 1;
+			seconds = GetCurrentTimeSeconds() - timeAtStart;
+			regenerateSeconds += seconds;
+			worstRegenerateSeconds = (seconds > worstRegenerateSeconds) ? seconds : worstRegenerateSeconds;
+			++regenerateRetryCounts[(numRegeneratedMaps < NUM_RETRY_BUCKETS - 1) ? numRegeneratedMaps : NUM_RETRY_BUCKETS - 1];
+			delete map;
+		}
+
+		g_theDevConsole->AddLine(Stringf("MapGenerationBenchmark: %s at %ix%i, %i seeds", mapDef.m_name.c_str(), mapSize, mapSize, numMaps), DevConsole::INFO_MAJOR);
+		g_theDevConsole->AddLine(Stringf("  undoing worms: %.2f ms/map, worst %.2f ms, %.1f worm steps undone per map", undoSeconds * 1000.0 / numMaps,
+			worstUndoSeconds * 1000.0, (float)numWormStepsUndone / (float)numMaps), DevConsole::INFO_MINOR);
+		g_theDevConsole->AddLine(Stringf("    maps thrown away 0: %i, 1: %i, 2: %i, 3: %i, 4+: %i", undoRetryCounts[0], undoRetryCounts[1], undoRetryCounts[2],
+			undoRetryCounts[3], undoRetryCounts[4]), DevConsole::INFO_MINOR);
+		g_theDevConsole->AddLine(Stringf("  regenerating: %.2f ms/map, worst %.2f ms", regenerateSeconds * 1000.0 / numMaps, worstRegenerateSeconds * 1000.0), DevConsole::INFO_MINOR);
+		g_theDevConsole->AddLine(Stringf("    maps thrown away 0: %i, 1: %i, 2: %i, 3: %i, 4+: %i", regenerateRetryCounts[0], regenerateRetryCounts[1], regenerateRetryCounts[2],
+			regenerateRetryCounts[3], regenerateRetryCounts[4]), DevConsole::INFO_MINOR);
+		g_theDevConsole->AddLine(Stringf("  %i maps without a way to the exit", numUnsolvableMaps), DevConsole::INFO_MINOR);
+		passed = passed && (numUnsolvableMaps == 0);
+	}
+	g_rng->m_seed = seedBefore;
+	g_rng->m_position = positionBefore;
+
+	g_theDevConsole->AddLine(Stringf("MapGenerationBenchmark %s", passed ? "PASSED" : "FAILED"), passed ? DevConsole::INFO_MAJOR : DevConsole::INFO_ERROR);
+	return passed;
+}
+
 void App::Shutdown()
 {
 	g_theGame->Shutdown();
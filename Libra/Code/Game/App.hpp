@@ -85,6 +85,11 @@ public:
 	bool IsQuitting() const;
 	bool HandleQuitRequested();
 	static bool EventSystemTesting_SetPlayerInvincible(EventArgs& eventArgs); // currently the event system need the member function to be static
+	static bool Command_DistanceFieldBenchmark(EventArgs& args);
+	static bool Command_FlowFieldStress(EventArgs& args);
+	static bool Command_PathfindingBenchmark(EventArgs& args);
+	static bool Command_MapGenerationBenchmark(EventArgs& args);
+	static bool Command_BulletHellStress(EventArgs& args);
 
 	void ManageAudio();
 	// todo: create function switch music: stop current music and start another one
@@ -100,12 +100,12 @@ void Aries::UpdateAction(float deltaSeconds)
 
 void Aries::WanderOnMap(float deltaSeconds)
 {
-	GenerateHeatMapAndWander(30.f, 0.2f, deltaSeconds);
+	FollowFlowFieldAndWander(30.f, 0.2f, deltaSeconds);
 }
 
 void Aries::ChasingPlayer(float deltaSeconds)
 {
-	GenerateHeatMapAndChasePlayer(30.f, 0.2f, deltaSeconds);
+	FollowFlowFieldAndChasePlayer(30.f, 0.2f, deltaSeconds);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -45,9 +45,6 @@ Capricorn::Capricorn(Map* owner, EntityType type, EntityFaction faction, Vec2 co
 	m_canSwim = g_gameConfigBlackboard.GetValue("capricornCanSwim", false);
 
 	AddVertsForRender();
-
-	// generate a heat map to see if the exit tile heat value could be modified
-	m_heatMap = new TileHeatMap(m_map->m_dimensions);
 }
 
 Capricorn::~Capricorn()
@@ -115,12 +112,12 @@ void Capricorn::UpdateAction(float deltaSeconds)
 
 void Capricorn::ChasingPlayer(float deltaSeconds)
 {
-	GenerateHeatMapAndChasePlayer(45.f, 0.5f, deltaSeconds);
+	FollowFlowFieldAndChasePlayer(45.f, 0.5f, deltaSeconds);
 }
 
 void Capricorn::WanderOnMap(float deltaSeconds)
 {
-	GenerateHeatMapAndWander( 45.f, 0.5f, deltaSeconds);
+	FollowFlowFieldAndWander( 45.f, 0.5f, deltaSeconds);
 }
 
 /// <Render>
@@ -18,11 +18,14 @@ extern RandomNumberGenerator* g_rng;
 Entity::Entity(Map* owner, EntityType entityType, EntityFaction faction, Vec2 const& startPos, float orientationDegrees)
 	:m_map(owner), m_entityType(entityType), m_entityFaction(faction), m_position(startPos), m_orientationDegrees(orientationDegrees)
 {
-	m_heatMap = new TileHeatMap(m_map->m_dimensions);
 }
 
 Entity::~Entity()
 {
+	if (m_flowField)
+	{
+		m_map->m_flowFieldCache.ReleaseFlowField(m_flowField);
+	}
 }
 
 //void Entity::TakeDamage()
@@ -181,86 +184,40 @@ void Entity::DrawEnemyChasingDirection_ForDebug() const
 	DrawDisk(headingPos, 0.05f, Rgba8::BLACK, Rgba8::BLACK);
 }
 
-void Entity::GenerateHeatMapForWandering()
+// entities heading to the same tile share the field, a new goal starts a new short term goal too
+void Entity::SetFlowFieldGoal(IntVec2 goalCoords)
 {
-	IntVec2 startCoords = m_map->GetTileCoordsInMap_For_WorldPos(m_position);
-	bool treatWaterAsSolid = true;
-	if (m_canSwim)
+	if (m_flowField && m_flowField->m_goalCoords == goalCoords)
 	{
-		treatWaterAsSolid = false;
+		return;
 	}
-	m_map->PopulateDistanceField(*m_heatMap, startCoords, 999999.f, treatWaterAsSolid, true);
-}
-
-void Entity::GenerateHeatMapForWanderingWayPoint( IntVec2 startCoords )
-{
-	bool treatWaterAsSolid = true;
-	if (m_canSwim)
+	if (m_flowField)
 	{
-		treatWaterAsSolid = false;
+		m_map->m_flowFieldCache.ReleaseFlowField(m_flowField);
 	}
-	m_map->PopulateDistanceField(*m_heatMap, startCoords, 999999.f, treatWaterAsSolid, true);
+	m_flowField = m_map->m_flowFieldCache.AcquireFlowField(goalCoords, !m_canSwim);
+	m_shortTermGoalHasReached = true;
 }
 
-void Entity::GenerateHeatMapFromPlayerSeenLocation()
-{
-	bool treatWaterAsSolid = true;
-	if (m_canSwim)
-	{
-		treatWaterAsSolid = false;
-	}
-	IntVec2 playerTileCoords = m_map->GetTileCoordsInMap_For_WorldPos(m_map->m_entityPtrListByType[ENTITY_TYPE_GOOD_PLAYER][0]->m_position);
-	m_map->PopulateDistanceField(*m_heatMap, playerTileCoords, 999999.f, treatWaterAsSolid, true);
-}
-
-void Entity::GenerateHeatMapAndWander(float speedUpDegreeRange, float lowerSpeedMultiplier, float deltaSeconds )
+void Entity::FollowFlowFieldAndWander(float speedUpDegreeRange, float lowerSpeedMultiplier, float deltaSeconds )
 {
 	if (m_wayPointHasReached)
 	{
-		// if has not reach previous way point, randomly pick a way point on the map that this entity is able to get to //this is the long term goal
-		GenerateHeatMapForWandering();
-		for (;;)
-		{
-			m_nextWayPointTileCoords.x = g_rng->RollRandomIntInRange(1, (m_map->m_dimensions.x - 2));
-			m_nextWayPointTileCoords.y = g_rng->RollRandomIntInRange(1, (m_map->m_dimensions.y - 2));
-
-			int tileIndex = m_map->GetTileIndex_For_TileCoordinates(m_nextWayPointTileCoords);
-			if (m_heatMap->m_values[tileIndex] == 999999.f)
-			{
-				continue;
-			}
-			else
-			{
-				GenerateHeatMapForWanderingWayPoint(m_nextWayPointTileCoords);// construct a new heat map based on the wandering way point
-				m_wayPointHasReached = false;
-				break;
-			}
-		}
+		// pick a way point on the map that this entity is able to get to //this is the long term goal
+		// the goals are shared by every wandering entity, so are the fields toward them, if none could be reached it stays put and picks again next time
+		IntVec2 currentTileCoords = m_map->GetTileCoordsInMap_For_WorldPos(m_position);
+		m_nextWayPointTileCoords = currentTileCoords;
+		m_map->m_flowFieldCache.PickWayPoint(currentTileCoords, !m_canSwim, m_nextWayPointTileCoords);
+		m_wayPointHasReached = false;
 	}
+	SetFlowFieldGoal(m_nextWayPointTileCoords); // the field could have been the one for chasing the player
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
 	if (m_shortTermGoalHasReached)
 	{
-		// based on the destination heat value find a short term goal
-		for (;;)
-		{
-			IntVec2 currentTileCoords = m_map->GetTileCoordsInMap_For_WorldPos(m_position);
-			int currentTileIndex = m_map->GetTileIndex_For_TileCoordinates(currentTileCoords);
-			// randomly pick from four directions
-			int direction = g_rng->RollRandomIntInRange(0, (NUM_CRAWLDIRECTION - 1));
-			if (direction == 0) { m_shortTermTileCoords = currentTileCoords + STEP_EAST; }
-			else if (direction == 1) { m_shortTermTileCoords = currentTileCoords + STEP_SOUTH; }
-			else if (direction == 2) { m_shortTermTileCoords = currentTileCoords + STEP_WEST; }
-			else { m_shortTermTileCoords = currentTileCoords + STEP_NORTH; }
-
-			// only pick the nearby tile which has lower heat value
-			int shortTermTileIndex = m_map->GetTileIndex_For_TileCoordinates(m_shortTermTileCoords);
-			if (m_heatMap->m_values[shortTermTileIndex] < m_heatMap->m_values[currentTileIndex])
-			{
-				m_shortTermGoalHasReached = false;
-				break; // the short term goal is adjacent to current tile
-			}
-			else continue;
-		}
+		// the flow field knows which neighbor is one step closer to the goal
+		IntVec2 currentTileCoords = m_map->GetTileCoordsInMap_For_WorldPos(m_position);
+		m_shortTermTileCoords = currentTileCoords + m_flowField->GetStepTowardGoal(currentTileCoords);
+		m_shortTermGoalHasReached = false;
 	}
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
 	// new orientation degrees
@@ -308,64 +265,30 @@ void Entity::GenerateHeatMapAndWander(float speedUpDegreeRange, float lowerSpeed
 	}
 }
 
-void Entity::GenerateHeatMapAndChasePlayer(float speedUpDegreeRange, float lowerSpeedMultiplier, float deltaSeconds)
+void Entity::FollowFlowFieldAndChasePlayer(float speedUpDegreeRange, float lowerSpeedMultiplier, float deltaSeconds)
 {
-	// when the entity see the player, generate and update the heat map every second for chasing
+	// when the entity see the player, head for the tile the player is on, everyone chasing the player shares the field toward it
 	if (m_playerSpoted)
 	{
-		bool treatWaterAsSolid = true;
-		if (m_canSwim)
-		{
-			treatWaterAsSolid = false;
-		}
-		IntVec2 playerTileCoords = m_map->GetTileCoordsInMap_For_WorldPos(m_map->m_entityPtrListByType[ENTITY_TYPE_GOOD_PLAYER][0]->m_position);
-		m_map->PopulateDistanceField(*m_heatMap, playerTileCoords, 999999.f, treatWaterAsSolid, true);
-		playerTileCoords = m_map->GetTileCoordsInMap_For_WorldPos(m_map->m_entityPtrListByType[ENTITY_TYPE_GOOD_PLAYER][0]->m_position);
-
-		// if the heat map is newly generated, and the player tile coords is different to last known pos tile coords
-		if (m_playerLastKnownTileCoords != playerTileCoords)
-		{
-			m_shortTermGoalHasReached = true; // means the newly generated tile coords needed to be refreshed
-			m_playerLastKnownTileCoords = playerTileCoords;
-		}
+		m_playerLastKnownTileCoords = m_map->GetTileCoordsInMap_For_WorldPos(m_map->m_entityPtrListByType[ENTITY_TYPE_GOOD_PLAYER][0]->m_position);
 	}
+	SetFlowFieldGoal(m_playerLastKnownTileCoords);
 	m_nextWayPointTileCoords = m_playerLastKnownTileCoords; // for debug
 
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
 	if (m_shortTermGoalHasReached)
 	{
-		// based on the destination heat value find a short term goal
-		for (;;)
-		{
-			IntVec2 currentTileCoords = m_map->GetTileCoordsInMap_For_WorldPos(m_position);
-			int currentTileIndex = m_map->GetTileIndex_For_TileCoordinates(currentTileCoords);
-			// randomly pick from four directions
-			int direction = g_rng->RollRandomIntInRange(0, (NUM_CRAWLDIRECTION - 1));
-			if (direction == 0)		 { m_shortTermTileCoords = currentTileCoords + STEP_EAST; }
-			else if (direction == 1) { m_shortTermTileCoords = currentTileCoords + STEP_SOUTH; }
-			else if (direction == 2) { m_shortTermTileCoords = currentTileCoords + STEP_WEST; }
-			else { m_shortTermTileCoords = currentTileCoords + STEP_NORTH; }
-
-			// only pick the nearby tile which has lower heat value
-			int shortTermTileIndex = m_map->GetTileIndex_For_TileCoordinates(m_shortTermTileCoords);
-			if (m_heatMap->m_values[shortTermTileIndex] < m_heatMap->m_values[currentTileIndex])
-			{
-				m_shortTermGoalHasReached = false;
-				break; // the short term goal is adjacent to current tile
-			}
-			else if (m_heatMap->m_values[shortTermTileIndex] == 1) // when the entity hit the player, all four neighbor heat tile's heat value become 1 and it is stuck in the infinite loop
-			{
-				break;
-			}
-			else continue;
-		}
+		// the flow field knows which neighbor is one step closer to the goal
+		IntVec2 currentTileCoords = m_map->GetTileCoordsInMap_For_WorldPos(m_position);
+		m_shortTermTileCoords = currentTileCoords + m_flowField->GetStepTowardGoal(currentTileCoords);
+		m_shortTermGoalHasReached = false;
 	}
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
 	// new orientation degrees
 	IntVec2 entityOccupiedTileCoords = m_map->GetTileCoordsInMap_For_WorldPos(m_position);
-	int entityOccupiedTileIndex = m_map->GetTileIndex_For_TileCoordinates(entityOccupiedTileCoords);
+	float distanceToGoal = m_flowField->GetDistanceToGoal(entityOccupiedTileCoords);
 	Vec2 direction;
-	if (m_heatMap->m_values[entityOccupiedTileIndex] == 1.f || m_heatMap->m_values[entityOccupiedTileIndex] == 0.f)// if the player is in the nearby tile, then go to the player directly
+	if (distanceToGoal == 1.f || distanceToGoal == 0.f)// if the player is in the nearby tile, then go to the player directly
 	{
 		direction = m_map->m_entityPtrListByType[ENTITY_TYPE_GOOD_PLAYER][0]->m_position;
 	}
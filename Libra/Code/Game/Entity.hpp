@@ -4,6 +4,7 @@
 #include "Engine/core/RaycastResult2D.hpp"
 #include <vector>
 #include "Engine/core/HeatMaps.hpp"
+#include "Game/FlowField.hpp"
 
 class Map;
 class Bullet;
@@ -76,13 +77,11 @@ public:
 	void DrawEnemyChasingDirection_ForDebug() const;
 
 	// path finding functions
-	void GenerateHeatMapForWandering();				  // used when the enemy has a new position to wander to, , notice that enemies will treat scorpio ally's occupying tile as solid tiles
-	void GenerateHeatMapForWanderingWayPoint(IntVec2 startCoords); // construct a new heat map which starts from the way point with a heat value 0
-	void GenerateHeatMapFromPlayerSeenLocation(); 
+	void SetFlowFieldGoal(IntVec2 goalCoords); // follow the map's shared flow field toward the tile, notice that enemies will treat scorpio ally's occupying tile as solid tiles
 
 	// AI 
-	void GenerateHeatMapAndWander(float speedUpDegreeRange, float lowerSpeedMultiplier, float deltaSeconds );
-	void GenerateHeatMapAndChasePlayer(float speedUpDegreeRange, float lowerSpeedMultiplier, float deltaSeconds);
+	void FollowFlowFieldAndWander(float speedUpDegreeRange, float lowerSpeedMultiplier, float deltaSeconds );
+	void FollowFlowFieldAndChasePlayer(float speedUpDegreeRange, float lowerSpeedMultiplier, float deltaSeconds);
 
 	// Audio
 	void SoundOffAlarmWhenSpotThePlayerDuringWandering();
@@ -115,7 +114,7 @@ public:
 	bool			m_shortTermGoalHasReached = true;
 
 	RaycastResult2D m_raycastResult;// use to store the raycast information that the entity doing every frame
-	TileHeatMap*	m_heatMap; // used to improve 
+	FlowField*		m_flowField = nullptr; // shared with every entity heading to the same tile, owned by the map's flow field cache
 
 	// physics flags
 	bool	m_isPushedByEntities = false;
@@ -0,0 +1,82 @@
+#include "Game/EntityBroadphase.hpp"
+#include "Game/Entity.hpp"
+#include <algorithm>
+#include <math.h>
+
+void EntityBroadphase::SetDimensions(IntVec2 const& mapDimensions)
+{
+	m_dimensions = mapDimensions;
+	m_cellStarts.assign(m_dimensions.x * m_dimensions.y + 1, 0);
+	m_cellEntities.clear();
+	m_addedEntities.clear();
+	m_addedCellIndices.clear();
+	m_maxPhysicsRadius = 0.f;
+}
+
+void EntityBroadphase::BeginRebuild()
+{
+	m_addedEntities.clear();
+	m_addedCellIndices.clear();
+	m_maxPhysicsRadius = 0.f;
+}
+
+void EntityBroadphase::AddEntity(Entity* entity)
+{
+	m_addedEntities.push_back(entity);
+	m_addedCellIndices.push_back(GetCellIndexForPosition(entity->m_position));
+	m_maxPhysicsRadius = (entity->m_physicsRadius > m_maxPhysicsRadius) ? entity->m_physicsRadius : m_maxPhysicsRadius;
+}
+
+void EntityBroadphase::EndRebuild()
+{
+	// count the entities per cell, turn the counts into where each cell starts, then drop every entity into its cell
+	int numCells = m_dimensions.x * m_dimensions.y;
+	std::fill(m_cellStarts.begin(), m_cellStarts.end(), 0);
+	for (int i = 0; i < (int)m_addedCellIndices.size(); ++i)
+	{
+		++m_cellStarts[m_addedCellIndices[i] + 1];
+	}
+	for (int cellIndex = 0; cellIndex < numCells; ++cellIndex)
+	{
+		m_cellStarts[cellIndex + 1] += m_cellStarts[cellIndex];
+	}
+	m_cellEntities.resize(m_addedEntities.size());
+	for (int i = 0; i < (int)m_addedEntities.size(); ++i)
+	{
+		// the start of the cell is moved along as it fills and set back afterwards
+		m_cellEntities[m_cellStarts[m_addedCellIndices[i]]++] = m_addedEntities[i];
+	}
+	for (int cellIndex = numCells; cellIndex > 0; --cellIndex)
+	{
+		m_cellStarts[cellIndex] = m_cellStarts[cellIndex - 1];
+	}
+	m_cellStarts[0] = 0;
+}
+
+void EntityBroadphase::GetEntitiesNearDisc(Vec2 const& center, float radius, std::vector<Entity*>& out_entities) const
+{
+	out_entities.clear();
+	float reach = radius + m_maxPhysicsRadius;
+	int minCellIndex = GetCellIndexForPosition(center - Vec2(reach, reach));
+	int maxCellIndex = GetCellIndexForPosition(center + Vec2(reach, reach));
+	int minCellX = minCellIndex % m_dimensions.x;
+	int minCellY = minCellIndex / m_dimensions.x;
+	int maxCellX = maxCellIndex % m_dimensions.x;
+	int maxCellY = maxCellIndex / m_dimensions.x;
+	for (int cellY = minCellY; cellY <= maxCellY; ++cellY)
+	{
+		// the cells of a row are next to each other, and so are their entities
+		int rowStart = m_cellStarts[minCellX + cellY * m_dimensions.x];
+		int rowEnd = m_cellStarts[maxCellX + cellY * m_dimensions.x + 1];
+		out_entities.insert(out_entities.end(), m_cellEntities.begin() + rowStart, m_cellEntities.begin() + rowEnd);
+	}
+}
+
+int EntityBroadphase::GetCellIndexForPosition(Vec2 const& position) const
+{
+	int cellX = (int)floorf(position.x);
+	int cellY = (int)floorf(position.y);
+	cellX = (cellX < 0) ? 0 : ((cellX > m_dimensions.x - 1) ? m_dimensions.x - 1 : cellX);
+	cellY = (cellY < 0) ? 0 : ((cellY > m_dimensions.y - 1) ? m_dimensions.y - 1 : cellY);
+	return cellX + cellY * m_dimensions.x;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include <vector>
+
+class Entity;
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// a uniform grid over the map with one cell per tile, every entity added goes into the cell of the tile its center is on
+// it is rebuilt every frame with a counting sort, so the entities of a cell sit next to each other and a rebuild allocates nothing once warmed up
+// a query only gathers the cells that could hold an entity overlapping the disc, so collisions cost about the number of entities near each other
+// instead of every entity against every other one
+class EntityBroadphase
+{
+public:
+	void	SetDimensions(IntVec2 const& mapDimensions);
+
+	// BeginRebuild, AddEntity for every entity, then EndRebuild before querying
+	void	BeginRebuild();
+	void	AddEntity(Entity* entity);
+	void	EndRebuild();
+
+	// every entity that could overlap the disc, including any entity at its center, in no particular order
+	void	GetEntitiesNearDisc(Vec2 const& center, float radius, std::vector<Entity*>& out_entities) const;
+
+	IntVec2	m_dimensions;
+
+private:
+	int		GetCellIndexForPosition(Vec2 const& position) const; // positions outside the map go to the nearest edge cell
+
+	std::vector<int>		m_cellStarts;		// the entities of cell i are m_cellEntities[m_cellStarts[i]] up to m_cellStarts[i + 1]
+	std::vector<Entity*>	m_cellEntities;
+	std::vector<Entity*>	m_addedEntities;
+	std::vector<int>		m_addedCellIndices;
+	float					m_maxPhysicsRadius = 0.f; // of everything added, how far around a disc the query has to look
+};
@@ -0,0 +1,291 @@
+#include "Game/FlowField.hpp"
+#include "Game/Map.hpp"
+#include "Engine/Math/RandomNumberGenerator.hpp"
+
+extern RandomNumberGenerator* g_rng;
+
+FlowField::FlowField(IntVec2 const& dimensions, IntVec2 goalCoords, bool treatWaterAsSolid)
+	:m_goalCoords(goalCoords), m_treatWaterAsSolid(treatWaterAsSolid), m_distanceField(dimensions)
+{
+}
+
+IntVec2 FlowField::GetStepTowardGoal(IntVec2 tileCoords) const
+{
+	int tileIndex = tileCoords.x + tileCoords.y * m_distanceField.m_dimensions.x;
+	switch (m_stepDirections[tileIndex])
+	{
+	case CRAWL_EAST:	return STEP_EAST;
+	case CRAWL_SOUTH:	return STEP_SOUTH;
+	case CRAWL_WEST:	return STEP_WEST;
+	case CRAWL_NORTH:	return STEP_NORTH;
+	}
+	return IntVec2(0, 0);
+}
+
+float FlowField::GetDistanceToGoal(IntVec2 tileCoords) const
+{
+	int tileIndex = tileCoords.x + tileCoords.y * m_distanceField.m_dimensions.x;
+	return m_distanceField.m_values[tileIndex];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// <flow field cache>
+FlowFieldCache::FlowFieldCache(Map* map)
+	:m_map(map)
+{
+}
+
+FlowFieldCache::~FlowFieldCache()
+{
+	for (auto& keyAndField : m_flowFieldsByKey)
+	{
+		delete keyAndField.second;
+	}
+}
+
+FlowField* FlowFieldCache::AcquireFlowField(IntVec2 goalCoords, bool treatWaterAsSolid)
+{
+	int key = GetFlowFieldKey(goalCoords, treatWaterAsSolid);
+	auto found = m_flowFieldsByKey.find(key);
+	if (found != m_flowFieldsByKey.end())
+	{
+		FlowField* flowField = found->second;
+		if (flowField->m_numUsers == 0)
+		{
+			for (int i = 0; i < (int)m_unusedFlowFields.size(); ++i)
+			{
+				if (m_unusedFlowFields[i] == flowField)
+				{
+					m_unusedFlowFields.erase(m_unusedFlowFields.begin() + i);
+					break;
+				}
+			}
+		}
+		else
+		{
+			++m_numFlowFieldsShared;
+		}
+		if (flowField->m_isStale)
+		{
+			BuildFlowField(*flowField);
+		}
+		++flowField->m_numUsers;
+		return flowField;
+	}
+
+	FlowField* flowField = new FlowField(m_map->m_dimensions, goalCoords, treatWaterAsSolid);
+	BuildFlowField(*flowField);
+	flowField->m_numUsers = 1;
+	m_flowFieldsByKey[key] = flowField;
+	return flowField;
+}
+
+void FlowFieldCache::ReleaseFlowField(FlowField*& flowField)
+{
+	if (!flowField)
+	{
+		return;
+	}
+	--flowField->m_numUsers;
+	if (flowField->m_numUsers == 0)
+	{
+		if (flowField->m_isStale)
+		{
+			DeleteFlowField(flowField);
+		}
+		else
+		{
+			m_unusedFlowFields.push_back(flowField);
+			if ((int)m_unusedFlowFields.size() > MAX_UNUSED_FLOW_FIELDS)
+			{
+				FlowField* oldestUnusedField = m_unusedFlowFields[0];
+				m_unusedFlowFields.erase(m_unusedFlowFields.begin());
+				DeleteFlowField(oldestUnusedField);
+			}
+		}
+	}
+	flowField = nullptr;
+}
+
+void FlowFieldCache::InvalidateAllFlowFields()
+{
+	for (int i = 0; i < (int)m_unusedFlowFields.size(); ++i)
+	{
+		DeleteFlowField(m_unusedFlowFields[i]);
+	}
+	m_unusedFlowFields.clear();
+
+	for (auto& keyAndField : m_flowFieldsByKey)
+	{
+		keyAndField.second->m_isStale = true;
+	}
+	m_isConnectivityStale[0] = true;
+	m_isConnectivityStale[1] = true;
+	m_areWayPointGoalsStale = true;
+}
+
+void FlowFieldCache::RebuildStaleFlowFields()
+{
+	for (auto& keyAndField : m_flowFieldsByKey)
+	{
+		if (keyAndField.second->m_isStale)
+		{
+			BuildFlowField(*keyAndField.second);
+		}
+	}
+}
+
+bool FlowFieldCache::AreAllStepsTowardGoal() const
+{
+	for (auto const& keyAndField : m_flowFieldsByKey)
+	{
+		FlowField const& flowField = *keyAndField.second;
+		for (int tileY = 0; tileY < m_map->m_dimensions.y; ++tileY)
+		{
+			for (int tileX = 0; tileX < m_map->m_dimensions.x; ++tileX)
+			{
+				IntVec2 tileCoords(tileX, tileY);
+				float distance = flowField.GetDistanceToGoal(tileCoords);
+				IntVec2 step = flowField.GetStepTowardGoal(tileCoords);
+				if (step == IntVec2(0, 0))
+				{
+					// only the goal itself and the tiles that never reach it have nowhere to go
+					if (distance != 0.f && distance != FLOW_FIELD_UNREACHABLE)
+					{
+						return false;
+					}
+				}
+				else if (flowField.GetDistanceToGoal(tileCoords + step) != distance - 1.f)
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool FlowFieldCache::PickWayPoint(IntVec2 fromCoords, bool treatWaterAsSolid, IntVec2& out_wayPointCoords)
+{
+	if (m_areWayPointGoalsStale)
+	{
+		RefreshWayPointGoals();
+	}
+
+	TileConnectivity& connectivity = GetConnectivity(treatWaterAsSolid);
+	int fromTileIndex = m_map->GetTileIndex_For_TileCoordinates(fromCoords);
+	IntVec2 reachableGoals[NUM_WAYPOINT_GOALS];
+	int numReachableGoals = 0;
+	for (int goalIndex = 0; goalIndex < (int)m_wayPointGoals.size(); ++goalIndex)
+	{
+		IntVec2 goalCoords = m_wayPointGoals[goalIndex];
+		if (!m_map->IsTileOutOfBounds(goalCoords) && goalCoords != fromCoords && connectivity.AreTilesConnected(fromTileIndex, m_map->GetTileIndex_For_TileCoordinates(goalCoords)))
+		{
+			reachableGoals[numReachableGoals++] = goalCoords;
+		}
+	}
+	if (numReachableGoals == 0)
+	{
+		return false;
+	}
+	out_wayPointCoords = reachableGoals[g_rng->RollRandomIntInRange(0, numReachableGoals - 1)];
+	return true;
+}
+
+TileConnectivity& FlowFieldCache::GetConnectivity(bool treatWaterAsSolid)
+{
+	int setIndex = treatWaterAsSolid ? 1 : 0;
+	TileConnectivity& connectivity = m_connectivity[setIndex];
+	if (m_isConnectivityStale[setIndex])
+	{
+		m_map->SetUpDistanceFieldBlockedTiles(treatWaterAsSolid, true);
+		TileDistanceFieldBuilder const& blockedTiles = m_map->m_distanceFieldBuilder;
+		connectivity.SetDimensions(m_map->m_dimensions);
+		for (int tileIndex = 0; tileIndex < m_map->m_dimensions.x * m_map->m_dimensions.y; ++tileIndex)
+		{
+			if (!blockedTiles.IsTileBlocked(tileIndex))
+			{
+				connectivity.OpenTile(tileIndex);
+			}
+		}
+		m_isConnectivityStale[setIndex] = false;
+	}
+	return connectivity;
+}
+
+// random tiles inside the border that both tanks and swimmers could stand on, a goal that got solid or water is rolled again
+// one that finds no such tile keeps its old coords and is skipped by PickWayPoint while it is out of bounds or blocked
+void FlowFieldCache::RefreshWayPointGoals()
+{
+	m_wayPointGoals.resize(NUM_WAYPOINT_GOALS, IntVec2(-1, -1));
+	for (int goalIndex = 0; goalIndex < NUM_WAYPOINT_GOALS; ++goalIndex)
+	{
+		IntVec2& goalCoords = m_wayPointGoals[goalIndex];
+		for (int attempt = 0; attempt < MAX_WAYPOINT_ATTEMPTS; ++attempt)
+		{
+			if (!m_map->IsTileOutOfBounds(goalCoords) && !m_map->IsTileSolid(goalCoords) && !m_map->IsTileWater(goalCoords))
+			{
+				break;
+			}
+			goalCoords.x = g_rng->RollRandomIntInRange(1, (m_map->m_dimensions.x - 2));
+			goalCoords.y = g_rng->RollRandomIntInRange(1, (m_map->m_dimensions.y - 2));
+		}
+	}
+	m_areWayPointGoalsStale = false;
+}
+
+void FlowFieldCache::BuildFlowField(FlowField& flowField)
+{
+	m_map->PopulateDistanceField(flowField.m_distanceField, flowField.m_goalCoords, FLOW_FIELD_UNREACHABLE, flowField.m_treatWaterAsSolid, true);
+	++m_numFlowFieldsBuilt;
+	flowField.m_isStale = false;
+
+	// step toward the neighbor nearest to the goal, the first one of the four on a tie
+	IntVec2 dimensions = m_map->m_dimensions;
+	std::vector<float> const& distances = flowField.m_distanceField.m_values;
+	flowField.m_stepDirections.assign(dimensions.x * dimensions.y, (unsigned char)NUM_CRAWLDIRECTION);
+	for (int tileY = 0; tileY < dimensions.y; ++tileY)
+	{
+		for (int tileX = 0; tileX < dimensions.x; ++tileX)
+		{
+			int tileIndex = tileX + tileY * dimensions.x;
+			float nearestDistance = distances[tileIndex];
+			if (nearestDistance == 0.f || nearestDistance == FLOW_FIELD_UNREACHABLE)
+			{
+				continue;
+			}
+			if (tileX + 1 < dimensions.x && distances[tileIndex + 1] < nearestDistance)
+			{
+				nearestDistance = distances[tileIndex + 1];
+				flowField.m_stepDirections[tileIndex] = CRAWL_EAST;
+			}
+			if (tileY > 0 && distances[tileIndex - dimensions.x] < nearestDistance)
+			{
+				nearestDistance = distances[tileIndex - dimensions.x];
+				flowField.m_stepDirections[tileIndex] = CRAWL_SOUTH;
+			}
+			if (tileX > 0 && distances[tileIndex - 1] < nearestDistance)
+			{
+				nearestDistance = distances[tileIndex - 1];
+				flowField.m_stepDirections[tileIndex] = CRAWL_WEST;
+			}
+			if (tileY + 1 < dimensions.y && distances[tileIndex + dimensions.x] < nearestDistance)
+			{
+				nearestDistance = distances[tileIndex + dimensions.x];
+				flowField.m_stepDirections[tileIndex] = CRAWL_NORTH;
+			}
+		}
+	}
+}
+
+int FlowFieldCache::GetFlowFieldKey(IntVec2 goalCoords, bool treatWaterAsSolid) const
+{
+	int goalTileIndex = m_map->GetTileIndex_For_TileCoordinates(goalCoords);
+	return goalTileIndex * 2 + (treatWaterAsSolid ? 1 : 0);
+}
+
+void FlowFieldCache::DeleteFlowField(FlowField* flowField)
+{
+	m_flowFieldsByKey.erase(GetFlowFieldKey(flowField->m_goalCoords, flowField->m_treatWaterAsSolid));
+	delete flowField;
+}
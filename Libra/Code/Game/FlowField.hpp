@@ -0,0 +1,71 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/core/HeatMaps.hpp"
+#include <vector>
+#include <map>
+
+class Map;
+
+constexpr float FLOW_FIELD_UNREACHABLE = 999999.f;
+constexpr int	MAX_UNUSED_FLOW_FIELDS = 16; // fields nobody follows anymore are kept for a while in case someone heads to the same tile again
+constexpr int	NUM_WAYPOINT_GOALS = 12; // the tiles wandering entities head to, few enough that their fields stay shared and cached
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// the distance of every tile to the goal tile, with living scorpios and, for the ones that cannot swim, water in the way
+// plus which way to step from every tile to get one tile closer, so an entity following it only reads its own tile
+struct FlowField
+{
+public:
+	FlowField(IntVec2 const& dimensions, IntVec2 goalCoords, bool treatWaterAsSolid);
+
+	IntVec2 GetStepTowardGoal(IntVec2 tileCoords) const; // IntVec2(0, 0) on the goal tile or where the goal could not be reached
+	float	GetDistanceToGoal(IntVec2 tileCoords) const;
+
+	IntVec2		m_goalCoords;
+	bool		m_treatWaterAsSolid = true;
+	bool		m_isStale = false;	// the tiles or the scorpios have changed since it was built
+	int			m_numUsers = 0;
+	TileHeatMap m_distanceField;
+	std::vector<unsigned char> m_stepDirections; // a WormDirection per tile, NUM_CRAWLDIRECTION where there is no step to take
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// the map's flow fields, keyed by goal tile and whether water blocks, so every entity heading to the same tile the same way shares one field
+// entities acquire a field when their goal changes and release it when they are done with it
+// wandering entities pick their way points from a small shared set of goal tiles, so the fields toward them are shared as well,
+// and whether a tile could be reached is read from one connectivity per blocker set instead of flooding the map for every pick
+class FlowFieldCache
+{
+public:
+	FlowFieldCache(Map* map);
+	~FlowFieldCache();
+
+	FlowField*	AcquireFlowField(IntVec2 goalCoords, bool treatWaterAsSolid);
+	void		ReleaseFlowField(FlowField*& flowField);
+
+	void		InvalidateAllFlowFields(); // when tiles change or a scorpio comes or goes, the unused fields are dropped
+	void		RebuildStaleFlowFields(); // once per frame, so every field in use is rebuilt at most once however many changes there were
+	bool		AreAllStepsTowardGoal() const; // every step of every field leads to a tile one closer to its goal
+
+	// a random way point goal in the same connected area as fromCoords, false if there is none and the entity should stay put
+	bool		PickWayPoint(IntVec2 fromCoords, bool treatWaterAsSolid, IntVec2& out_wayPointCoords);
+
+	int			m_numFlowFieldsBuilt = 0;
+	int			m_numFlowFieldsShared = 0; // acquired while someone else was already following it
+
+private:
+	void		BuildFlowField(FlowField& flowField);
+	int			GetFlowFieldKey(IntVec2 goalCoords, bool treatWaterAsSolid) const;
+	void		DeleteFlowField(FlowField* flowField);
+	TileConnectivity& GetConnectivity(bool treatWaterAsSolid); // rebuilt when it is asked for after the tiles or the scorpios changed
+	void		RefreshWayPointGoals(); // replaces the goals that are solid or water by now
+
+	Map*						m_map = nullptr;
+	std::map<int, FlowField*>	m_flowFieldsByKey;
+	std::vector<FlowField*>		m_unusedFlowFields; // the least recently released first
+
+	TileConnectivity			m_connectivity[2]; // indexed by treatWaterAsSolid, living scorpios always block like in the fields
+	bool						m_isConnectivityStale[2] = { true, true };
+	std::vector<IntVec2>		m_wayPointGoals;
+	bool						m_areWayPointGoalsStale = true;
+};
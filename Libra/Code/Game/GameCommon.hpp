@@ -22,6 +22,7 @@ constexpr unsigned char TILE_STONE_COLOR_A = 255;
 
 constexpr int ENTRANCE_SAFEZONE_SIZE = 5;
 constexpr int EXIT_SAFEZONE_SIZE = 7;
+constexpr int MAX_WAYPOINT_ATTEMPTS = 64; // random tiles tried for a shared wandering way point goal before keeping the old one
 
 // game camera settings
 constexpr float WORLD_CAMERA_ORTHO_X = 200.f;
@@ -44,9 +44,6 @@ Leo::Leo(Map* owner, EntityType type, EntityFaction faction, Vec2 const& startPo
 	m_bodyCurrent_OrientDegrees = angleDegrees;
 
 	AddVertsForRender();
-
-	// generate a heat map to see if the exit tile heat value could be modified
-	m_heatMap = new TileHeatMap(m_map->m_dimensions);
 }
 
 Leo::~Leo()
@@ -146,12 +143,12 @@ void Leo::ChasingPlayer(float deltaSeconds)
 	//	m_wayPointHasReached = false;
 	//	m_shortTermGoalHasReached = false;
 	//}
-	GenerateHeatMapAndChasePlayer(45.f, 0.5f, deltaSeconds);
+	FollowFlowFieldAndChasePlayer(45.f, 0.5f, deltaSeconds);
 }
 
 void Leo::WanderOnMap(float deltaSeconds)
 {
-	GenerateHeatMapAndWander( 45.f, 0.5f, deltaSeconds);
+	FollowFlowFieldAndWander( 45.f, 0.5f, deltaSeconds);
 }
 
 /// <Render>
@@ -4,6 +4,7 @@
 #include "Engine/Math/RandomNumberGenerator.hpp"
 #include "Engine/core/RaycastResult2D.hpp"
 #include "Engine/Audio/AudioSystem.hpp"
+#include "Engine/core/Time.hpp"
 #include "Game/Map.hpp"
 #include "Game/App.hpp"
 #include "Game/Entity.hpp"
@@ -33,6 +34,7 @@ extern RandomNumberGenerator* g_rng;
 extern App* g_theApp;
 extern Game* g_theGame;
 extern AudioSystem* g_theAudio;
+extern DevConsole* g_theDevConsole;
 
 std::vector<MapDefinition> MapDefinition::s_mapDefs;
 
@@ -94,6 +96,7 @@ MapDefinition::MapDefinition(XmlElement const& mapDefElement)
 
 
 Map::Map(MapDefinition inputMapDefinition)
+	:m_flowFieldCache(this)
 {
 	m_mapDefinition = inputMapDefinition;
 	GenerateTiles_And_CheckIfMapIsSolvable();
@@ -109,14 +112,34 @@ Map::~Map()
 		// todo: delete nullptr is fine but some of the entities are not complete deleted
 		delete m_allEntitiesOnThisMap[i];
 	}
+	delete m_exitDistanceField;
 }
 
 void Map::Update(float deltaSeconds)
 {
 	// UpdateLevelTransition(deltaSeconds); // this function is put into the Game
+	m_flowFieldCache.RebuildStaleFlowFields();
 	UpdateAllEntities(deltaSeconds);
+	if (m_collisionStressFramesLeft > 0)
+	{
+		UpdateCollisionStressTest();
+	}
+	double timeAtStart = GetCurrentTimeSeconds();
 	UpdateEntityPhysicCollision(deltaSeconds);
 	CheckBulletHit(deltaSeconds);
+	if (m_collisionStressFramesLeft > 0)
+	{
+		int broadphaseIndex = m_useCollisionBroadphase ? 1 : 0;
+		m_collisionStressSeconds[broadphaseIndex] += GetCurrentTimeSeconds() - timeAtStart;
+		++m_collisionStressFrames[broadphaseIndex];
+		m_useCollisionBroadphase = !m_useCollisionBroadphase; // every other frame, so both see about the same bullets
+		--m_collisionStressFramesLeft;
+		if (m_collisionStressFramesLeft == 0)
+		{
+			m_useCollisionBroadphase = true;
+			ReportCollisionStressTest();
+		}
+	}
 	ClearDeadGarbageEntities(deltaSeconds);
 	// DrawHealthBarForDamagedEntity();
 }
@@ -136,6 +159,11 @@ void Map::PopulateTiles(IntVec2 mapDimensions)
 
 	// initialize the tiles
 	m_tiles.resize(numOfTiles);
+	m_wormSteps.clear();
+	m_solidTileBits.assign((numOfTiles + 63) / 64, 0);
+	m_waterTileBits.assign((numOfTiles + 63) / 64, 0);
+	m_distanceFieldBuilder.SetDimensions(m_dimensions);
+	m_actorBroadphase.SetDimensions(m_dimensions);
 	for ( int tileY = 0; tileY < m_dimensions.y; ++tileY)
 	{
 		for (int tileX = 0; tileX < m_dimensions.x; ++tileX)
@@ -238,6 +266,10 @@ void Map::SpawnWormToPopulateTiles(int numWorm, int totalSteps, std::string tile
 		IntVec2 tileCoords;
 		tileCoords.x = g_rng->RollRandomIntInRange(1, (m_dimensions.x - 2));
 		tileCoords.y = g_rng->RollRandomIntInRange(1, (m_dimensions.y - 2));
+		WormStep firstStep;
+		firstStep.m_tileIndex = GetTileIndex_For_TileCoordinates(tileCoords);
+		firstStep.m_previousTileDef = m_tiles[firstStep.m_tileIndex].m_tileDef;
+		m_wormSteps.push_back(firstStep);
 		SetTileType(tileCoords.x, tileCoords.y, tileType);
 
 		for ( int stepIndex = 0; stepIndex < totalSteps; ++stepIndex)
@@ -260,13 +292,97 @@ void Map::SpawnWormToPopulateTiles(int numWorm, int totalSteps, std::string tile
 			}
 			else
 			{
+				WormStep step;
+				step.m_tileIndex = GetTileIndex_For_TileCoordinates(tileCoords);
+				step.m_previousTileDef = m_tiles[step.m_tileIndex].m_tileDef;
+				m_wormSteps.push_back(step);
 				SetTileType(tileCoords.x, tileCoords.y, tileType);
 			}
 		}
 	}
 }
 
+// the worms are undone from the last step back until the entry and the exit are connected, the union-find is updated as every tile opens,
+// so the map is only thrown away and generated again when undoing every worm is not enough
 void Map::GenerateTiles_And_CheckIfMapIsSolvable()
+{
+	m_numMapRegenerations = 0;
+	PopulateTiles(m_mapDefinition.mapSize);
+	while (!MakeGeneratedMapSolvable())
+	{
+		PopulateTiles(m_mapDefinition.mapSize);
+		++m_numMapRegenerations;
+	}
+
+	// set solid to the tiles that player is unable to reach, therefore there will only be one kind of solid tile on map
+	int entryTileIndex = GetTileIndex_For_TileCoordinates(IntVec2(1, 1));
+	for (int tileIndex = 0; tileIndex < m_dimensions.x * m_dimensions.y; ++tileIndex)
+	{
+		if (m_tileConnectivity.IsTileOpen(tileIndex) && !m_tileConnectivity.AreTilesConnected(tileIndex, entryTileIndex))
+		{
+			SetTileType(tileIndex % m_dimensions.x, tileIndex / m_dimensions.x, m_mapDefinition.worm2_TileTYpe);
+		}
+	}
+
+	// the distance field is only for the solvability heat map view now
+	delete m_exitDistanceField;
+	m_exitDistanceField = new TileHeatMap(m_dimensions);
+	PopulateDistanceField(*m_exitDistanceField, IntVec2(1, 1), 999999.f, true);
+	DebuggerPrintf("Map generation succeed after %i regenerations and %i worm steps undone\n", m_numMapRegenerations, m_numWormStepsUndone);
+}
+
+bool Map::MakeGeneratedMapSolvable()
+{
+	m_numWormStepsUndone = 0;
+	m_tileConnectivity.SetDimensions(m_dimensions);
+	for (int tileIndex = 0; tileIndex < m_dimensions.x * m_dimensions.y; ++tileIndex)
+	{
+		if (!m_tiles[tileIndex].IsSolid() && !m_tiles[tileIndex].IsWater())
+		{
+			m_tileConnectivity.OpenTile(tileIndex);
+		}
+	}
+
+	int entryTileIndex = GetTileIndex_For_TileCoordinates(IntVec2(1, 1));
+	int exitTileIndex = GetTileIndex_For_TileCoordinates(IntVec2(m_dimensions.x - 2, m_dimensions.y - 2));
+	for (int stepIndex = (int)m_wormSteps.size() - 1; stepIndex >= 0; --stepIndex)
+	{
+		if (m_tileConnectivity.AreTilesConnected(entryTileIndex, exitTileIndex))
+		{
+			return true;
+		}
+		// only the steps that put something solid where it was open before, the border and the bunkers were laid over the worms
+		WormStep const& step = m_wormSteps[stepIndex];
+		IntVec2 tileCoords(step.m_tileIndex % m_dimensions.x, step.m_tileIndex / m_dimensions.x);
+		if (m_tileConnectivity.IsTileOpen(step.m_tileIndex) || IsTileInBorderOrSafeZone(tileCoords))
+		{
+			continue;
+		}
+		if (step.m_previousTileDef->m_isSolid || step.m_previousTileDef->m_isWater)
+		{
+			continue;
+		}
+		SetTileType(tileCoords.x, tileCoords.y, step.m_previousTileDef->m_name);
+		m_tileConnectivity.OpenTile(step.m_tileIndex);
+		++m_numWormStepsUndone;
+	}
+	return m_tileConnectivity.AreTilesConnected(entryTileIndex, exitTileIndex);
+}
+
+bool Map::IsTileInBorderOrSafeZone(IntVec2 const& tileCoords) const
+{
+	if (tileCoords.x <= 0 || tileCoords.y <= 0 || tileCoords.x >= m_dimensions.x - 1 || tileCoords.y >= m_dimensions.y - 1)
+	{
+		return true;
+	}
+	if (tileCoords.x <= ENTRANCE_SAFEZONE_SIZE && tileCoords.y <= ENTRANCE_SAFEZONE_SIZE)
+	{
+		return true;
+	}
+	return tileCoords.x >= m_dimensions.x - 1 - EXIT_SAFEZONE_SIZE && tileCoords.y >= m_dimensions.y - 1 - EXIT_SAFEZONE_SIZE;
+}
+
+int Map::GenerateTilesByRegenerating()
 {
 	PopulateTiles(m_mapDefinition.mapSize);
 	int mapGerneration = 1;
@@ -290,8 +406,7 @@ void Map::GenerateTiles_And_CheckIfMapIsSolvable()
 					}
 				}
 			}
-			DebuggerPrintf("Map generation succeed after %i times\n", mapGerneration);
-			return;
+			return mapGerneration;
 		}
 		else
 		{
@@ -323,6 +438,19 @@ void Map::SetTileType(int tileX, int tileY, std::string type)
 {
 	int tileIndex = tileX + (tileY * m_dimensions.x);
 	m_tiles[tileIndex].SetType(type);
+
+	uint64_t tileBit = uint64_t(1) << (tileIndex & 63);
+	m_solidTileBits[tileIndex >> 6] &= ~tileBit;
+	m_waterTileBits[tileIndex >> 6] &= ~tileBit;
+	if (m_tiles[tileIndex].IsSolid())
+	{
+		m_solidTileBits[tileIndex >> 6] |= tileBit;
+	}
+	if (m_tiles[tileIndex].IsWater())
+	{
+		m_waterTileBits[tileIndex >> 6] |= tileBit;
+	}
+	m_flowFieldCache.InvalidateAllFlowFields();
 }
 
 void Map::AddVertsForTiles(std::vector<Vertex_PCU>& verts, int tileIndex) const
@@ -345,9 +473,12 @@ void Map::UpdateAllEntities(float deltaSeconds)
 	int& etI = entityTypeIndex;
 
 	// update the entity by the order of enum
+	double aiSecondsThisFrame = 0.0;
 	for (etI = 0; etI < NUM_ENTITY_TYPES; ++ etI)
 	{
 		EntityPtrList& eList = m_entityPtrListByType[etI];
+		bool isTimed = (m_aiStressFramesLeft > 0) && IsAIEntity(static_cast<EntityType>(etI));
+		double timeAtStart = isTimed ? GetCurrentTimeSeconds() : 0.0;
 		for (int i = 0; i < (int)eList.size(); ++i)
 		{
 			if ( CheckEntityIsAlive(eList[i]) )
@@ -355,30 +486,303 @@ void Map::UpdateAllEntities(float deltaSeconds)
 				eList[i]->Update(deltaSeconds);
 			}
 		}
+		if (isTimed)
+		{
+			aiSecondsThisFrame += GetCurrentTimeSeconds() - timeAtStart;
+		}
 	}
+
+	if (m_aiStressFramesLeft > 0)
+	{
+		m_aiStressSeconds += aiSecondsThisFrame;
+		m_aiStressWorstFrameSeconds = (aiSecondsThisFrame > m_aiStressWorstFrameSeconds) ? aiSecondsThisFrame : m_aiStressWorstFrameSeconds;
+		++m_aiStressFrames;
+		--m_aiStressFramesLeft;
+		if (m_aiStressFramesLeft == 0)
+		{
+			ReportAIStressTest();
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// AI stress test, the updates of the Leos, Aries and Capricorns are timed for a number of frames
+void Map::StartAIStressTest(int numFrames)
+{
+	m_aiStressFramesLeft = numFrames;
+	m_aiStressFrames = 0;
+	m_aiStressSeconds = 0.0;
+	m_aiStressWorstFrameSeconds = 0.0;
+	m_aiStressFlowFieldsBuiltAtStart = m_flowFieldCache.m_numFlowFieldsBuilt;
+	m_aiStressFlowFieldsSharedAtStart = m_flowFieldCache.m_numFlowFieldsShared;
+}
+
+void Map::ReportAIStressTest()
+{
+	int numAIEntities = (int)m_entityPtrListByType[ENTITY_TYPE_EVIL_LEO].size() + (int)m_entityPtrListByType[ENTITY_TYPE_EVIL_ARIES].size()
+		+ (int)m_entityPtrListByType[ENTITY_TYPE_EVIL_CAPRICORN].size();
+	g_theDevConsole->AddLine(Stringf("FlowFieldStress: %i AI entities, %i frames", numAIEntities, m_aiStressFrames), DevConsole::INFO_MAJOR);
+	g_theDevConsole->AddLine(Stringf("  AI: %.3f ms/frame, worst frame %.3f ms", m_aiStressSeconds * 1000.0 / m_aiStressFrames,
+		m_aiStressWorstFrameSeconds * 1000.0), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  %i flow fields built, %i times an entity joined a field already in use", m_flowFieldCache.m_numFlowFieldsBuilt - m_aiStressFlowFieldsBuiltAtStart,
+		m_flowFieldCache.m_numFlowFieldsShared - m_aiStressFlowFieldsSharedAtStart), DevConsole::INFO_MINOR);
+
+	bool passed = m_flowFieldCache.AreAllStepsTowardGoal();
+	g_theDevConsole->AddLine(Stringf("FlowFieldStress %s", passed ? "PASSED" : "FAILED"), passed ? DevConsole::INFO_MAJOR : DevConsole::INFO_ERROR);
+}
+
+bool Map::IsAIEntity(EntityType type) const
+{
+	return type == ENTITY_TYPE_EVIL_LEO || type == ENTITY_TYPE_EVIL_ARIES || type == ENTITY_TYPE_EVIL_CAPRICORN;
 }
 
 void Map::UpdateEntityPhysicCollision(float deltaSeconds)
 {
 	if (!g_theApp->m_noClipMode)
 	{
-		// player with other entity
-		CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_GOOD_PLAYER], m_entityPtrListByType[ENTITY_TYPE_EVIL_SCORPIO]);
-		CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_GOOD_PLAYER], m_entityPtrListByType[ENTITY_TYPE_EVIL_ARIES]);
-		CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_GOOD_PLAYER], m_entityPtrListByType[ENTITY_TYPE_EVIL_LEO]);
+		if (m_useCollisionBroadphase)
+		{
+			PushActorsOutOfEachOther();
+		}
+		else
+		{
+			PushActorsOutOfEachOtherBruteForce();
+		}
+		PushEntitiesOutOfWalls(deltaSeconds);
+	}
 
-		// the same type entity push its own kind
-		CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_EVIL_LEO], m_entityPtrListByType[ENTITY_TYPE_EVIL_LEO]);
-		CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_EVIL_ARIES], m_entityPtrListByType[ENTITY_TYPE_EVIL_ARIES]);
+}
 
-		// different kind of enemy push different kind of enemy entity
-		CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_EVIL_LEO], m_entityPtrListByType[ENTITY_TYPE_EVIL_ARIES]);
-		CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_EVIL_LEO], m_entityPtrListByType[ENTITY_TYPE_EVIL_SCORPIO]);
-		CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_EVIL_ARIES], m_entityPtrListByType[ENTITY_TYPE_EVIL_SCORPIO]);
+void Map::PushActorsOutOfEachOtherBruteForce()
+{
+	// player with other entity
+	CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_GOOD_PLAYER], m_entityPtrListByType[ENTITY_TYPE_EVIL_SCORPIO]);
+	CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_GOOD_PLAYER], m_entityPtrListByType[ENTITY_TYPE_EVIL_ARIES]);
+	CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_GOOD_PLAYER], m_entityPtrListByType[ENTITY_TYPE_EVIL_LEO]);
+
+	// the same type entity push its own kind
+	CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_EVIL_LEO], m_entityPtrListByType[ENTITY_TYPE_EVIL_LEO]);
+	CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_EVIL_ARIES], m_entityPtrListByType[ENTITY_TYPE_EVIL_ARIES]);
+
+	// different kind of enemy push different kind of enemy entity
+	CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_EVIL_LEO], m_entityPtrListByType[ENTITY_TYPE_EVIL_ARIES]);
+	CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_EVIL_LEO], m_entityPtrListByType[ENTITY_TYPE_EVIL_SCORPIO]);
+	CheckEntityTypeListCollision(m_entityPtrListByType[ENTITY_TYPE_EVIL_ARIES], m_entityPtrListByType[ENTITY_TYPE_EVIL_SCORPIO]);
+}
 
-		PushEntitiesOutOfWalls(deltaSeconds);
+// the same pairs as the brute force, each actor against the actors near it
+void Map::PushActorsOutOfEachOther()
+{
+	RebuildActorBroadphase();
+	for (int faction = 0; faction < NUM_FACTION; ++faction)
+	{
+		EntityPtrList& actorList = m_actorPtrListByType[faction];
+		for (int i = 0; i < (int)actorList.size(); ++i)
+		{
+			Entity* actor = actorList[i];
+			if (!CheckEntityIsAlive(actor))
+			{
+				continue;
+			}
+			m_actorBroadphase.GetEntitiesNearDisc(actor->m_position, actor->m_physicsRadius, m_nearbyActors);
+			for (int j = 0; j < (int)m_nearbyActors.size(); ++j)
+			{
+				Entity* nearbyActor = m_nearbyActors[j];
+				if (nearbyActor == actor || !IsCollisionPairChecked(actor->m_entityType, nearbyActor->m_entityType) || !CheckEntityIsAlive(nearbyActor))
+				{
+					continue;
+				}
+				if (DoEntitiesOverlap(*actor, *nearbyActor))
+				{
+					PushEntitiesOutOfEachOther(*actor, *nearbyActor);
+				}
+			}
+		}
 	}
+}
 
+void Map::RebuildActorBroadphase()
+{
+	m_actorBroadphase.BeginRebuild();
+	for (int faction = 0; faction < NUM_FACTION; ++faction)
+	{
+		EntityPtrList& actorList = m_actorPtrListByType[faction];
+		for (int i = 0; i < (int)actorList.size(); ++i)
+		{
+			if (actorList[i])
+			{
+				m_actorBroadphase.AddEntity(actorList[i]);
+			}
+		}
+	}
+	m_actorBroadphase.EndRebuild();
+}
+
+int Map::CountCollidingPairs(bool useBroadphase)
+{
+	int numPairs = 0;
+	if (useBroadphase)
+	{
+		RebuildActorBroadphase();
+		for (int faction = 0; faction < NUM_FACTION; ++faction)
+		{
+			EntityPtrList& actorList = m_actorPtrListByType[faction];
+			for (int i = 0; i < (int)actorList.size(); ++i)
+			{
+				Entity* actor = actorList[i];
+				if (!CheckEntityIsAlive(actor))
+				{
+					continue;
+				}
+				m_actorBroadphase.GetEntitiesNearDisc(actor->m_position, actor->m_physicsRadius, m_nearbyActors);
+				for (int j = 0; j < (int)m_nearbyActors.size(); ++j)
+				{
+					Entity* nearbyActor = m_nearbyActors[j];
+					if (nearbyActor != actor && IsCollisionPairChecked(actor->m_entityType, nearbyActor->m_entityType) && CheckEntityIsAlive(nearbyActor)
+						&& DoEntitiesOverlap(*actor, *nearbyActor))
+					{
+						++numPairs;
+					}
+				}
+			}
+
+			// the bullets of this faction against the actors of the other one
+			if (faction == FACTION_NEUTRAL)
+			{
+				continue;
+			}
+			EntityFaction targetFaction = (faction == FACTION_GOOD) ? FACTION_EVIL : FACTION_GOOD;
+			EntityPtrList& bulletList = m_bulletPtrListByType[faction];
+			for (int i = 0; i < (int)bulletList.size(); ++i)
+			{
+				Entity* bullet = bulletList[i];
+				if (!IsEntityPointerValid_And_TheEntityIsAlive(bullet))
+				{
+					continue;
+				}
+				m_actorBroadphase.GetEntitiesNearDisc(bullet->m_position, bullet->m_physicsRadius, m_nearbyActors);
+				for (int j = 0; j < (int)m_nearbyActors.size(); ++j)
+				{
+					Entity* actor = m_nearbyActors[j];
+					if (actor->m_entityFaction == targetFaction && IsEntityPointerValid_And_TheEntityIsAlive(actor) && DoEntitiesOverlap(*bullet, *actor))
+					{
+						++numPairs;
+					}
+				}
+			}
+		}
+		return numPairs;
+	}
+
+	for (int typeA = 0; typeA < NUM_ENTITY_TYPES; ++typeA)
+	{
+		for (int typeB = 0; typeB < NUM_ENTITY_TYPES; ++typeB)
+		{
+			if (!IsCollisionPairChecked((EntityType)typeA, (EntityType)typeB))
+			{
+				continue;
+			}
+			EntityPtrList& listA = m_entityPtrListByType[typeA];
+			EntityPtrList& listB = m_entityPtrListByType[typeB];
+			for (int i = 0; i < (int)listA.size(); ++i)
+			{
+				for (int j = 0; j < (int)listB.size(); ++j)
+				{
+					if (listA[i] != listB[j] && CheckEntityIsAlive(listA[i]) && CheckEntityIsAlive(listB[j]) && DoEntitiesOverlap(*listA[i], *listB[j]))
+					{
+						++numPairs;
+					}
+				}
+			}
+		}
+	}
+	EntityFaction const bulletFactions[2] = { FACTION_GOOD, FACTION_EVIL };
+	for (int factionIndex = 0; factionIndex < 2; ++factionIndex)
+	{
+		EntityPtrList& bulletList = m_bulletPtrListByType[bulletFactions[factionIndex]];
+		EntityPtrList& actorList = m_actorPtrListByType[bulletFactions[1 - factionIndex]];
+		for (int i = 0; i < (int)bulletList.size(); ++i)
+		{
+			for (int j = 0; j < (int)actorList.size(); ++j)
+			{
+				if (IsEntityPointerValid_And_TheEntityIsAlive(bulletList[i]) && IsEntityPointerValid_And_TheEntityIsAlive(actorList[j])
+					&& DoEntitiesOverlap(*bulletList[i], *actorList[j]))
+				{
+					++numPairs;
+				}
+			}
+		}
+	}
+	return numPairs;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// bullet hell stress test, the bullets are topped up every frame and the collisions are timed, every other frame through the broadphase
+void Map::StartCollisionStressTest(int numBullets, int numFrames)
+{
+	m_collisionStressBullets = numBullets;
+	m_collisionStressFramesLeft = numFrames;
+	m_collisionStressFrames[0] = 0;
+	m_collisionStressFrames[1] = 0;
+	m_collisionStressSeconds[0] = 0.0;
+	m_collisionStressSeconds[1] = 0.0;
+	m_collisionStressPairs = 0;
+	m_collisionStressPairMismatches = 0;
+	m_useCollisionBroadphase = true;
+}
+
+void Map::UpdateCollisionStressTest()
+{
+	int numLivingBullets = 0;
+	for (int faction = 0; faction < NUM_FACTION; ++faction)
+	{
+		EntityPtrList& bulletList = m_bulletPtrListByType[faction];
+		for (int i = 0; i < (int)bulletList.size(); ++i)
+		{
+			numLivingBullets += IsEntityPointerValid_And_TheEntityIsAlive(bulletList[i]) ? 1 : 0;
+		}
+	}
+	for (int bulletIndex = numLivingBullets; bulletIndex < m_collisionStressBullets; ++bulletIndex)
+	{
+		EntityType bulletType = (bulletIndex % 2 == 0) ? ENTITY_TYPE_GOOD_BULLET : ENTITY_TYPE_EVIL_BULLET;
+		SpawnNewEntity(bulletType, GetRandomNotSolidNotWaterTilePos(), g_rng->RollRandomFloatInRange(0.f, 360.f));
+	}
+
+	int numBroadphasePairs = CountCollidingPairs(true);
+	int numBruteForcePairs = CountCollidingPairs(false);
+	m_collisionStressPairs += numBruteForcePairs;
+	if (numBroadphasePairs != numBruteForcePairs)
+	{
+		++m_collisionStressPairMismatches;
+	}
+}
+
+void Map::ReportCollisionStressTest()
+{
+	int numFrames = m_collisionStressFrames[0] + m_collisionStressFrames[1];
+	double bruteForceMillisecondsPerFrame = m_collisionStressSeconds[0] * 1000.0 / (m_collisionStressFrames[0] > 0 ? m_collisionStressFrames[0] : 1);
+	double broadphaseMillisecondsPerFrame = m_collisionStressSeconds[1] * 1000.0 / (m_collisionStressFrames[1] > 0 ? m_collisionStressFrames[1] : 1);
+	g_theDevConsole->AddLine(Stringf("BulletHellStress: %i bullets, %i frames", m_collisionStressBullets, numFrames), DevConsole::INFO_MAJOR);
+	g_theDevConsole->AddLine(Stringf("  collisions brute force: %.3f ms/frame, broadphase: %.3f ms/frame, %.1fx faster", bruteForceMillisecondsPerFrame,
+		broadphaseMillisecondsPerFrame, bruteForceMillisecondsPerFrame / broadphaseMillisecondsPerFrame), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  %.1f colliding pairs per frame, %i frames with different pairs", (float)m_collisionStressPairs / (float)numFrames,
+		m_collisionStressPairMismatches), DevConsole::INFO_MINOR);
+
+	bool passed = (m_collisionStressPairMismatches == 0);
+	g_theDevConsole->AddLine(Stringf("BulletHellStress %s", passed ? "PASSED" : "FAILED"), passed ? DevConsole::INFO_MAJOR : DevConsole::INFO_ERROR);
+	m_collisionStressBullets = 0;
+}
+
+bool Map::IsCollisionPairChecked(EntityType typeA, EntityType typeB) const
+{
+	switch (typeA)
+	{
+	case ENTITY_TYPE_GOOD_PLAYER:	return typeB == ENTITY_TYPE_EVIL_SCORPIO || typeB == ENTITY_TYPE_EVIL_ARIES || typeB == ENTITY_TYPE_EVIL_LEO;
+	case ENTITY_TYPE_EVIL_LEO:		return typeB == ENTITY_TYPE_EVIL_LEO || typeB == ENTITY_TYPE_EVIL_ARIES || typeB == ENTITY_TYPE_EVIL_SCORPIO;
+	case ENTITY_TYPE_EVIL_ARIES:	return typeB == ENTITY_TYPE_EVIL_ARIES || typeB == ENTITY_TYPE_EVIL_SCORPIO;
+	default:						break;
+	}
+	return false;
 }
 
 void Map::CheckEntityTypeListCollision(EntityPtrList& listA, EntityPtrList& listB)
@@ -623,6 +1027,45 @@ void Map::CheckBulletHit(float deltaSeconds)
 {
 	UNUSED(deltaSeconds);
 
+	if (!m_useCollisionBroadphase)
+	{
+		CheckBulletHitBruteForce();
+		return;
+	}
+	RebuildActorBroadphase(); // the pushes have moved the actors
+	CheckBulletHitsOnFaction(FACTION_GOOD, FACTION_EVIL);
+	CheckBulletHitsOnFaction(FACTION_EVIL, FACTION_GOOD);
+}
+
+// the bullet lists only ever hold bullets, so they are cast without checking
+void Map::CheckBulletHitsOnFaction(EntityFaction bulletFaction, EntityFaction actorFaction)
+{
+	EntityPtrList& bulletList = m_bulletPtrListByType[bulletFaction];
+	for (int i = 0; i < (int)bulletList.size(); ++i)
+	{
+		Entity* bullet = bulletList[i];
+		if (!IsEntityPointerValid_And_TheEntityIsAlive(bullet))
+		{
+			continue;
+		}
+		m_actorBroadphase.GetEntitiesNearDisc(bullet->m_position, bullet->m_physicsRadius, m_nearbyActors);
+		for (int j = 0; j < (int)m_nearbyActors.size(); ++j)
+		{
+			Entity* actor = m_nearbyActors[j];
+			if (actor->m_entityFaction != actorFaction || !IsEntityPointerValid_And_TheEntityIsAlive(actor))
+			{
+				continue;
+			}
+			if (DoEntitiesOverlap(*bullet, *actor))
+			{
+				actor->ReactToBulletHit(*static_cast<Bullet*>(bullet));
+			}
+		}
+	}
+}
+
+void Map::CheckBulletHitBruteForce()
+{
 	// check with good bullet faction with evil actor faction
 	EntityPtrList& goodBulletList = m_bulletPtrListByType[FACTION_GOOD];
 	for (int i = 0; i < (int)goodBulletList.size(); ++i)
@@ -748,9 +1191,9 @@ void Map::RenderHeatMap() const
 	case HeatMapAnalysis::FIRST_LEO_PATHING : // will draw the heat map for the first leo
 	{
 		Entity* const& leo = m_entityPtrListByType[ENTITY_TYPE_EVIL_LEO][0];
-		if (leo)
+		if (leo && leo->m_flowField)
 		{
-			DrawHeatMap(*leo->m_heatMap);
+			DrawHeatMap(leo->m_flowField->m_distanceField);
 
 			std::vector<Vertex_PCU> verts;
 			Vec2 tailPos = leo->m_position + 1600.f * Vec2(1.f, 1.f);
@@ -840,6 +1283,10 @@ void Map::AddEntityToMap(Entity& e)
 	entityPtr->m_map = this;
 	AddEntityToList(entityPtr, m_allEntitiesOnThisMap);
 	AddEntityToList(entityPtr, m_entityPtrListByType[entityPtr->m_entityType]);// add entity to list according to the entity type
+	if (entityPtr->m_entityType == ENTITY_TYPE_EVIL_SCORPIO)
+	{
+		m_flowFieldCache.InvalidateAllFlowFields(); // the scorpios block the way
+	}
 	// add entity to list according to if there is actor of projectile
 	// then put them according to their faction
 	// todo:???? when should put them into different faction list
@@ -1020,6 +1467,10 @@ void Map::RemoveEntityFromMap(Entity& e)
 	Entity* entityPtr = &e;
 
 	RemoveEntityFromList(entityPtr, m_entityPtrListByType[entityPtr->m_entityType]); // todo:??? may throw an error when in debug mode
+	if (entityPtr->m_entityType == ENTITY_TYPE_EVIL_SCORPIO)
+	{
+		m_flowFieldCache.InvalidateAllFlowFields();
+	}
 
 	RemoveEntityFromList(entityPtr, m_allEntitiesOnThisMap);
 
@@ -1147,6 +1598,41 @@ bool Map::IsPointInSolid(Vec2 referencePointPos)
 }
 
 void Map::PopulateDistanceField(TileHeatMap& distanceField, IntVec2 startCoords, float maxCost, bool treatWaterAsSolid, bool treatScorpioAsSolid) const
+{
+	SetUpDistanceFieldBlockedTiles(treatWaterAsSolid, treatScorpioAsSolid);
+	m_distanceFieldBuilder.PopulateDistanceField(distanceField, startCoords, maxCost);
+}
+
+// solid tiles always block, the water tiles and the tiles of the living scorpios only when asked to
+void Map::SetUpDistanceFieldBlockedTiles(bool treatWaterAsSolid, bool treatScorpioAsSolid) const
+{
+	std::vector<uint64_t>& blockedTileBits = m_distanceFieldBuilder.m_blockedTileBits;
+	blockedTileBits = m_solidTileBits;
+	if (treatWaterAsSolid)
+	{
+		for (int wordIndex = 0; wordIndex < (int)blockedTileBits.size(); ++wordIndex)
+		{
+			blockedTileBits[wordIndex] |= m_waterTileBits[wordIndex];
+		}
+	}
+	if (treatScorpioAsSolid)
+	{
+		for (int i = 0; i < (int)m_entityPtrListByType[ENTITY_TYPE_EVIL_SCORPIO].size(); ++i)
+		{
+			Entity* const& scorpio = m_entityPtrListByType[ENTITY_TYPE_EVIL_SCORPIO][i];
+			if (scorpio && CheckEntityIsAlive(scorpio))
+			{
+				IntVec2 scorpioTileCoords = GetTileCoordsInMap_For_WorldPos(scorpio->m_position);
+				if (!IsTileOutOfBounds(scorpioTileCoords))
+				{
+					m_distanceFieldBuilder.SetTileBlocked(GetTileIndex_For_TileCoordinates(scorpioTileCoords), true);
+				}
+			}
+		}
+	}
+}
+
+void Map::PopulateDistanceFieldBySweeping(TileHeatMap& distanceField, IntVec2 startCoords, float maxCost, bool treatWaterAsSolid, bool treatScorpioAsSolid) const
 {
 	distanceField.SetDefaultHeatValueForAllTiles(maxCost);
 	distanceField.SetHeatValueForTile(startCoords, 0.f);
@@ -3,6 +3,8 @@
 #include "Engine/Math/Vec2.hpp"
 #include "Game/Entity.hpp"
 #include "Engine/core/HeatMaps.hpp"
+#include "Game/FlowField.hpp"
+#include "Game/EntityBroadphase.hpp"
 #include "Engine/core/XmlUtils.hpp"
 #include <vector>
 #include <string>
@@ -94,6 +96,31 @@ public:
 	// could combine all enemy firing
 	void CheckBulletHit(float deltaSeconds);
 
+	// the actors sit in a grid rebuilt before the pushes and the bullet hits, so only actors near each other are tested
+	// the brute force versions test every list against every other list like it used to, BulletHellStress times them against each other
+	void RebuildActorBroadphase();
+	bool IsCollisionPairChecked(EntityType typeA, EntityType typeB) const; // the type pairs that push, the first one of the pair is pushed by the second
+	void PushActorsOutOfEachOther();
+	void PushActorsOutOfEachOtherBruteForce();
+	void CheckBulletHitsOnFaction(EntityFaction bulletFaction, EntityFaction actorFaction);
+	void CheckBulletHitBruteForce();
+	int  CountCollidingPairs(bool useBroadphase); // the pushes and the bullet hits this frame would make, without making them
+
+	EntityBroadphase		m_actorBroadphase;
+	std::vector<Entity*>	m_nearbyActors;
+	bool					m_useCollisionBroadphase = true;
+
+	// bullet hell stress test, see BulletHellStress in App
+	void	StartCollisionStressTest(int numBullets, int numFrames);
+	void	UpdateCollisionStressTest(); // keeps the bullets topped up and checks both ways find the same pairs
+	void	ReportCollisionStressTest();
+	int		m_collisionStressBullets = 0;
+	int		m_collisionStressFramesLeft = 0;
+	int		m_collisionStressFrames[2] = {};		// brute force, broadphase
+	double	m_collisionStressSeconds[2] = {};
+	int		m_collisionStressPairs = 0;
+	int		m_collisionStressPairMismatches = 0;	// frames the broadphase and the brute force found a different number of pairs
+
 	// render tile verts and entities verts separately
 	void AddVertsForTiles(std::vector<Vertex_PCU>& verts, int tileIndex) const;
 	void Render() const;
@@ -104,7 +131,7 @@ public:
 	void RenderHeatMap() const;
 	void DrawHeatMap(TileHeatMap heatMap) const;
 
-	TileHeatMap* m_exitDistanceField;
+	TileHeatMap* m_exitDistanceField = nullptr;
 	std::vector<Vertex_PCU> m_exitHeatMapVerts;
 
 	// functions used to get tile index information
@@ -138,11 +165,46 @@ public:
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
 	// heat maps
 	void GenerateTiles_And_CheckIfMapIsSolvable();
+	bool MakeGeneratedMapSolvable();
+	bool IsTileInBorderOrSafeZone(IntVec2 const& tileCoords) const;
+	// the old way of regenerating the whole map and flooding it again until the exit is reachable, only kept for MapGenerationBenchmark,
+	// returns how many maps it generated
+	int  GenerateTilesByRegenerating();
 	bool CheckIfGeneratedMapIsSolvable();
 	void PopulateDistanceField(TileHeatMap& distanceField, IntVec2 startCoords, float maxCost, bool treatWaterAsSolid=true, bool treatScorpioAsSolid = false) const;
+	void SetUpDistanceFieldBlockedTiles(bool treatWaterAsSolid, bool treatScorpioAsSolid) const;
+	// the old ring by ring sweep over the whole map, only kept for DistanceFieldBenchmark to check the bucket queue against
+	void PopulateDistanceFieldBySweeping(TileHeatMap& distanceField, IntVec2 startCoords, float maxCost, bool treatWaterAsSolid = true, bool treatScorpioAsSolid = false) const;
 	void SetHeatIfLessAndNotSolid( bool& isBlocked, TileHeatMap& distanceField, IntVec2 tileCoords, float compareValue, bool treatWaterAsSolid = true, bool treatScorpioAsSolid = false) const;
 	// void PopulateDistanceFieldForEntityPathing(Entity* entityPtr, IntVec2 startCoords, float maxCost) const;
 
+	mutable TileDistanceFieldBuilder m_distanceFieldBuilder;
+	std::vector<uint64_t> m_solidTileBits; // one bit per tile like the builder's blocked tiles, kept up to date by SetTileType
+	std::vector<uint64_t> m_waterTileBits;
+	FlowFieldCache m_flowFieldCache; // invalidated whenever a tile changes or a scorpio comes or goes
+
+	// map generation, every worm step remembers the tile it changed so the ones that walled the exit off could be undone
+	struct WormStep
+	{
+		int							m_tileIndex = 0;
+		TileTypeDefinition const*	m_previousTileDef = nullptr;
+	};
+	std::vector<WormStep>	m_wormSteps;
+	TileConnectivity		m_tileConnectivity; // the tiles a tank could drive on, water counts as solid
+	int						m_numMapRegenerations = 0; // whole maps thrown away because undoing the worms was not enough
+	int						m_numWormStepsUndone = 0;
+
+	// AI stress test, see FlowFieldStress in App
+	void	StartAIStressTest(int numFrames);
+	void	ReportAIStressTest();
+	bool	IsAIEntity(EntityType type) const;
+	int		m_aiStressFramesLeft = 0;
+	int		m_aiStressFrames = 0;
+	double	m_aiStressSeconds = 0.0;
+	double	m_aiStressWorstFrameSeconds = 0.0;
+	int		m_aiStressFlowFieldsBuiltAtStart = 0;
+	int		m_aiStressFlowFieldsSharedAtStart = 0;
+
 	EntityPtrList	m_allEntitiesOnThisMap;
 	EntityPtrList	m_entityPtrListByType[NUM_ENTITY_TYPES];
 	// std::vector<EntityPtrList*> m_entityPtrList[NUM_ENTITY_TYPES];
@@ -9,15 +9,23 @@
 #include "Engine/Input/InputSystem.hpp"
 #include "Engine/Renderer/DebugRender.hpp"
 #include "Engine/core/DevConsole.hpp"
+#include "Engine/core/FileUtils.hpp"
 #include "Engine/Math/RandomNumberGenerator.hpp"
 #include "Game/ShiningTriangle.hpp"
 #include "Game/App.hpp"
 #include "Game/Game.hpp"
+#include "Game/Player.hpp"
+#include "Game/World.hpp"
+#include "Game/ChunkMesher.hpp"
+#include "ThirdParty/Noise_Squirrel/RawNoise.hpp"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <math.h>
  
 extern App* g_theApp;// global variable must be define in the cpp
 extern Clock* g_theGameClock;
+extern World* g_theWorld;
 
 Game* g_theGame = nullptr;
 Renderer* g_theRenderer = nullptr;
@@ -126,6 +134,23 @@ void App :: Startup ()
 
 	// set up event system subscription
 	SubscribeEventCallbackFunction("quit", App::Event_Quit);
+	SubscribeEventCallbackFunction("JobSystemBenchmark", App::Command_JobSystemBenchmark);
+	SubscribeEventCallbackFunction("ChunkStreamingReplay", App::Command_ChunkStreamingReplay);
+	SubscribeEventCallbackFunction("JobSystemRetrieveTest", App::Command_JobSystemRetrieveTest);
+	SubscribeEventCallbackFunction("ChunkRegistryBenchmark", App::Command_ChunkRegistryBenchmark);
+	SubscribeEventCallbackFunction("ChunkStreamingIOTest", App::Command_ChunkStreamingIOTest);
+	SubscribeEventCallbackFunction("ChunkRegionBenchmark", App::Command_ChunkRegionBenchmark);
+	SubscribeEventCallbackFunction("ChunkSerializationBenchmark", App::Command_ChunkSerializationBenchmark);
+	SubscribeEventCallbackFunction("ChunkMemoryReport", App::Command_ChunkMemoryReport);
+	SubscribeEventCallbackFunction("ChunkMesherBenchmark", App::Command_ChunkMesherBenchmark);
+	SubscribeEventCallbackFunction("UseGreedyMesher", App::Command_UseGreedyMesher);
+	SubscribeEventCallbackFunction("LightingBenchmark", App::Command_LightingBenchmark);
+	SubscribeEventCallbackFunction("UseWavefrontLighting", App::Command_UseWavefrontLighting);
+	SubscribeEventCallbackFunction("ChunkGenerationBenchmark", App::Command_ChunkGenerationBenchmark);
+	SubscribeEventCallbackFunction("UseBatchNoise", App::Command_UseBatchNoise);
+	SubscribeEventCallbackFunction("ChunkGenerationDeterminismTest", App::Command_ChunkGenerationDeterminismTest);
+	SubscribeEventCallbackFunction("BlockTypeBenchmark", App::Command_BlockTypeBenchmark);
+	SubscribeEventCallbackFunction("VoxelRaycastBenchmark", App::Command_VoxelRaycastBenchmark);
 	// show helper commands at the start when the console is turned on
 	FireEvent("ControlInstructions");
 
@@ -163,6 +188,7 @@ void App::LoadGameConfigXml()
 void App::LoadGameShader()
 {
 	g_shaders[WORLD] = g_theRenderer->CreateOrGetShader("Data/Shaders/World", VertexType::Vertex_PCU);
+	g_shaders[WORLD_VOXEL] = g_theRenderer->CreateOrGetShader("Data/Shaders/WorldVoxel", VertexType::Vertex_Voxel);
 }
 
 bool App :: IsQuitting()const
@@ -595,16 +621,1857 @@ void App::GenerateAndQueueNumJobsForJobSystem(int numJobs)
 	}
 }
 
+// only the test jobs, the chunk generation jobs in the same job system belong to the world
 void App::RetrieveOneCompletedJob()
 {
-	g_theJobSystem->RetrieveCompletedJobs(nullptr);	
+	for (int jobIndex = 0; jobIndex < (int)m_jobs.size(); ++jobIndex)
+	{
+		if (m_jobs[jobIndex]->m_jobStatus == JobStatus::COMPLETED)
+		{
+			g_theJobSystem->RetrieveCompletedJobs(m_jobs[jobIndex]);
+			return;
+		}
+	}
 }
 
 void App::RetrieveAllCompletedJobs()
 {
-	while (g_theJobSystem->m_completedJobs.size() != 0)
+	std::vector<TestJob*> completedJobs;
+	g_theJobSystem->RetrieveAllCompletedJobs(completedJobs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// job system benchmark
+// usage in dev console: "JobSystemBenchmark numJobs = 1000000"
+// runs the same tiny jobs through the work stealing job system and through a copy of the old single mutex queue,
+// then leaves both idle for a moment to see how much CPU the sleeping workers still burn
+void BenchmarkTinyJob::Execute()
+{
+	// a few rounds of integer hashing, cheap enough that the queueing cost dominates
+	unsigned int value = m_input;
+	for (int i = 0; i < 8; ++i)
+	{
+		value ^= value >> 16;
+		value *= 0x7feb352d;
+		value ^= value >> 15;
+	}
+	m_result = value;
+}
+
+// the job queue as it was before work stealing: one deque behind one mutex, idle workers sleep for 1us and poll again
+class LegacyMutexJobQueue
+{
+public:
+	LegacyMutexJobQueue(int numWorkers)
+	{
+		for (int i = 0; i < numWorkers; ++i)
+		{
+			m_workers.push_back(new std::thread(&LegacyMutexJobQueue::WorkerMain, this));
+		}
+	}
+
+	~LegacyMutexJobQueue()
+	{
+		m_isShuttingDown = true;
+		for (int i = 0; i < (int)m_workers.size(); ++i)
+		{
+			m_workers[i]->join();
+			delete m_workers[i];
+		}
+	}
+
+	void QueueJob(Job* job)
+	{
+		m_queuedJobsMutex.lock();
+		m_queuedJobs.push_back(job);
+		m_queuedJobsMutex.unlock();
+	}
+
+	Job* RetrieveCompletedJob()
+	{
+		Job* job = nullptr;
+		m_completedJobsMutex.lock();
+		if (!m_completedJobs.empty())
+		{
+			job = m_completedJobs.front();
+			m_completedJobs.pop_front();
+		}
+		m_completedJobsMutex.unlock();
+		return job;
+	}
+
+	std::vector<std::thread*> const& GetWorkerThreads() const { return m_workers; }
+
+private:
+	void WorkerMain()
+	{
+		while (!m_isShuttingDown)
+		{
+			Job* job = nullptr;
+			m_queuedJobsMutex.lock();
+			if (!m_queuedJobs.empty())
+			{
+				job = m_queuedJobs.front();
+				m_queuedJobs.pop_front();
+			}
+			m_queuedJobsMutex.unlock();
+
+			if (job)
+			{
+				job->Execute();
+				m_completedJobsMutex.lock();
+				m_completedJobs.push_back(job);
+				m_completedJobsMutex.unlock();
+			}
+			else
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(1));
+			}
+		}
+	}
+
+	std::atomic<bool>			m_isShuttingDown = false;
+	std::deque<Job*>			m_queuedJobs;
+	std::mutex					m_queuedJobsMutex;
+	std::deque<Job*>			m_completedJobs;
+	std::mutex					m_completedJobsMutex;
+	std::vector<std::thread*>	m_workers;
+};
+
+// how busy the benchmark's own worker threads are while nothing is queued, in percentage of those threads
+// only their CPU time counts, the game's job system, the I/O worker and the render thread keep running in the same process
+static float MeasureIdleCPUPercentage(std::vector<std::thread*> const& workerThreads, float idleSeconds)
+{
+	std::vector<double> cpuAtStart(workerThreads.size());
+	for (int threadIndex = 0; threadIndex < (int)workerThreads.size(); ++threadIndex)
+	{
+		cpuAtStart[threadIndex] = GetThreadCPUSeconds(workerThreads[threadIndex]->native_handle());
+	}
+	double timeAtStart = GetCurrentTimeSeconds();
+	std::this_thread::sleep_for(std::chrono::milliseconds(int(idleSeconds * 1000.f)));
+	double cpuSeconds = 0.0;
+	for (int threadIndex = 0; threadIndex < (int)workerThreads.size(); ++threadIndex)
+	{
+		cpuSeconds += GetThreadCPUSeconds(workerThreads[threadIndex]->native_handle()) - cpuAtStart[threadIndex];
+	}
+	double wallSeconds = GetCurrentTimeSeconds() - timeAtStart;
+	return float(100.0 * cpuSeconds / (wallSeconds * double(workerThreads.size())));
+}
+
+bool App::Command_JobSystemBenchmark(EventArgs& args)
+{
+	int numJobs = args.GetValue("numJobs", 1000000);
+	int numWorkers = g_theJobSystem->GetNumWorkers();
+	if (numJobs <= 0 || numWorkers <= 0)
+	{
+		g_theDevConsole->AddLine("JobSystemBenchmark needs numJobs > 0 and at least one worker", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	std::vector<BenchmarkTinyJob> jobs(numJobs);
+	for (int i = 0; i < numJobs; ++i)
+	{
+		jobs[i].m_input = (unsigned int)i;
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------------------------------------
+	// work stealing job system, a separate one so the game's chunk jobs do not get mixed in
+	double stealingSeconds = 0.0;
+	float stealingIdleCPU = 0.f;
+	{
+		JobSystemConfig benchmarkConfig;
+		benchmarkConfig.numberOfWorkers = numWorkers;
+		benchmarkConfig.numIOWorkers = 0;
+		JobSystem benchmarkJobSystem(benchmarkConfig);
+		benchmarkJobSystem.Startup();
+
+		double timeAtStart = GetCurrentTimeSeconds();
+		for (int i = 0; i < numJobs; ++i)
+		{
+			benchmarkJobSystem.QueueJobs(&jobs[i]);
+		}
+		std::vector<BenchmarkTinyJob*> completedJobs;
+		completedJobs.reserve(numJobs);
+		while ((int)completedJobs.size() < numJobs)
+		{
+			benchmarkJobSystem.RetrieveAllCompletedJobs(completedJobs);
+		}
+		stealingSeconds = GetCurrentTimeSeconds() - timeAtStart;
+		std::vector<std::thread*> workerThreads;
+		for (int workerIndex = 0; workerIndex < (int)benchmarkJobSystem.m_workers.size(); ++workerIndex)
+		{
+			workerThreads.push_back(benchmarkJobSystem.m_workers[workerIndex]->m_thread);
+		}
+		stealingIdleCPU = MeasureIdleCPUPercentage(workerThreads, 0.5f);
+
+		benchmarkJobSystem.ShutDown();
+	}
+
+	//----------------------------------------------------------------------------------------------------------------------------------------------------
+	// old single mutex queue
+	double legacySeconds = 0.0;
+	float legacyIdleCPU = 0.f;
+	{
+		LegacyMutexJobQueue legacyQueue(numWorkers);
+
+		double timeAtStart = GetCurrentTimeSeconds();
+		for (int i = 0; i < numJobs; ++i)
+		{
+			legacyQueue.QueueJob(&jobs[i]);
+		}
+		int numRetrievedJobs = 0;
+		while (numRetrievedJobs < numJobs)
+		{
+			if (legacyQueue.RetrieveCompletedJob())
+			{
+				++numRetrievedJobs;
+			}
+		}
+		legacySeconds = GetCurrentTimeSeconds() - timeAtStart;
+		legacyIdleCPU = MeasureIdleCPUPercentage(legacyQueue.GetWorkerThreads(), 0.5f);
+	}
+
+	g_theDevConsole->AddLine(Stringf("JobSystemBenchmark: %i tiny jobs, %i workers", numJobs, numWorkers), DevConsole::INFO_MAJOR);
+	g_theDevConsole->AddLine(Stringf("  work stealing: %.2f ms, %.0f jobs/s, idle CPU %.1f%%", stealingSeconds * 1000.0, double(numJobs) / stealingSeconds, stealingIdleCPU), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  single mutex : %.2f ms, %.0f jobs/s, idle CPU %.1f%%", legacySeconds * 1000.0, double(numJobs) / legacySeconds, legacyIdleCPU), DevConsole::INFO_MINOR);
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// completed job retrieval test
+// usage in dev console: "JobSystemRetrieveTest numJobs = 100000"
+// every job has to come back exactly once through the batch retrieval, the generic ones must not show up in the benchmark list
+class RetrieveTestGenericJob : public Job
+{
+public:
+	void Execute() override {}
+};
+
+bool App::Command_JobSystemRetrieveTest(EventArgs& args)
+{
+	int numJobs = args.GetValue("numJobs", 100000);
+	if (numJobs <= 0)
+	{
+		g_theDevConsole->AddLine("JobSystemRetrieveTest needs numJobs > 0", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	JobSystemConfig testConfig;
+	testConfig.numberOfWorkers = g_theJobSystem->GetNumWorkers();
+	testConfig.numIOWorkers = 0;
+	JobSystem testJobSystem(testConfig);
+	testJobSystem.Startup();
+
+	// every other job is of another type, they have to stay out of each other's lists
+	std::vector<Job*> jobs;
+	jobs.reserve(numJobs);
+	for (int jobIndex = 0; jobIndex < numJobs; ++jobIndex)
+	{
+		Job* job = nullptr;
+		if (jobIndex % 2 == 0)
+		{
+			BenchmarkTinyJob* benchmarkJob = new BenchmarkTinyJob();
+			benchmarkJob->m_input = (unsigned int)jobIndex; // used to find it again
+			job = benchmarkJob;
+		}
+		else
+		{
+			job = new RetrieveTestGenericJob();
+		}
+		jobs.push_back(job);
+	}
+
+	double timeAtStart = GetCurrentTimeSeconds();
+	for (int jobIndex = 0; jobIndex < numJobs; ++jobIndex)
+	{
+		testJobSystem.QueueJobs(jobs[jobIndex]);
+	}
+
+	// retrieve in batches until everything is back or it takes way too long
+	std::vector<BenchmarkTinyJob*> benchmarkJobs;
+	std::vector<Job*> genericJobs;
+	int numBatches = 0;
+	int numExpectedBenchmarkJobs = (numJobs + 1) / 2;
+	int numExpectedGenericJobs = numJobs / 2;
+	while ((int)benchmarkJobs.size() < numExpectedBenchmarkJobs || (int)genericJobs.size() < numExpectedGenericJobs)
+	{
+		testJobSystem.RetrieveAllCompletedJobs(benchmarkJobs);
+		testJobSystem.RetrieveAllCompletedJobs(genericJobs, JOB_TYPE_GENERIC);
+		++numBatches;
+		if (GetCurrentTimeSeconds() - timeAtStart > 30.0)
+		{
+			break;
+		}
+	}
+	double retrieveSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	// nothing must be left behind after the last batch
+	testJobSystem.RetrieveAllCompletedJobs(benchmarkJobs);
+	testJobSystem.RetrieveAllCompletedJobs(genericJobs, JOB_TYPE_GENERIC);
+	testJobSystem.ShutDown();
+
+	int numDuplicates = 0;
+	int numWrongType = 0;
+	int numNotRetrieved = 0;
+	std::vector<unsigned char> timesSeen(numJobs, 0);
+	for (int i = 0; i < (int)benchmarkJobs.size(); ++i)
+	{
+		BenchmarkTinyJob* job = benchmarkJobs[i];
+		int jobIndex = (int)job->m_input;
+		if (jobIndex < 0 || jobIndex >= numJobs || jobs[jobIndex] != job)
+		{
+			++numWrongType;
+			continue;
+		}
+		if (timesSeen[jobIndex]++ > 0)
+		{
+			++numDuplicates;
+		}
+	}
+	for (int i = 0; i < (int)genericJobs.size(); ++i)
+	{
+		if (genericJobs[i]->m_jobType != JOB_TYPE_GENERIC)
+		{
+			++numWrongType;
+		}
+	}
+	for (int jobIndex = 0; jobIndex < numJobs; ++jobIndex)
+	{
+		if (jobs[jobIndex]->m_jobStatus != JobStatus::RETRIEVED)
+		{
+			++numNotRetrieved;
+		}
+		if (jobIndex % 2 == 0 && timesSeen[jobIndex] == 0)
+		{
+			++numNotRetrieved;
+		}
+	}
+	int numGenericExtra = (int)genericJobs.size() - numExpectedGenericJobs;
+	if (numGenericExtra > 0)
+	{
+		numDuplicates += numGenericExtra;
+	}
+
+	for (int jobIndex = 0; jobIndex < numJobs; ++jobIndex)
+	{
+		delete jobs[jobIndex];
+	}
+
+	bool passed = (numDuplicates == 0 && numWrongType == 0 && numNotRetrieved == 0);
+	g_theDevConsole->AddLine(Stringf("JobSystemRetrieveTest %s: %i jobs retrieved in %i batches, %.2f ms", passed ? "PASSED" : "FAILED", numJobs, numBatches, retrieveSeconds * 1000.0), passed ? DevConsole::INFO_MAJOR : DevConsole::INFO_ERROR);
+	g_theDevConsole->AddLine(Stringf("  duplicates %i, wrong type %i, missing %i", numDuplicates, numWrongType, numNotRetrieved), DevConsole::INFO_MINOR);
+	return passed;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// chunk streaming replay
+// usage in dev console: "ChunkStreamingReplay" or "ChunkStreamingReplay prioritize = false" to fly the same path with FIFO chunk jobs
+// the result is printed when the path is finished
+bool App::Command_ChunkStreamingReplay(EventArgs& args)
+{
+	if (!g_theWorld)
+	{
+		g_theDevConsole->AddLine("ChunkStreamingReplay needs a world, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	bool prioritizeChunkJobs = args.GetValue("prioritize", true);
+	float flySpeed = args.GetValue("speed", 40.f);
+	g_theWorld->RequestChunkStreamingReplay(prioritizeChunkJobs, flySpeed);
+	return true;
+}
+
+// usage in dev console: "ChunkStreamingIOTest" or "ChunkStreamingIOTest speed = 80"
+// flies the replay path twice from the same start, the first run saves every chunk and the second loads them back
+// it fails if the main thread opened any file during the second run, every load and save has to go through the I/O lane
+bool App::Command_ChunkStreamingIOTest(EventArgs& args)
+{
+	if (!g_theWorld)
+	{
+		g_theDevConsole->AddLine("ChunkStreamingIOTest needs a world, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	float flySpeed = args.GetValue("speed", 40.f);
+	g_theWorld->RequestChunkStreamingIOTest(flySpeed);
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// chunk registry benchmark
+// usage in dev console: "ChunkRegistryBenchmark numSteps = 2000"
+// the player walks one chunk east per step with MAX_CHUNKS around it: the column that falls out of range is removed, the new one is added
+// with its four neighbor lookups, and the whole window is probed for the nearest missing chunk the way the activation used to every frame
+struct StdMapChunkRegistry
+{
+	int* Find(IntVec2 const& coords) const
+	{
+		std::map<IntVec2, int*>::const_iterator iter = m_map.find(coords);
+		return (iter == m_map.end()) ? nullptr : iter->second;
+	}
+	void Set(IntVec2 const& coords, int* value)	{ m_map[coords] = value; }
+	void Remove(IntVec2 const& coords)			{ m_map.erase(coords); }
+
+	std::map<IntVec2, int*> m_map;
+};
+
+struct HashMapChunkRegistry
+{
+	int* Find(IntVec2 const& coords) const			{ return m_map.Find(coords); }
+	void Set(IntVec2 const& coords, int* value)	{ m_map.Set(coords, value); }
+	void Remove(IntVec2 const& coords)			{ m_map.Remove(coords); }
+
+	ChunkCoordsHashMap<int> m_map = ChunkCoordsHashMap<int>(MAX_CHUNKS);
+};
+
+struct ChunkRegistryBenchmarkResult
+{
+	double	m_activateSeconds = 0.0;
+	double	m_deactivateSeconds = 0.0;
+	double	m_lookupSeconds = 0.0;
+	int		m_numActivations = 0;
+	int		m_numDeactivations = 0;
+	int		m_numLookups = 0;
+	int		m_numFound = 0; // printed so the compiler could not drop the lookups
+};
+
+template <typename RegistryType>
+static ChunkRegistryBenchmarkResult RunChunkRegistryBenchmark(int numSteps)
+{
+	ChunkRegistryBenchmarkResult result;
+	RegistryType activeChunks;
+	RegistryType chunksBeingGenerated;
+	static int s_dummyChunk = 0;
+
+	for (int step = 0; step < numSteps; ++step)
+	{
+		IntVec2 playerCoords(step, 0);
+
+		// deactivate the column behind the player
+		double timeAtStart = GetCurrentTimeSeconds();
+		if (step > 0)
+		{
+			for (int y = -MAX_CHUNK_RADIUS_Y; y < MAX_CHUNK_RADIUS_Y; ++y)
+			{
+				activeChunks.Remove(IntVec2(playerCoords.x - MAX_CHUNK_RADIUS_X - 1, y));
+				++result.m_numDeactivations;
+			}
+		}
+		result.m_deactivateSeconds += GetCurrentTimeSeconds() - timeAtStart;
+
+		// activate the new column in front, or the whole window on the first step
+		timeAtStart = GetCurrentTimeSeconds();
+		int firstNewColumnX = (step == 0) ? playerCoords.x - MAX_CHUNK_RADIUS_X : playerCoords.x + MAX_CHUNK_RADIUS_X - 1;
+		for (int x = firstNewColumnX; x < playerCoords.x + MAX_CHUNK_RADIUS_X; ++x)
+		{
+			for (int y = -MAX_CHUNK_RADIUS_Y; y < MAX_CHUNK_RADIUS_Y; ++y)
+			{
+				IntVec2 coords(x, y);
+				chunksBeingGenerated.Set(coords, &s_dummyChunk);
+				chunksBeingGenerated.Remove(coords);
+				result.m_numFound += activeChunks.Find(coords + IntVec2(1, 0)) ? 1 : 0;
+				result.m_numFound += activeChunks.Find(coords + IntVec2(-1, 0)) ? 1 : 0;
+				result.m_numFound += activeChunks.Find(coords + IntVec2(0, 1)) ? 1 : 0;
+				result.m_numFound += activeChunks.Find(coords + IntVec2(0, -1)) ? 1 : 0;
+				activeChunks.Set(coords, &s_dummyChunk);
+				++result.m_numActivations;
+			}
+		}
+		result.m_activateSeconds += GetCurrentTimeSeconds() - timeAtStart;
+
+		// look for the nearest missing chunk
+		timeAtStart = GetCurrentTimeSeconds();
+		for (int x = playerCoords.x - MAX_CHUNK_RADIUS_X; x <= playerCoords.x + MAX_CHUNK_RADIUS_X; ++x)
+		{
+			for (int y = -MAX_CHUNK_RADIUS_Y; y <= MAX_CHUNK_RADIUS_Y; ++y)
+			{
+				IntVec2 coords(x, y);
+				if (!chunksBeingGenerated.Find(coords))
+				{
+					result.m_numFound += activeChunks.Find(coords) ? 1 : 0;
+					++result.m_numLookups;
+				}
+				++result.m_numLookups;
+			}
+		}
+		result.m_lookupSeconds += GetCurrentTimeSeconds() - timeAtStart;
+	}
+	return result;
+}
+
+static void PrintChunkRegistryBenchmarkResult(char const* registryName, ChunkRegistryBenchmarkResult const& result)
+{
+	g_theDevConsole->AddLine(Stringf("  %s: activate %.1f M/s, deactivate %.1f M/s, lookup %.1f M/s (found %i)", registryName,
+		1e-6 * double(result.m_numActivations) / result.m_activateSeconds,
+		1e-6 * double(result.m_numDeactivations) / result.m_deactivateSeconds,
+		1e-6 * double(result.m_numLookups) / result.m_lookupSeconds,
+		result.m_numFound), DevConsole::INFO_MINOR);
+}
+
+bool App::Command_ChunkRegistryBenchmark(EventArgs& args)
+{
+	int numSteps = args.GetValue("numSteps", 2000);
+	if (numSteps <= 0)
+	{
+		g_theDevConsole->AddLine("ChunkRegistryBenchmark needs numSteps > 0", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	ChunkRegistryBenchmarkResult stdMapResult = RunChunkRegistryBenchmark<StdMapChunkRegistry>(numSteps);
+	ChunkRegistryBenchmarkResult hashMapResult = RunChunkRegistryBenchmark<HashMapChunkRegistry>(numSteps);
+
+	g_theDevConsole->AddLine(Stringf("ChunkRegistryBenchmark: %i steps, %i chunks active", numSteps, MAX_CHUNKS), DevConsole::INFO_MAJOR);
+	PrintChunkRegistryBenchmarkResult("std::map          ", stdMapResult);
+	PrintChunkRegistryBenchmarkResult("ChunkCoordsHashMap", hashMapResult);
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// chunk region benchmark
+// usage in dev console: "ChunkRegionBenchmark numChunks = 10000"
+// saves the same world once as one .chunk file per chunk and once converted into region files, then loads every chunk back
+// with nothing in memory, the way a new session starts, and probes as many chunks that were never saved
+// the OS file cache is still warm from writing, so the numbers show the per file cost rather than the disk
+bool App::Command_ChunkRegionBenchmark(EventArgs& args)
+{
+	int numChunks = args.GetValue("numChunks", 10000);
+	if (numChunks <= 0)
+	{
+		g_theDevConsole->AddLine("ChunkRegionBenchmark needs numChunks > 0", DevConsole::INFO_ERROR);
+		return false;
+	}
+	if (!g_theWorld || g_theWorld->m_activeChunks.GetSize() == 0)
+	{
+		g_theDevConsole->AddLine("ChunkRegionBenchmark needs active chunks to copy, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	// real chunk data, repeated over a square of chunks
+	std::vector<std::vector<uint8_t>> sampleChunks;
+	for (int chunkIndex = 0; chunkIndex < g_theWorld->m_activeChunks.GetSize() && chunkIndex < 64; ++chunkIndex)
+	{
+		sampleChunks.emplace_back();
+		g_theWorld->m_activeChunks.GetEntry(chunkIndex).m_value->EncodeBlocksData(sampleChunks.back());
+	}
+	int squareSize = (int)ceil(sqrt((double)numChunks));
+	std::vector<IntVec2> chunkCoords;
+	for (int i = 0; i < numChunks; ++i)
+	{
+		chunkCoords.push_back(IntVec2(i % squareSize - squareSize / 2, i / squareSize - squareSize / 2));
+	}
+
+	std::string folderPath = "Saves/RegionBenchmark";
+	CreateFolder(folderPath);
+	std::vector<std::string> leftoverFileNames = GetFileNamesInFolder(folderPath, "*");
+	for (int fileIndex = 0; fileIndex < (int)leftoverFileNames.size(); ++fileIndex)
+	{
+		FileDelete(folderPath + "/" + leftoverFileNames[fileIndex]);
+	}
+
+	double timeAtStart = GetCurrentTimeSeconds();
+	for (int i = 0; i < numChunks; ++i)
+	{
+		std::string filePath = Stringf("%s/Chunk(%i, %i).chunk", folderPath.c_str(), chunkCoords[i].x, chunkCoords[i].y);
+		FileWriteFromBuffer(sampleChunks[i % sampleChunks.size()], filePath);
+	}
+	double chunkFilesWriteSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	// the old load: probe the file, read it to check the header, then read it again to decode
+	timeAtStart = GetCurrentTimeSeconds();
+	std::vector<uint8_t> chunkData;
+	for (int i = 0; i < numChunks; ++i)
+	{
+		std::string filePath = Stringf("%s/Chunk(%i, %i).chunk", folderPath.c_str(), chunkCoords[i].x, chunkCoords[i].y);
+		if (IfThisFileCouldBeRead(filePath))
+		{
+			FileReadToBuffer(chunkData, filePath);
+			FileReadToBuffer(chunkData, filePath);
+		}
+	}
+	double chunkFilesLoadSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	timeAtStart = GetCurrentTimeSeconds();
+	for (int i = 0; i < numChunks; ++i)
+	{
+		IntVec2 missingCoords = chunkCoords[i] + IntVec2(squareSize * 2, 0);
+		IfThisFileCouldBeRead(Stringf("%s/Chunk(%i, %i).chunk", folderPath.c_str(), missingCoords.x, missingCoords.y));
+	}
+	double chunkFilesProbeSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	// the converter deletes the .chunk files it has taken over
+	timeAtStart = GetCurrentTimeSeconds();
+	int numConverted = 0;
+	{
+		ChunkRegionFiles converter(folderPath);
+		numConverted = converter.ConvertChunkFiles();
+	}
+	double convertSeconds = GetCurrentTimeSeconds() - timeAtStart;
+	int numRegionFiles = (int)GetFileNamesInFolder(folderPath, "*.region").size();
+
+	int numMismatches = 0;
+	timeAtStart = GetCurrentTimeSeconds();
+	{
+		ChunkRegionFiles regionFiles(folderPath);
+		for (int i = 0; i < numChunks; ++i)
+		{
+			if (!regionFiles.LoadChunk(chunkCoords[i], chunkData) || chunkData != sampleChunks[i % sampleChunks.size()])
+			{
+				++numMismatches;
+			}
+		}
+	}
+	double regionsLoadSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	timeAtStart = GetCurrentTimeSeconds();
+	{
+		ChunkRegionFiles regionFiles(folderPath);
+		for (int i = 0; i < numChunks; ++i)
+		{
+			regionFiles.HasChunk(chunkCoords[i] + IntVec2(squareSize * 2, 0));
+		}
+	}
+	double regionsProbeSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	std::vector<std::string> benchmarkFileNames = GetFileNamesInFolder(folderPath, "*");
+	for (int fileIndex = 0; fileIndex < (int)benchmarkFileNames.size(); ++fileIndex)
+	{
+		FileDelete(folderPath + "/" + benchmarkFileNames[fileIndex]);
+	}
+
+	bool passed = (numConverted == numChunks && numMismatches == 0);
+	g_theDevConsole->AddLine(Stringf("ChunkRegionBenchmark %s: %i chunks, %i .chunk files -> %i region files", passed ? "PASSED" : "FAILED", numChunks, numConverted, numRegionFiles), passed ? DevConsole::INFO_MAJOR : DevConsole::INFO_ERROR);
+	g_theDevConsole->AddLine(Stringf("  .chunk files: write %.1f ms, cold load %.1f ms, probe missing %.1f ms", chunkFilesWriteSeconds * 1000.0, chunkFilesLoadSeconds * 1000.0, chunkFilesProbeSeconds * 1000.0), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  region files: convert %.1f ms, cold load %.1f ms, probe missing %.1f ms, %i mismatches", convertSeconds * 1000.0, regionsLoadSeconds * 1000.0, regionsProbeSeconds * 1000.0, numMismatches), DevConsole::INFO_MINOR);
+	return passed;
+}
+
+// the version 2 encoder, kept here only so the benchmark can compare against it
+static void EncodeBlocksDataVersion2(Chunk const* chunk, std::vector<uint8_t>& out_buffer)
+{
+	out_buffer.clear();
+	out_buffer.push_back('G');
+	out_buffer.push_back('C');
+	out_buffer.push_back('H');
+	out_buffer.push_back('K');
+	out_buffer.push_back(2);
+	out_buffer.push_back(CHUNK_BITS_X);
+	out_buffer.push_back(CHUNK_BITS_Y);
+	out_buffer.push_back(CHUNK_BITS_Z);
+
+	int blockIndex = 0;
+	while (blockIndex < CHUNK_BLOCKS_TOTAL)
+	{
+		uint8_t defIndex = chunk->m_blocks[blockIndex].m_blockDefIndex;
+		int runLength = 1;
+		while (runLength < 255 && blockIndex + runLength < CHUNK_BLOCKS_TOTAL && chunk->m_blocks[blockIndex + runLength].m_blockDefIndex == defIndex)
+		{
+			++runLength;
+		}
+		out_buffer.push_back(defIndex);
+		out_buffer.push_back((uint8_t)runLength);
+		blockIndex += runLength;
+	}
+}
+
+// every save of a folder with the coords it was saved at, "Chunk(x, y).chunk" files first, then the chunks in region files
+static void LoadChunkSavesInFolder(std::string const& folderPath, std::vector<IntVec2>& out_chunkCoords, std::vector<std::vector<uint8_t>>& out_savedChunks)
+{
+	std::vector<std::string> chunkFileNames = GetFileNamesInFolder(folderPath, "Chunk(*).chunk");
+	for (int fileIndex = 0; fileIndex < (int)chunkFileNames.size(); ++fileIndex)
+	{
+		IntVec2 chunkCoords;
+		if (!ChunkRegionFiles::ParseCoordsInFileName(chunkFileNames[fileIndex], chunkCoords))
+		{
+			continue;
+		}
+		out_chunkCoords.push_back(chunkCoords);
+		out_savedChunks.emplace_back();
+		FileReadToBuffer(out_savedChunks.back(), folderPath + "/" + chunkFileNames[fileIndex]);
+	}
+
+	ChunkRegionFiles regionFiles(folderPath);
+	std::vector<IntVec2> regionChunkCoords;
+	regionFiles.GetSavedChunkCoords(regionChunkCoords);
+	for (int chunkIndex = 0; chunkIndex < (int)regionChunkCoords.size(); ++chunkIndex)
 	{
-		g_theJobSystem->RetrieveCompletedJobs(nullptr);
+		out_chunkCoords.push_back(regionChunkCoords[chunkIndex]);
+		out_savedChunks.emplace_back();
+		regionFiles.LoadChunk(regionChunkCoords[chunkIndex], out_savedChunks.back());
 	}
 }
 
+// the saves of a folder, "Chunk(x, y).chunk" files and chunks in region files, are decoded then encoded again in every format
+// MB/s counts one byte per block, so the numbers do not depend on how well a format compresses
+bool App::Command_ChunkSerializationBenchmark(EventArgs& args)
+{
+	std::string folderPath = args.GetValue("folder", std::string("Saves/World_1"));
+	int numRepeats = args.GetValue("repeats", 10);
+	if (numRepeats <= 0)
+	{
+		g_theDevConsole->AddLine("ChunkSerializationBenchmark needs repeats > 0", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	std::vector<IntVec2> savedChunkCoords;
+	std::vector<std::vector<uint8_t>> savedChunks;
+	LoadChunkSavesInFolder(folderPath, savedChunkCoords, savedChunks);
+
+	// every save that decodes becomes a sample chunk
+	std::vector<Chunk*> chunks;
+	for (int saveIndex = 0; saveIndex < (int)savedChunks.size(); ++saveIndex)
+	{
+		Chunk* chunk = new Chunk(IntVec2(saveIndex, 0));
+		if (chunk->DecodeBlocksData(savedChunks[saveIndex]))
+		{
+			chunks.push_back(chunk);
+		}
+		else
+		{
+			delete chunk;
+		}
+	}
+	int numBrokenSaves = (int)savedChunks.size() - (int)chunks.size();
+	if (chunks.empty())
+	{
+		g_theDevConsole->AddLine(Stringf("ChunkSerializationBenchmark found no readable chunk saves in %s", folderPath.c_str()), DevConsole::INFO_ERROR);
+		return false;
+	}
+	int numChunks = (int)chunks.size();
+
+	std::vector<std::vector<uint8_t>> version2Data(numChunks);
+	std::vector<std::vector<uint8_t>> rawData(numChunks);
+	std::vector<std::vector<uint8_t>> compressedData(numChunks);
+	size_t version2Bytes = 0;
+	size_t rawBytes = 0;
+	size_t compressedBytes = 0;
+
+	double timeAtStart = GetCurrentTimeSeconds();
+	for (int repeat = 0; repeat < numRepeats; ++repeat)
+	{
+		for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+		{
+			EncodeBlocksDataVersion2(chunks[chunkIndex], version2Data[chunkIndex]);
+		}
+	}
+	double version2EncodeSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	timeAtStart = GetCurrentTimeSeconds();
+	for (int repeat = 0; repeat < numRepeats; ++repeat)
+	{
+		for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+		{
+			chunks[chunkIndex]->EncodeBlocksData(rawData[chunkIndex], false);
+		}
+	}
+	double rawEncodeSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	timeAtStart = GetCurrentTimeSeconds();
+	for (int repeat = 0; repeat < numRepeats; ++repeat)
+	{
+		for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+		{
+			chunks[chunkIndex]->EncodeBlocksData(compressedData[chunkIndex], true);
+		}
+	}
+	double compressedEncodeSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+	{
+		version2Bytes += version2Data[chunkIndex].size();
+		rawBytes += rawData[chunkIndex].size();
+		compressedBytes += compressedData[chunkIndex].size();
+	}
+
+	// decoding into one scratch chunk, then every format has to give back the same blocks
+	Chunk* scratchChunk = new Chunk(IntVec2(0, 0));
+	double decodeSeconds[3] = {};
+	std::vector<std::vector<uint8_t>>* decodeData[3] = { &version2Data, &rawData, &compressedData };
+	int numMismatches = 0;
+	for (int formatIndex = 0; formatIndex < 3; ++formatIndex)
+	{
+		timeAtStart = GetCurrentTimeSeconds();
+		for (int repeat = 0; repeat < numRepeats; ++repeat)
+		{
+			for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+			{
+				scratchChunk->DecodeBlocksData((*decodeData[formatIndex])[chunkIndex]);
+			}
+		}
+		decodeSeconds[formatIndex] = GetCurrentTimeSeconds() - timeAtStart;
+
+		for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+		{
+			if (!scratchChunk->DecodeBlocksData((*decodeData[formatIndex])[chunkIndex]))
+			{
+				++numMismatches;
+				continue;
+			}
+			for (int blockIndex = 0; blockIndex < CHUNK_BLOCKS_TOTAL; ++blockIndex)
+			{
+				if (scratchChunk->m_blocks[blockIndex].m_blockDefIndex != chunks[chunkIndex]->m_blocks[blockIndex].m_blockDefIndex)
+				{
+					++numMismatches;
+					break;
+				}
+			}
+		}
+	}
+
+	// a flipped byte has to be caught by the checksum or the run validation, never loaded as blocks
+	int numUndetectedCorruptions = 0;
+	for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+	{
+		std::vector<uint8_t> corruptedData = compressedData[chunkIndex];
+		corruptedData[8 + (corruptedData.size() - 8) / 2] ^= 0x5A;
+		if (scratchChunk->DecodeBlocksData(corruptedData))
+		{
+			++numUndetectedCorruptions;
+		}
+	}
+	delete scratchChunk;
+	for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+	{
+		delete chunks[chunkIndex];
+	}
+
+	double blockMegabytes = (double)numChunks * (double)numRepeats * (double)CHUNK_BLOCKS_TOTAL / (1024.0 * 1024.0);
+	bool passed = (numMismatches == 0 && numUndetectedCorruptions == 0);
+	g_theDevConsole->AddLine(Stringf("ChunkSerializationBenchmark %s: %i chunks from %s x %i repeats, %i saves could not be read", passed ? "PASSED" : "FAILED", numChunks, folderPath.c_str(), numRepeats, numBrokenSaves), passed ? DevConsole::INFO_MAJOR : DevConsole::INFO_ERROR);
+	g_theDevConsole->AddLine(Stringf("  v2 byte runs: %.1f bytes/chunk, encode %.0f MB/s, decode %.0f MB/s", (double)version2Bytes / numChunks, blockMegabytes / version2EncodeSeconds, blockMegabytes / decodeSeconds[0]), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  v3 varint runs: %.1f bytes/chunk, encode %.0f MB/s, decode %.0f MB/s", (double)rawBytes / numChunks, blockMegabytes / rawEncodeSeconds, blockMegabytes / decodeSeconds[1]), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  v3 varint runs + LZ: %.1f bytes/chunk, encode %.0f MB/s, decode %.0f MB/s", (double)compressedBytes / numChunks, blockMegabytes / compressedEncodeSeconds, blockMegabytes / decodeSeconds[2]), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  %i round trip mismatches, %i corrupted saves loaded", numMismatches, numUndetectedCorruptions), DevConsole::INFO_MINOR);
+	return passed;
+}
+
+// what a chunk costs with flat and with paletted blocks, measured on the active chunks
+// compact=false expands every chunk and stops compacting, compact=true turns it back on
+bool App::Command_ChunkMemoryReport(EventArgs& args)
+{
+	if (!g_theWorld || g_theWorld->m_activeChunks.GetSize() == 0)
+	{
+		g_theDevConsole->AddLine("ChunkMemoryReport needs active chunks, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+	int budgetMB = args.GetValue("budgetMB", 1024);
+	g_theWorld->m_compactFarChunks = args.GetValue("compact", g_theWorld->m_compactFarChunks);
+
+	int numChunks = g_theWorld->m_activeChunks.GetSize();
+	int numCompacted = 0;
+	size_t totalBytes = 0;
+	size_t totalPalettedBytes = 0;
+	size_t minPalettedBytes = (size_t)-1;
+	size_t maxPalettedBytes = 0;
+	int numUniformSections = 0;
+	double compressSeconds = 0.0;
+	double decompressSeconds = 0.0;
+	std::vector<Block> flatBlocks(CHUNK_BLOCKS_TOTAL);
+	for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+	{
+		Chunk* chunk = g_theWorld->m_activeChunks.GetEntry(chunkIndex).m_value;
+		if (!g_theWorld->m_compactFarChunks)
+		{
+			chunk->ExpandBlocks();
+		}
+		totalBytes += sizeof(Chunk) + chunk->GetBlocksNumBytes();
+
+		// every chunk is measured both ways, a flat one is paletted on the side
+		ChunkPalettedBlocks palettedBlocks;
+		ChunkPalettedBlocks const* measuredBlocks = chunk->m_palettedBlocks;
+		if (chunk->IsCompacted())
+		{
+			++numCompacted;
+		}
+		else
+		{
+			double timeAtStart = GetCurrentTimeSeconds();
+			palettedBlocks.CompressBlocks(chunk->m_blocks);
+			compressSeconds += GetCurrentTimeSeconds() - timeAtStart;
+			measuredBlocks = &palettedBlocks;
+		}
+		double timeAtStart = GetCurrentTimeSeconds();
+		measuredBlocks->DecompressBlocks(flatBlocks.data());
+		decompressSeconds += GetCurrentTimeSeconds() - timeAtStart;
+
+		size_t palettedBytes = measuredBlocks->GetNumBytes();
+		totalPalettedBytes += palettedBytes;
+		minPalettedBytes = (palettedBytes < minPalettedBytes) ? palettedBytes : minPalettedBytes;
+		maxPalettedBytes = (palettedBytes > maxPalettedBytes) ? palettedBytes : maxPalettedBytes;
+		numUniformSections += measuredBlocks->GetNumUniformSections();
+	}
+	int numFlatChunks = numChunks - numCompacted;
+
+	// the rest of the chunk, biome arrays included, is the same in both modes, vertex buffers live on the GPU and are left out
+	double chunkBytesWithoutBlocks = (double)(sizeof(Chunk));
+	double flatChunkBytes = chunkBytesWithoutBlocks + (double)(sizeof(Block) * CHUNK_BLOCKS_TOTAL);
+	double palettedChunkBytes = chunkBytesWithoutBlocks + (double)totalPalettedBytes / numChunks;
+	double budgetBytes = (double)budgetMB * 1024.0 * 1024.0;
+	double flatChunksInBudget = budgetBytes / flatChunkBytes;
+	double palettedChunksInBudget = budgetBytes / palettedChunkBytes;
+	double pi = 3.14159265358979;
+
+	g_theDevConsole->AddLine(Stringf("ChunkMemoryReport: %i active chunks, %i compacted, %i flat, %.1f MB in chunks right now", numChunks, numCompacted, numFlatChunks, (double)totalBytes / (1024.0 * 1024.0)), DevConsole::INFO_MAJOR);
+	g_theDevConsole->AddLine(Stringf("  flat: %.1f KB per chunk (%.1f KB blocks + %.1f KB the rest)", flatChunkBytes / 1024.0, (double)(sizeof(Block) * CHUNK_BLOCKS_TOTAL) / 1024.0, chunkBytesWithoutBlocks / 1024.0), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  paletted: %.1f KB per chunk (blocks %.1f KB avg, %.1f min, %.1f max), %.1f of %i sections uniform", palettedChunkBytes / 1024.0, (double)totalPalettedBytes / numChunks / 1024.0, (double)minPalettedBytes / 1024.0, (double)maxPalettedBytes / 1024.0, (double)numUniformSections / numChunks, CHUNK_NUM_SECTIONS), DevConsole::INFO_MINOR);
+	if (numFlatChunks > 0)
+	{
+		g_theDevConsole->AddLine(Stringf("  compact %.3f ms per chunk, expand %.3f ms per chunk", compressSeconds * 1000.0 / numFlatChunks, decompressSeconds * 1000.0 / numChunks), DevConsole::INFO_MINOR);
+	}
+	g_theDevConsole->AddLine(Stringf("  %i MB holds %.0f flat chunks (activate range %.0f) or %.0f paletted chunks (activate range %.0f)", budgetMB,
+		flatChunksInBudget, sqrt(flatChunksInBudget / pi) * CHUNK_SIZE_X, palettedChunksInBudget, sqrt(palettedChunksInBudget / pi) * CHUNK_SIZE_X), DevConsole::INFO_MINOR);
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+struct ChunkMesherBenchmarkResult
+{
+	int		m_numChunks = 0;
+	size_t	m_numOldVerts = 0;
+	size_t	m_numGreedyVerts = 0;
+	double	m_oldSeconds = 0.0;
+	double	m_greedySeconds = 0.0;
+	int		m_numCoverageMismatches = 0;
+};
+
+// both meshers on every chunk, the greedy quads have to cover exactly the faces the old mesher draws one by one
+static ChunkMesherBenchmarkResult RunChunkMesherBenchmark(std::vector<Chunk*> const& chunks, int numRepeats)
+{
+	ChunkMesherBenchmarkResult result;
+	result.m_numChunks = (int)chunks.size();
+	std::vector<Block> snapshot(MESH_SNAPSHOT_BLOCKS_TOTAL);
+	std::vector<Vertex_Voxel> voxelVerts;
+	for (int chunkIndex = 0; chunkIndex < (int)chunks.size(); ++chunkIndex)
+	{
+		Chunk* chunk = chunks[chunkIndex];
+		chunk->ExpandBlocks(); // the old mesher reads m_blocks straight
+
+		double timeAtStart = GetCurrentTimeSeconds();
+		for (int repeat = 0; repeat < numRepeats; ++repeat)
+		{
+			chunk->AddVertsForAllBlocksInChunk();
+		}
+		result.m_oldSeconds += GetCurrentTimeSeconds() - timeAtStart;
+
+		// every section the world would mesh, the empty ones are skipped by both meshers
+		size_t numGreedyFaces = 0;
+		size_t numGreedyVerts = 0;
+		for (int sectionIndex = 0; sectionIndex < CHUNK_NUM_SECTIONS; ++sectionIndex)
+		{
+			if (chunk->IsSectionEmpty(sectionIndex))
+			{
+				continue;
+			}
+
+			timeAtStart = GetCurrentTimeSeconds();
+			for (int repeat = 0; repeat < numRepeats; ++repeat)
+			{
+				CopySectionBlocksForMeshing(chunk, sectionIndex, snapshot.data());
+				BuildGreedySectionMesh(snapshot.data(), sectionIndex, voxelVerts);
+			}
+			result.m_greedySeconds += GetCurrentTimeSeconds() - timeAtStart;
+
+			// the top right corner of every quad holds its size in blocks
+			for (size_t vertIndex = 2; vertIndex < voxelVerts.size(); vertIndex += 6)
+			{
+				uint32_t packedTexture = voxelVerts[vertIndex].m_packedTexture;
+				numGreedyFaces += (packedTexture & 0xFF) * ((packedTexture >> VOXEL_TEXTURE_SHIFT_V) & 0xFF);
+			}
+			numGreedyVerts += voxelVerts.size();
+		}
+		if (numGreedyFaces * 6 != chunk->m_blockVerts.size())
+		{
+			++result.m_numCoverageMismatches;
+		}
+
+		result.m_numOldVerts += chunk->m_blockVerts.size();
+		result.m_numGreedyVerts += numGreedyVerts;
+		std::vector<Vertex_PCU>().swap(chunk->m_blockVerts);
+	}
+	return result;
+}
+
+static void PrintChunkMesherBenchmarkResult(char const* chunksName, ChunkMesherBenchmarkResult const& result, int numRepeats)
+{
+	double numChunks = (double)result.m_numChunks;
+	double numMeshes = numChunks * (double)numRepeats;
+	double oldBytes = (double)(result.m_numOldVerts * sizeof(Vertex_PCU)) / numChunks;
+	double greedyBytes = (double)(result.m_numGreedyVerts * sizeof(Vertex_Voxel)) / numChunks;
+	g_theDevConsole->AddLine(Stringf("  %s, %i chunks", chunksName, result.m_numChunks), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("    old Vertex_PCU quads: %.0f verts/chunk, %.1f KB/chunk, %.0f meshes/s", (double)result.m_numOldVerts / numChunks, oldBytes / 1024.0, numMeshes / result.m_oldSeconds), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("    greedy Vertex_Voxel quads: %.0f verts/chunk, %.1f KB/chunk, %.0f meshes/s", (double)result.m_numGreedyVerts / numChunks, greedyBytes / 1024.0, numMeshes / result.m_greedySeconds), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("    %.1fx fewer bytes, %.1fx faster, %i chunks where the quads do not cover the same faces", oldBytes / greedyBytes, result.m_oldSeconds / result.m_greedySeconds, result.m_numCoverageMismatches), DevConsole::INFO_MINOR);
+}
+
+// the old mesher against the greedy one without touching the GPU: first the saves of a folder, decoded and linked to the saved chunks next to them,
+// then the active chunks, which also have their lighting
+// a side with no chunk next to it is meshed as if it were solid, both meshers leave those faces out
+bool App::Command_ChunkMesherBenchmark(EventArgs& args)
+{
+	if (!g_theWorld)
+	{
+		g_theDevConsole->AddLine("ChunkMesherBenchmark needs the block defs, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+	std::string folderPath = args.GetValue("folder", std::string("Saves/World_1"));
+	int numRepeats = args.GetValue("repeats", 10);
+	if (numRepeats <= 0)
+	{
+		g_theDevConsole->AddLine("ChunkMesherBenchmark needs repeats > 0", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	std::vector<IntVec2> savedChunkCoords;
+	std::vector<std::vector<uint8_t>> savedChunks;
+	LoadChunkSavesInFolder(folderPath, savedChunkCoords, savedChunks);
+
+	// a chunk saved both as a file and in a region is only taken once
+	ChunkCoordsHashMap<Chunk> chunksByCoords;
+	std::vector<Chunk*> savedChunksDecoded;
+	for (int saveIndex = 0; saveIndex < (int)savedChunks.size(); ++saveIndex)
+	{
+		if (chunksByCoords.Contains(savedChunkCoords[saveIndex]))
+		{
+			continue;
+		}
+		Chunk* chunk = new Chunk(savedChunkCoords[saveIndex]);
+		if (!chunk->DecodeBlocksData(savedChunks[saveIndex]))
+		{
+			delete chunk;
+			continue;
+		}
+		chunksByCoords.Set(chunk->m_chunkCoords, chunk);
+		savedChunksDecoded.push_back(chunk);
+	}
+	for (int chunkIndex = 0; chunkIndex < (int)savedChunksDecoded.size(); ++chunkIndex)
+	{
+		Chunk* chunk = savedChunksDecoded[chunkIndex];
+		IntVec2 chunkCoords = chunk->m_chunkCoords;
+		chunk->m_eastNeighbor = chunksByCoords.Find(chunkCoords + IntVec2(1, 0));
+		chunk->m_westNeighbor = chunksByCoords.Find(chunkCoords + IntVec2(-1, 0));
+		chunk->m_northNeighbor = chunksByCoords.Find(chunkCoords + IntVec2(0, 1));
+		chunk->m_southNeighbor = chunksByCoords.Find(chunkCoords + IntVec2(0, -1));
+	}
+
+	std::vector<Chunk*> activeChunks;
+	for (int chunkIndex = 0; chunkIndex < g_theWorld->m_activeChunks.GetSize(); ++chunkIndex)
+	{
+		Chunk* chunk = g_theWorld->m_activeChunks.GetEntry(chunkIndex).m_value;
+		if (chunk->DoAllFourSurroundingNeighborChunksExist())
+		{
+			activeChunks.push_back(chunk);
+		}
+	}
+
+	if (savedChunksDecoded.empty() && activeChunks.empty())
+	{
+		g_theDevConsole->AddLine(Stringf("ChunkMesherBenchmark found no readable chunk saves in %s and no active chunks", folderPath.c_str()), DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	bool passed = true;
+	g_theDevConsole->AddLine(Stringf("ChunkMesherBenchmark: x %i repeats, %i B per Vertex_PCU, %i B per Vertex_Voxel", numRepeats, (int)sizeof(Vertex_PCU), (int)sizeof(Vertex_Voxel)), DevConsole::INFO_MAJOR);
+	if (!savedChunksDecoded.empty())
+	{
+		ChunkMesherBenchmarkResult savedResult = RunChunkMesherBenchmark(savedChunksDecoded, numRepeats);
+		PrintChunkMesherBenchmarkResult(Stringf("saves in %s, unlit", folderPath.c_str()).c_str(), savedResult, numRepeats);
+		passed = passed && (savedResult.m_numCoverageMismatches == 0);
+	}
+	if (!activeChunks.empty())
+	{
+		ChunkMesherBenchmarkResult activeResult = RunChunkMesherBenchmark(activeChunks, numRepeats);
+		PrintChunkMesherBenchmarkResult("active chunks", activeResult, numRepeats);
+		passed = passed && (activeResult.m_numCoverageMismatches == 0);
+	}
+	for (int chunkIndex = 0; chunkIndex < (int)savedChunksDecoded.size(); ++chunkIndex)
+	{
+		delete savedChunksDecoded[chunkIndex];
+	}
+
+	g_theDevConsole->AddLine(Stringf("ChunkMesherBenchmark %s", passed ? "PASSED" : "FAILED"), passed ? DevConsole::INFO_MAJOR : DevConsole::INFO_ERROR);
+	return passed;
+}
+
+// enabled=false goes back to the old mesher, every active chunk is remeshed the new way
+bool App::Command_UseGreedyMesher(EventArgs& args)
+{
+	if (!g_theWorld)
+	{
+		g_theDevConsole->AddLine("UseGreedyMesher needs the world, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+	g_theWorld->m_useGreedyMesher = args.GetValue("enabled", !g_theWorld->m_useGreedyMesher);
+	for (int chunkIndex = 0; chunkIndex < g_theWorld->m_activeChunks.GetSize(); ++chunkIndex)
+	{
+		g_theWorld->m_activeChunks.GetEntry(chunkIndex).m_value->MarkMeshDirty();
+	}
+	g_theDevConsole->AddLine(Stringf("UseGreedyMesher: %s", g_theWorld->m_useGreedyMesher ? "greedy Vertex_Voxel meshes" : "Vertex_PCU quad per face"), DevConsole::INFO_MAJOR);
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+struct LightingBenchmarkResult
+{
+	double	m_activateSeconds = 0.0;
+	double	m_editSeconds = 0.0;
+	int		m_numRounds = 0; // wavefront rounds, every chunk with light work runs one job per round
+
+	// what World::Update pays for lighting, one frame is one Propagate() call or one pass of the dirty block queue
+	int		m_numFrames = 0;
+	double	m_frameSeconds = 0.0;
+	double	m_worstFrameSeconds = 0.0;
+};
+
+// stands in for the chunk generate and mesh jobs the workers are busy with while the game runs
+class LightingBenchmarkLoadJob : public Job
+{
+public:
+	void Execute() override
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(m_durationMs));
+	}
+
+	int m_durationMs = 10;
+};
+
+static void QueueLightingBenchmarkLoad(std::vector<LightingBenchmarkLoadJob>& loadJobs, JobHandle& handle)
+{
+	for (int jobIndex = 0; jobIndex < (int)loadJobs.size(); ++jobIndex)
+	{
+		loadJobs[jobIndex].m_needsRetrieving = false;
+		g_theJobSystem->QueuePrioritizedJob(&loadJobs[jobIndex], jobIndex, handle);
+	}
+}
+
+static void AddLightingBenchmarkFrame(double frameSeconds, LightingBenchmarkResult& result)
+{
+	++result.m_numFrames;
+	result.m_frameSeconds += frameSeconds;
+	if (frameSeconds > result.m_worstFrameSeconds)
+	{
+		result.m_worstFrameSeconds = frameSeconds;
+	}
+}
+
+// until nothing is left, the world's own dirty lighting is settled with it
+static void SettleLightingForBenchmark(bool useWavefront, LightingBenchmarkResult& result)
+{
+	if (useWavefront)
+	{
+		while (g_theWorld->m_lightPropagator.HasWork())
+		{
+			double timeAtStart = GetCurrentTimeSeconds();
+			result.m_numRounds += g_theWorld->m_lightPropagator.Propagate(MAX_LIGHT_PROPAGATION_ROUNDS_PER_FRAME);
+			AddLightingBenchmarkFrame(GetCurrentTimeSeconds() - timeAtStart, result);
+		}
+	}
+	else
+	{
+		double timeAtStart = GetCurrentTimeSeconds();
+		g_theWorld->ProcessDirtyLightBlockQueue();
+		AddLightingBenchmarkFrame(GetCurrentTimeSeconds() - timeAtStart, result);
+	}
+}
+
+// linked and lit the way World::ActivateNewChunk does it, numPerFrame chunks at a time with the light settled after every batch
+static void ActivateChunksForLightingBenchmark(std::vector<Chunk*> const& chunks, int numPerFrame, bool useWavefront, LightingBenchmarkResult& result)
+{
+	World* world = g_theWorld;
+	world->m_useWavefrontLighting = useWavefront;
+	ChunkCoordsHashMap<Chunk> chunksByCoords;
+	for (int firstIndex = 0; firstIndex < (int)chunks.size(); firstIndex += numPerFrame)
+	{
+		double timeAtStart = GetCurrentTimeSeconds();
+		int endIndex = (firstIndex + numPerFrame < (int)chunks.size()) ? firstIndex + numPerFrame : (int)chunks.size();
+		for (int chunkIndex = firstIndex; chunkIndex < endIndex; ++chunkIndex)
+		{
+			Chunk* chunk = chunks[chunkIndex];
+			IntVec2 chunkCoords = chunk->m_chunkCoords;
+			chunk->m_eastNeighbor = chunksByCoords.Find(chunkCoords + IntVec2(1, 0));
+			chunk->m_westNeighbor = chunksByCoords.Find(chunkCoords + IntVec2(-1, 0));
+			chunk->m_northNeighbor = chunksByCoords.Find(chunkCoords + IntVec2(0, 1));
+			chunk->m_southNeighbor = chunksByCoords.Find(chunkCoords + IntVec2(0, -1));
+			if (chunk->m_eastNeighbor)
+			{
+				chunk->m_eastNeighbor->m_westNeighbor = chunk;
+			}
+			if (chunk->m_westNeighbor)
+			{
+				chunk->m_westNeighbor->m_eastNeighbor = chunk;
+			}
+			if (chunk->m_northNeighbor)
+			{
+				chunk->m_northNeighbor->m_southNeighbor = chunk;
+			}
+			if (chunk->m_southNeighbor)
+			{
+				chunk->m_southNeighbor->m_northNeighbor = chunk;
+			}
+			chunksByCoords.Set(chunkCoords, chunk);
+
+			if (useWavefront)
+			{
+				world->m_lightPropagator.InitializeChunk(chunk);
+			}
+			else
+			{
+				world->LightInfluenceInitialization(chunk);
+			}
+		}
+		SettleLightingForBenchmark(useWavefront, result);
+		result.m_activateSeconds += GetCurrentTimeSeconds() - timeAtStart;
+	}
+}
+
+// the same edits for the same seed: dig the top block of a column, put a glowstone on it, or a stone roof a few blocks over it
+static void EditChunksForLightingBenchmark(std::vector<Chunk*> const& chunks, int numEdits, bool useWavefront, LightingBenchmarkResult& result)
+{
+	World* world = g_theWorld;
+	world->m_useWavefrontLighting = useWavefront;
+	BlockDef const& glowStoneDef = BlockDef::s_BlockDefs[BLOCK_TYPE_GLOWSTONE];
+	BlockDef const& stoneDef = BlockDef::s_BlockDefs[BLOCK_TYPE_STONE];
+	for (int editIndex = 0; editIndex < numEdits; ++editIndex)
+	{
+		unsigned int editNoise = Get1dNoiseUint(editIndex, (unsigned int)world->m_seed);
+		Chunk* chunk = chunks[editNoise % (unsigned int)chunks.size()];
+		int x = (int)(editNoise >> 8) & (CHUNK_SIZE_X - 1);
+		int y = (int)(editNoise >> 12) & (CHUNK_SIZE_Y - 1);
+		int topZ = CHUNK_SIZE_Z - 1;
+		while (topZ > 0 && !chunk->m_blocks[chunk->GetIndexForLocalCoordinates(IntVec3(x, y, topZ))].IsOpaque())
+		{
+			--topZ;
+		}
+
+		double timeAtStart = GetCurrentTimeSeconds();
+		switch ((editNoise >> 16) % 3)
+		{
+		case 0:
+			world->DigBlockAt(BlockIter(chunk, chunk->GetIndexForLocalCoordinates(IntVec3(x, y, topZ))));
+			break;
+		case 1:
+			world->PlaceBlockAt(BlockIter(chunk, chunk->GetIndexForLocalCoordinates(IntVec3(x, y, topZ + 1))), glowStoneDef);
+			break;
+		default:
+			world->PlaceBlockAt(BlockIter(chunk, chunk->GetIndexForLocalCoordinates(IntVec3(x, y, topZ + 4))), stoneDef);
+			break;
+		}
+		SettleLightingForBenchmark(useWavefront, result);
+		result.m_editSeconds += GetCurrentTimeSeconds() - timeAtStart;
+	}
+}
+
+// every block goes through the dirty block queue once more and the queue runs until nothing changes,
+// the light the per block rule settles on with nothing left out, returns how many blocks it changed
+// (on activation only sky blocks on the border are dirtied, light from the chunk next to it never comes in through a cave on the border)
+static int SettleAllBlocksWithDirtyBlockQueue(std::vector<Chunk*> const& chunks)
+{
+	std::vector<uint8_t> lightBefore;
+	lightBefore.reserve(chunks.size() * CHUNK_BLOCKS_TOTAL);
+	for (int chunkIndex = 0; chunkIndex < (int)chunks.size(); ++chunkIndex)
+	{
+		for (int blockIndex = 0; blockIndex < CHUNK_BLOCKS_TOTAL; ++blockIndex)
+		{
+			lightBefore.push_back(chunks[chunkIndex]->m_blocks[blockIndex].m_blockLighting);
+			g_theWorld->MarkLightingDirty(BlockIter(chunks[chunkIndex], blockIndex));
+		}
+	}
+	g_theWorld->ProcessDirtyLightBlockQueue();
+
+	int numChangedBlocks = 0;
+	for (int chunkIndex = 0; chunkIndex < (int)chunks.size(); ++chunkIndex)
+	{
+		for (int blockIndex = 0; blockIndex < CHUNK_BLOCKS_TOTAL; ++blockIndex)
+		{
+			numChangedBlocks += (lightBefore[chunkIndex * CHUNK_BLOCKS_TOTAL + blockIndex] != chunks[chunkIndex]->m_blocks[blockIndex].m_blockLighting) ? 1 : 0;
+		}
+	}
+	return numChangedBlocks;
+}
+
+static int CountLightMismatches(std::vector<Chunk*> const& chunksA, std::vector<Chunk*> const& chunksB, int& out_numSkyMismatches)
+{
+	int numLightMismatches = 0;
+	out_numSkyMismatches = 0;
+	for (int chunkIndex = 0; chunkIndex < (int)chunksA.size(); ++chunkIndex)
+	{
+		Block const* blocksA = chunksA[chunkIndex]->m_blocks;
+		Block const* blocksB = chunksB[chunkIndex]->m_blocks;
+		for (int blockIndex = 0; blockIndex < CHUNK_BLOCKS_TOTAL; ++blockIndex)
+		{
+			numLightMismatches += (blocksA[blockIndex].m_blockLighting != blocksB[blockIndex].m_blockLighting) ? 1 : 0;
+			out_numSkyMismatches += (blocksA[blockIndex].IsBlockSky() != blocksB[blockIndex].IsBlockSky()) ? 1 : 0;
+		}
+	}
+	return numLightMismatches;
+}
+
+// a square of chunks is generated from the world seed, never registered with the world, and lit twice from the same blocks:
+// by the dirty block queue and by the wavefront, activated nearest first in the same batches, then edited the same way
+// the queue's copy is settled over every block before each comparison (not timed), then every block has to have
+// the same outdoor and indoor light and the same sky flag in both copies
+// load=N keeps N prioritized 10 ms jobs in the job system while the wavefront runs, the frame cost shows whether its rounds wait behind them
+bool App::Command_LightingBenchmark(EventArgs& args)
+{
+	if (!g_theWorld)
+	{
+		g_theDevConsole->AddLine("LightingBenchmark needs the world, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+	int radius = args.GetValue("radius", 4);
+	int numPerFrame = args.GetValue("perFrame", 4);
+	int numEdits = args.GetValue("edits", 200);
+	int numLoadJobs = args.GetValue("load", 0);
+	IntVec2 centerCoords = IntVec2(args.GetValue("x", 0), args.GetValue("y", 0));
+	if (radius < 1 || numPerFrame < 1 || numEdits < 0 || numLoadJobs < 0)
+	{
+		g_theDevConsole->AddLine("LightingBenchmark needs radius >= 1, perFrame >= 1, edits >= 0 and load >= 0", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	std::vector<IntVec2> chunkCoordsList;
+	for (int y = -radius; y <= radius; ++y)
+	{
+		for (int x = -radius; x <= radius; ++x)
+		{
+			chunkCoordsList.push_back(centerCoords + IntVec2(x, y));
+		}
+	}
+	std::stable_sort(chunkCoordsList.begin(), chunkCoordsList.end(), [&centerCoords](IntVec2 const& a, IntVec2 const& b)
+		{
+			return a.GetLengthSquaredToThisCoords(centerCoords) < b.GetLengthSquaredToThisCoords(centerCoords);
+		});
+
+	// generated once, the copy lit by the wavefront gets the same blocks
+	std::vector<Chunk*> queueChunks;
+	std::vector<Chunk*> wavefrontChunks;
+	for (int chunkIndex = 0; chunkIndex < (int)chunkCoordsList.size(); ++chunkIndex)
+	{
+		Chunk* chunk = new Chunk(chunkCoordsList[chunkIndex]);
+		chunk->GenerateBiomeFactors();
+		chunk->CreateInitialBlocks();
+		chunk->StampFeatures();
+		chunk->RecountSectionBlocks();
+		queueChunks.push_back(chunk);
+
+		Chunk* copy = new Chunk(chunkCoordsList[chunkIndex]);
+		std::copy(chunk->m_blocks, chunk->m_blocks + CHUNK_BLOCKS_TOTAL, copy->m_blocks);
+		copy->RecountSectionBlocks();
+		wavefrontChunks.push_back(copy);
+	}
+
+	bool wasUsingWavefront = g_theWorld->m_useWavefrontLighting;
+	LightingBenchmarkResult queueResult;
+	LightingBenchmarkResult wavefrontResult;
+	// a job could only be queued once, every phase gets its own
+	std::vector<LightingBenchmarkLoadJob> activateLoadJobs(numLoadJobs);
+	std::vector<LightingBenchmarkLoadJob> editLoadJobs(numLoadJobs);
+	JobHandle loadHandle;
+	ActivateChunksForLightingBenchmark(queueChunks, numPerFrame, false, queueResult);
+	QueueLightingBenchmarkLoad(activateLoadJobs, loadHandle);
+	ActivateChunksForLightingBenchmark(wavefrontChunks, numPerFrame, true, wavefrontResult);
+	g_theJobSystem->WaitFor(loadHandle);
+	LightingBenchmarkResult activateQueueResult = queueResult;
+	LightingBenchmarkResult activateWavefrontResult = wavefrontResult;
+	queueResult = LightingBenchmarkResult();
+	wavefrontResult = LightingBenchmarkResult();
+	int numActivateQueueMisses = SettleAllBlocksWithDirtyBlockQueue(queueChunks);
+	int numActivateSkyMismatches = 0;
+	int numActivateLightMismatches = CountLightMismatches(queueChunks, wavefrontChunks, numActivateSkyMismatches);
+
+	EditChunksForLightingBenchmark(queueChunks, numEdits, false, queueResult);
+	QueueLightingBenchmarkLoad(editLoadJobs, loadHandle);
+	EditChunksForLightingBenchmark(wavefrontChunks, numEdits, true, wavefrontResult);
+	g_theJobSystem->WaitFor(loadHandle);
+	int numEditQueueMisses = SettleAllBlocksWithDirtyBlockQueue(queueChunks);
+	int numEditSkyMismatches = 0;
+	int numEditLightMismatches = CountLightMismatches(queueChunks, wavefrontChunks, numEditSkyMismatches);
+	g_theWorld->m_useWavefrontLighting = wasUsingWavefront;
+
+	for (int chunkIndex = 0; chunkIndex < (int)queueChunks.size(); ++chunkIndex)
+	{
+		g_theWorld->UndirtyAllBlocksInChunk(queueChunks[chunkIndex]);
+		g_theWorld->m_lightPropagator.RemoveChunk(wavefrontChunks[chunkIndex]);
+		delete queueChunks[chunkIndex];
+		delete wavefrontChunks[chunkIndex];
+	}
+
+	int numChunks = (int)chunkCoordsList.size();
+	double numBlocks = (double)numChunks * (double)CHUNK_BLOCKS_TOTAL;
+	g_theDevConsole->AddLine(Stringf("LightingBenchmark: %i chunks around (%i, %i), %i activated per frame, %i edits, %i load jobs", numChunks, centerCoords.x, centerCoords.y, numPerFrame, numEdits, numLoadJobs), DevConsole::INFO_MAJOR);
+	g_theDevConsole->AddLine(Stringf("  activation: dirty block queue %.2f ms/chunk, wavefront %.2f ms/chunk in %i rounds, %.1fx faster", activateQueueResult.m_activateSeconds * 1000.0 / numChunks,
+		activateWavefrontResult.m_activateSeconds * 1000.0 / numChunks, activateWavefrontResult.m_numRounds, activateQueueResult.m_activateSeconds / activateWavefrontResult.m_activateSeconds), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("    frame cost: dirty block queue %.2f ms avg %.2f ms worst, wavefront %.2f ms avg %.2f ms worst over %i frames",
+		activateQueueResult.m_frameSeconds * 1000.0 / activateQueueResult.m_numFrames, activateQueueResult.m_worstFrameSeconds * 1000.0,
+		activateWavefrontResult.m_frameSeconds * 1000.0 / activateWavefrontResult.m_numFrames, activateWavefrontResult.m_worstFrameSeconds * 1000.0, activateWavefrontResult.m_numFrames), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("    %i of %.0f blocks have different light, %i a different sky flag, the queue left %i blocks unsettled", numActivateLightMismatches, numBlocks, numActivateSkyMismatches, numActivateQueueMisses), DevConsole::INFO_MINOR);
+	if (numEdits > 0)
+	{
+		g_theDevConsole->AddLine(Stringf("  edits: dirty block queue %.3f ms/edit, wavefront %.3f ms/edit, %.1fx faster", queueResult.m_editSeconds * 1000.0 / numEdits,
+			wavefrontResult.m_editSeconds * 1000.0 / numEdits, queueResult.m_editSeconds / wavefrontResult.m_editSeconds), DevConsole::INFO_MINOR);
+		g_theDevConsole->AddLine(Stringf("    frame cost: dirty block queue %.3f ms avg %.3f ms worst, wavefront %.3f ms avg %.3f ms worst over %i frames",
+			queueResult.m_frameSeconds * 1000.0 / queueResult.m_numFrames, queueResult.m_worstFrameSeconds * 1000.0,
+			wavefrontResult.m_frameSeconds * 1000.0 / wavefrontResult.m_numFrames, wavefrontResult.m_worstFrameSeconds * 1000.0, wavefrontResult.m_numFrames), DevConsole::INFO_MINOR);
+		g_theDevConsole->AddLine(Stringf("    %i of %.0f blocks have different light, %i a different sky flag, the queue left %i blocks unsettled", numEditLightMismatches, numBlocks, numEditSkyMismatches, numEditQueueMisses), DevConsole::INFO_MINOR);
+	}
+
+	bool passed = (numActivateLightMismatches == 0 && numActivateSkyMismatches == 0 && numEditLightMismatches == 0 && numEditSkyMismatches == 0);
+	g_theDevConsole->AddLine(Stringf("LightingBenchmark %s", passed ? "PASSED" : "FAILED"), passed ? DevConsole::INFO_MAJOR : DevConsole::INFO_ERROR);
+	return passed;
+}
+
+// enabled=false lights new chunks and edits with the dirty block queue again
+bool App::Command_UseWavefrontLighting(EventArgs& args)
+{
+	if (!g_theWorld)
+	{
+		g_theDevConsole->AddLine("UseWavefrontLighting needs the world, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+	g_theWorld->m_useWavefrontLighting = args.GetValue("enabled", !g_theWorld->m_useWavefrontLighting);
+	g_theDevConsole->AddLine(Stringf("UseWavefrontLighting: %s", g_theWorld->m_useWavefrontLighting ? "wavefront jobs per chunk" : "dirty block queue on the main thread"), DevConsole::INFO_MAJOR);
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+struct ChunkGenerationBenchmarkResult
+{
+	double	m_noiseSeconds = 0.0; // the biome factors and the features, the parts that read the noise and work out the feature regions
+	double	m_totalSeconds = 0.0;
+};
+
+// generates the chunk the way ChunkGenerateJob does, on this thread
+static void GenerateChunkForBenchmark(Chunk* chunk, ChunkGenerationBenchmarkResult& result)
+{
+	double timeAtStart = GetCurrentTimeSeconds();
+	chunk->GenerateBiomeFactors();
+	double timeAfterBiomes = GetCurrentTimeSeconds();
+	chunk->CreateInitialBlocks();
+	double timeBeforeFeatures = GetCurrentTimeSeconds();
+	chunk->StampFeatures();
+	double timeAfterFeatures = GetCurrentTimeSeconds();
+	chunk->RecountSectionBlocks();
+	double timeAtEnd = GetCurrentTimeSeconds();
+	result.m_noiseSeconds += (timeAfterBiomes - timeAtStart) + (timeAfterFeatures - timeBeforeFeatures);
+	result.m_totalSeconds += timeAtEnd - timeAtStart;
+}
+
+static bool AreGeneratedChunksIdentical(Chunk const* a, Chunk const* b)
+{
+	for (int blockIndex = 0; blockIndex < CHUNK_BLOCKS_TOTAL; ++blockIndex)
+	{
+		if (a->m_blocks[blockIndex].m_blockDefIndex != b->m_blocks[blockIndex].m_blockDefIndex || a->m_blocks[blockIndex].m_blockBitFlags != b->m_blocks[blockIndex].m_blockBitFlags)
+		{
+			return false;
+		}
+	}
+	// the floats are compared bit for bit
+	return memcmp(a->m_terrainHeightZ, b->m_terrainHeightZ, sizeof(a->m_terrainHeightZ)) == 0
+		&& memcmp(a->m_temperature, b->m_temperature, sizeof(a->m_temperature)) == 0
+		&& memcmp(a->m_humidity, b->m_humidity, sizeof(a->m_humidity)) == 0;
+}
+
+// every chunk in the square is generated on the main thread column by column and then with the batch noise,
+// each way starting from an empty feature cache so it works out the regions itself,
+// chunks per second are for one core, and both ways have to give the same blocks and biome factors
+bool App::Command_ChunkGenerationBenchmark(EventArgs& args)
+{
+	if (!g_theWorld)
+	{
+		g_theDevConsole->AddLine("ChunkGenerationBenchmark needs the world, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+	int radius = args.GetValue("radius", 4);
+	IntVec2 centerCoords = IntVec2(args.GetValue("x", 0), args.GetValue("y", 0));
+	if (radius < 0)
+	{
+		g_theDevConsole->AddLine("ChunkGenerationBenchmark needs radius >= 0", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	bool wasUsingBatchNoise = g_theWorld->m_useBatchNoise;
+	ChunkGenerationBenchmarkResult scalarResult;
+	ChunkGenerationBenchmarkResult batchResult;
+	std::vector<Chunk*> scalarChunks;
+	std::vector<Chunk*> batchChunks;
+	for (int y = -radius; y <= radius; ++y)
+	{
+		for (int x = -radius; x <= radius; ++x)
+		{
+			scalarChunks.push_back(new Chunk(centerCoords + IntVec2(x, y)));
+			batchChunks.push_back(new Chunk(centerCoords + IntVec2(x, y)));
+		}
+	}
+	int numChunks = (int)scalarChunks.size();
+
+	g_theWorld->m_useBatchNoise = false;
+	g_theWorld->m_featureCache.Clear();
+	for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+	{
+		GenerateChunkForBenchmark(scalarChunks[chunkIndex], scalarResult);
+	}
+	g_theWorld->m_useBatchNoise = true;
+	g_theWorld->m_featureCache.Clear();
+	for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+	{
+		GenerateChunkForBenchmark(batchChunks[chunkIndex], batchResult);
+	}
+	g_theWorld->m_useBatchNoise = wasUsingBatchNoise;
+
+	int numMismatchedChunks = 0;
+	for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+	{
+		numMismatchedChunks += AreGeneratedChunksIdentical(scalarChunks[chunkIndex], batchChunks[chunkIndex]) ? 0 : 1;
+		delete scalarChunks[chunkIndex];
+		delete batchChunks[chunkIndex];
+	}
+
+	g_theDevConsole->AddLine(Stringf("ChunkGenerationBenchmark: %i chunks around (%i, %i), one core", numChunks, centerCoords.x, centerCoords.y), DevConsole::INFO_MAJOR);
+	g_theDevConsole->AddLine(Stringf("  column by column: %.1f chunks/s, %.2f ms/chunk in biome and feature noise", numChunks / scalarResult.m_totalSeconds, scalarResult.m_noiseSeconds * 1000.0 / numChunks), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  batch noise: %.1f chunks/s, %.2f ms/chunk in biome and feature noise, %.1fx faster noise, %.1fx more chunks", numChunks / batchResult.m_totalSeconds,
+		batchResult.m_noiseSeconds * 1000.0 / numChunks, scalarResult.m_noiseSeconds / batchResult.m_noiseSeconds, scalarResult.m_totalSeconds / batchResult.m_totalSeconds), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  %i chunks generated differently", numMismatchedChunks), DevConsole::INFO_MINOR);
+
+	bool passed = (numMismatchedChunks == 0);
+	g_theDevConsole->AddLine(Stringf("ChunkGenerationBenchmark %s", passed ? "PASSED" : "FAILED"), passed ? DevConsole::INFO_MAJOR : DevConsole::INFO_ERROR);
+	return passed;
+}
+
+// enabled=false generates new chunks with the scalar noise column by column again
+bool App::Command_UseBatchNoise(EventArgs& args)
+{
+	if (!g_theWorld)
+	{
+		g_theDevConsole->AddLine("UseBatchNoise needs the world, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+	g_theWorld->m_useBatchNoise = args.GetValue("enabled", !g_theWorld->m_useBatchNoise);
+	g_theDevConsole->AddLine(Stringf("UseBatchNoise: %s", g_theWorld->m_useBatchNoise ? "SSE noise grids" : "scalar noise per column"), DevConsole::INFO_MAJOR);
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// chunk generation determinism test
+// usage in dev console: "ChunkGenerationDeterminismTest radius=4 workers=8"
+// the square of chunks is generated on this thread alone, then on a job system of that many workers, twice,
+// every run has to give the same blocks, so the generation workers can be raised without the terrain changing
+// the first two runs start from an empty feature cache, so the workers race to work out the same regions, the last one reuses them
+static void GenerateChunksOnWorkers(std::vector<Chunk*> const& chunks, JobSystem* jobSystem)
+{
+	std::function<void(int, int)> generateChunks = [&chunks](int beginIndex, int endIndex)
+		{
+			for (int chunkIndex = beginIndex; chunkIndex < endIndex; ++chunkIndex)
+			{
+				// the same steps as ChunkGenerateJob
+				Chunk* chunk = chunks[chunkIndex];
+				chunk->GenerateBiomeFactors();
+				chunk->CreateInitialBlocks();
+				chunk->StampFeatures();
+				chunk->RecountSectionBlocks();
+			}
+		};
+	if (!jobSystem)
+	{
+		generateChunks(0, (int)chunks.size());
+		return;
+	}
+	jobSystem->ParallelFor(0, (int)chunks.size(), 1, generateChunks);
+}
+
+static int CountChunksWithDifferentBlocks(std::vector<Chunk*> const& chunksA, std::vector<Chunk*> const& chunksB)
+{
+	int numDifferentChunks = 0;
+	for (int chunkIndex = 0; chunkIndex < (int)chunksA.size(); ++chunkIndex)
+	{
+		Block const* blocksA = chunksA[chunkIndex]->m_blocks;
+		Block const* blocksB = chunksB[chunkIndex]->m_blocks;
+		for (int blockIndex = 0; blockIndex < CHUNK_BLOCKS_TOTAL; ++blockIndex)
+		{
+			if (blocksA[blockIndex].m_blockDefIndex != blocksB[blockIndex].m_blockDefIndex || blocksA[blockIndex].m_blockBitFlags != blocksB[blockIndex].m_blockBitFlags)
+			{
+				++numDifferentChunks;
+				break;
+			}
+		}
+	}
+	return numDifferentChunks;
+}
+
+bool App::Command_ChunkGenerationDeterminismTest(EventArgs& args)
+{
+	if (!g_theWorld)
+	{
+		g_theDevConsole->AddLine("ChunkGenerationDeterminismTest needs the world, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+	int radius = args.GetValue("radius", 4);
+	int numWorkers = args.GetValue("workers", g_theJobSystem->GetNumWorkers());
+	if (radius < 0 || numWorkers < 1)
+	{
+		g_theDevConsole->AddLine("ChunkGenerationDeterminismTest needs radius >= 0 and workers >= 1", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	constexpr int NUM_RUNS = 3; // this thread alone, then the workers twice
+	std::vector<Chunk*> chunksPerRun[NUM_RUNS];
+	for (int y = -radius; y <= radius; ++y)
+	{
+		for (int x = -radius; x <= radius; ++x)
+		{
+			for (int run = 0; run < NUM_RUNS; ++run)
+			{
+				chunksPerRun[run].push_back(new Chunk(IntVec2(x, y)));
+			}
+		}
+	}
+
+	// a separate job system so the game's chunk jobs do not get mixed in and the number of workers is the one asked for
+	JobSystemConfig testConfig;
+	testConfig.numberOfWorkers = numWorkers;
+	testConfig.numIOWorkers = 0;
+	JobSystem testJobSystem(testConfig);
+	testJobSystem.Startup();
+
+	double runSeconds[NUM_RUNS] = {};
+	for (int run = 0; run < NUM_RUNS; ++run)
+	{
+		if (run < 2)
+		{
+			g_theWorld->m_featureCache.Clear();
+		}
+		double timeAtStart = GetCurrentTimeSeconds();
+		GenerateChunksOnWorkers(chunksPerRun[run], (run == 0) ? nullptr : &testJobSystem);
+		runSeconds[run] = GetCurrentTimeSeconds() - timeAtStart;
+	}
+	testJobSystem.ShutDown();
+
+	int numDifferentOnWorkers = CountChunksWithDifferentBlocks(chunksPerRun[0], chunksPerRun[1]);
+	int numDifferentBetweenWorkerRuns = CountChunksWithDifferentBlocks(chunksPerRun[1], chunksPerRun[2]);
+	int numChunks = (int)chunksPerRun[0].size();
+	for (int run = 0; run < NUM_RUNS; ++run)
+	{
+		for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+		{
+			delete chunksPerRun[run][chunkIndex];
+		}
+	}
+
+	g_theDevConsole->AddLine(Stringf("ChunkGenerationDeterminismTest: %i chunks, 1 thread %.1f ms, %i workers %.1f ms and %.1f ms with the feature regions cached", numChunks, runSeconds[0] * 1000.0,
+		numWorkers, runSeconds[1] * 1000.0, runSeconds[2] * 1000.0), DevConsole::INFO_MAJOR);
+	g_theDevConsole->AddLine(Stringf("  %i chunks differ between 1 thread and %i workers, %i between the two runs on workers", numDifferentOnWorkers, numWorkers, numDifferentBetweenWorkerRuns), DevConsole::INFO_MINOR);
+
+	bool passed = (numDifferentOnWorkers == 0 && numDifferentBetweenWorkerRuns == 0);
+	g_theDevConsole->AddLine(Stringf("ChunkGenerationDeterminismTest %s", passed ? "PASSED" : "FAILED"), passed ? DevConsole::INFO_MAJOR : DevConsole::INFO_ERROR);
+	return passed;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// block type benchmark
+// usage in dev console: "BlockTypeBenchmark radius=2"
+// the square of chunks gets its initial blocks, then every block is set again from its type on this thread two ways:
+// by name, searching the defs for it the way generation used to for every block, and by BlockType through the flag table
+// both have to give the blocks CreateInitialBlocks did
+bool App::Command_BlockTypeBenchmark(EventArgs& args)
+{
+	if (!g_theWorld)
+	{
+		g_theDevConsole->AddLine("BlockTypeBenchmark needs the world, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+	int radius = args.GetValue("radius", 2);
+	if (radius < 0)
+	{
+		g_theDevConsole->AddLine("BlockTypeBenchmark needs radius >= 0", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	char const* blockTypeNames[NUM_BLOCK_TYPES];
+	for (int type = 0; type < NUM_BLOCK_TYPES; ++type)
+	{
+		blockTypeNames[type] = BlockDef::s_BlockDefs[type].m_name.c_str();
+	}
+
+	double generateSeconds = 0.0;
+	double byNameSeconds = 0.0;
+	double byTypeSeconds = 0.0;
+	int numChunks = 0;
+	int numDifferentChunks = 0;
+	std::vector<Block> blocksByName(CHUNK_BLOCKS_TOTAL);
+	std::vector<Block> blocksByType(CHUNK_BLOCKS_TOTAL);
+	for (int y = -radius; y <= radius; ++y)
+	{
+		for (int x = -radius; x <= radius; ++x)
+		{
+			Chunk* chunk = new Chunk(IntVec2(x, y));
+			chunk->GenerateBiomeFactors();
+			double timeAtStart = GetCurrentTimeSeconds();
+			chunk->CreateInitialBlocks();
+			generateSeconds += GetCurrentTimeSeconds() - timeAtStart;
+
+			timeAtStart = GetCurrentTimeSeconds();
+			for (int blockIndex = 0; blockIndex < CHUNK_BLOCKS_TOTAL; ++blockIndex)
+			{
+				blocksByName[blockIndex].SetType(blockTypeNames[chunk->m_blocks[blockIndex].m_blockDefIndex]);
+			}
+			byNameSeconds += GetCurrentTimeSeconds() - timeAtStart;
+
+			timeAtStart = GetCurrentTimeSeconds();
+			for (int blockIndex = 0; blockIndex < CHUNK_BLOCKS_TOTAL; ++blockIndex)
+			{
+				blocksByType[blockIndex].SetType(chunk->m_blocks[blockIndex].GetType());
+			}
+			byTypeSeconds += GetCurrentTimeSeconds() - timeAtStart;
+
+			for (int blockIndex = 0; blockIndex < CHUNK_BLOCKS_TOTAL; ++blockIndex)
+			{
+				Block const& generated = chunk->m_blocks[blockIndex];
+				if (blocksByName[blockIndex].m_blockDefIndex != generated.m_blockDefIndex || blocksByName[blockIndex].m_blockBitFlags != generated.m_blockBitFlags
+					|| blocksByType[blockIndex].m_blockDefIndex != generated.m_blockDefIndex || blocksByType[blockIndex].m_blockBitFlags != generated.m_blockBitFlags)
+				{
+					++numDifferentChunks;
+					break;
+				}
+			}
+			++numChunks;
+			delete chunk;
+		}
+	}
+
+	g_theDevConsole->AddLine(Stringf("BlockTypeBenchmark: %i chunks, one core", numChunks), DevConsole::INFO_MAJOR);
+	g_theDevConsole->AddLine(Stringf("  CreateInitialBlocks: %.3f ms/chunk", generateSeconds * 1000.0 / numChunks), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  every block set by name: %.3f ms/chunk, by BlockType: %.3f ms/chunk, %.1fx faster", byNameSeconds * 1000.0 / numChunks,
+		byTypeSeconds * 1000.0 / numChunks, byNameSeconds / byTypeSeconds), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  %i chunks set differently", numDifferentChunks), DevConsole::INFO_MINOR);
+
+	bool passed = (numDifferentChunks == 0);
+	g_theDevConsole->AddLine(Stringf("BlockTypeBenchmark %s", passed ? "PASSED" : "FAILED"), passed ? DevConsole::INFO_MAJOR : DevConsole::INFO_ERROR);
+	return passed;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// voxel raycast benchmark
+// usage in dev console: "VoxelRaycastBenchmark rays=100000 range=48 dist=64"
+// random rays start within range blocks of the player in the active chunks, each is cast with FastRaycastForVoxelGrids one at a time,
+// then all of them with the batch DDA on this thread and on the job workers
+// both batches have to agree, and with the single ray function on whether and how far away the ray hits,
+// where it does not the ray is stepped through in tiny steps and the batch has to agree with that instead
+
+// the distance to the first solid block, -1 when there is none, stepping 1/1000 of a block at a time
+static float StepRayThroughActiveChunks(VoxelRay const& ray)
+{
+	constexpr double STEP_DIST = 0.001;
+	for (double dist = 0.0; dist <= (double)ray.m_dist; dist += STEP_DIST)
+	{
+		int blockX = (int)floor((double)ray.m_start.x + (double)ray.m_fwdNormal.x * dist);
+		int blockY = (int)floor((double)ray.m_start.y + (double)ray.m_fwdNormal.y * dist);
+		int blockZ = (int)floor((double)ray.m_start.z + (double)ray.m_fwdNormal.z * dist);
+		if (blockZ < 0 || blockZ >= CHUNK_SIZE_Z)
+		{
+			return -1.f;
+		}
+		Chunk* chunk = g_theWorld->m_activeChunks.Find(IntVec2(blockX >> CHUNK_BITS_X, blockY >> CHUNK_BITS_Y));
+		if (!chunk)
+		{
+			return -1.f;
+		}
+		int blockIndex = (blockX & (CHUNK_SIZE_X - 1)) | ((blockY & (CHUNK_SIZE_Y - 1)) << CHUNK_BITSHIFT_Y) | (blockZ << CHUNK_BITSHIFT_Z);
+		Block block = chunk->m_blocks ? chunk->m_blocks[blockIndex] : chunk->m_palettedBlocks->GetBlock(blockIndex);
+		if (block.IsSolid())
+		{
+			return (float)dist;
+		}
+	}
+	return -1.f;
+}
+
+static bool DoVoxelRaycastsAgree(SimpleMinerRaycastResult const& a, SimpleMinerRaycastResult const& b)
+{
+	return a.m_didImpact == b.m_didImpact && (!a.m_didImpact || fabsf(a.m_impactDist - b.m_impactDist) < 0.01f);
+}
+
+bool App::Command_VoxelRaycastBenchmark(EventArgs& args)
+{
+	if (!g_theWorld || !g_theWorld->m_playerLocatedChunk)
+	{
+		g_theDevConsole->AddLine("VoxelRaycastBenchmark needs the world around the player, start the game first", DevConsole::INFO_ERROR);
+		return false;
+	}
+	int numRays = args.GetValue("rays", 100000);
+	float range = args.GetValue("range", 48.f);
+	float maxDist = args.GetValue("dist", 64.f);
+	if (numRays < 1 || range < 0.f || maxDist < 1.f)
+	{
+		g_theDevConsole->AddLine("VoxelRaycastBenchmark needs rays >= 1, range >= 0 and dist >= 1", DevConsole::INFO_ERROR);
+		return false;
+	}
+
+	// the same rays every time for the same player position
+	RandomNumberGenerator rng(1234);
+	Vec3 playerPos = g_theGame->m_player->m_position;
+	std::vector<VoxelRay> rays;
+	rays.reserve(numRays);
+	while ((int)rays.size() < numRays)
+	{
+		VoxelRay ray;
+		ray.m_start = Vec3(playerPos.x + rng.RollRandomFloatInRange(-range, range), playerPos.y + rng.RollRandomFloatInRange(-range, range),
+			rng.RollRandomFloatInRange(0.f, float(CHUNK_SIZE_Z) - 0.01f));
+		Vec3 fwd = Vec3(rng.RollRandomFloatInRange(-1.f, 1.f), rng.RollRandomFloatInRange(-1.f, 1.f), rng.RollRandomFloatInRange(-1.f, 1.f));
+		if (fwd.GetLengthSquared() < 0.01f || !g_theWorld->m_activeChunks.Find(g_theWorld->GetChunkCoordsForWorldPos(ray.m_start)))
+		{
+			continue;
+		}
+		ray.m_fwdNormal = fwd.GetNormalized();
+		ray.m_dist = rng.RollRandomFloatInRange(1.f, maxDist);
+		rays.push_back(ray);
+	}
+
+	std::vector<SimpleMinerRaycastResult> singleResults(numRays);
+	double timeAtStart = GetCurrentTimeSeconds();
+	for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+	{
+		singleResults[rayIndex] = g_theWorld->FastRaycastForVoxelGrids(rays[rayIndex].m_start, rays[rayIndex].m_fwdNormal, rays[rayIndex].m_dist);
+	}
+	double singleSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	std::vector<SimpleMinerRaycastResult> batchResults;
+	timeAtStart = GetCurrentTimeSeconds();
+	g_theWorld->RaycastVoxels(rays, batchResults, false);
+	double batchSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	std::vector<SimpleMinerRaycastResult> workerResults;
+	timeAtStart = GetCurrentTimeSeconds();
+	g_theWorld->RaycastVoxels(rays, workerResults, true);
+	double workerSeconds = GetCurrentTimeSeconds() - timeAtStart;
+
+	int numHits = 0;
+	int numDifferentOnWorkers = 0;
+	int numDifferentFromSingle = 0;
+	int numWrong = 0;
+	for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+	{
+		SimpleMinerRaycastResult const& batchResult = batchResults[rayIndex];
+		SimpleMinerRaycastResult const& workerResult = workerResults[rayIndex];
+		numHits += batchResult.m_didImpact ? 1 : 0;
+		if (workerResult.m_didImpact != batchResult.m_didImpact || workerResult.m_impactDist != batchResult.m_impactDist
+			|| workerResult.m_aimedBlockIter.m_chunk != batchResult.m_aimedBlockIter.m_chunk || workerResult.m_aimedBlockIter.m_blockIndex != batchResult.m_aimedBlockIter.m_blockIndex)
+		{
+			++numDifferentOnWorkers;
+		}
+		if (!DoVoxelRaycastsAgree(batchResult, singleResults[rayIndex]))
+		{
+			++numDifferentFromSingle;
+			float steppedDist = StepRayThroughActiveChunks(rays[rayIndex]);
+			bool agreesWithSteps = batchResult.m_didImpact ? (steppedDist >= 0.f && fabsf(steppedDist - batchResult.m_impactDist) < 0.01f) : (steppedDist < 0.f);
+			numWrong += agreesWithSteps ? 0 : 1;
+		}
+	}
+
+	g_theDevConsole->AddLine(Stringf("VoxelRaycastBenchmark: %i rays within %.0f blocks of the player, up to %.0f blocks long, %i hit", numRays, range, maxDist, numHits), DevConsole::INFO_MAJOR);
+	g_theDevConsole->AddLine(Stringf("  FastRaycastForVoxelGrids one at a time: %.3f us/ray", singleSeconds * 1000000.0 / numRays), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  batch DDA on this thread: %.3f us/ray, %.1fx faster", batchSeconds * 1000000.0 / numRays, singleSeconds / batchSeconds), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  batch DDA on the job workers: %.3f us/ray, %.1fx faster, %i rays differ from this thread", workerSeconds * 1000000.0 / numRays,
+		singleSeconds / workerSeconds, numDifferentOnWorkers), DevConsole::INFO_MINOR);
+	g_theDevConsole->AddLine(Stringf("  %i rays differ from FastRaycastForVoxelGrids, the batch is wrong in %i of them going by the stepped ray", numDifferentFromSingle, numWrong), DevConsole::INFO_MINOR);
+
+	bool passed = (numDifferentOnWorkers == 0 && numWrong == 0);
+	g_theDevConsole->AddLine(Stringf("VoxelRaycastBenchmark %s", passed ? "PASSED" : "FAILED"), passed ? DevConsole::INFO_MAJOR : DevConsole::INFO_ERROR);
+	return passed;
+}
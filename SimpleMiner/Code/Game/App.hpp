@@ -34,6 +34,7 @@ enum TextureID
 enum ShaderID
 {
 	WORLD,
+	WORLD_VOXEL,
 	NUM_SHADERS
 };
 
@@ -54,6 +55,22 @@ public:
 	void Execute() override;
 };
 
+// a job that is almost free to execute, so the benchmark measures the job system overhead only
+class BenchmarkTinyJob : public Job
+{
+public:
+	static constexpr int JOB_TYPE = JOB_TYPE_BENCHMARK;
+
+	BenchmarkTinyJob()
+		: Job(JOB_TYPE)
+	{}
+
+	void Execute() override;
+
+	unsigned int m_input = 0;
+	unsigned int m_result = 0;
+};
+
 class App
 {
 public:
@@ -88,6 +105,23 @@ public:
 
 	// event system functions
 	static bool Event_Quit(EventArgs& args);
+	static bool Command_JobSystemBenchmark(EventArgs& args);
+	static bool Command_ChunkStreamingReplay(EventArgs& args);
+	static bool Command_JobSystemRetrieveTest(EventArgs& args);
+	static bool Command_ChunkRegistryBenchmark(EventArgs& args);
+	static bool Command_ChunkStreamingIOTest(EventArgs& args);
+	static bool Command_ChunkRegionBenchmark(EventArgs& args);
+	static bool Command_ChunkSerializationBenchmark(EventArgs& args);
+	static bool Command_ChunkMemoryReport(EventArgs& args);
+	static bool Command_ChunkMesherBenchmark(EventArgs& args);
+	static bool Command_UseGreedyMesher(EventArgs& args);
+	static bool Command_LightingBenchmark(EventArgs& args);
+	static bool Command_UseWavefrontLighting(EventArgs& args);
+	static bool Command_ChunkGenerationBenchmark(EventArgs& args);
+	static bool Command_UseBatchNoise(EventArgs& args);
+	static bool Command_ChunkGenerationDeterminismTest(EventArgs& args);
+	static bool Command_BlockTypeBenchmark(EventArgs& args);
+	static bool Command_VoxelRaycastBenchmark(EventArgs& args);
 
 private:
 	void BeginFrame();
@@ -4,6 +4,8 @@
 #include "Engine/core/StringUtils.hpp"
 
 std::vector<BlockDef> BlockDef::s_BlockDefs;
+uint8_t BlockDef::s_bitFlagsByType[NUM_BLOCK_TYPES] = {};
+uint8_t BlockDef::s_indoorLightByType[NUM_BLOCK_TYPES] = {};
 
 bool BlockDef::operator!=(BlockDef compare)
 {
@@ -67,6 +69,10 @@ void BlockDef::InitializeBlockDefs()
 	CreateNewBlockDef("spruceLog",		true,		true,		true,		false,				0,					0,			IntVec2(38, 33),	IntVec2(35, 33),	IntVec2(38, 33));
 	CreateNewBlockDef("spruceLeaf",		true,		true,		true,		false,				0,					0,			IntVec2(34, 35),	IntVec2(34, 35),	IntVec2(34, 35));
 	CreateNewBlockDef("cactus",			true,		true,		true,		false,				0,					0,			IntVec2(38, 36),	IntVec2(37, 36),	IntVec2(39, 36));
+
+	// the defs have to line up with BlockType
+	GUARANTEE_OR_DIE((int)s_BlockDefs.size() == NUM_BLOCK_TYPES, Stringf("%i block defs for %i block types", (int)s_BlockDefs.size(), (int)NUM_BLOCK_TYPES));
+	GUARANTEE_OR_DIE(GetBlockTypeByName("cactus") == BLOCK_TYPE_CACTUS && GetBlockTypeByName("glowStone") == BLOCK_TYPE_GLOWSTONE, "the block defs are not in BlockType order");
 }
 
 void BlockDef::CreateNewBlockDef(std::string name, bool visible, bool solid, bool opaque, bool emissive,
@@ -74,6 +80,17 @@ void BlockDef::CreateNewBlockDef(std::string name, bool visible, bool solid, boo
 	IntVec2 topSpriteCoords, IntVec2 sidesSpriteCoords, IntVec2 bottomSpriteCoords)
 {
 	BlockDef newBlockDef = *new BlockDef(name, visible, solid, opaque, emissive, outdoorLightLevel, indoorLightLevel, topSpriteCoords, sidesSpriteCoords, bottomSpriteCoords);
+	int typeIndex = (int)BlockDef::s_BlockDefs.size();
+	GUARANTEE_OR_DIE(typeIndex < NUM_BLOCK_TYPES, Stringf("%s has no BlockType", name.c_str()));
+	newBlockDef.m_type = (BlockType)typeIndex;
+
+	uint8_t bitFlags = 0;
+	bitFlags |= opaque ? BLOCK_BIT_MASK_IS_FULL_OPAQUE : 0;
+	bitFlags |= emissive ? BLOCK_BIT_MASK_IS_EMISSIVE : 0;
+	bitFlags |= visible ? BLOCK_BIT_MASK_IS_VISIBLE : 0;
+	bitFlags |= solid ? BLOCK_BIT_MASK_IS_SOLID : 0;
+	s_bitFlagsByType[typeIndex] = bitFlags;
+	s_indoorLightByType[typeIndex] = indoorLightLevel;
 
 	// all block def is using the same sprite sheet
 	std::string spriteSheetPath = "Data/Images/BasicSprites_64x64.png";
@@ -98,51 +115,43 @@ BlockDef BlockDef::GetBlockDefByName(std::string name)
 	return s_BlockDefs[0];
 }
 
-void Block::SetType(std::string tileTypeName)
+BlockType BlockDef::GetBlockTypeByName(std::string const& name)
 {
-	for (int i = 0; i < BlockDef::s_BlockDefs.size(); ++i)
+	for (int i = 0; i < (int)s_BlockDefs.size(); ++i)
 	{
-		if (BlockDef::s_BlockDefs[i].m_name == tileTypeName)
+		if (s_BlockDefs[i].m_name == name)
 		{
-			m_blockDefIndex = unsigned char(i);
-			SetIsOpaque(BlockDef::s_BlockDefs[i].m_isOpaque);
-			SetIsEmissive(BlockDef::s_BlockDefs[i].m_isEmissive);
-			SetVisibility(BlockDef::s_BlockDefs[i].m_isVisible);
-			SetSolidity(BlockDef::s_BlockDefs[i].m_isSolid);
-			return; // if find the correct tile definition, stop the for loop
+			return s_BlockDefs[i].m_type;
 		}
 	}
 
-	ERROR_RECOVERABLE(Stringf("%s is not defined in the block defs", tileTypeName.c_str()));
+	ERROR_RECOVERABLE(Stringf("%s is not defined in the block defs", name.c_str()));
+	return BLOCK_TYPE_AIR;
 }
 
-void Block::SetType(BlockDef const& def)
+// the sky and light dirty bits belong to the block, the rest come from the type's table
+void Block::SetType(BlockType type)
 {
-	for (int i = 0; i < BlockDef::s_BlockDefs.size(); ++i)
-	{
-		if (BlockDef::s_BlockDefs[i] == def)
-		{
-			m_blockDefIndex = unsigned char(i);
-			SetIsOpaque(def.m_isOpaque);
-			SetIsEmissive(def.m_isEmissive);
-			SetVisibility(def.m_isVisible);
-			SetSolidity(def.m_isSolid);
-			return; // if find the correct tile definition, stop the for loop
-		}
-	}
+	m_blockDefIndex = (unsigned char)type;
+	m_blockBitFlags = (uint8_t)((m_blockBitFlags & ~BLOCK_BIT_MASK_DEF_FLAGS) | BlockDef::s_bitFlagsByType[type]);
+}
+
+void Block::SetType(std::string tileTypeName)
+{
+	SetType(BlockDef::GetBlockTypeByName(tileTypeName));
+}
 
-	ERROR_RECOVERABLE(Stringf("%s is not defined in the block defs", def.m_name.c_str()));
+void Block::SetType(BlockDef const& def)
+{
+	SetType(def.m_type);
 }
 
 void Block::UpdateBlockBitFlagsByBlockDef()
 {
-	BlockDef def = BlockDef::s_BlockDefs[m_blockDefIndex];
-	SetIsOpaque(def.m_isOpaque);
-	SetIsEmissive(def.m_isEmissive);
-	SetVisibility(def.m_isVisible);
+	SetType(GetType());
 }
 
-BlockDef Block::GetBlockDef() const
+BlockDef const& Block::GetBlockDef() const
 {
 	return BlockDef::s_BlockDefs[int(m_blockDefIndex)];
 }
@@ -338,7 +347,7 @@ void Block::SetIsEmissive(bool isEmissive)
 
 	if (isEmissive)
 	{
-		m_blockBitFlags = m_blockBitFlags | (1 << (BLOCK_BIT_MASK_IS_EMISSIVE - 1));
+		m_blockBitFlags = m_blockBitFlags | BLOCK_BIT_MASK_IS_EMISSIVE;
 	}
 	else
 	{
@@ -399,7 +408,7 @@ void BlockTemplate::InitializeBlockTemplates()
 	BlockTemplate::CreateCactusBlockTemplate();
 }
 
-BlockTemplate BlockTemplate::GetBlockTemplateByName(std::string templateName)
+BlockTemplate const& BlockTemplate::GetBlockTemplateByName(std::string templateName)
 {
 	for (int i = 0; i < (int)s_blockTemplates.size(); ++i)
 	{
@@ -419,74 +428,74 @@ void BlockTemplate::CreateOakBlockTemplate()
 	BlockTemplate* oakTree = new BlockTemplate("oak");
 
 	// trunk
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLog"), IntVec3(0, 0, 1))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLog"), IntVec3(0, 0, 2))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLog"), IntVec3(0, 0, 2))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLog"), IntVec3(0, 0, 3))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLog"), IntVec3(0, 0, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLog"), IntVec3(0, 0, 5))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLog"), IntVec3(0, 0, 6))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLog"), IntVec3(0, 0, 7))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LOG, IntVec3(0, 0, 1))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LOG, IntVec3(0, 0, 2))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LOG, IntVec3(0, 0, 2))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LOG, IntVec3(0, 0, 3))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LOG, IntVec3(0, 0, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LOG, IntVec3(0, 0, 5))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LOG, IntVec3(0, 0, 6))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LOG, IntVec3(0, 0, 7))));
 
 	// 4nd floor leaves
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-2, 2, 4), 0.3f)));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-1, 2, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(0, 2, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(1, 2, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(1, 2, 4), 0.3f)));
-
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-2, 1, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-1, 1, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(0, 1, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(1, 1, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(2, 1, 4))));
-
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-2, 0, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-1, 0, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(1, 0, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(2, 0, 4))));
-
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-2, -1, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-1, -1, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(0, -1, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(1, -1, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(2, -1, 4))));
-
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-2, -2, 4), 0.3f)));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-1, -2, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(0, -2, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(1, -2, 4))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(2, -2, 4), 0.3f)));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-2, 2, 4), 0.3f)));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-1, 2, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(0, 2, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(1, 2, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(1, 2, 4), 0.3f)));
+
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-2, 1, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-1, 1, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(0, 1, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(1, 1, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(2, 1, 4))));
+
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-2, 0, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-1, 0, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(1, 0, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(2, 0, 4))));
+
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-2, -1, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-1, -1, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(0, -1, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(1, -1, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(2, -1, 4))));
+
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-2, -2, 4), 0.3f)));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-1, -2, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(0, -2, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(1, -2, 4))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(2, -2, 4), 0.3f)));
 
 	// 5nd floor leaves
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-1, 1, 5))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(0, 1, 5))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(1, 1, 5))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-1, 0, 5))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(1, 0, 5))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-1, -1, 5))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(0, -1, 5))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(1, -1, 5))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-1, 1, 5))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(0, 1, 5))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(1, 1, 5))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-1, 0, 5))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(1, 0, 5))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-1, -1, 5))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(0, -1, 5))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(1, -1, 5))));
 
 	// 6nd floor leaves
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-1, 1, 6))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(0, 1, 6))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(1, 1, 6))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-1, 0, 6))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(1, 0, 6))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-1, -1, 6))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(0, -1, 6))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(1, -1, 6))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-1, 1, 6))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(0, 1, 6))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(1, 1, 6))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-1, 0, 6))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(1, 0, 6))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-1, -1, 6))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(0, -1, 6))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(1, -1, 6))));
 
 	// 7nd floor leaves
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-1, 1, 7))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(0, 1, 7))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(1, 1, 7))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-1, 0, 7))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(1, 0, 7))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(-1, -1, 7))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(0, -1, 7))));
-	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("oakLeaf"), IntVec3(1, -1, 7))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-1, 1, 7))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(0, 1, 7))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(1, 1, 7))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-1, 0, 7))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(1, 0, 7))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(-1, -1, 7))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(0, -1, 7))));
+	oakTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_OAK_LEAF, IntVec3(1, -1, 7))));
 
 	BlockTemplate::s_blockTemplates.push_back(*oakTree);
 }
@@ -497,75 +506,75 @@ void BlockTemplate::CreateSpruceBlockTemplate()
 	float possibility = 0.6f;
 
 	// trunk
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLog"), IntVec3(0, 0, 1))));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLog"), IntVec3(0, 0, 2))));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLog"), IntVec3(0, 0, 2))));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLog"), IntVec3(0, 0, 3))));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLog"), IntVec3(0, 0, 4))));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLog"), IntVec3(0, 0, 5))));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLog"), IntVec3(0, 0, 6))));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLog"), IntVec3(0, 0, 7))));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLog"), IntVec3(0, 0, 8))));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LOG, IntVec3(0, 0, 1))));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LOG, IntVec3(0, 0, 2))));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LOG, IntVec3(0, 0, 2))));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LOG, IntVec3(0, 0, 3))));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LOG, IntVec3(0, 0, 4))));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LOG, IntVec3(0, 0, 5))));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LOG, IntVec3(0, 0, 6))));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LOG, IntVec3(0, 0, 7))));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LOG, IntVec3(0, 0, 8))));
 
 	// 4nd floor leaves
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, 1, 4), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(0, 1, 4)))); //
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, 1, 4), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, 0, 4))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, 0, 4))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, -1, 4), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(0, -1, 4))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, -1, 4), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, 1, 4), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(0, 1, 4)))); //
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, 1, 4), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, 0, 4))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, 0, 4))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, -1, 4), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(0, -1, 4))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, -1, 4), possibility)));
 
 	// 5nd floor leaves
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, 1, 5), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(0, 1, 5)))); //
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, 1, 5), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, 0, 5))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, 0, 5))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, -1, 5), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(0, -1, 5))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, -1, 5), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, 1, 5), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(0, 1, 5)))); //
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, 1, 5), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, 0, 5))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, 0, 5))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, -1, 5), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(0, -1, 5))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, -1, 5), possibility)));
 
 	// 6nd floor leaves
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, 1, 6), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(0, 1,	6)))); //
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, 1,	6), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, 0, 6))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, 0,	6))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, -1,6), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(0, -1, 6))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, -1, 6), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, 1, 6), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(0, 1,	6)))); //
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, 1,	6), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, 0, 6))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, 0,	6))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, -1,6), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(0, -1, 6))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, -1, 6), possibility)));
 
 	// 7nd floor leaves
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, 1, 7), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(0, 1,	7)))); //
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, 1,	7), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, 0, 7))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, 0,	7))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, -1,7), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(0, -1, 7))));// 
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, -1, 7), possibility)));	
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, 1, 7), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(0, 1,	7)))); //
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, 1,	7), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, 0, 7))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, 0,	7))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, -1,7), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(0, -1, 7))));// 
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, -1, 7), possibility)));	
 	
 	// 7nd floor leaves
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, 1, 7), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(0, 1,	7)))); //
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, 1,	7), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, 0, 7))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, 0,	7))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, -1,7), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(0, -1, 7))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, -1, 7), possibility)));	
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, 1, 7), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(0, 1,	7)))); //
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, 1,	7), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, 0, 7))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, 0,	7))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, -1,7), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(0, -1, 7))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, -1, 7), possibility)));	
 	
 	// 8nd floor leaves
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, 1, 8), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(0, 1,	8)))); //
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, 1,	8), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, 0, 8))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, 0,	8))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(-1, -1,8), possibility)));
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(0, -1, 8))));//
-	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("spruceLeaf"), IntVec3(1, -1, 8), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, 1, 8), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(0, 1,	8)))); //
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, 1,	8), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, 0, 8))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, 0,	8))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(-1, -1,8), possibility)));
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(0, -1, 8))));//
+	spruceTree->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_SPRUCE_LEAF, IntVec3(1, -1, 8), possibility)));
 
 	BlockTemplate::s_blockTemplates.push_back(*spruceTree);
 }
@@ -576,13 +585,13 @@ void BlockTemplate::CreateCactusBlockTemplate()
 	float possibility = 0.6f;
 
 	// trunk
-	cactus->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("cactus"), IntVec3(0, 0, 1))));
-	cactus->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("cactus"), IntVec3(0, 0, 2))));
-	cactus->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("cactus"), IntVec3(0, 0, 2))));
-	cactus->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("cactus"), IntVec3(0, 0, 3))));
-	cactus->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("cactus"), IntVec3(0, 0, 4))));
-	cactus->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("cactus"), IntVec3(0, 0, 5))));
-	cactus->m_entries.push_back(*(new BlockTemplateEntry(BlockDef::GetBlockDefByName("cactus"), IntVec3(0, 0, 6), possibility)));
+	cactus->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_CACTUS, IntVec3(0, 0, 1))));
+	cactus->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_CACTUS, IntVec3(0, 0, 2))));
+	cactus->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_CACTUS, IntVec3(0, 0, 2))));
+	cactus->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_CACTUS, IntVec3(0, 0, 3))));
+	cactus->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_CACTUS, IntVec3(0, 0, 4))));
+	cactus->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_CACTUS, IntVec3(0, 0, 5))));
+	cactus->m_entries.push_back(*(new BlockTemplateEntry(BLOCK_TYPE_CACTUS, IntVec3(0, 0, 6), possibility)));
 
 	BlockTemplate::s_blockTemplates.push_back(*cactus);
 }
@@ -7,6 +7,33 @@
 #include "Engine/Renderer/SpriteSheet.hpp"
 #include <vector>
 
+// the block types in the order BlockDef::InitializeBlockDefs creates them
+// a type is the index into s_BlockDefs and the per type tables, and is what Block::m_blockDefIndex holds
+enum BlockType : uint8_t
+{
+	BLOCK_TYPE_AIR,
+	BLOCK_TYPE_WATER,
+	BLOCK_TYPE_ICE,
+	BLOCK_TYPE_SAND,
+	BLOCK_TYPE_STONE,
+	BLOCK_TYPE_COBBLESTONE,
+	BLOCK_TYPE_GRASS_BRICK,
+	BLOCK_TYPE_DIRT,
+	BLOCK_TYPE_GRASS,
+	BLOCK_TYPE_SNOWY_GRASS,
+	BLOCK_TYPE_COAL,
+	BLOCK_TYPE_IRON,
+	BLOCK_TYPE_GOLD,
+	BLOCK_TYPE_DIAMOND,
+	BLOCK_TYPE_GLOWSTONE,
+	BLOCK_TYPE_OAK_LOG,
+	BLOCK_TYPE_OAK_LEAF,
+	BLOCK_TYPE_SPRUCE_LOG,
+	BLOCK_TYPE_SPRUCE_LEAF,
+	BLOCK_TYPE_CACTUS,
+	NUM_BLOCK_TYPES
+};
+
 struct BlockDef
 {
 public:
@@ -18,6 +45,7 @@ public:
 	~BlockDef();
 
 	std::string		m_name;
+	BlockType		m_type = BLOCK_TYPE_AIR;
 	bool			m_isVisible = true;
 	bool			m_isSolid = false;
 	bool			m_isOpaque = false;
@@ -41,8 +69,13 @@ public:
 		uint8_t outdoorLightLevel, uint8_t indoorLightLevel, 
 		IntVec2 topSpriteCoords, IntVec2 sidesSpriteCoords, IntVec2 bottomSpriteCoords);
 	static BlockDef GetBlockDefByName(std::string name);
+	static BlockType GetBlockTypeByName(std::string const& name); // for names read at load time, the game code uses the BlockType directly
 	static std::vector<BlockDef> s_BlockDefs;
 
+	// flat per type copies of the def data read for every block
+	static uint8_t s_bitFlagsByType[NUM_BLOCK_TYPES]; // the opaque, emissive, visible and solid bits of m_blockBitFlags
+	static uint8_t s_indoorLightByType[NUM_BLOCK_TYPES];
+
 	bool	operator==(BlockDef compare);
 	bool	operator!=(BlockDef compare);
 };
@@ -55,10 +88,12 @@ public:
 
 	// void SetChunkIndex(unsigned int index);
 	// unsigned int GetChunkIndex() const;
+	void SetType(BlockType type);
 	void SetType(std::string tileTypeName);
 	void SetType(BlockDef const& def);
 	void UpdateBlockBitFlagsByBlockDef();
-	BlockDef GetBlockDef() const;
+	BlockDef const& GetBlockDef() const;
+	BlockType GetType() const { return (BlockType)m_blockDefIndex; }
 
 	// lighting
 	uint8_t GetOutdoorLighting() const;
@@ -94,13 +129,13 @@ private:
 
 struct BlockTemplateEntry
 {
-	BlockTemplateEntry(BlockDef def, IntVec3 coords, float possibility = 1.f)
-		: blockDef(def)
+	BlockTemplateEntry(BlockType type, IntVec3 coords, float possibility = 1.f)
+		: blockType(type)
 		, chanceToSpawn(possibility)
 		, offset(coords)
 	{}
 	float		chanceToSpawn = 1.f;
-	BlockDef	blockDef;
+	BlockType	blockType;
 	IntVec3		offset;
 };
 
@@ -114,7 +149,7 @@ struct BlockTemplate
 
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
 	static void InitializeBlockTemplates();
-	static BlockTemplate GetBlockTemplateByName(std::string templateName);
+	static BlockTemplate const& GetBlockTemplateByName(std::string templateName);
 	static void CreateOakBlockTemplate();
 	static void CreateSpruceBlockTemplate();
 	static void CreateCactusBlockTemplate();
@@ -21,6 +21,8 @@ Block* BlockIter::GetBlock() const
 	}
 	else
 	{
+		// lighting and meshing reach into neighbor chunks through here, a compacted neighbor gets its flat blocks back
+		m_chunk->ExpandBlocks();
 		return &m_chunk->m_blocks[m_blockIndex];
 	}
 }
@@ -83,7 +85,7 @@ BlockIter BlockIter::GetSouthNeighbor() const
 {
 	if (!m_chunk)
 	{
-		BlockIter(nullptr, -1);
+		return BlockIter(nullptr, -1);
 	}
 
 	int localY = (m_blockIndex & CHUNK_MASK_Y) >> CHUNK_BITS_X;
@@ -127,7 +129,7 @@ BlockIter BlockIter::GetLowerLevelNeighbor() const
 	else
 	{
 		int blockIndex = m_blockIndex - CHUNK_BLOCKS_PER_LAYER; // top of the chunk
-		if (blockIndex <= 0)
+		if (blockIndex < 0)
 		{
 			return BlockIter(nullptr, -1);
 		}
@@ -1,7 +1,6 @@
 #include "Engine/Math/AABB2.hpp"
 #include "Engine/core/VertexUtils.hpp"
 #include "Engine/Renderer/Renderer.hpp"
-#include "Engine/Math/RandomNumberGenerator.hpp"
 #include "Engine/core/RaycastUtils.Hpp"
 #include "Engine/Audio/AudioSystem.hpp"
 #include "Engine/core/Image.hpp"
@@ -21,6 +20,9 @@
 #include "Game/Block.hpp"
 #include "Game/BlockIterator.hpp"
 #include "Game/Chunk.hpp"
+#include "Game/ChunkMesher.hpp"
+#include "Game/ChunkFeatures.hpp"
+#include "Engine/core/CompressionUtils.hpp"
 #include <thread>
 
 Rgba8 const white = Rgba8(255, 255, 255);
@@ -37,7 +39,6 @@ const IntVec2 STEP_SOUTHWEST = IntVec2(-1, -1);
 const IntVec2 STEP_WESTNORTH = IntVec2(-1, 1);
 const IntVec2 STEP_NORTHEAST = IntVec2(1, 1);
 
-extern RandomNumberGenerator* g_rng;
 extern App* g_theApp;
 extern Game* g_theGame;
 extern World* g_theWorld;
@@ -46,12 +47,54 @@ extern JobSystem* g_theJobSystem;
 Chunk::Chunk(IntVec2 originCoords)
 	:m_chunkCoords(originCoords)
 {
+	m_blocks = new Block[CHUNK_BLOCKS_TOTAL];
 }
 
 Chunk::~Chunk()
 {
-	delete m_vertexBuffer;
-	m_vertexBuffer = nullptr;
+	for (int sectionIndex = 0; sectionIndex < CHUNK_NUM_SECTIONS; ++sectionIndex)
+	{
+		ReleaseSectionMesh(sectionIndex);
+	}
+
+	delete[] m_blocks;
+	m_blocks = nullptr;
+	delete m_palettedBlocks;
+	m_palettedBlocks = nullptr;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+void Chunk::CompactBlocks()
+{
+	if (IsCompacted())
+	{
+		return;
+	}
+	m_palettedBlocks = new ChunkPalettedBlocks();
+	m_palettedBlocks->CompressBlocks(m_blocks);
+	delete[] m_blocks;
+	m_blocks = nullptr;
+}
+
+void Chunk::ExpandBlocks()
+{
+	if (!IsCompacted())
+	{
+		return;
+	}
+	m_blocks = new Block[CHUNK_BLOCKS_TOTAL];
+	m_palettedBlocks->DecompressBlocks(m_blocks);
+	delete m_palettedBlocks;
+	m_palettedBlocks = nullptr;
+}
+
+size_t Chunk::GetBlocksNumBytes() const
+{
+	if (IsCompacted())
+	{
+		return m_palettedBlocks->GetNumBytes();
+	}
+	return sizeof(Block) * CHUNK_BLOCKS_TOTAL;
 }
 
 void ChunkGenerateJob::Execute()
@@ -59,256 +102,268 @@ void ChunkGenerateJob::Execute()
 	m_chunk->m_chunkState = ChunkState::ACTIVATING_GENERATING;
 	m_chunk->GenerateBiomeFactors();
 	m_chunk->CreateInitialBlocks();
-	m_chunk->SpawnTreeBlockTemplatesAccordingToBiomeFactors();
+	m_chunk->StampFeatures();
+	m_chunk->RecountSectionBlocks();
 	m_chunk->m_chunkState = ChunkState::ACTIVATING_GENERATE_COMPLETE;
 }
 
+void ChunkLoadJob::Execute()
+{
+	m_chunk->m_chunkState = ChunkState::ACTIVATING_LOADING;
+	m_wasLoaded = m_chunk->LoadBlocksDataFromFile();
+	m_chunk->m_chunkState = ChunkState::ACTIVATING_LOAD_COMPLETE;
+}
+
+void ChunkSaveJob::Execute()
+{
+	m_chunk->m_chunkState = ChunkState::DEACTIVATING_SAVING;
+	m_chunk->SaveBlocksDataToFile();
+	m_chunk->m_chunkState = ChunkState::DEACTIVATING_SAVE_COMPLETE;
+}
+
+void ChunkMeshJob::Execute()
+{
+	BuildGreedySectionMesh(m_snapshot.data(), m_sectionIndex, m_verts);
+}
+
+// the main thread never touches the disk for a chunk, looking for the save file is a job on the I/O lane as well
+// the world queues the generate job when the load job comes back without a save file
 void Chunk::Startup()
 {
-	if (CheckIfThereIsSaveFile())
+	m_chunkState = ChunkState::CONSTRUCTING;
+	ChunkLoadJob* job = new ChunkLoadJob(this);
+	m_pendingJob = job;
+
+	g_theJobSystem->QueueJobs(job);
+	m_chunkState = ChunkState::ACTIVATING_QUEUED_LOAD;
+	g_theWorld->m_chunksBeingGeneratedOrLoaded.Set(m_chunkCoords, this);
+}
+ 
+// only the dirty sections are remeshed, a section waits for its mesh job to come back before it queues another one,
+// an edit in between makes that result stale
+void Chunk::Update()
+{
+	if (!DoAllFourSurroundingNeighborChunksExist())
 	{
-		LoadBlocksDataFromFile();
-		g_theWorld->ActivateNewChunk(this);
+		return;
 	}
-	else
-	{
-		// queue up a synchronized threaded job in the background
-		ChunkGenerateJob* job = new ChunkGenerateJob(this);
-		m_chunkState = ChunkState::CONSTRUCTING;
 
-		g_theJobSystem->QueueJobs(job);
-		m_chunkState = ChunkState::ACTIVATING_QUEUED_GENERATE;
-		g_theWorld->m_chunksBeingGeneratedOrLoaded.insert(m_chunkCoords);
+	for (int sectionIndex = 0; sectionIndex < CHUNK_NUM_SECTIONS; ++sectionIndex)
+	{
+		ChunkSection& section = m_sections[sectionIndex];
+		if (section.m_isMeshDirty && !section.m_meshJob)
+		{
+			UpdateSectionMesh(sectionIndex);
+			section.m_isMeshDirty = false;
+		}
 	}
 }
- 
-void Chunk::Update()
+
+// nothing is drawn for an empty or a buried section, nor are the blocks ever looked at
+void Chunk::UpdateSectionMesh(int sectionIndex)
 {
-	if (m_isMeshDirty && DoAllFourSurroundingNeighborChunksExist())
+	if (IsSectionEmpty(sectionIndex) || IsSectionBuried(sectionIndex))
 	{
-		// if the chunk need saving, meaning we have not update its save file yet
-		// if (!m_needsSaving)
-		// {
-		// 	if (CheckIfThereIsSaveFile())
-		// 	{
-		// 		LoadBlocksDataFromFile();
-		// 	}
-		// 	else
-		// 	{
-		// 		CreateInitialBlocks();
-		// 		SpawnTreeBlockTemplatesAccordingToBiomeFactors();
-		// 	}
-		// }
+		ReleaseSectionMesh(sectionIndex);
+		return;
+	}
 
-		// g_theWorld->LightInfluenceInitialization(this);
+	ExpandBlocks();
+	if (g_theWorld->m_useGreedyMesher)
+	{
+		QueueMeshJob(sectionIndex);
+	}
+	else
+	{
+		m_blockVerts.clear();
+		AddVertsForSection(sectionIndex);
+		UploadSectionMesh(sectionIndex, false);
+	}
+}
 
-		AddVertsForAllBlocksInChunk();
-		CreateVertexBuffer();
-		CopyVertexBufferFromCPUtoGPU();
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+void Chunk::MarkMeshDirty()
+{
+	for (int sectionIndex = 0; sectionIndex < CHUNK_NUM_SECTIONS; ++sectionIndex)
+	{
+		m_sections[sectionIndex].m_isMeshDirty = true;
+	}
+}
+
+void Chunk::MarkSectionMeshDirtyForLocalZ(int localZ)
+{
+	int sectionIndex = localZ >> CHUNK_SECTION_BITS_Z;
+	m_sections[sectionIndex].m_isMeshDirty = true;
 
-		m_isMeshDirty = false;
+	int zInSection = localZ & (CHUNK_SECTION_SIZE_Z - 1);
+	if (zInSection == 0 && sectionIndex > 0)
+	{
+		m_sections[sectionIndex - 1].m_isMeshDirty = true;
+	}
+	else if (zInSection == (CHUNK_SECTION_SIZE_Z - 1) && sectionIndex < (CHUNK_NUM_SECTIONS - 1))
+	{
+		m_sections[sectionIndex + 1].m_isMeshDirty = true;
 	}
 }
 
-void Chunk::GenerateBiomeFactors()
+void Chunk::MarkMeshDirtyAroundBlock(int blockIndex)
 {
-	// terrain height for each column of blocks
+	IntVec3 coords = GetlocalBlockCoordsForIndex(blockIndex);
+	MarkSectionMeshDirtyForLocalZ(coords.z);
+
+	if (coords.x == 0 && m_westNeighbor)
+	{
+		m_westNeighbor->MarkSectionMeshDirtyForLocalZ(coords.z);
+	}
+	else if (coords.x == (CHUNK_SIZE_X - 1) && m_eastNeighbor)
+	{
+		m_eastNeighbor->MarkSectionMeshDirtyForLocalZ(coords.z);
+	}
+	if (coords.y == 0 && m_southNeighbor)
+	{
+		m_southNeighbor->MarkSectionMeshDirtyForLocalZ(coords.z);
+	}
+	else if (coords.y == (CHUNK_SIZE_Y - 1) && m_northNeighbor)
+	{
+		m_northNeighbor->MarkSectionMeshDirtyForLocalZ(coords.z);
+	}
+}
 
-	// the terrain height of each block column is based on the global block coordinates of that block's column with a slight random variation
-	for (int localX = (0 - TREE_COVER_SIZE_MAX); localX < (CHUNK_SIZE_X + TREE_COVER_SIZE_MAX); ++localX)
+bool Chunk::IsMeshDirty() const
+{
+	for (int sectionIndex = 0; sectionIndex < CHUNK_NUM_SECTIONS; ++sectionIndex)
 	{
-		for (int localY = (0 - TREE_COVER_SIZE_MAX); localY < (CHUNK_SIZE_Y + TREE_COVER_SIZE_MAX); ++localY)
+		if (m_sections[sectionIndex].m_isMeshDirty || m_sections[sectionIndex].m_meshJob)
 		{
-			int globalX = localX + m_chunkCoords.x * CHUNK_SIZE_X;
-			int globalY = localY + m_chunkCoords.y * CHUNK_SIZE_Y;
+			return true;
+		}
+	}
+	return false;
+}
 
-			// create a new neighborhood coords system
-			int neighborhoodX = localX + TREE_COVER_SIZE_MAX;
-			int neighborhoodY = localY + TREE_COVER_SIZE_MAX;
-			int neighborhoodColumnIndex = neighborhoodY * NEIGHBORHOOD_SIZE_X + neighborhoodX;
-			
-			// assignment 2 setting
-			// terrainHeightZ[localY * CHUNK_SIZE_X + localX] = 64 +int(30.f * Compute2dPerlinNoise(float(globalX), float(globalY), 200.f, 5, 0.5f, 2.f, true, g_theWorld->m_seed));
-
-			// assignment 3 setting
-			// Generate Biome Factors
-			float Temperature = 0.5f + 0.5f * Compute2dPerlinNoise(float(globalX), float(globalY), 300.f, 5, 0.5f, 2.f, true, g_theWorld->m_seed); // range from 0 - 1, so we could use all easing functions
-			float Humidity = 0.5f + 0.5f * Compute2dPerlinNoise(float(globalX), float(globalY), 600, 2, 0.5f, 2.f, true, g_theWorld->m_seed);
-			float Hilliness = 0.5f + 0.5f * Compute2dPerlinNoise(float(globalX), float(globalY), 2000, 3, 0.5f, 2.f, true, g_theWorld->m_seed); // range from 0 - 1, so we could use all easing functions
-			float Oceanness = 0.5f + 0.5f * Compute2dPerlinNoise(float(globalX), float(globalY), 1000, 7, 0.5f, 2.f, true, g_theWorld->m_seed);
-			
-			// Humidity = 1.f - (1.f - Humidity) * (1.f - Oceanness); // both humidity and oceanness will contribute but result will not over 1
-			// todo: but this will cause the humidity hardly ever under 0.4f
-
-			// mountain height settings
-			int groundHeightZ = 0;
-			float terrainNoise = Compute2dPerlinNoise(float(globalX), float(globalY), 100, 5);
-			float terrainNoiseFromZeroToOne = fabsf(terrainNoise);
-			Hilliness = SmoothStep3(SmoothStep3(Hilliness));
-
-			float terrainHeightAboveRiverBed = terrainNoiseFromZeroToOne * TERRAIN_HEIGHT_ABOVE_WATER_MAX; // heightest mountain
-			float terrainHeightAboveWater = terrainHeightAboveRiverBed - RIVER_DEPTH_MAX;
-
-			float terrainHeightAboveWaterBed = terrainHeightAboveWater;
-			if (terrainHeightAboveWater > 0.f)
-			{
-				terrainHeightAboveWater *= Hilliness;
-				terrainHeightAboveWaterBed = terrainHeightAboveWater + RIVER_DEPTH_MAX;
-			}
-			groundHeightZ = (int)((float)RIVER_BED_HEIGHT_Z + terrainHeightAboveWaterBed);
-
-			// ocean
-			// Map Oceanness into [0,1] and run a SmoothStep3() easing function on it (perhaps even twice!) 
-			// to get more distinctively ocean and non-ocean (land) biome areas
-			Oceanness = SmoothStep3(SmoothStep3(Oceanness));
-			// Oceanness < 0.50 = normal terrain
-			if (Oceanness >= 0.5f && Oceanness <= 0.75f)
-			{
-				Oceanness = RangeMap(Oceanness, 0.5f, 0.75f, 0.f, 1.f);
-				int OceanLowing = (int)((float)OCEAN_LOWING_MAX * Oceanness);
-				groundHeightZ -= OceanLowing;
-			}
-			else if (Oceanness > 0.75f)
-			{
-				int OceanLowing = OCEAN_LOWING_MAX;
-				groundHeightZ -= OceanLowing;
-			}
+// every face of a full section touches another full section, nothing is above the top or below the bottom of the world
+// a missing neighbor chunk counts as full, the mesher leaves the faces towards it out as well
+bool Chunk::IsSectionBuried(int sectionIndex) const
+{
+	if (!IsSectionFull(sectionIndex))
+	{
+		return false;
+	}
+	if (sectionIndex > 0 && !IsSectionFull(sectionIndex - 1))
+	{
+		return false;
+	}
+	if (sectionIndex < (CHUNK_NUM_SECTIONS - 1) && !IsSectionFull(sectionIndex + 1))
+	{
+		return false;
+	}
 
-			// store the biome info
-			m_terrainHeightZ[neighborhoodColumnIndex] = groundHeightZ;
-			m_temperature[neighborhoodColumnIndex] = Temperature;
-			m_humidity[neighborhoodColumnIndex] = Humidity;
+	Chunk const* neighbors[4] = { m_eastNeighbor, m_westNeighbor, m_northNeighbor, m_southNeighbor };
+	for (int neighborIndex = 0; neighborIndex < 4; ++neighborIndex)
+	{
+		if (neighbors[neighborIndex] && !neighbors[neighborIndex]->IsSectionFull(sectionIndex))
+		{
+			return false;
 		}
 	}
+	return true;
 }
 
-
-void Chunk::SpawnTreeBlockTemplatesAccordingToBiomeFactors()
+// block indices of a section are contiguous, so every section is one straight run over the blocks
+void Chunk::RecountSectionBlocks()
 {
-	// after all blocks are defined
-	// rewrite with tree blocks
-	// tree density
-
-	for (int localX = (0 - TREE_COVER_SIZE_MAX); localX < (CHUNK_SIZE_X + TREE_COVER_SIZE_MAX); ++localX)
+	for (int sectionIndex = 0; sectionIndex < CHUNK_NUM_SECTIONS; ++sectionIndex)
 	{
-		for (int localY = (0 - TREE_COVER_SIZE_MAX); localY < (CHUNK_SIZE_Y + TREE_COVER_SIZE_MAX); ++localY)
+		Block const* sectionBlocks = m_blocks + sectionIndex * CHUNK_BLOCKS_PER_SECTION;
+		int numVisibleBlocks = 0;
+		for (int i = 0; i < CHUNK_BLOCKS_PER_SECTION; ++i)
 		{
-			int globalX = localX + m_chunkCoords.x * CHUNK_SIZE_X;
-			int globalY = localY + m_chunkCoords.y * CHUNK_SIZE_Y;
+			numVisibleBlocks += (sectionBlocks[i].m_blockBitFlags & BLOCK_BIT_MASK_IS_VISIBLE) ? 1 : 0;
+		}
+		m_sections[sectionIndex].m_numVisibleBlocks = numVisibleBlocks;
+	}
+	RebuildColumnHeights();
+}
 
-			IntVec2 localCoords = IntVec2(localX, localY);
-			IntVec2 treeCoords = GetBiomeCoordsByLocalCoords(IntVec2(localX, localY));
-			int treeColumnIndex = GetBiomeIndexByTreeCoords(treeCoords);
+int Chunk::GetOpenSkyBottomZ() const
+{
+	for (int sectionIndex = CHUNK_NUM_SECTIONS - 1; sectionIndex >= 0; --sectionIndex)
+	{
+		if (!IsSectionEmpty(sectionIndex))
+		{
+			return (sectionIndex + 1) * CHUNK_SECTION_SIZE_Z;
+		}
+	}
+	return 0;
+}
 
-			float Forestness = 0.5f + 0.5f * Compute2dPerlinNoise(float(globalX), float(globalY), 90.f, 3, 0.5f, 2.f, true, g_theWorld->m_seed); // rename of "tree density"
-			Forestness = SmoothStep3(SmoothStep3(Forestness));
-			float treeNoiseMinimumThreshold = RangeMapClamped(Forestness, 0.6f, 1.f, 0.99f, 0.75f);
-			float TreeNoise = Get2dNoiseZeroToOne(globalX, globalY, g_theWorld->m_seed);
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+static_assert(CHUNK_SIZE_Z <= 128, "column heights are kept in int8_t");
 
-			// this randomize decides whether the tree should be planted
-			if (TreeNoise > treeNoiseMinimumThreshold)
+// the sections above the open sky bottom are all air, so every column starts its scan below them
+void Chunk::RebuildColumnHeights()
+{
+	int openSkyBottomZ = GetOpenSkyBottomZ();
+	for (int columnIndex = 0; columnIndex < CHUNK_BLOCKS_PER_LAYER; ++columnIndex)
+	{
+		int highestOpaqueZ = -1;
+		int highestSolidZ = -1;
+		for (int z = openSkyBottomZ - 1; z >= 0 && (highestOpaqueZ < 0 || highestSolidZ < 0); --z)
+		{
+			uint8_t flags = m_blocks[columnIndex | (z << CHUNK_BITSHIFT_Z)].m_blockBitFlags;
+			if (highestOpaqueZ < 0 && (flags & BLOCK_BIT_MASK_IS_FULL_OPAQUE))
 			{
-				// calculate all neighbors tree including this point noise 3x3 to see if this one is the highest one is this one
-				float max = 0.f;
-				for (int posX = (globalX - (TREE_COVER_SIZE_MAX)); posX < (globalX + 2); ++posX)
-				{
-					for (int posY = (globalY - (TREE_COVER_SIZE_MAX)); posY < (globalY + 2); ++posY)
-					{
-						float neighborNoise = Get2dNoiseZeroToOne(posX, posY, g_theWorld->m_seed);
-						if (neighborNoise > max)
-						{
-							max = neighborNoise;
-						}
-					}
-				}
-
-				if (TreeNoise == max)
-				{
-					// check if the the tree planting origin terrain height is above water
-					if (m_terrainHeightZ[treeColumnIndex] > WATER_LEVEL_Z)
-					{
-						// discuss what kind of tree need to plant here
-						if (m_humidity[treeColumnIndex] < 0.4f)
-						{
-							SpawnTreeBlockTemplatesAtColumCoords(BlockTemplate::GetBlockTemplateByName("cactus"), localCoords);
-						}
-						else if (m_temperature[treeColumnIndex] < 0.4f)
-						{
-							SpawnTreeBlockTemplatesAtColumCoords(BlockTemplate::GetBlockTemplateByName("spruce"), localCoords);
-						}
-						else
-						{
-							// calculate the chance to spawn spruce and oak then decide which tree to spawn
-							float spruceChance = RangeMap(m_temperature[treeColumnIndex], 0.4f, 0.7f, 1.f, 0.f);
-							if (TreeNoise < spruceChance)
-							{
-								SpawnTreeBlockTemplatesAtColumCoords(BlockTemplate::GetBlockTemplateByName("spruce"), localCoords);
-							}
-							else
-							{
-								SpawnTreeBlockTemplatesAtColumCoords(BlockTemplate::GetBlockTemplateByName("oak"), localCoords);
-							}
-						}
-					}
-				}
+				highestOpaqueZ = z;
+			}
+			if (highestSolidZ < 0 && (flags & BLOCK_BIT_MASK_IS_SOLID))
+			{
+				highestSolidZ = z;
 			}
-
 		}
+		m_highestOpaqueZ[columnIndex] = (int8_t)highestOpaqueZ;
+		m_highestSolidZ[columnIndex] = (int8_t)highestSolidZ;
 	}
-
 }
 
-void Chunk::SpawnTreeBlockTemplatesAtColumCoords(BlockTemplate treeTemplate, IntVec2 localCoords)
-{
-	// base on the local column coords, find which chunk to plant the tree - origin
-	// get the local coords of the chunk and get the height of the column
-	IntVec2 treeCoords = GetBiomeCoordsByLocalCoords(localCoords);
-	int m_treeColumnIndex = GetBiomeIndexByTreeCoords(treeCoords);
-	int groundHeightZ = m_terrainHeightZ[m_treeColumnIndex];
-	bool canPlantTreeHere = true;
-
-	// if there local coords is outside the current, check the nearby 
-	
-	// for (int localZ = CHUNK_SIZE_Z; localZ >= groundHeightZ; --localZ)
-	// {
-	// 	int blockIndex = chunkPtr->GetIndexForLocalCoordinates(IntVec3(localCoords.x, localCoords.y, localZ));
-	// 	if (localZ == groundHeightZ)
-	// 	{
-	// 		if (chunkPtr->m_blocks[blockIndex].IsSolid())
-	// 		{
-	// 			canPlantTreeHere = true;
-	// 		}
-	// 	}
-	// 	else
-	// 	{
-	// 		// if there is anything visible on the grass ground, do not spawn a tree
-	// 		if (!chunkPtr->m_blocks[blockIndex].IsVisible())
-	// 		{
-	// 			break;
-	// 		}
-	// 	}
-	// }
-
-	if (canPlantTreeHere)
-	{
-		IntVec3 treeLocalOrigin = IntVec3(localCoords.x, localCoords.y, groundHeightZ);
-
-		// get all the tree block info and set the block type of the chunk
-		for (int blockIndex = 0; blockIndex < (int)treeTemplate.m_entries.size(); ++blockIndex)
+// a block set above the highest raises it, the highest one taken away lowers it to the next one down, anything else leaves it
+static int8_t GetColumnHeightAfterChange(Block const* blocks, int columnIndex, int changedZ, int8_t highestZ, uint8_t flagMask)
+{
+	if (blocks[columnIndex | (changedZ << CHUNK_BITSHIFT_Z)].m_blockBitFlags & flagMask)
+	{
+		return (changedZ > highestZ) ? (int8_t)changedZ : highestZ;
+	}
+	if (changedZ != highestZ)
+	{
+		return highestZ;
+	}
+	for (int z = changedZ - 1; z >= 0; --z)
+	{
+		if (blocks[columnIndex | (z << CHUNK_BITSHIFT_Z)].m_blockBitFlags & flagMask)
 		{
-			BlockTemplateEntry& entry = treeTemplate.m_entries[blockIndex];
-			IntVec3 entryLocalCoords = treeLocalOrigin + entry.offset;
-			// if (Get2dNoiseZeroToOne(globalX, globalY, g_theWorld->m_seed) < entry.chanceToSpawn) // will cause light influence issue, some block is black
-			// {
-				// if this tree's block is in this chunk's space, rewrite the type
-				if (AreTheLocalCoordsInChunk(entryLocalCoords))
-				{
-					int treeblockIndex = GetIndexForLocalCoordinates(entryLocalCoords);
-					m_blocks[treeblockIndex].SetType(entry.blockDef);
-				}
-			// }
+			return (int8_t)z;
 		}
 	}
+	return -1;
+}
+
+void Chunk::UpdateColumnHeightsForBlock(int blockIndex)
+{
+	int columnIndex = blockIndex & CHUNK_MASK_COLUMN;
+	int z = blockIndex >> CHUNK_BITSHIFT_Z;
+	m_highestOpaqueZ[columnIndex] = GetColumnHeightAfterChange(m_blocks, columnIndex, z, m_highestOpaqueZ[columnIndex], BLOCK_BIT_MASK_IS_FULL_OPAQUE);
+	m_highestSolidZ[columnIndex] = GetColumnHeightAfterChange(m_blocks, columnIndex, z, m_highestSolidZ[columnIndex], BLOCK_BIT_MASK_IS_SOLID);
+}
+
+// the biome factors of the chunk and the padded neighborhood around it come from the feature regions, see ChunkFeatures
+void Chunk::GenerateBiomeFactors()
+{
+	CopyBiomeFactorsFromRegions(this, g_theWorld->m_featureCache);
+}
+
+// after all blocks are defined, carve the caves and plant the trees of the regions around the chunk
+void Chunk::StampFeatures()
+{
+	StampFeaturesIntoChunk(this, g_theWorld->m_featureCache);
 }
 
 
@@ -370,18 +425,47 @@ bool Chunk::AreTheLocalCoordsInChunk(IntVec3 localdCoords)
 	return false;
 }
 
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// the random rolls of generation are noise hashed from the world seed and the block's world coords instead of g_rng,
+// so a chunk comes out the same on any worker, in any order, with any number of workers
+// every roll has its own seed so the rolls of one block do not follow each other
+enum GenerationRoll
+{
+	GENERATION_ROLL_DIRT_DEPTH,
+	GENERATION_ROLL_COAL,
+	GENERATION_ROLL_IRON,
+	GENERATION_ROLL_GOLD,
+	GENERATION_ROLL_DIAMOND,
+	GENERATION_ROLL_DIRT_OR_GRASS_BRICK,
+	NUM_GENERATION_ROLLS
+};
+
+static inline float RollGenerationNoise(unsigned int const rollSeeds[NUM_GENERATION_ROLLS], GenerationRoll roll, int globalX, int globalY, int globalZ)
+{
+	return Get3dNoiseZeroToOne(globalX, globalY, globalZ, rollSeeds[roll]);
+}
+
 void Chunk::CreateInitialBlocks()
 {
+	unsigned int rollSeeds[NUM_GENERATION_ROLLS];
+	for (int roll = 0; roll < NUM_GENERATION_ROLLS; ++roll)
+	{
+		rollSeeds[roll] = Get1dNoiseUint(roll, (unsigned int)g_theWorld->m_seed);
+	}
+
 	// for each column, based on the height, it is given of different blockDefs
 	for (int localX = 0; localX < CHUNK_SIZE_X; ++localX)
 	{
 		for (int localY = 0; localY < CHUNK_SIZE_Y; ++localY)
 		{
+			int globalX = localX + m_chunkCoords.x * CHUNK_SIZE_X;
+			int globalY = localY + m_chunkCoords.y * CHUNK_SIZE_Y;
+
 			// The block at terrainHeightZ in each column is grass
 			// All blocks above this in any column are set to air
 			// random(3~4) blocks below this are set to dirt
 			// we first get the dirt number for each column
-			int numDirt = g_rng->RollRandomIntInRange(3, 4);
+			int numDirt = (RollGenerationNoise(rollSeeds, GENERATION_ROLL_DIRT_DEPTH, globalX, globalY, 0) < 0.5f) ? 3 : 4;
 			IntVec2 treeCoords = GetBiomeCoordsByLocalCoords(IntVec2(localX, localY));
 			int biomeIndex = GetBiomeIndexByTreeCoords(treeCoords);
 			int terrainHeight = m_terrainHeightZ[biomeIndex];
@@ -395,25 +479,25 @@ void Chunk::CreateInitialBlocks()
 				// if not, 0.1% chance to become diamond.
 				if (localZ < (terrainHeight - numDirt))
 				{
-					if (g_rng->RollRandomFloatZeroToOne() < 0.05f)
+					if (RollGenerationNoise(rollSeeds, GENERATION_ROLL_COAL, globalX, globalY, localZ) < 0.05f)
 					{
-						SetBlockTypeForLocalBlock("coal", IntVec3(localX, localY, localZ));
+						SetBlockTypeForLocalBlock(BLOCK_TYPE_COAL, IntVec3(localX, localY, localZ));
 					}
-					else if (g_rng->RollRandomFloatZeroToOne() < 0.02f)
+					else if (RollGenerationNoise(rollSeeds, GENERATION_ROLL_IRON, globalX, globalY, localZ) < 0.02f)
 					{
-						SetBlockTypeForLocalBlock("iron", IntVec3(localX, localY, localZ));
+						SetBlockTypeForLocalBlock(BLOCK_TYPE_IRON, IntVec3(localX, localY, localZ));
 					}
-					else if (g_rng->RollRandomFloatZeroToOne() < 0.005f)
+					else if (RollGenerationNoise(rollSeeds, GENERATION_ROLL_GOLD, globalX, globalY, localZ) < 0.005f)
 					{
-						SetBlockTypeForLocalBlock("gold", IntVec3(localX, localY, localZ));
+						SetBlockTypeForLocalBlock(BLOCK_TYPE_GOLD, IntVec3(localX, localY, localZ));
 					}
-					else if (g_rng->RollRandomFloatZeroToOne() < 0.001f)
+					else if (RollGenerationNoise(rollSeeds, GENERATION_ROLL_DIAMOND, globalX, globalY, localZ) < 0.001f)
 					{
-						SetBlockTypeForLocalBlock("diamond", IntVec3(localX, localY, localZ));
+						SetBlockTypeForLocalBlock(BLOCK_TYPE_DIAMOND, IntVec3(localX, localY, localZ));
 					}
 					else
 					{
-						SetBlockTypeForLocalBlock("stone", IntVec3(localX, localY, localZ));
+						SetBlockTypeForLocalBlock(BLOCK_TYPE_STONE, IntVec3(localX, localY, localZ));
 					}
 				}
 				else if (localZ >= (terrainHeight - numDirt) && localZ < terrainHeight)
@@ -421,15 +505,15 @@ void Chunk::CreateInitialBlocks()
 					// Grass and Dirt blocks on or near the surface are instead replaced with sand blocks
 					if (m_humidity[biomeIndex] < 0.4f)
 					{
-						SetBlockTypeForLocalBlock("sand", IntVec3(localX, localY, localZ));
+						SetBlockTypeForLocalBlock(BLOCK_TYPE_SAND, IntVec3(localX, localY, localZ));
 					}
-					else if (g_rng->RollRandomFloatZeroToOne() < 0.5f)
+					else if (RollGenerationNoise(rollSeeds, GENERATION_ROLL_DIRT_OR_GRASS_BRICK, globalX, globalY, localZ) < 0.5f)
 					{
-						SetBlockTypeForLocalBlock("dirt", IntVec3(localX, localY, localZ));
+						SetBlockTypeForLocalBlock(BLOCK_TYPE_DIRT, IntVec3(localX, localY, localZ));
 					}
 					else
 					{
-						SetBlockTypeForLocalBlock("grassBrick", IntVec3(localX, localY, localZ));
+						SetBlockTypeForLocalBlock(BLOCK_TYPE_GRASS_BRICK, IntVec3(localX, localY, localZ));
 					}
 				}
 				else if (localZ == terrainHeight)
@@ -439,15 +523,15 @@ void Chunk::CreateInitialBlocks()
 					// Areas of moderate humidity should have beaches; wet areas (high humidity) should not.
 					if (m_humidity[biomeIndex] < 0.6f && terrainHeight == WATER_LEVEL_Z)
 					{
-						SetBlockTypeForLocalBlock("sand", IntVec3(localX, localY, localZ));
+						SetBlockTypeForLocalBlock(BLOCK_TYPE_SAND, IntVec3(localX, localY, localZ));
 					}
 					else if (m_humidity[biomeIndex] < 0.4f)
 					{
-						SetBlockTypeForLocalBlock("sand", IntVec3(localX, localY, localZ));
+						SetBlockTypeForLocalBlock(BLOCK_TYPE_SAND, IntVec3(localX, localY, localZ));
 					}
 					else
 					{
-						SetBlockTypeForLocalBlock("grass", IntVec3(localX, localY, localZ));
+						SetBlockTypeForLocalBlock(BLOCK_TYPE_GRASS, IntVec3(localX, localY, localZ));
 					}
 				}
 				else if (localZ > terrainHeight)
@@ -457,16 +541,16 @@ void Chunk::CreateInitialBlocks()
 					{
 						if (m_temperature[biomeIndex] < 0.4f)
 						{
-							SetBlockTypeForLocalBlock("ice", IntVec3(localX, localY, localZ));
+							SetBlockTypeForLocalBlock(BLOCK_TYPE_ICE, IntVec3(localX, localY, localZ));
 						}
 						else
 						{
-							SetBlockTypeForLocalBlock("water", IntVec3(localX, localY, localZ));
+							SetBlockTypeForLocalBlock(BLOCK_TYPE_WATER, IntVec3(localX, localY, localZ));
 						}
 					}
 					else
 					{
-						SetBlockTypeForLocalBlock("air", IntVec3(localX, localY, localZ));
+						SetBlockTypeForLocalBlock(BLOCK_TYPE_AIR, IntVec3(localX, localY, localZ));
 					}
 				}				
 			}
@@ -474,10 +558,11 @@ void Chunk::CreateInitialBlocks()
 	}
 }
 
-void Chunk::SetBlockTypeForLocalBlock(std::string blcokTypeName, IntVec3 const& localCoords)
+void Chunk::SetBlockTypeForLocalBlock(BlockType blockType, IntVec3 const& localCoords)
 {
+	ExpandBlocks();
 	int index = GetIndexForLocalCoordinates(localCoords);
-	m_blocks[index].SetType(blcokTypeName);
+	m_blocks[index].SetType(blockType);
 }
 
 int Chunk::GetIndexForLocalCoordinates(IntVec3 const& localCoords)
@@ -537,15 +622,13 @@ AABB3 Chunk::GetBlockBoundsInWorldSpace(int blockIndex)
 
 int Chunk::GetFirstSolidBlockUnderInputCoords(IntVec3 const& standingLocalCoords)
 {
-	for (int z = (CHUNK_SIZE_Z - 1); z >= 0; --z)
+	int columnIndex = GetIndexForLocalCoordinates(IntVec3(standingLocalCoords.x, standingLocalCoords.y, 0));
+	int highestSolidZ = GetHighestSolidZ(columnIndex);
+	if (highestSolidZ < 0)
 	{
-		int index = GetIndexForLocalCoordinates(IntVec3(standingLocalCoords.x, standingLocalCoords.y, z));
-		if (m_blocks[index].GetBlockDef().m_isSolid)
-		{
-			return index;
-		}
+		return 0;
 	}
-	return 0;
+	return columnIndex | (highestSolidZ << CHUNK_BITSHIFT_Z);
 }
 
 bool Chunk::IfTheBlockIsAtTheBottomOfTheChunk(IntVec3 const& blockCoords)
@@ -555,6 +638,7 @@ bool Chunk::IfTheBlockIsAtTheBottomOfTheChunk(IntVec3 const& blockCoords)
 
 bool Chunk::IfTheBlockIsAirOrWaterOrOutOfChunk(IntVec3 const& blockCoords)
 {
+	ExpandBlocks();
 	int index = GetIndexForLocalCoordinates(blockCoords);
 	if (CheckIfTheBlockCoordsIsInsideChunkBound(blockCoords))
 	{
@@ -562,7 +646,7 @@ bool Chunk::IfTheBlockIsAirOrWaterOrOutOfChunk(IntVec3 const& blockCoords)
 	}
 	else
 	{
-		if (m_blocks[index].GetBlockDef() == BlockDef::GetBlockDefByName("air") || m_blocks[index].GetBlockDef() == BlockDef::GetBlockDefByName("water"))
+		if (m_blocks[index].GetType() == BLOCK_TYPE_AIR || m_blocks[index].GetType() == BLOCK_TYPE_WATER)
 		{
 			return true;
 		}
@@ -575,6 +659,7 @@ bool Chunk::IfTheBlockIsAirOrWaterOrOutOfChunk(IntVec3 const& blockCoords)
 
 bool Chunk::IfTheBlockIsAirOrOutOfChunk(IntVec3 const& blockCoords)
 {
+	ExpandBlocks();
 	int index = GetIndexForLocalCoordinates(blockCoords);
 	if (!CheckIfTheBlockCoordsIsInsideChunkBound(blockCoords))
 	{
@@ -582,7 +667,7 @@ bool Chunk::IfTheBlockIsAirOrOutOfChunk(IntVec3 const& blockCoords)
 	}
 	else
 	{
-		if (m_blocks[index].GetBlockDef() == BlockDef::GetBlockDefByName("air"))
+		if (m_blocks[index].GetType() == BLOCK_TYPE_AIR)
 		{
 			return true;
 		}
@@ -605,32 +690,48 @@ bool Chunk::CheckIfTheBlockCoordsIsInsideChunkBound(IntVec3 const& blockCoords)
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------
+// only the touched section is remeshed, and the section or neighbor chunk next to the block when it is on an edge
 bool Chunk::DigBlock(int blockIndex)
 {
-	m_blocks[blockIndex].SetType("air");
-	m_isMeshDirty = true;
+	ExpandBlocks();
+	if (m_blocks[blockIndex].IsVisible())
+	{
+		--m_sections[blockIndex / CHUNK_BLOCKS_PER_SECTION].m_numVisibleBlocks;
+	}
+	m_blocks[blockIndex].SetType(BLOCK_TYPE_AIR);
+	UpdateColumnHeightsForBlock(blockIndex);
+	MarkMeshDirtyAroundBlock(blockIndex);
 	m_needsSaving = true;
 	return true;
 }
 
 void Chunk::SetBlock(int blockIndex, BlockDef const& def)
 {
+	ExpandBlocks();
+	int& numVisibleBlocks = m_sections[blockIndex / CHUNK_BLOCKS_PER_SECTION].m_numVisibleBlocks;
+	numVisibleBlocks -= m_blocks[blockIndex].IsVisible() ? 1 : 0;
 	m_blocks[blockIndex].SetType(def);
-	m_isMeshDirty = true;
+	numVisibleBlocks += m_blocks[blockIndex].IsVisible() ? 1 : 0;
+	UpdateColumnHeightsForBlock(blockIndex);
+	MarkMeshDirtyAroundBlock(blockIndex);
 	m_needsSaving = true;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------
-void Chunk::Render() const
+void Chunk::Render(bool isVoxelMesh) const
 {
-	RenderBlocks();
+	RenderBlocks(isVoxelMesh);
 }
 
-void Chunk::RenderBlocks() const
+void Chunk::RenderBlocks(bool isVoxelMesh) const
 {
-	if (m_vertexBuffer)
+	for (int sectionIndex = 0; sectionIndex < CHUNK_NUM_SECTIONS; ++sectionIndex)
 	{
-		g_theRenderer->DrawVertexBuffer(m_vertexBuffer, (int)(m_vertexBuffer->m_size));
+		ChunkSection const& section = m_sections[sectionIndex];
+		if (section.m_vertexBuffer && section.m_isVoxelMesh == isVoxelMesh)
+		{
+			g_theRenderer->DrawVertexBuffer(section.m_vertexBuffer, (int)(section.m_vertexBuffer->m_size));
+		}
 	}
 }
 
@@ -644,17 +745,44 @@ Mat44 Chunk::GetModelMatrix() const
 	return transformMat;
 }
 
+// empty sections are skipped, their air blocks are never looked at
 void Chunk::AddVertsForAllBlocksInChunk()
 {
 	m_blockVerts.clear();
-	m_blockVerts.reserve(CHUNK_BLOCKS_TOTAL * 36);
+	for (int sectionIndex = 0; sectionIndex < CHUNK_NUM_SECTIONS; ++sectionIndex)
+	{
+		if (!IsSectionEmpty(sectionIndex))
+		{
+			AddVertsForSection(sectionIndex);
+		}
+	}
+}
 
-	for (int i = 0; i < CHUNK_BLOCKS_TOTAL; ++i)
+void Chunk::AddVertsForSection(int sectionIndex)
+{
+	int firstBlockIndex = sectionIndex * CHUNK_BLOCKS_PER_SECTION;
+	for (int i = firstBlockIndex; i < firstBlockIndex + CHUNK_BLOCKS_PER_SECTION; ++i)
 	{
 		AddVertsForBlock(i);
 	}
 }
 
+// the old mesh keeps being drawn until the new one is uploaded
+void Chunk::QueueMeshJob(int sectionIndex)
+{
+	ChunkMeshJob* job = new ChunkMeshJob(this, sectionIndex);
+	job->m_snapshot.resize(MESH_SNAPSHOT_BLOCKS_TOTAL);
+	CopySectionBlocksForMeshing(this, sectionIndex, job->m_snapshot.data());
+	m_sections[sectionIndex].m_meshJob = job;
+	g_theWorld->QueueChunkMeshJob(job);
+}
+
+void Chunk::UploadMeshFromJob(ChunkMeshJob* job)
+{
+	m_voxelVerts.swap(job->m_verts);
+	UploadSectionMesh(job->m_sectionIndex, true);
+}
+
 void Chunk::DrawDebugRender() const
 {
 	std::vector<Vertex_PCU> debugVerts;
@@ -945,170 +1073,264 @@ void Chunk::AddVertsForBlock(int localBlockIndex)
 	//// AddVertsForQuad3D(m_blockVerts, FBL, FBR, BBR, BBL, white, floorUVs);
 }
 
-void Chunk::CreateVertexBuffer()
+void Chunk::UploadSectionMesh(int sectionIndex, bool isVoxelMesh)
 {
-	if (m_vertexBuffer)
+	ReleaseSectionMesh(sectionIndex);
+	ChunkSection& section = m_sections[sectionIndex];
+	section.m_isVoxelMesh = isVoxelMesh;
+
+	size_t vertexSize = isVoxelMesh ? sizeof(Vertex_Voxel) : sizeof(Vertex_PCU);
+	size_t numVerts = isVoxelMesh ? m_voxelVerts.size() : m_blockVerts.size();
+	void const* vertsData = isVoxelMesh ? (void const*)m_voxelVerts.data() : (void const*)m_blockVerts.data();
+	if (numVerts > 0)
 	{
-		delete m_vertexBuffer;
+		section.m_vertexBuffer = g_theRenderer->CreateVertexBuffer(numVerts, vertexSize);
+		g_theRenderer->CopyCPUToGPU(vertsData, numVerts * vertexSize, section.m_vertexBuffer);
 	}
-	size_t vertexSize = sizeof(Vertex_PCU);
-	m_vertexBuffer = g_theRenderer->CreateVertexBuffer((size_t)(m_blockVerts.size()), vertexSize);
-}
-
-void Chunk::CopyVertexBufferFromCPUtoGPU()
-{
-	size_t vertexSize = sizeof(Vertex_PCU);
-	size_t vertexArrayDataSize = (m_blockVerts.size()) * vertexSize;
-	g_theRenderer->CopyCPUToGPU(m_blockVerts.data(), vertexArrayDataSize, m_vertexBuffer);
 
 	// swap the verts data into a temporary vector array
+	std::vector<Vertex_Voxel> tempVoxelVerts;
+	tempVoxelVerts.swap(m_voxelVerts);
 	std::vector<Vertex_PCU> tempVerts;
 	tempVerts.swap(m_blockVerts);
 }
 
-//----------------------------------------------------------------------------------------------------------------------------------------------------
-void Chunk::SaveBlocksDataToFile()
+void Chunk::ReleaseSectionMesh(int sectionIndex)
 {
-	std::vector<uint8_t> inBuffer;
-	// Chunk files always start with the four character code (4CC) GCHK  for Guildhall Chunk
-	inBuffer.push_back('G');
-	inBuffer.push_back('C');
-	inBuffer.push_back('H');
-	inBuffer.push_back('K');
+	delete m_sections[sectionIndex].m_vertexBuffer;
+	m_sections[sectionIndex].m_vertexBuffer = nullptr;
+}
 
-	inBuffer.push_back(2); // version 2 of the .chunk file format
-	inBuffer.push_back(4); // CHUNK_BITS_X
-	inBuffer.push_back(4); // CHUNK_BITS_Y
-	inBuffer.push_back(7); // CHUNK_BITS_Z
+unsigned int Chunk::GetNumVerts() const
+{
+	unsigned int numVerts = 0;
+	for (int sectionIndex = 0; sectionIndex < CHUNK_NUM_SECTIONS; ++sectionIndex)
+	{
+		if (m_sections[sectionIndex].m_vertexBuffer)
+		{
+			numVerts += (unsigned int)m_sections[sectionIndex].m_vertexBuffer->m_size;
+		}
+	}
+	return numVerts;
+}
 
-	//
-	uint8_t defIndex = 0;
-	uint8_t numBlocksOfSameKind = 0;
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// version 3 of the chunk format, after the same 8 bytes of header as version 2:
+// a flags byte, the run stream size as a varint, a checksum of the run stream, then the run stream, LZ compressed if the flag says so
+// the run stream is (defIndex, runLength as varint) pairs in block index order, a whole layer of stone is one run instead of 256/255 of them
+void Chunk::EncodeBlocksData(std::vector<uint8_t>& inBuffer, bool useCompression) const
+{
+	// a compacted chunk is saved from a temporary flat copy, the chunk itself stays compacted
+	Block const* blocks = m_blocks;
+	std::vector<Block> expandedBlocks;
+	if (IsCompacted())
+	{
+		expandedBlocks.resize(CHUNK_BLOCKS_TOTAL);
+		m_palettedBlocks->DecompressBlocks(expandedBlocks.data());
+		blocks = expandedBlocks.data();
+	}
 
-	for (int i = 0; i < CHUNK_BLOCKS_TOTAL; ++i)
+	// single pass, a run is written out when the next block is different
+	std::vector<uint8_t> runStream;
+	runStream.reserve(2048);
+	uint8_t runDefIndex = blocks[0].m_blockDefIndex;
+	uint32_t runLength = 1;
+	for (int i = 1; i < CHUNK_BLOCKS_TOTAL; ++i)
 	{
-		defIndex = m_blocks[i].m_blockDefIndex;
-		numBlocksOfSameKind = 1;
-		for (int j = (i + 1); j < CHUNK_BLOCKS_TOTAL; ++j)
+		uint8_t defIndex = blocks[i].m_blockDefIndex;
+		if (defIndex == runDefIndex)
 		{
-			if (defIndex == m_blocks[j].m_blockDefIndex && numBlocksOfSameKind < 255)
-			{
-				++numBlocksOfSameKind;
-				++i;
-			}
-			else
-			{
-				break;
-			}
+			++runLength;
+			continue;
 		}
-		inBuffer.push_back(defIndex);
-		inBuffer.push_back(numBlocksOfSameKind);
+		runStream.push_back(runDefIndex);
+		AppendVarUInt(runStream, runLength);
+		runDefIndex = defIndex;
+		runLength = 1;
 	}
+	runStream.push_back(runDefIndex);
+	AppendVarUInt(runStream, runLength);
+
+	// the LZ stage only stays if it actually makes the chunk smaller
+	std::vector<uint8_t> compressedRunStream;
+	bool isCompressed = false;
+	if (useCompression)
+	{
+		CompressLZ(runStream.data(), (int)runStream.size(), compressedRunStream);
+		isCompressed = compressedRunStream.size() < runStream.size();
+	}
+	std::vector<uint8_t> const& payload = isCompressed ? compressedRunStream : runStream;
+
+	inBuffer.clear();
+	inBuffer.reserve(16 + payload.size());
+	// Chunk files always start with the four character code (4CC) GCHK  for Guildhall Chunk
+	inBuffer.push_back('G');
+	inBuffer.push_back('C');
+	inBuffer.push_back('H');
+	inBuffer.push_back('K');
 
-	// set up save file name
-	unsigned char worldSeed = (unsigned char)g_theWorld->m_seed;
-	std::string saveFolderPathName = Stringf("Saves/World_%u", worldSeed);
-	std::string fileName = Stringf("%s/Chunk(%i, %i).chunk", saveFolderPathName.c_str(), m_chunkCoords.x, m_chunkCoords.y);
+	inBuffer.push_back(CHUNK_SAVE_VERSION);
+	inBuffer.push_back(CHUNK_BITS_X);
+	inBuffer.push_back(CHUNK_BITS_Y);
+	inBuffer.push_back(CHUNK_BITS_Z);
+
+	inBuffer.push_back(isCompressed ? CHUNK_SAVE_FLAG_LZ : 0);
+	AppendVarUInt(inBuffer, (uint32_t)runStream.size());
+	uint32_t checksum = ComputeChecksum32(runStream.data(), (int)runStream.size());
+	inBuffer.push_back((uint8_t)(checksum));
+	inBuffer.push_back((uint8_t)(checksum >> 8));
+	inBuffer.push_back((uint8_t)(checksum >> 16));
+	inBuffer.push_back((uint8_t)(checksum >> 24));
+	inBuffer.insert(inBuffer.end(), payload.begin(), payload.end());
+}
 
-	if (!FileWriteFromBuffer(inBuffer, fileName))
+void Chunk::SaveBlocksDataToFile()
+{
+	std::vector<uint8_t> inBuffer;
+	EncodeBlocksData(inBuffer);
+	if (!g_theWorld->m_chunkRegionFiles->SaveChunk(m_chunkCoords, inBuffer))
 	{
 		ERROR_AND_DIE("Have problem saving the chunk data");
 	}
 	m_needsSaving = false;
 }
 
+// only looks at the region's offset table, which is in memory after the first chunk of the region
 bool Chunk::CheckIfThereIsSaveFile()
 {
-	unsigned char worldSeed = (unsigned char)g_theWorld->m_seed;
-	std::string saveFolderPathName = Stringf("Saves/World_%u", worldSeed);
+	return g_theWorld->m_chunkRegionFiles->HasChunk(m_chunkCoords);
+}
 
-	std::string fileName = Stringf("%s/Chunk(%i, %i).chunk", saveFolderPathName.c_str(), m_chunkCoords.x, m_chunkCoords.y);
-	bool hasSaveFile = IfThisFileCouldBeRead(fileName);
-	if (!hasSaveFile)
+bool Chunk::LoadBlocksDataFromFile()
+{
+	std::vector<uint8_t> outBuffer;
+	if (!g_theWorld->m_chunkRegionFiles->LoadChunk(m_chunkCoords, outBuffer))
 	{
 		return false;
 	}
-	else
-	{
-		if (CheckIfSaveFileMatchWorldSeedNumber(fileName))
-		{
-			return true;
-		}
-		else
-		{
-			return false;
-		}
-	}
+	return DecodeBlocksData(outBuffer);
 }
 
-bool Chunk::CheckIfSaveFileMatchWorldSeedNumber(std::string fileName)
+// a save that does not check out returns false without touching the blocks, the chunk then gets generated again
+bool Chunk::DecodeBlocksData(std::vector<uint8_t> const& outBuffer)
 {
-	std::vector<uint8_t> tempBuffer;
-	FileReadToBuffer(tempBuffer, fileName);
+	int bufferSize = (int)outBuffer.size();
+	if (bufferSize < 8 ||
+		outBuffer[0] != 'G' ||
+		outBuffer[1] != 'C' ||
+		outBuffer[2] != 'H' ||
+		outBuffer[3] != 'K' ||
+
+		outBuffer[5] != CHUNK_BITS_X ||
+		outBuffer[6] != CHUNK_BITS_Y ||
+		outBuffer[7] != CHUNK_BITS_Z)
+	{
+		return false;
+	}
 
-	// verify the beginning of the file to be correct chunk file
-	// including the if the save file match with the world seed number
-	if (tempBuffer[0] == 'G' &&
-		tempBuffer[1] == 'C' &&
-		tempBuffer[2] == 'H' &&
-		tempBuffer[3] == 'K' &&
+	uint8_t version = outBuffer[4];
+	if (version == 2)
+	{
+		// (defIndex, count) byte pairs
+		return DecodeBlockRuns(outBuffer.data() + 8, bufferSize - 8, false);
+	}
+	if (version != CHUNK_SAVE_VERSION || bufferSize < 9)
+	{
+		return false;
+	}
 
-		tempBuffer[4] == 2 &&
+	uint8_t flags = outBuffer[8];
+	int readIndex = 9;
+	uint32_t runStreamSize = 0;
+	if (!ReadVarUInt(outBuffer.data(), bufferSize, readIndex, runStreamSize) || readIndex + 4 > bufferSize || runStreamSize > CHUNK_BLOCKS_TOTAL * 6)
+	{
+		return false;
+	}
+	uint32_t checksum = (uint32_t)outBuffer[readIndex] | ((uint32_t)outBuffer[readIndex + 1] << 8) | ((uint32_t)outBuffer[readIndex + 2] << 16) | ((uint32_t)outBuffer[readIndex + 3] << 24);
+	readIndex += 4;
 
-		tempBuffer[5] == CHUNK_BITS_X &&
-		tempBuffer[6] == CHUNK_BITS_Y &&
-		tempBuffer[7] == CHUNK_BITS_Z)
+	uint8_t const* runStream = outBuffer.data() + readIndex;
+	std::vector<uint8_t> decompressedRunStream;
+	if (flags & CHUNK_SAVE_FLAG_LZ)
 	{
-		return true;
+		if (!DecompressLZ(outBuffer.data() + readIndex, bufferSize - readIndex, decompressedRunStream, (int)runStreamSize))
+		{
+			return false;
+		}
+		runStream = decompressedRunStream.data();
 	}
-	else
+	else if ((uint32_t)(bufferSize - readIndex) != runStreamSize)
 	{
 		return false;
 	}
+
+	if (ComputeChecksum32(runStream, (int)runStreamSize) != checksum)
+	{
+		return false;
+	}
+	return DecodeBlockRuns(runStream, (int)runStreamSize, true);
 }
 
-void Chunk::LoadBlocksDataFromFile()
+// the runs are checked first, then every run is filled in one go with a block whose bit flags are worked out once per def
+// the chunk is freshly constructed when it loads, so the rest of each block is still the default
+bool Chunk::DecodeBlockRuns(uint8_t const* runStream, int runStreamSize, bool hasVarUIntLengths)
 {
-	unsigned char worldSeed = (unsigned char)g_theWorld->m_seed;
-	std::string saveFolderPathName = Stringf("Saves/World_%u", worldSeed);
+	int numBlockDefs = (int)BlockDef::s_BlockDefs.size();
+	std::vector<uint32_t> runs; // defIndex in the low 8 bits, length above
+	runs.reserve(2048);
 
-	std::string fileName = Stringf("%s/Chunk(%i, %i).chunk", saveFolderPathName.c_str(), m_chunkCoords.x, m_chunkCoords.y);
-	std::vector<uint8_t> outBuffer;
-	FileReadToBuffer(outBuffer, fileName);
-
-	// verify the beginning of the file to be correct chunk file
-	if (outBuffer[0] == 'G' &&
-		outBuffer[1] == 'C' &&
-		outBuffer[2] == 'H' &&
-		outBuffer[3] == 'K' &&
-
-		outBuffer[5] == CHUNK_BITS_X &&
-		outBuffer[6] == CHUNK_BITS_Y &&
-		outBuffer[7] == CHUNK_BITS_Z)
+	int numBlocks = 0;
+	int readIndex = 0;
+	while (readIndex < runStreamSize)
 	{
-		uint8_t defIndex = 0;
-		uint8_t numBlocksOfSameKind = 1;
-		int blockIndex = 0;
-
-		// decipher the data
-		for (int i = 8; i < (outBuffer.size() - 1) ; i += 2)
+		uint8_t defIndex = runStream[readIndex++];
+		uint32_t runLength = 0;
+		if (hasVarUIntLengths)
 		{
-			defIndex = outBuffer[i];
-			numBlocksOfSameKind = outBuffer[i + 1];
-
-			// write into block data
-			for (int j = numBlocksOfSameKind; j > 0; --j)
+			if (!ReadVarUInt(runStream, runStreamSize, readIndex, runLength))
 			{
-				m_blocks[blockIndex].m_blockDefIndex = defIndex;
-				m_blocks[blockIndex].UpdateBlockBitFlagsByBlockDef(); // otherwise, the block bit flag will all be zero
-				++blockIndex;
+				return false;
 			}
 		}
+		else
+		{
+			if (readIndex >= runStreamSize)
+			{
+				return false;
+			}
+			runLength = runStream[readIndex++];
+		}
+
+		if (defIndex >= numBlockDefs || runLength == 0 || runLength > (uint32_t)(CHUNK_BLOCKS_TOTAL - numBlocks))
+		{
+			return false;
+		}
+		numBlocks += (int)runLength;
+		runs.push_back(defIndex | (runLength << 8));
 	}
-	else
+	if (numBlocks != CHUNK_BLOCKS_TOTAL)
+	{
+		return false;
+	}
+
+	Block blockForDef[256];
+	bool hasBlockForDef[256] = {};
+	int blockIndex = 0;
+	for (int runIndex = 0; runIndex < (int)runs.size(); ++runIndex)
 	{
-		ERROR_AND_DIE(Stringf("Error reading %s, wrong format", fileName.c_str())); 
+		uint8_t defIndex = (uint8_t)(runs[runIndex] & 0xFF);
+		int runLength = (int)(runs[runIndex] >> 8);
+		if (!hasBlockForDef[defIndex])
+		{
+			blockForDef[defIndex].m_blockDefIndex = defIndex;
+			blockForDef[defIndex].UpdateBlockBitFlagsByBlockDef(); // otherwise, the block bit flag will all be zero
+			hasBlockForDef[defIndex] = true;
+		}
+		std::fill(m_blocks + blockIndex, m_blocks + blockIndex + runLength, blockForDef[defIndex]);
+		blockIndex += runLength;
 	}
+	RecountSectionBlocks();
+	return true;
 }
 
 // takes the chunk coordinates in the world and transform it into world location
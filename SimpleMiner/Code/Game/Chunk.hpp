@@ -3,9 +3,12 @@
 #include "Engine/core/HeatMaps.hpp"
 #include "Engine/core/XmlUtils.hpp"
 #include "Engine/core/Vertex_PCU.hpp"
+#include "Engine/core/Vertex_Voxel.hpp"
 #include "Engine/Math/EulerAngles.hpp"
 #include "Engine/Math/FloatRange.hpp"
 #include "Game/Block.hpp"
+#include "Game/ChunkPalettedBlocks.hpp"
+#include "Game/ChunkLighting.hpp"
 #include "Game/GameCommon.hpp"
 #include "Engine/core/JobSystem.hpp"
 #include <vector>
@@ -14,6 +17,7 @@
 class VertexBuffer;
 class Shader;
 class BlockIter;
+struct ChunkMeshJob;
 
 enum class ChunkState
 {
@@ -37,6 +41,17 @@ enum class ChunkState
 	NUM_CHUNK_STATES
 };
 
+// a 16 high slice of the chunk column, meshed and drawn on its own
+// a section with no visible block, or a full one with full sections all around it, has no mesh at all
+struct ChunkSection
+{
+	int				m_numVisibleBlocks = 0; // air is the only invisible block, and every visible block is opaque
+	bool			m_isMeshDirty = true;
+	bool			m_isVoxelMesh = false; // the vertex buffer holds Vertex_Voxel local to the chunk rather than Vertex_PCU in world space
+	VertexBuffer*	m_vertexBuffer = nullptr; // null when the section has nothing to draw
+	ChunkMeshJob*	m_meshJob = nullptr; // the mesh job building from a snapshot of this section, null when none is in flight
+};
+
 class Chunk
 {
 public:
@@ -49,7 +64,7 @@ public:
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
 	// Block management
 	void	CreateInitialBlocks();
-	void	SetBlockTypeForLocalBlock(std::string blcokTypeName, IntVec3 const& localCoords);
+	void	SetBlockTypeForLocalBlock(BlockType blockType, IntVec3 const& localCoords);
 	int		GetIndexForLocalCoordinates(IntVec3 const& localCoords);
 	IntVec3 GetlocalBlockCoordsForIndex(int localBlockIndex);
 	IntVec3 GetlocalBlockCoordsForWorldPos(Vec3 const& worldPos);
@@ -64,10 +79,17 @@ public:
 	bool IfTheBlockIsAirOrOutOfChunk(IntVec3 const& blockCoords);
 	bool CheckIfTheBlockCoordsIsInsideChunkBound(IntVec3 const& blockCoords);
 
-	// Block* m_blocks = nullptr; // pointer to the first block array
-	// m_blocks = new Block[CHUNK_BLOCKS_TOTAL]; // call new block 32768 times
 	// Block* m_blocks[32768]; // this is worst because the block is stored scattered everywhere in memory
-	Block  m_blocks[CHUNK_BLOCKS_TOTAL]; //pack all the block data together
+	Block* m_blocks = nullptr; // all the block data packed together, one allocation of CHUNK_BLOCKS_TOTAL, null while the chunk is compacted
+
+	// far chunks nothing is editing or relighting keep their blocks paletted instead, see World::CompactFarChunks
+	// anything that needs the flat array back calls ExpandBlocks, BlockIter::GetBlock does it for the neighbor chunks
+	bool	IsCompacted() const { return m_blocks == nullptr; }
+	void	CompactBlocks();
+	void	ExpandBlocks();
+	size_t	GetBlocksNumBytes() const;
+
+	ChunkPalettedBlocks* m_palettedBlocks = nullptr;
 
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
 	// player game play action
@@ -76,28 +98,64 @@ public:
 
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
 	// Rendering
-	void Render() const;
-	void RenderBlocks() const;
+	void Render(bool isVoxelMesh) const;
+	void RenderBlocks(bool isVoxelMesh) const; // only the sections meshed that way, each kind needs its own shader
 	Mat44 GetModelMatrix() const;
 
 	void AddVertsForAllBlocksInChunk();
+	void AddVertsForSection(int sectionIndex); // appends to m_blockVerts
+	void QueueMeshJob(int sectionIndex); // the greedy mesh is built on a worker from a snapshot, see ChunkMesher, the world uploads it when the job comes back
+	void UploadMeshFromJob(ChunkMeshJob* job);
+	void UpdateSectionMesh(int sectionIndex);
+	void UploadSectionMesh(int sectionIndex, bool isVoxelMesh); // from m_voxelVerts or m_blockVerts, which are emptied
+	void ReleaseSectionMesh(int sectionIndex);
 	void DrawDebugRender() const;
 	void AddVertsForBlock(int localBlockIndex);
-	void CreateVertexBuffer();
-	void CopyVertexBufferFromCPUtoGPU();
+	unsigned int GetNumVerts() const;
+
+	//----------------------------------------------------------------------------------------------------------------------------------------------------
+	// sections
+	void	MarkMeshDirty(); // every section
+	void	MarkSectionMeshDirtyForLocalZ(int localZ); // and the section next to it when z is on its top or bottom layer
+	void	MarkMeshDirtyAroundBlock(int blockIndex); // and the neighbor chunk's section when the block is on the chunk edge
+	bool	IsMeshDirty() const; // some section is dirty or still being meshed
+	bool	IsSectionEmpty(int sectionIndex) const { return m_sections[sectionIndex].m_numVisibleBlocks == 0; }
+	bool	IsSectionFull(int sectionIndex) const { return m_sections[sectionIndex].m_numVisibleBlocks == CHUNK_BLOCKS_PER_SECTION; }
+	bool	IsSectionBuried(int sectionIndex) const;
+	void	RecountSectionBlocks(); // after the blocks are generated or loaded
+	int		GetOpenSkyBottomZ() const; // every block from here to the top of the chunk is air
+
+	ChunkSection m_sections[CHUNK_NUM_SECTIONS];
+
+	//----------------------------------------------------------------------------------------------------------------------------------------------------
+	// column heights, z of the highest opaque and of the highest solid block in every column, -1 when it has none
+	// DigBlock and SetBlock keep them up to date, RecountSectionBlocks rebuilds them after the blocks are generated or loaded
+	int		GetHighestOpaqueZ(int columnIndex) const { return m_highestOpaqueZ[columnIndex]; }
+	int		GetHighestSolidZ(int columnIndex) const { return m_highestSolidZ[columnIndex]; }
+	int		GetSkyBottomZ(int columnIndex) const { return m_highestOpaqueZ[columnIndex] + 1; } // every block from here up is sky
+	void	RebuildColumnHeights();
+	void	UpdateColumnHeightsForBlock(int blockIndex); // after the block has changed
+
+	int8_t	m_highestOpaqueZ[CHUNK_BLOCKS_PER_LAYER];
+	int8_t	m_highestSolidZ[CHUNK_BLOCKS_PER_LAYER];
 
+	ChunkLightQueues m_lightQueues; // the wavefront lighting's work on this chunk, see ChunkLighting
 
 	bool	m_needsSaving = false;
-	bool	m_isMeshDirty = true; // meaning the meshes data needed to be updated
 
 	std::vector<Vertex_PCU> m_blockVerts;
-	VertexBuffer* m_vertexBuffer;
+	std::vector<Vertex_Voxel> m_voxelVerts;
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
 	// saving and loading
+	// the chunk is saved as a GCHK blob in its region file, see ChunkRegionFiles
+	void EncodeBlocksData(std::vector<uint8_t>& out_buffer, bool useCompression = true) const;
 	void SaveBlocksDataToFile();
 	bool CheckIfThereIsSaveFile();
-	void LoadBlocksDataFromFile();
-	bool CheckIfSaveFileMatchWorldSeedNumber(std::string fileName);
+	bool LoadBlocksDataFromFile(); // false if there is no save, or it is not a chunk this version could read
+	bool DecodeBlocksData(std::vector<uint8_t> const& chunkData); // version 2 or 3, false if the data is broken
+	bool DecodeBlockRuns(uint8_t const* runStream, int runStreamSize, bool hasVarUIntLengths);
+
+	Job* m_pendingJob = nullptr; // the load, generate or save job that owns the chunk right now, null when it is active
 
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
 	// chunk physics info
@@ -109,8 +167,7 @@ public:
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
 	// biome factors
 	void GenerateBiomeFactors();
-	void SpawnTreeBlockTemplatesAccordingToBiomeFactors();
-	void SpawnTreeBlockTemplatesAtColumCoords(BlockTemplate treeTemplate, IntVec2 localCoords);
+	void StampFeatures();
 	bool DoAllEightSurroundingNeighborChunksExist();
 	bool DoAllFourSurroundingNeighborChunksExist();
 
@@ -139,11 +196,71 @@ public:
 struct ChunkGenerateJob : public Job
 {
 public:
+	static constexpr int JOB_TYPE = JOB_TYPE_CHUNK_GENERATION;
+
 	ChunkGenerateJob(Chunk* chunkPtr) 
-		: m_chunk(chunkPtr)
+		: Job(JOB_TYPE)
+		, m_chunk(chunkPtr)
 	{}
 
 	virtual void Execute() override;
 
 	Chunk* m_chunk = nullptr;
-};
\ No newline at end of file
+};
+
+// runs on the disk I/O lane, when there is no save file for the chunk the world queues a ChunkGenerateJob for it instead
+struct ChunkLoadJob : public Job
+{
+public:
+	static constexpr int JOB_TYPE = JOB_TYPE_CHUNK_LOAD;
+
+	ChunkLoadJob(Chunk* chunkPtr)
+		: Job(JOB_TYPE)
+		, m_chunk(chunkPtr)
+	{
+		m_isIOJob = true;
+	}
+
+	virtual void Execute() override;
+
+	Chunk* m_chunk = nullptr;
+	bool m_wasLoaded = false;
+};
+
+// runs on the disk I/O lane, the chunk is already out of the world and gets deleted once the job is retrieved
+struct ChunkSaveJob : public Job
+{
+public:
+	static constexpr int JOB_TYPE = JOB_TYPE_CHUNK_SAVE;
+
+	ChunkSaveJob(Chunk* chunkPtr)
+		: Job(JOB_TYPE)
+		, m_chunk(chunkPtr)
+	{
+		m_isIOJob = true;
+	}
+
+	virtual void Execute() override;
+
+	Chunk* m_chunk = nullptr;
+};
+// meshes a snapshot of one section and its one block border taken on the main thread, so it never reads the chunk itself
+// m_chunk is only touched by the main thread, it is null once the chunk has been deactivated and the result is thrown away
+struct ChunkMeshJob : public Job
+{
+public:
+	static constexpr int JOB_TYPE = JOB_TYPE_CHUNK_MESH;
+
+	ChunkMeshJob(Chunk* chunkPtr, int sectionIndex)
+		: Job(JOB_TYPE)
+		, m_chunk(chunkPtr)
+		, m_sectionIndex(sectionIndex)
+	{}
+
+	virtual void Execute() override;
+
+	Chunk* m_chunk = nullptr;
+	int m_sectionIndex = 0;
+	std::vector<Block> m_snapshot; // MESH_SNAPSHOT_BLOCKS_TOTAL blocks
+	std::vector<Vertex_Voxel> m_verts;
+};
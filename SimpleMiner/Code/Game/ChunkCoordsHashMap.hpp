@@ -0,0 +1,184 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// open addressing hash map from chunk coords to a pointer, used instead of std::map for the active and in-flight chunks
+// the entries are packed in a vector so looping through all of them is as cheap as looping an array,
+// the slot table only stores the entry index and is probed linearly, removing shifts the following slots back so there are no tombstones
+// removing swaps the last entry into the hole, so when removing while looping, loop backwards
+template <typename ValueType>
+class ChunkCoordsHashMap
+{
+public:
+	struct Entry
+	{
+		IntVec2		m_coords;
+		ValueType*	m_value = nullptr;
+	};
+
+	ChunkCoordsHashMap(int expectedNumEntries = 64);
+
+	ValueType*	Find(IntVec2 const& coords) const; // null when the coords are not in the map
+	bool		Contains(IntVec2 const& coords) const	{ return FindSlot(coords) >= 0; }
+	void		Set(IntVec2 const& coords, ValueType* value); // adds or replaces
+	bool		Remove(IntVec2 const& coords);
+	void		Clear();
+
+	int				GetSize() const				{ return (int)m_entries.size(); }
+	Entry const&	GetEntry(int index) const	{ return m_entries[index]; }
+
+private:
+	static unsigned int HashCoords(IntVec2 const& coords);
+	int  FindSlot(IntVec2 const& coords) const; // -1 if not found
+	void Rehash(int newNumSlots);
+
+	static constexpr int EMPTY_SLOT = -1;
+
+	std::vector<Entry>	m_entries;
+	std::vector<int>	m_slots; // index into m_entries, always a power of 2 long and at most half full
+	unsigned int		m_slotMask = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+template <typename ValueType>
+ChunkCoordsHashMap<ValueType>::ChunkCoordsHashMap(int expectedNumEntries)
+{
+	int numSlots = 16;
+	while (numSlots < expectedNumEntries * 2)
+	{
+		numSlots <<= 1;
+	}
+	m_entries.reserve(expectedNumEntries);
+	Rehash(numSlots);
+}
+
+template <typename ValueType>
+unsigned int ChunkCoordsHashMap<ValueType>::HashCoords(IntVec2 const& coords)
+{
+	// neighbor chunks only differ in the low bits, mix them so they do not pile up in the same few slots
+	unsigned int hash = (unsigned int)coords.x * 0x9E3779B1u;
+	hash ^= (unsigned int)coords.y * 0x85EBCA77u;
+	hash ^= hash >> 15;
+	hash *= 0x2C1B3C6Du;
+	hash ^= hash >> 13;
+	return hash;
+}
+
+template <typename ValueType>
+int ChunkCoordsHashMap<ValueType>::FindSlot(IntVec2 const& coords) const
+{
+	unsigned int slot = HashCoords(coords) & m_slotMask;
+	while (m_slots[slot] != EMPTY_SLOT)
+	{
+		if (m_entries[m_slots[slot]].m_coords == coords)
+		{
+			return (int)slot;
+		}
+		slot = (slot + 1) & m_slotMask;
+	}
+	return -1;
+}
+
+template <typename ValueType>
+ValueType* ChunkCoordsHashMap<ValueType>::Find(IntVec2 const& coords) const
+{
+	int slot = FindSlot(coords);
+	if (slot < 0)
+	{
+		return nullptr;
+	}
+	return m_entries[m_slots[slot]].m_value;
+}
+
+template <typename ValueType>
+void ChunkCoordsHashMap<ValueType>::Set(IntVec2 const& coords, ValueType* value)
+{
+	int existingSlot = FindSlot(coords);
+	if (existingSlot >= 0)
+	{
+		m_entries[m_slots[existingSlot]].m_value = value;
+		return;
+	}
+
+	if ((int)(m_entries.size() + 1) * 2 > (int)m_slots.size())
+	{
+		Rehash((int)m_slots.size() * 2);
+	}
+
+	unsigned int slot = HashCoords(coords) & m_slotMask;
+	while (m_slots[slot] != EMPTY_SLOT)
+	{
+		slot = (slot + 1) & m_slotMask;
+	}
+
+	Entry newEntry;
+	newEntry.m_coords = coords;
+	newEntry.m_value = value;
+	m_slots[slot] = (int)m_entries.size();
+	m_entries.push_back(newEntry);
+}
+
+template <typename ValueType>
+bool ChunkCoordsHashMap<ValueType>::Remove(IntVec2 const& coords)
+{
+	int removedSlot = FindSlot(coords);
+	if (removedSlot < 0)
+	{
+		return false;
+	}
+
+	// fill the hole in the entries with the last entry, and point its slot to the new place
+	int removedEntryIndex = m_slots[removedSlot];
+	int lastEntryIndex = (int)m_entries.size() - 1;
+	if (removedEntryIndex != lastEntryIndex)
+	{
+		int lastEntrySlot = FindSlot(m_entries[lastEntryIndex].m_coords);
+		m_slots[lastEntrySlot] = removedEntryIndex;
+		m_entries[removedEntryIndex] = m_entries[lastEntryIndex];
+	}
+	m_entries.pop_back();
+
+	// shift back every following slot of the same probe run that could live in the hole, so lookups never stop early
+	unsigned int holeSlot = (unsigned int)removedSlot;
+	unsigned int slot = (holeSlot + 1) & m_slotMask;
+	while (m_slots[slot] != EMPTY_SLOT)
+	{
+		unsigned int homeSlot = HashCoords(m_entries[m_slots[slot]].m_coords) & m_slotMask;
+		bool homeIsInsideHoleToSlot = ((slot - homeSlot) & m_slotMask) < ((slot - holeSlot) & m_slotMask);
+		if (!homeIsInsideHoleToSlot)
+		{
+			m_slots[holeSlot] = m_slots[slot];
+			holeSlot = slot;
+		}
+		slot = (slot + 1) & m_slotMask;
+	}
+	m_slots[holeSlot] = EMPTY_SLOT;
+	return true;
+}
+
+template <typename ValueType>
+void ChunkCoordsHashMap<ValueType>::Clear()
+{
+	m_entries.clear();
+	for (int slot = 0; slot < (int)m_slots.size(); ++slot)
+	{
+		m_slots[slot] = EMPTY_SLOT;
+	}
+}
+
+template <typename ValueType>
+void ChunkCoordsHashMap<ValueType>::Rehash(int newNumSlots)
+{
+	m_slots.assign(newNumSlots, EMPTY_SLOT);
+	m_slotMask = (unsigned int)newNumSlots - 1;
+	for (int entryIndex = 0; entryIndex < (int)m_entries.size(); ++entryIndex)
+	{
+		unsigned int slot = HashCoords(m_entries[entryIndex].m_coords) & m_slotMask;
+		while (m_slots[slot] != EMPTY_SLOT)
+		{
+			slot = (slot + 1) & m_slotMask;
+		}
+		m_slots[slot] = entryIndex;
+	}
+}
@@ -0,0 +1,531 @@
+#include "Engine/Renderer/Renderer.hpp"
+#include "Game/ChunkFeatures.hpp"
+#include "Game/Chunk.hpp"
+#include "Game/World.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/Easing.hpp"
+#include "ThirdParty/Noise_Squirrel/SmoothNoise.hpp"
+#include "ThirdParty/Noise_Squirrel/RawNoise.hpp"
+#include "ThirdParty/Noise_Squirrel/BatchNoise.hpp"
+#include <algorithm>
+
+extern World* g_theWorld;
+
+// the noise channels of the cave worms, every channel has its own seed
+enum CaveNoise
+{
+	CAVE_NOISE_START,
+	CAVE_NOISE_START_X,
+	CAVE_NOISE_START_Y,
+	CAVE_NOISE_START_Z,
+	CAVE_NOISE_WORM,
+	NUM_CAVE_NOISES
+};
+
+static int FloorDivide(int value, int divisor)
+{
+	int quotient = value / divisor;
+	if ((value % divisor != 0) && ((value < 0) != (divisor < 0)))
+	{
+		--quotient;
+	}
+	return quotient;
+}
+
+IntVec2 ChunkFeatureCache::GetRegionCoordsForGlobalColumn(int globalX, int globalY)
+{
+	return IntVec2(FloorDivide(globalX, FEATURE_REGION_SIZE_X), FloorDivide(globalY, FEATURE_REGION_SIZE_Y));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+std::shared_ptr<ChunkFeatureRegion const> ChunkFeatureCache::GetRegion(IntVec2 const& regionCoords)
+{
+	std::shared_future<std::shared_ptr<ChunkFeatureRegion const>> cachedRegion;
+	std::promise<std::shared_ptr<ChunkFeatureRegion const>> regionPromise;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_useCounter;
+		for (CachedRegion& cached : m_regions)
+		{
+			if (cached.m_regionCoords == regionCoords)
+			{
+				cached.m_lastUsed = m_useCounter;
+				cachedRegion = cached.m_region;
+				break;
+			}
+		}
+
+		if (!cachedRegion.valid())
+		{
+			// claim the region so other threads wait for this one instead of working it out again
+			CachedRegion newRegion;
+			newRegion.m_regionCoords = regionCoords;
+			newRegion.m_region = regionPromise.get_future().share();
+			newRegion.m_lastUsed = m_useCounter;
+			m_regions.push_back(newRegion);
+
+			if ((int)m_regions.size() > FEATURE_CACHE_MAX_REGIONS)
+			{
+				// the waiting threads keep their own future, so a region being worked out can go too
+				auto leastRecentlyUsed = std::min_element(m_regions.begin(), m_regions.end(),
+					[](CachedRegion const& a, CachedRegion const& b) { return a.m_lastUsed < b.m_lastUsed; });
+				m_regions.erase(leastRecentlyUsed);
+			}
+		}
+	}
+
+	if (cachedRegion.valid())
+	{
+		return cachedRegion.get();
+	}
+
+	std::shared_ptr<ChunkFeatureRegion> region = std::make_shared<ChunkFeatureRegion>();
+	region->m_regionCoords = regionCoords;
+	ComputeFeatureRegion(*region, (unsigned int)g_theWorld->m_seed, g_theWorld->m_useBatchNoise);
+	regionPromise.set_value(region);
+	return region;
+}
+
+void ChunkFeatureCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_regions.clear();
+}
+
+int ChunkFeatureCache::GetNumRegions() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (int)m_regions.size();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// the noise for a grid of block columns, out[y * numX + x] is the column (startX + x, startY + y)
+// the batch functions give the same bits as calling the scalar ones column by column, World::m_useBatchNoise picks one
+static void ComputePerlinNoiseForColumns(float* out_noise, int startX, int startY, int numX, int numY, bool useBatchNoise, float scale, unsigned int numOctaves,
+	float octavePersistence = 0.5f, float octaveScale = 2.f, bool renormalize = true, unsigned int seed = 0)
+{
+	if (useBatchNoise)
+	{
+		Compute2dPerlinNoiseGrid(out_noise, startX, startY, numX, numY, scale, numOctaves, octavePersistence, octaveScale, renormalize, seed);
+		return;
+	}
+	for (int y = 0; y < numY; ++y)
+	{
+		for (int x = 0; x < numX; ++x)
+		{
+			out_noise[y * numX + x] = Compute2dPerlinNoise(float(startX + x), float(startY + y), scale, numOctaves, octavePersistence, octaveScale, renormalize, seed);
+		}
+	}
+}
+
+static void ComputeZeroToOneNoiseForColumns(float* out_noise, int startX, int startY, int numX, int numY, bool useBatchNoise, unsigned int seed)
+{
+	if (useBatchNoise)
+	{
+		Get2dNoiseZeroToOneGrid(out_noise, startX, startY, numX, numY, seed);
+		return;
+	}
+	for (int y = 0; y < numY; ++y)
+	{
+		for (int x = 0; x < numX; ++x)
+		{
+			out_noise[y * numX + x] = Get2dNoiseZeroToOne(startX + x, startY + y, seed);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// the terrain height of a block column from its hilliness, oceanness and terrain noise
+static int GetGroundHeightZFromNoise(float hillinessNoise, float oceannessNoise, float terrainNoise)
+{
+	float Hilliness = 0.5f + 0.5f * hillinessNoise; // range from 0 - 1, so we could use all easing functions
+	float Oceanness = 0.5f + 0.5f * oceannessNoise;
+
+	// mountain height settings
+	int groundHeightZ = 0;
+	float terrainNoiseFromZeroToOne = fabsf(terrainNoise);
+	Hilliness = SmoothStep3(SmoothStep3(Hilliness));
+
+	float terrainHeightAboveRiverBed = terrainNoiseFromZeroToOne * TERRAIN_HEIGHT_ABOVE_WATER_MAX; // heightest mountain
+	float terrainHeightAboveWater = terrainHeightAboveRiverBed - RIVER_DEPTH_MAX;
+
+	float terrainHeightAboveWaterBed = terrainHeightAboveWater;
+	if (terrainHeightAboveWater > 0.f)
+	{
+		terrainHeightAboveWater *= Hilliness;
+		terrainHeightAboveWaterBed = terrainHeightAboveWater + RIVER_DEPTH_MAX;
+	}
+	groundHeightZ = (int)((float)RIVER_BED_HEIGHT_Z + terrainHeightAboveWaterBed);
+
+	// ocean
+	// Map Oceanness into [0,1] and run a SmoothStep3() easing function on it (perhaps even twice!)
+	// to get more distinctively "ocean" and "non-ocean (land)" biome areas
+	Oceanness = SmoothStep3(SmoothStep3(Oceanness));
+	// Oceanness < 0.50 = normal terrain
+	if (Oceanness >= 0.5f && Oceanness <= 0.75f)
+	{
+		Oceanness = RangeMap(Oceanness, 0.5f, 0.75f, 0.f, 1.f);
+		int OceanLowing = (int)((float)OCEAN_LOWING_MAX * Oceanness);
+		groundHeightZ -= OceanLowing;
+	}
+	else if (Oceanness > 0.75f)
+	{
+		int OceanLowing = OCEAN_LOWING_MAX;
+		groundHeightZ -= OceanLowing;
+	}
+	return groundHeightZ;
+}
+
+// a single column outside of any grid, for the cave worms wandering out of their region
+static int ComputeGroundHeightZForColumn(int globalX, int globalY, unsigned int worldSeed)
+{
+	float hillinessNoise = Compute2dPerlinNoise(float(globalX), float(globalY), 2000.f, 3, 0.5f, 2.f, true, worldSeed);
+	float oceannessNoise = Compute2dPerlinNoise(float(globalX), float(globalY), 1000.f, 7, 0.5f, 2.f, true, worldSeed);
+	float terrainNoise = Compute2dPerlinNoise(float(globalX), float(globalY), 100.f, 5);
+	return GetGroundHeightZFromNoise(hillinessNoise, oceannessNoise, terrainNoise);
+}
+
+static void ComputeRegionBiomeFactors(ChunkFeatureRegion& region, int regionStartX, int regionStartY, unsigned int worldSeed, bool useBatchNoise)
+{
+	std::vector<float> noise(5 * FEATURE_REGION_COLUMNS);
+	float* temperatureNoise = &noise[0];
+	float* humidityNoise = temperatureNoise + FEATURE_REGION_COLUMNS;
+	float* hillinessNoise = humidityNoise + FEATURE_REGION_COLUMNS;
+	float* oceannessNoise = hillinessNoise + FEATURE_REGION_COLUMNS;
+	float* terrainNoiseGrid = oceannessNoise + FEATURE_REGION_COLUMNS;
+	ComputePerlinNoiseForColumns(temperatureNoise, regionStartX, regionStartY, FEATURE_REGION_SIZE_X, FEATURE_REGION_SIZE_Y, useBatchNoise, 300.f, 5, 0.5f, 2.f, true, worldSeed);
+	ComputePerlinNoiseForColumns(humidityNoise, regionStartX, regionStartY, FEATURE_REGION_SIZE_X, FEATURE_REGION_SIZE_Y, useBatchNoise, 600.f, 2, 0.5f, 2.f, true, worldSeed);
+	ComputePerlinNoiseForColumns(hillinessNoise, regionStartX, regionStartY, FEATURE_REGION_SIZE_X, FEATURE_REGION_SIZE_Y, useBatchNoise, 2000.f, 3, 0.5f, 2.f, true, worldSeed);
+	ComputePerlinNoiseForColumns(oceannessNoise, regionStartX, regionStartY, FEATURE_REGION_SIZE_X, FEATURE_REGION_SIZE_Y, useBatchNoise, 1000.f, 7, 0.5f, 2.f, true, worldSeed);
+	ComputePerlinNoiseForColumns(terrainNoiseGrid, regionStartX, regionStartY, FEATURE_REGION_SIZE_X, FEATURE_REGION_SIZE_Y, useBatchNoise, 100.f, 5);
+
+	for (int columnIndex = 0; columnIndex < FEATURE_REGION_COLUMNS; ++columnIndex)
+	{
+		// Humidity = 1.f - (1.f - Humidity) * (1.f - Oceanness); // both humidity and oceanness will contribute but result will not over 1
+		// todo: but this will cause the humidity hardly ever under 0.4f
+		region.m_temperature[columnIndex] = 0.5f + 0.5f * temperatureNoise[columnIndex]; // range from 0 - 1, so we could use all easing functions
+		region.m_humidity[columnIndex] = 0.5f + 0.5f * humidityNoise[columnIndex];
+		region.m_terrainHeightZ[columnIndex] = GetGroundHeightZFromNoise(hillinessNoise[columnIndex], oceannessNoise[columnIndex], terrainNoiseGrid[columnIndex]);
+	}
+}
+
+// a tree grows where the tree noise beats the forestness threshold and is the highest of the TREE_COVER_SIZE_MAX window around it
+static void ComputeRegionTrees(ChunkFeatureRegion& region, int regionStartX, int regionStartY, unsigned int worldSeed, bool useBatchNoise)
+{
+	// the tree noise also covers the window each column compares itself with, TREE_COVER_SIZE_MAX to the west and south and one to the east and north
+	constexpr int TREE_NOISE_SIZE_X = FEATURE_REGION_SIZE_X + TREE_COVER_SIZE_MAX + 1;
+	constexpr int TREE_NOISE_SIZE_Y = FEATURE_REGION_SIZE_Y + TREE_COVER_SIZE_MAX + 1;
+	std::vector<float> forestnessNoise(FEATURE_REGION_COLUMNS);
+	std::vector<float> treeNoiseGrid(TREE_NOISE_SIZE_X * TREE_NOISE_SIZE_Y);
+	ComputePerlinNoiseForColumns(forestnessNoise.data(), regionStartX, regionStartY, FEATURE_REGION_SIZE_X, FEATURE_REGION_SIZE_Y, useBatchNoise, 90.f, 3, 0.5f, 2.f, true, worldSeed);
+	ComputeZeroToOneNoiseForColumns(treeNoiseGrid.data(), regionStartX - TREE_COVER_SIZE_MAX, regionStartY - TREE_COVER_SIZE_MAX, TREE_NOISE_SIZE_X, TREE_NOISE_SIZE_Y, useBatchNoise, worldSeed);
+
+	// x outer and y inner, so the trees come out sorted the way they are planted
+	for (int regionX = 0; regionX < FEATURE_REGION_SIZE_X; ++regionX)
+	{
+		for (int regionY = 0; regionY < FEATURE_REGION_SIZE_Y; ++regionY)
+		{
+			int columnIndex = regionY * FEATURE_REGION_SIZE_X + regionX;
+			int treeNoiseX = regionX + TREE_COVER_SIZE_MAX;
+			int treeNoiseY = regionY + TREE_COVER_SIZE_MAX;
+
+			float Forestness = 0.5f + 0.5f * forestnessNoise[columnIndex]; // rename of "tree density"
+			Forestness = SmoothStep3(SmoothStep3(Forestness));
+			float treeNoiseMinimumThreshold = RangeMapClamped(Forestness, 0.6f, 1.f, 0.99f, 0.75f);
+			float TreeNoise = treeNoiseGrid[treeNoiseY * TREE_NOISE_SIZE_X + treeNoiseX];
+			if (TreeNoise <= treeNoiseMinimumThreshold)
+			{
+				continue;
+			}
+
+			// only the highest tree noise of the window gets a tree
+			float max = 0.f;
+			for (int posX = (treeNoiseX - TREE_COVER_SIZE_MAX); posX < (treeNoiseX + 2); ++posX)
+			{
+				for (int posY = (treeNoiseY - TREE_COVER_SIZE_MAX); posY < (treeNoiseY + 2); ++posY)
+				{
+					float neighborNoise = treeNoiseGrid[posY * TREE_NOISE_SIZE_X + posX];
+					if (neighborNoise > max)
+					{
+						max = neighborNoise;
+					}
+				}
+			}
+			if (TreeNoise != max || region.m_terrainHeightZ[columnIndex] <= WATER_LEVEL_Z)
+			{
+				continue;
+			}
+
+			// discuss what kind of tree need to plant here
+			TreeFeature tree;
+			tree.m_globalColumn = IntVec2(regionStartX + regionX, regionStartY + regionY);
+			tree.m_groundHeightZ = region.m_terrainHeightZ[columnIndex];
+			if (region.m_humidity[columnIndex] < 0.4f)
+			{
+				tree.m_type = TREE_TYPE_CACTUS;
+			}
+			else if (region.m_temperature[columnIndex] < 0.4f)
+			{
+				tree.m_type = TREE_TYPE_SPRUCE;
+			}
+			else
+			{
+				// calculate the chance to spawn spruce and oak then decide which tree to spawn
+				float spruceChance = RangeMap(region.m_temperature[columnIndex], 0.4f, 0.7f, 1.f, 0.f);
+				tree.m_type = (TreeNoise < spruceChance) ? TREE_TYPE_SPRUCE : TREE_TYPE_OAK;
+			}
+			region.m_trees.push_back(tree);
+		}
+	}
+}
+
+// a chunk starts a worm when its cave noise is the highest within CAVE_COVER_CHUNK_TIMES chunks,
+// the worm runs CAVE_MAX_RADIUS both ways from a point in the chunk, turning and widening with 1d perlin noise along its length,
+// and is kept under the ground so the surface and the trees on it stay whole:
+// every segment ends below the lowest ground of the columns at its start, middle and end, and the carving never touches
+// the surface block of a column or the CAVE_SURFACE_CRUST_BLOCKS under it, the capsule could still reach up there over a valley
+static void ComputeRegionCaves(ChunkFeatureRegion& region, unsigned int worldSeed)
+{
+	// a row of seeds of its own, the generation rolls of Chunk::CreateInitialBlocks use row 0
+	unsigned int caveSeeds[NUM_CAVE_NOISES];
+	for (int caveNoise = 0; caveNoise < NUM_CAVE_NOISES; ++caveNoise)
+	{
+		caveSeeds[caveNoise] = Get2dNoiseUint(caveNoise, 1, worldSeed);
+	}
+
+	constexpr int NUM_SEGMENTS_PER_HALF = int(CAVE_MAX_RADIUS / CAVE_SEGMENT_LENGTH);
+	int regionChunkStartX = region.m_regionCoords.x * FEATURE_REGION_SIZE_CHUNKS;
+	int regionChunkStartY = region.m_regionCoords.y * FEATURE_REGION_SIZE_CHUNKS;
+	for (int chunkX = regionChunkStartX; chunkX < regionChunkStartX + FEATURE_REGION_SIZE_CHUNKS; ++chunkX)
+	{
+		for (int chunkY = regionChunkStartY; chunkY < regionChunkStartY + FEATURE_REGION_SIZE_CHUNKS; ++chunkY)
+		{
+			float caveNoise = Get2dNoiseZeroToOne(chunkX, chunkY, caveSeeds[CAVE_NOISE_START]);
+			bool isHighest = true;
+			for (int posX = chunkX - CAVE_COVER_CHUNK_TIMES; posX <= chunkX + CAVE_COVER_CHUNK_TIMES && isHighest; ++posX)
+			{
+				for (int posY = chunkY - CAVE_COVER_CHUNK_TIMES; posY <= chunkY + CAVE_COVER_CHUNK_TIMES; ++posY)
+				{
+					if (Get2dNoiseZeroToOne(posX, posY, caveSeeds[CAVE_NOISE_START]) > caveNoise)
+					{
+						isHighest = false;
+						break;
+					}
+				}
+			}
+			if (!isHighest)
+			{
+				continue;
+			}
+
+			// locate the origin block of the worm in the chunk
+			int regionX = (chunkX - regionChunkStartX) * CHUNK_SIZE_X + int(Get2dNoiseZeroToOne(chunkX, chunkY, caveSeeds[CAVE_NOISE_START_X]) * float(CHUNK_SIZE_X));
+			int regionY = (chunkY - regionChunkStartY) * CHUNK_SIZE_Y + int(Get2dNoiseZeroToOne(chunkX, chunkY, caveSeeds[CAVE_NOISE_START_Y]) * float(CHUNK_SIZE_Y));
+			int terrainHeight = region.m_terrainHeightZ[regionY * FEATURE_REGION_SIZE_X + regionX];
+			float startZ = Get2dNoiseZeroToOne(chunkX, chunkY, caveSeeds[CAVE_NOISE_START_Z]) * float(terrainHeight);
+			startZ = GetClamped(startZ, CAVE_WORM_MAX_RADIUS + 2.f, float(terrainHeight) - CAVE_WORM_MAX_RADIUS - 2.f);
+			Vec3 wormStart(float(region.m_regionCoords.x * FEATURE_REGION_SIZE_X + regionX) + 0.5f, float(region.m_regionCoords.y * FEATURE_REGION_SIZE_Y + regionY) + 0.5f, startZ);
+
+			unsigned int wormSeed = Get2dNoiseUint(chunkX, chunkY, caveSeeds[CAVE_NOISE_WORM]);
+			float startYawDegrees = 360.f * Get1dNoiseZeroToOne(0, wormSeed);
+
+			// the second half heads the other way, walking the noise backwards so the worm bends smoothly through its start
+			for (int half = 0; half < 2; ++half)
+			{
+				float wormDirection = (half == 0) ? 1.f : -1.f;
+				Vec3 segmentStart = wormStart;
+				for (int segmentIndex = 0; segmentIndex < NUM_SEGMENTS_PER_HALF; ++segmentIndex)
+				{
+					float caveWormLength = wormDirection * float(segmentIndex) * CAVE_SEGMENT_LENGTH;
+					float yawNoise = Compute1dPerlinNoise(caveWormLength, CAVE_TURN_SCALE, 3, 0.5f, 2.f, true, wormSeed);
+					float pitchNoise = Compute1dPerlinNoise(caveWormLength, CAVE_TURN_SCALE, 3, 0.5f, 2.f, true, wormSeed + 1);
+					float radiusNoise = Compute1dPerlinNoise(caveWormLength, CAVE_TURN_SCALE, 2, 0.5f, 2.f, true, wormSeed + 2);
+					float yawDegrees = startYawDegrees + 180.f * float(half) + CAVE_YAW_MAX * yawNoise;
+					float pitchDegrees = GetClamped(CAVE_PITCH_MAX * pitchNoise, -CAVE_PITCH_MAX, CAVE_PITCH_MAX);
+					float radius = RangeMapClamped(radiusNoise, -1.f, 1.f, CAVE_WORM_MIN_RADIUS, CAVE_WORM_MAX_RADIUS);
+
+					Vec3 segmentEnd = segmentStart + Vec3::GetDirectionForYawPitch(yawDegrees, pitchDegrees) * CAVE_SEGMENT_LENGTH;
+					Vec3 segmentMiddle = (segmentStart + segmentEnd) * 0.5f;
+					int groundHeightZ = ComputeGroundHeightZForColumn((int)floorf(segmentEnd.x), (int)floorf(segmentEnd.y), worldSeed);
+					groundHeightZ = std::min(groundHeightZ, ComputeGroundHeightZForColumn((int)floorf(segmentMiddle.x), (int)floorf(segmentMiddle.y), worldSeed));
+					groundHeightZ = std::min(groundHeightZ, ComputeGroundHeightZForColumn((int)floorf(segmentStart.x), (int)floorf(segmentStart.y), worldSeed));
+					float maxZ = float(groundHeightZ) - radius - 2.f;
+					float minZ = radius + 2.f;
+					segmentEnd.z = GetClamped(segmentEnd.z, minZ, maxZ > minZ ? maxZ : minZ);
+
+					CaveSegment segment;
+					segment.m_start = segmentStart;
+					segment.m_end = segmentEnd;
+					segment.m_radius = radius;
+					region.m_caveSegments.push_back(segment);
+					segmentStart = segmentEnd;
+				}
+			}
+		}
+	}
+}
+
+void ComputeFeatureRegion(ChunkFeatureRegion& region, unsigned int worldSeed, bool useBatchNoise)
+{
+	int regionStartX = region.m_regionCoords.x * FEATURE_REGION_SIZE_X;
+	int regionStartY = region.m_regionCoords.y * FEATURE_REGION_SIZE_Y;
+	ComputeRegionBiomeFactors(region, regionStartX, regionStartY, worldSeed, useBatchNoise);
+	ComputeRegionTrees(region, regionStartX, regionStartY, worldSeed, useBatchNoise);
+	ComputeRegionCaves(region, worldSeed);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+void CopyBiomeFactorsFromRegions(Chunk* chunk, ChunkFeatureCache& cache)
+{
+	// the neighborhood reaches TREE_COVER_SIZE_MAX past the chunk, so it can span up to four regions
+	int neighborhoodStartX = chunk->m_chunkCoords.x * CHUNK_SIZE_X - TREE_COVER_SIZE_MAX;
+	int neighborhoodStartY = chunk->m_chunkCoords.y * CHUNK_SIZE_Y - TREE_COVER_SIZE_MAX;
+	IntVec2 minRegionCoords = ChunkFeatureCache::GetRegionCoordsForGlobalColumn(neighborhoodStartX, neighborhoodStartY);
+	IntVec2 maxRegionCoords = ChunkFeatureCache::GetRegionCoordsForGlobalColumn(neighborhoodStartX + NEIGHBORHOOD_SIZE_X - 1, neighborhoodStartY + NEIGHBORHOOD_SIZE_Y - 1);
+
+	for (int regionCoordsX = minRegionCoords.x; regionCoordsX <= maxRegionCoords.x; ++regionCoordsX)
+	{
+		for (int regionCoordsY = minRegionCoords.y; regionCoordsY <= maxRegionCoords.y; ++regionCoordsY)
+		{
+			std::shared_ptr<ChunkFeatureRegion const> region = cache.GetRegion(IntVec2(regionCoordsX, regionCoordsY));
+			int regionStartX = regionCoordsX * FEATURE_REGION_SIZE_X;
+			int regionStartY = regionCoordsY * FEATURE_REGION_SIZE_Y;
+
+			// the part of the neighborhood inside this region
+			int startX = std::max(neighborhoodStartX, regionStartX);
+			int endX = std::min(neighborhoodStartX + NEIGHBORHOOD_SIZE_X, regionStartX + FEATURE_REGION_SIZE_X);
+			int startY = std::max(neighborhoodStartY, regionStartY);
+			int endY = std::min(neighborhoodStartY + NEIGHBORHOOD_SIZE_Y, regionStartY + FEATURE_REGION_SIZE_Y);
+			for (int globalY = startY; globalY < endY; ++globalY)
+			{
+				for (int globalX = startX; globalX < endX; ++globalX)
+				{
+					int neighborhoodColumnIndex = (globalY - neighborhoodStartY) * NEIGHBORHOOD_SIZE_X + (globalX - neighborhoodStartX);
+					int regionColumnIndex = (globalY - regionStartY) * FEATURE_REGION_SIZE_X + (globalX - regionStartX);
+					chunk->m_terrainHeightZ[neighborhoodColumnIndex] = region->m_terrainHeightZ[regionColumnIndex];
+					chunk->m_humidity[neighborhoodColumnIndex] = region->m_humidity[regionColumnIndex];
+					chunk->m_temperature[neighborhoodColumnIndex] = region->m_temperature[regionColumnIndex];
+				}
+			}
+		}
+	}
+}
+
+// carves the blocks whose centers are inside the capsule into air, up to CAVE_SURFACE_CRUST_BLOCKS under the column's surface block
+static void CarveCaveSegmentIntoChunk(Chunk* chunk, CaveSegment const& segment, Vec3 const& chunkOrigin)
+{
+	int minX = std::max(0, (int)floorf(std::min(segment.m_start.x, segment.m_end.x) - segment.m_radius - chunkOrigin.x));
+	int maxX = std::min(CHUNK_SIZE_X - 1, (int)floorf(std::max(segment.m_start.x, segment.m_end.x) + segment.m_radius - chunkOrigin.x));
+	int minY = std::max(0, (int)floorf(std::min(segment.m_start.y, segment.m_end.y) - segment.m_radius - chunkOrigin.y));
+	int maxY = std::min(CHUNK_SIZE_Y - 1, (int)floorf(std::max(segment.m_start.y, segment.m_end.y) + segment.m_radius - chunkOrigin.y));
+	int minZ = std::max(0, (int)floorf(std::min(segment.m_start.z, segment.m_end.z) - segment.m_radius));
+	int maxZ = std::min(CHUNK_SIZE_Z - 1, (int)floorf(std::max(segment.m_start.z, segment.m_end.z) + segment.m_radius));
+	if (minX > maxX || minY > maxY || minZ > maxZ)
+	{
+		return;
+	}
+
+	Vec3 bone = segment.m_end - segment.m_start;
+	float boneLengthSquared = bone.GetLengthSquared();
+	float radiusSquared = segment.m_radius * segment.m_radius;
+	for (int localZ = minZ; localZ <= maxZ; ++localZ)
+	{
+		for (int localY = minY; localY <= maxY; ++localY)
+		{
+			for (int localX = minX; localX <= maxX; ++localX)
+			{
+				Vec3 blockCenter = chunkOrigin + Vec3(float(localX) + 0.5f, float(localY) + 0.5f, float(localZ) + 0.5f);
+				Vec3 startToBlock = blockCenter - segment.m_start;
+				float t = (boneLengthSquared > 0.f) ? GetClamped(DotProduct3D(startToBlock, bone) / boneLengthSquared, 0.f, 1.f) : 0.f;
+				Vec3 nearestToBlock = startToBlock - bone * t;
+				if (nearestToBlock.GetLengthSquared() > radiusSquared)
+				{
+					continue;
+				}
+
+				int terrainHeightZ = chunk->m_terrainHeightZ[chunk->GetBiomeIndexByTreeCoords(chunk->GetBiomeCoordsByLocalCoords(IntVec2(localX, localY)))];
+				if (localZ >= terrainHeightZ - CAVE_SURFACE_CRUST_BLOCKS)
+				{
+					continue;
+				}
+
+				int blockIndex = (localX << CHUNK_BITSHIFT_X) | (localY << CHUNK_BITSHIFT_Y) | (localZ << CHUNK_BITSHIFT_Z);
+				if (chunk->m_blocks[blockIndex].IsSolid())
+				{
+					chunk->m_blocks[blockIndex].SetType(BLOCK_TYPE_AIR);
+				}
+			}
+		}
+	}
+}
+
+void StampFeaturesIntoChunk(Chunk* chunk, ChunkFeatureCache& cache)
+{
+	int chunkStartX = chunk->m_chunkCoords.x * CHUNK_SIZE_X;
+	int chunkStartY = chunk->m_chunkCoords.y * CHUNK_SIZE_Y;
+	Vec3 chunkOrigin((float)chunkStartX, (float)chunkStartY, 0.f);
+
+	// every region whose features can reach into the chunk
+	IntVec2 minRegionCoords = ChunkFeatureCache::GetRegionCoordsForGlobalColumn(chunkStartX - FEATURE_REACH_BLOCKS, chunkStartY - FEATURE_REACH_BLOCKS);
+	IntVec2 maxRegionCoords = ChunkFeatureCache::GetRegionCoordsForGlobalColumn(chunkStartX + CHUNK_SIZE_X - 1 + FEATURE_REACH_BLOCKS, chunkStartY + CHUNK_SIZE_Y - 1 + FEATURE_REACH_BLOCKS);
+	std::vector<std::shared_ptr<ChunkFeatureRegion const>> regions;
+	for (int regionCoordsX = minRegionCoords.x; regionCoordsX <= maxRegionCoords.x; ++regionCoordsX)
+	{
+		for (int regionCoordsY = minRegionCoords.y; regionCoordsY <= maxRegionCoords.y; ++regionCoordsY)
+		{
+			regions.push_back(cache.GetRegion(IntVec2(regionCoordsX, regionCoordsY)));
+		}
+	}
+
+	// caves first, the trees stand on the ground the caves leave alone
+	for (std::shared_ptr<ChunkFeatureRegion const> const& region : regions)
+	{
+		for (CaveSegment const& segment : region->m_caveSegments)
+		{
+			CarveCaveSegmentIntoChunk(chunk, segment, chunkOrigin);
+		}
+	}
+
+	// the trees rooted within TREE_COVER_SIZE_MAX of the chunk, planted in x then y order so overlapping trees end up as they always have
+	std::vector<TreeFeature> trees;
+	for (std::shared_ptr<ChunkFeatureRegion const> const& region : regions)
+	{
+		for (TreeFeature const& tree : region->m_trees)
+		{
+			int localX = tree.m_globalColumn.x - chunkStartX;
+			int localY = tree.m_globalColumn.y - chunkStartY;
+			if (localX >= -TREE_COVER_SIZE_MAX && localX < CHUNK_SIZE_X + TREE_COVER_SIZE_MAX && localY >= -TREE_COVER_SIZE_MAX && localY < CHUNK_SIZE_Y + TREE_COVER_SIZE_MAX)
+			{
+				trees.push_back(tree);
+			}
+		}
+	}
+	if (trees.empty())
+	{
+		return;
+	}
+	std::sort(trees.begin(), trees.end(), [](TreeFeature const& a, TreeFeature const& b)
+		{
+			return (a.m_globalColumn.x != b.m_globalColumn.x) ? (a.m_globalColumn.x < b.m_globalColumn.x) : (a.m_globalColumn.y < b.m_globalColumn.y);
+		});
+
+	BlockTemplate const* treeTemplates[NUM_TREE_TYPES] =
+	{
+		&BlockTemplate::GetBlockTemplateByName("oak"),
+		&BlockTemplate::GetBlockTemplateByName("spruce"),
+		&BlockTemplate::GetBlockTemplateByName("cactus"),
+	};
+	for (TreeFeature const& tree : trees)
+	{
+		IntVec3 treeLocalOrigin = IntVec3(tree.m_globalColumn.x - chunkStartX, tree.m_globalColumn.y - chunkStartY, tree.m_groundHeightZ);
+		for (BlockTemplateEntry const& entry : treeTemplates[tree.m_type]->m_entries)
+		{
+			// if this tree's block is in this chunk's space, rewrite the type
+			IntVec3 entryLocalCoords = treeLocalOrigin + entry.offset;
+			if (chunk->AreTheLocalCoordsInChunk(entryLocalCoords))
+			{
+				chunk->m_blocks[chunk->GetIndexForLocalCoordinates(entryLocalCoords)].SetType(entry.blockType);
+			}
+		}
+	}
+}
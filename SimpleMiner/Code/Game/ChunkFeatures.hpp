@@ -0,0 +1,91 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/Vec3.hpp"
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Chunk;
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// the features stage of chunk generation, the world is split into regions of FEATURE_REGION_SIZE_CHUNKS x FEATURE_REGION_SIZE_CHUNKS chunks
+// a region's biome factors, trees and cave worms are worked out once from noise, whichever worker first needs them, and kept in the cache
+// a chunk copies its biome factors out of the regions and stamps in every tree and cave of the regions around it that reaches into it,
+// so a cave can run through many chunks and every chunk carves its own part of the same worm
+// a region only depends on the world seed and its coords, so it comes out the same on any worker and after being evicted and worked out again
+
+constexpr int FEATURE_REGION_SIZE_CHUNKS = 4;
+constexpr int FEATURE_REGION_SIZE_X = FEATURE_REGION_SIZE_CHUNKS * CHUNK_SIZE_X;
+constexpr int FEATURE_REGION_SIZE_Y = FEATURE_REGION_SIZE_CHUNKS * CHUNK_SIZE_Y;
+constexpr int FEATURE_REGION_COLUMNS = FEATURE_REGION_SIZE_X * FEATURE_REGION_SIZE_Y;
+constexpr int FEATURE_CACHE_MAX_REGIONS = 64; // the least recently used region goes first, about 48 KB each
+
+constexpr float CAVE_SEGMENT_LENGTH = 4.f;
+constexpr float CAVE_TURN_SCALE = 32.f; // blocks along the worm for its heading noise to change a full step
+constexpr int	CAVE_SURFACE_CRUST_BLOCKS = 2; // never carved under a column's surface block, whatever a worm's capsule reaches
+constexpr int	FEATURE_REACH_BLOCKS = int(CAVE_MAX_RADIUS + CAVE_WORM_MAX_RADIUS) + 1; // no feature reaches farther than this from its region
+
+enum TreeType : uint8_t
+{
+	TREE_TYPE_OAK,
+	TREE_TYPE_SPRUCE,
+	TREE_TYPE_CACTUS,
+	NUM_TREE_TYPES
+};
+
+struct TreeFeature
+{
+	IntVec2		m_globalColumn;
+	int			m_groundHeightZ = 0;
+	TreeType	m_type = TREE_TYPE_OAK;
+};
+
+// one capsule of a cave worm, in world block coords
+struct CaveSegment
+{
+	Vec3	m_start;
+	Vec3	m_end;
+	float	m_radius = 0.f;
+};
+
+struct ChunkFeatureRegion
+{
+	IntVec2						m_regionCoords;
+	int							m_terrainHeightZ[FEATURE_REGION_COLUMNS]; // x + y * FEATURE_REGION_SIZE_X from the region's southwest column
+	float						m_humidity[FEATURE_REGION_COLUMNS];
+	float						m_temperature[FEATURE_REGION_COLUMNS];
+	std::vector<TreeFeature>	m_trees; // rooted in this region, sorted by x and then y, the order trees used to be planted in
+	std::vector<CaveSegment>	m_caveSegments; // of the worms starting in this region
+};
+
+class ChunkFeatureCache
+{
+public:
+	// worked out on the calling thread when it is not cached yet, a thread asking for a region another thread is working out waits for it
+	std::shared_ptr<ChunkFeatureRegion const> GetRegion(IntVec2 const& regionCoords);
+	void	Clear();
+	int		GetNumRegions() const;
+
+	static IntVec2	GetRegionCoordsForGlobalColumn(int globalX, int globalY);
+
+private:
+	struct CachedRegion
+	{
+		IntVec2	m_regionCoords;
+		std::shared_future<std::shared_ptr<ChunkFeatureRegion const>>	m_region;
+		uint64_t	m_lastUsed = 0;
+	};
+
+	mutable std::mutex			m_mutex;
+	std::vector<CachedRegion>	m_regions; // few enough that a linear search is fine
+	uint64_t					m_useCounter = 0;
+};
+
+// only reads the world seed and its coords
+void ComputeFeatureRegion(ChunkFeatureRegion& region, unsigned int worldSeed, bool useBatchNoise);
+
+// the chunk's part of the regions, run by the generate job
+void CopyBiomeFactorsFromRegions(Chunk* chunk, ChunkFeatureCache& cache);
+void StampFeaturesIntoChunk(Chunk* chunk, ChunkFeatureCache& cache);
@@ -0,0 +1,507 @@
+#include "Game/ChunkLighting.hpp"
+#include "Game/Chunk.hpp"
+#include "Engine/core/JobSystem.hpp"
+#include <algorithm>
+
+extern JobSystem* g_theJobSystem;
+
+// a block next to the one being spread from, m_border is -1 when it is in the same chunk
+struct LightNeighbor
+{
+	int	m_blockIndex;
+	int	m_border;
+};
+
+static inline uint8_t GetLight(Block const& block, int channel)
+{
+	if (channel == LIGHT_CHANNEL_OUTDOOR)
+	{
+		return (uint8_t)(block.m_blockLighting >> LIGHT_BITS_INDOOR);
+	}
+	return (uint8_t)(block.m_blockLighting & LIGHT_MASK_INDOOR);
+}
+
+static inline void SetLight(Block& block, int channel, uint8_t light)
+{
+	if (channel == LIGHT_CHANNEL_OUTDOOR)
+	{
+		block.m_blockLighting = (uint8_t)((block.m_blockLighting & LIGHT_MASK_INDOOR) | (light << LIGHT_BITS_INDOOR));
+	}
+	else
+	{
+		block.m_blockLighting = (uint8_t)((block.m_blockLighting & LIGHT_MASK_OUTDOOR) | light);
+	}
+}
+
+// the light the block gives off by itself, the same rule as World::ProcessNextDirtyLightBlock
+static inline uint8_t GetSourceLight(Block const& block, int channel)
+{
+	if (channel == LIGHT_CHANNEL_OUTDOOR)
+	{
+		return block.IsBlockSky() ? (uint8_t)MAX_LIGHT_VALUE : (uint8_t)0;
+	}
+	return BlockDef::s_indoorLightByType[block.m_blockDefIndex];
+}
+
+static inline int GetOppositeBorder(int border)
+{
+	return border ^ 1; // east <-> west, north <-> south
+}
+
+static int GetLightNeighbors(int blockIndex, LightNeighbor out_neighbors[6])
+{
+	int x = blockIndex & CHUNK_MASK_X;
+	int y = (blockIndex & CHUNK_MASK_Y) >> CHUNK_BITSHIFT_Y;
+	int z = blockIndex >> CHUNK_BITSHIFT_Z;
+	int numNeighbors = 0;
+
+	out_neighbors[numNeighbors++] = (x < CHUNK_SIZE_X - 1) ? LightNeighbor{ blockIndex + 1, -1 } : LightNeighbor{ blockIndex & ~CHUNK_MASK_X, CHUNK_BORDER_EAST };
+	out_neighbors[numNeighbors++] = (x > 0) ? LightNeighbor{ blockIndex - 1, -1 } : LightNeighbor{ blockIndex | CHUNK_MASK_X, CHUNK_BORDER_WEST };
+	out_neighbors[numNeighbors++] = (y < CHUNK_SIZE_Y - 1) ? LightNeighbor{ blockIndex + CHUNK_SIZE_X, -1 } : LightNeighbor{ blockIndex & ~CHUNK_MASK_Y, CHUNK_BORDER_NORTH };
+	out_neighbors[numNeighbors++] = (y > 0) ? LightNeighbor{ blockIndex - CHUNK_SIZE_X, -1 } : LightNeighbor{ blockIndex | CHUNK_MASK_Y, CHUNK_BORDER_SOUTH };
+	if (z < CHUNK_SIZE_Z - 1)
+	{
+		out_neighbors[numNeighbors++] = LightNeighbor{ blockIndex + CHUNK_BLOCKS_PER_LAYER, -1 };
+	}
+	if (z > 0)
+	{
+		out_neighbors[numNeighbors++] = LightNeighbor{ blockIndex - CHUNK_BLOCKS_PER_LAYER, -1 };
+	}
+	return numNeighbors;
+}
+
+// the section of the block, the one next to it when the block is on its top or bottom layer,
+// and the same sections of the neighbor chunk when the block is on the chunk edge
+static void RecordLightChange(ChunkLightQueues& queues, int blockIndex)
+{
+	int z = blockIndex >> CHUNK_BITSHIFT_Z;
+	int sectionIndex = z >> CHUNK_SECTION_BITS_Z;
+	int sectionZ = z & (CHUNK_SECTION_SIZE_Z - 1);
+	uint32_t sections = 1u << sectionIndex;
+	if (sectionZ == 0 && sectionIndex > 0)
+	{
+		sections |= 1u << (sectionIndex - 1);
+	}
+	if (sectionZ == CHUNK_SECTION_SIZE_Z - 1 && sectionIndex < CHUNK_NUM_SECTIONS - 1)
+	{
+		sections |= 1u << (sectionIndex + 1);
+	}
+	queues.m_meshDirtySections |= sections;
+
+	int x = blockIndex & CHUNK_MASK_X;
+	int y = (blockIndex & CHUNK_MASK_Y) >> CHUNK_BITSHIFT_Y;
+	if (x == CHUNK_SIZE_X - 1)
+	{
+		queues.m_neighborMeshDirtySections[CHUNK_BORDER_EAST] |= sections;
+	}
+	else if (x == 0)
+	{
+		queues.m_neighborMeshDirtySections[CHUNK_BORDER_WEST] |= sections;
+	}
+	if (y == CHUNK_SIZE_Y - 1)
+	{
+		queues.m_neighborMeshDirtySections[CHUNK_BORDER_NORTH] |= sections;
+	}
+	else if (y == 0)
+	{
+		queues.m_neighborMeshDirtySections[CHUNK_BORDER_SOUTH] |= sections;
+	}
+}
+
+// light coming in from a block next to this one
+static void SpreadLightToBlock(ChunkLightQueues& queues, Block* blocks, int blockIndex, uint8_t light, int channel)
+{
+	Block& block = blocks[blockIndex];
+	if (block.IsOpaque() || GetLight(block, channel) >= light)
+	{
+		return;
+	}
+	SetLight(block, channel, light);
+	RecordLightChange(queues, blockIndex);
+	queues.m_addBuckets[channel][light].push_back(blockIndex);
+}
+
+// a block next to this one used to have oldLight, anything dimmer may have been lit by it and is taken away,
+// anything at least as bright is lit from somewhere else and spreads again in the add pass
+static void SpreadRemovalToBlock(ChunkLightQueues& queues, Block* blocks, int blockIndex, uint8_t oldLight, int channel)
+{
+	Block& block = blocks[blockIndex];
+	uint8_t light = GetLight(block, channel);
+	if (light == 0)
+	{
+		return;
+	}
+
+	if (light < oldLight && !block.IsOpaque())
+	{
+		uint8_t sourceLight = GetSourceLight(block, channel);
+		SetLight(block, channel, sourceLight);
+		RecordLightChange(queues, blockIndex);
+		queues.m_removals[channel].push_back(LightRemoval{ blockIndex, light });
+		if (sourceLight > 0)
+		{
+			queues.m_addBuckets[channel][sourceLight].push_back(blockIndex);
+		}
+	}
+	else if (light >= oldLight)
+	{
+		queues.m_addBuckets[channel][light].push_back(blockIndex);
+	}
+}
+
+// sky flags top down, then every block gets its own light, the sources go into the add buckets
+// the columns of the open sky above the terrain are all 15 with 15 all around, only the ones on the chunk edge have to spread
+static void InitializeLightSources(Chunk* chunk)
+{
+	ChunkLightQueues& queues = chunk->m_lightQueues;
+	Block* blocks = chunk->m_blocks;
+	int openSkyBottomZ = chunk->GetOpenSkyBottomZ();
+
+	for (int y = 0; y < CHUNK_SIZE_Y; ++y)
+	{
+		for (int x = 0; x < CHUNK_SIZE_X; ++x)
+		{
+			int columnIndex = x | (y << CHUNK_BITSHIFT_Y);
+			bool isEdgeColumn = (x == 0 || x == CHUNK_SIZE_X - 1 || y == 0 || y == CHUNK_SIZE_Y - 1);
+			int skyBottomZ = chunk->GetSkyBottomZ(columnIndex);
+
+			// a sky block only has somewhere to spread where a neighbor column is not sky yet, edge columns spread into the next chunk
+			int outdoorSeedTopZ = CHUNK_SIZE_Z;
+			if (!isEdgeColumn)
+			{
+				outdoorSeedTopZ = chunk->GetSkyBottomZ(columnIndex + 1);
+				outdoorSeedTopZ = std::max(outdoorSeedTopZ, chunk->GetSkyBottomZ(columnIndex - 1));
+				outdoorSeedTopZ = std::max(outdoorSeedTopZ, chunk->GetSkyBottomZ(columnIndex + CHUNK_SIZE_X));
+				outdoorSeedTopZ = std::max(outdoorSeedTopZ, chunk->GetSkyBottomZ(columnIndex - CHUNK_SIZE_X));
+			}
+
+			for (int z = CHUNK_SIZE_Z - 1; z >= 0; --z)
+			{
+				int blockIndex = columnIndex | (z << CHUNK_BITSHIFT_Z);
+				Block& block = blocks[blockIndex];
+				block.SetIsBlockSky(z >= skyBottomZ);
+
+				for (int channel = 0; channel < NUM_LIGHT_CHANNELS; ++channel)
+				{
+					uint8_t sourceLight = GetSourceLight(block, channel);
+					if (GetLight(block, channel) != sourceLight)
+					{
+						SetLight(block, channel, sourceLight);
+						RecordLightChange(queues, blockIndex);
+					}
+					if (sourceLight == 0)
+					{
+						continue;
+					}
+					bool canSpread = (channel == LIGHT_CHANNEL_OUTDOOR) ? (z < outdoorSeedTopZ) : (isEdgeColumn || z < openSkyBottomZ);
+					if (canSpread)
+					{
+						queues.m_addBuckets[channel][sourceLight].push_back(blockIndex);
+					}
+				}
+			}
+		}
+	}
+}
+
+// a neighbor chunk was just activated on these borders, it gets the light of every lit block along them
+static void ExportBorderLight(ChunkLightQueues& queues, Block const* blocks)
+{
+	for (int border = 0; border < NUM_CHUNK_BORDERS; ++border)
+	{
+		if ((queues.m_borderExportMask & (1 << border)) == 0)
+		{
+			continue;
+		}
+
+		for (int z = 0; z < CHUNK_SIZE_Z; ++z)
+		{
+			for (int along = 0; along < CHUNK_SIZE_X; ++along)
+			{
+				int x = along;
+				int y = along;
+				switch (border)
+				{
+				case CHUNK_BORDER_EAST:		x = CHUNK_SIZE_X - 1;	break;
+				case CHUNK_BORDER_WEST:		x = 0;					break;
+				case CHUNK_BORDER_NORTH:	y = CHUNK_SIZE_Y - 1;	break;
+				case CHUNK_BORDER_SOUTH:	y = 0;					break;
+				}
+				int blockIndex = x | (y << CHUNK_BITSHIFT_Y) | (z << CHUNK_BITSHIFT_Z);
+				int neighborBlockIndex = (border == CHUNK_BORDER_EAST || border == CHUNK_BORDER_WEST) ? (blockIndex ^ CHUNK_MASK_X) : (blockIndex ^ CHUNK_MASK_Y);
+				for (int channel = 0; channel < NUM_LIGHT_CHANNELS; ++channel)
+				{
+					uint8_t light = GetLight(blocks[blockIndex], channel);
+					if (light > 1)
+					{
+						queues.m_outbox[border].push_back(LightBorderUpdate{ (uint16_t)neighborBlockIndex, (uint8_t)(light - 1), (uint8_t)channel, false });
+					}
+				}
+			}
+		}
+	}
+	queues.m_borderExportMask = 0;
+}
+
+// the block takes its own light again, whatever it lit before is taken away and lit again from what is left
+static void ReseedDirtyBlock(ChunkLightQueues& queues, Block* blocks, int blockIndex)
+{
+	Block& block = blocks[blockIndex];
+	for (int channel = 0; channel < NUM_LIGHT_CHANNELS; ++channel)
+	{
+		uint8_t oldLight = GetLight(block, channel);
+		uint8_t sourceLight = GetSourceLight(block, channel);
+		if (oldLight != sourceLight)
+		{
+			SetLight(block, channel, sourceLight);
+			RecordLightChange(queues, blockIndex);
+		}
+		queues.m_removals[channel].push_back(LightRemoval{ blockIndex, oldLight });
+		if (sourceLight > 0)
+		{
+			queues.m_addBuckets[channel][sourceLight].push_back(blockIndex);
+		}
+	}
+}
+
+// first in first out, the queue grows while it is walked
+static void RunRemovalPass(ChunkLightQueues& queues, Block* blocks, int channel)
+{
+	std::vector<LightRemoval>& removals = queues.m_removals[channel];
+	LightNeighbor neighbors[6];
+	for (size_t removalIndex = 0; removalIndex < removals.size(); ++removalIndex)
+	{
+		LightRemoval removal = removals[removalIndex]; // a copy, pushing may move the vector
+		int numNeighbors = GetLightNeighbors(removal.m_blockIndex, neighbors);
+		for (int neighborIndex = 0; neighborIndex < numNeighbors; ++neighborIndex)
+		{
+			LightNeighbor const& neighbor = neighbors[neighborIndex];
+			if (neighbor.m_border < 0)
+			{
+				SpreadRemovalToBlock(queues, blocks, neighbor.m_blockIndex, removal.m_oldLight, channel);
+			}
+			else
+			{
+				queues.m_outbox[neighbor.m_border].push_back(LightBorderUpdate{ (uint16_t)neighbor.m_blockIndex, removal.m_oldLight, (uint8_t)channel, true });
+			}
+		}
+	}
+	removals.clear();
+}
+
+// brightest bucket first, a block spreads only to the bucket one below, so every bucket is complete by the time it is walked
+// an entry whose block has changed since it was pushed is stale and skipped
+static void RunAddPass(ChunkLightQueues& queues, Block* blocks, int channel)
+{
+	LightNeighbor neighbors[6];
+	for (int light = MAX_LIGHT_VALUE; light > 0; --light)
+	{
+		std::vector<int>& bucket = queues.m_addBuckets[channel][light];
+		uint8_t spreadLight = (uint8_t)(light - 1);
+		for (size_t entryIndex = 0; spreadLight > 0 && entryIndex < bucket.size(); ++entryIndex)
+		{
+			int blockIndex = bucket[entryIndex];
+			if (GetLight(blocks[blockIndex], channel) != light)
+			{
+				continue;
+			}
+
+			int numNeighbors = GetLightNeighbors(blockIndex, neighbors);
+			for (int neighborIndex = 0; neighborIndex < numNeighbors; ++neighborIndex)
+			{
+				LightNeighbor const& neighbor = neighbors[neighborIndex];
+				if (neighbor.m_border < 0)
+				{
+					SpreadLightToBlock(queues, blocks, neighbor.m_blockIndex, spreadLight, channel);
+				}
+				else
+				{
+					queues.m_outbox[neighbor.m_border].push_back(LightBorderUpdate{ (uint16_t)neighbor.m_blockIndex, spreadLight, (uint8_t)channel, false });
+				}
+			}
+		}
+		bucket.clear();
+	}
+}
+
+void PropagateLightInChunk(Chunk* chunk)
+{
+	ChunkLightQueues& queues = chunk->m_lightQueues;
+	Block* blocks = chunk->m_blocks;
+
+	if (queues.m_needsInitialization)
+	{
+		InitializeLightSources(chunk);
+		queues.m_needsInitialization = false;
+	}
+	if (queues.m_borderExportMask != 0)
+	{
+		ExportBorderLight(queues, blocks);
+	}
+	for (int dirtyIndex = 0; dirtyIndex < (int)queues.m_dirtyBlocks.size(); ++dirtyIndex)
+	{
+		ReseedDirtyBlock(queues, blocks, queues.m_dirtyBlocks[dirtyIndex]);
+	}
+	queues.m_dirtyBlocks.clear();
+
+	for (int channel = 0; channel < NUM_LIGHT_CHANNELS; ++channel)
+	{
+		RunRemovalPass(queues, blocks, channel);
+		RunAddPass(queues, blocks, channel);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+void ChunkLightQueues::Clear()
+{
+	m_isQueued = false;
+	m_needsInitialization = false;
+	m_borderExportMask = 0;
+	m_dirtyBlocks.clear();
+	for (int channel = 0; channel < NUM_LIGHT_CHANNELS; ++channel)
+	{
+		m_removals[channel].clear();
+		for (int light = 0; light <= MAX_LIGHT_VALUE; ++light)
+		{
+			m_addBuckets[channel][light].clear();
+		}
+	}
+	for (int border = 0; border < NUM_CHUNK_BORDERS; ++border)
+	{
+		m_outbox[border].clear();
+		m_neighborMeshDirtySections[border] = 0;
+	}
+	m_meshDirtySections = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+void ChunkLightPropagator::InitializeChunk(Chunk* chunk)
+{
+	chunk->m_lightQueues.m_needsInitialization = true;
+	QueueChunk(chunk);
+
+	Chunk* neighbors[NUM_CHUNK_BORDERS] = { chunk->m_eastNeighbor, chunk->m_westNeighbor, chunk->m_northNeighbor, chunk->m_southNeighbor };
+	for (int border = 0; border < NUM_CHUNK_BORDERS; ++border)
+	{
+		if (neighbors[border])
+		{
+			neighbors[border]->m_lightQueues.m_borderExportMask |= (uint8_t)(1 << GetOppositeBorder(border));
+			QueueChunk(neighbors[border]);
+		}
+	}
+}
+
+void ChunkLightPropagator::MarkBlockLightDirty(Chunk* chunk, int blockIndex)
+{
+	chunk->m_lightQueues.m_dirtyBlocks.push_back(blockIndex);
+	QueueChunk(chunk);
+}
+
+// the outboxes are always empty between two calls of Propagate, so no other chunk holds light for this one
+void ChunkLightPropagator::RemoveChunk(Chunk* chunk)
+{
+	if (chunk->m_lightQueues.m_isQueued)
+	{
+		m_chunksWithWork.erase(std::remove(m_chunksWithWork.begin(), m_chunksWithWork.end(), chunk), m_chunksWithWork.end());
+	}
+	chunk->m_lightQueues.Clear();
+}
+
+int ChunkLightPropagator::Propagate(int maxRounds)
+{
+	int numRounds = 0;
+	while (!m_chunksWithWork.empty() && numRounds < maxRounds)
+	{
+		m_roundChunks.swap(m_chunksWithWork);
+		m_chunksWithWork.clear();
+		for (int chunkIndex = 0; chunkIndex < (int)m_roundChunks.size(); ++chunkIndex)
+		{
+			m_roundChunks[chunkIndex]->m_lightQueues.m_isQueued = false;
+			m_roundChunks[chunkIndex]->ExpandBlocks();
+		}
+
+		g_theJobSystem->ParallelFor(0, (int)m_roundChunks.size(), 1, [this](int beginIndex, int endIndex)
+			{
+				for (int chunkIndex = beginIndex; chunkIndex < endIndex; ++chunkIndex)
+				{
+					PropagateLightInChunk(m_roundChunks[chunkIndex]);
+				}
+			});
+
+		// in list order, so the same chunks and edits always end with the same light
+		for (int chunkIndex = 0; chunkIndex < (int)m_roundChunks.size(); ++chunkIndex)
+		{
+			HandOverBorderUpdates(m_roundChunks[chunkIndex]);
+			MarkLitSectionsMeshDirty(m_roundChunks[chunkIndex]);
+		}
+		m_roundChunks.clear();
+		++numRounds;
+	}
+	return numRounds;
+}
+
+void ChunkLightPropagator::QueueChunk(Chunk* chunk)
+{
+	if (!chunk->m_lightQueues.m_isQueued)
+	{
+		chunk->m_lightQueues.m_isQueued = true;
+		m_chunksWithWork.push_back(chunk);
+	}
+}
+
+// a border with no chunk behind it drops its updates, the chunk asks for them again when it is activated
+void ChunkLightPropagator::HandOverBorderUpdates(Chunk* chunk)
+{
+	Chunk* neighbors[NUM_CHUNK_BORDERS] = { chunk->m_eastNeighbor, chunk->m_westNeighbor, chunk->m_northNeighbor, chunk->m_southNeighbor };
+	for (int border = 0; border < NUM_CHUNK_BORDERS; ++border)
+	{
+		std::vector<LightBorderUpdate>& outbox = chunk->m_lightQueues.m_outbox[border];
+		Chunk* neighbor = neighbors[border];
+		if (neighbor && !outbox.empty())
+		{
+			neighbor->ExpandBlocks();
+			ChunkLightQueues& neighborQueues = neighbor->m_lightQueues;
+			for (int updateIndex = 0; updateIndex < (int)outbox.size(); ++updateIndex)
+			{
+				LightBorderUpdate const& update = outbox[updateIndex];
+				if (update.m_isRemoval)
+				{
+					SpreadRemovalToBlock(neighborQueues, neighbor->m_blocks, update.m_blockIndex, update.m_light, update.m_channel);
+				}
+				else
+				{
+					SpreadLightToBlock(neighborQueues, neighbor->m_blocks, update.m_blockIndex, update.m_light, update.m_channel);
+				}
+			}
+			QueueChunk(neighbor);
+		}
+		outbox.clear();
+	}
+}
+
+void ChunkLightPropagator::MarkLitSectionsMeshDirty(Chunk* chunk)
+{
+	ChunkLightQueues& queues = chunk->m_lightQueues;
+	Chunk* neighbors[NUM_CHUNK_BORDERS] = { chunk->m_eastNeighbor, chunk->m_westNeighbor, chunk->m_northNeighbor, chunk->m_southNeighbor };
+	for (int sectionIndex = 0; sectionIndex < CHUNK_NUM_SECTIONS; ++sectionIndex)
+	{
+		uint32_t sectionBit = 1u << sectionIndex;
+		if (queues.m_meshDirtySections & sectionBit)
+		{
+			chunk->m_sections[sectionIndex].m_isMeshDirty = true;
+		}
+		for (int border = 0; border < NUM_CHUNK_BORDERS; ++border)
+		{
+			if (neighbors[border] && (queues.m_neighborMeshDirtySections[border] & sectionBit))
+			{
+				neighbors[border]->m_sections[sectionIndex].m_isMeshDirty = true;
+			}
+		}
+	}
+
+	queues.m_meshDirtySections = 0;
+	for (int border = 0; border < NUM_CHUNK_BORDERS; ++border)
+	{
+		queues.m_neighborMeshDirtySections[border] = 0;
+	}
+}
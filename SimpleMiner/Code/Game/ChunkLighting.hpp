@@ -0,0 +1,87 @@
+#pragma once
+#include "Game/Block.hpp"
+#include "Game/GameCommon.hpp"
+#include <vector>
+
+class Chunk;
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// wavefront voxel lighting, outdoor and indoor light are two channels spread the same way:
+// a sky block is an outdoor source of 15, an emissive block an indoor source of its def's light, and light only spreads into non-opaque blocks
+// every chunk with light work runs a removal pass and then an add pass over its own blocks on a job worker,
+// the add pass takes the blocks one light level at a time from 15 down, so every block is spread from once with its final value
+// light leaving the chunk goes to an outbox, the main thread hands it to the neighbor between rounds and the neighbor runs again next round
+// it ends with the light the per block rule of World::ProcessNextDirtyLightBlock settles on once every block is settled, see LightingBenchmark
+
+enum LightChannel
+{
+	LIGHT_CHANNEL_OUTDOOR,
+	LIGHT_CHANNEL_INDOOR,
+	NUM_LIGHT_CHANNELS
+};
+
+// the same order as the neighbor pointers everywhere else
+enum ChunkBorder
+{
+	CHUNK_BORDER_EAST,	// +x
+	CHUNK_BORDER_WEST,	// -x
+	CHUNK_BORDER_NORTH,	// +y
+	CHUNK_BORDER_SOUTH,	// -y
+	NUM_CHUNK_BORDERS
+};
+
+constexpr int MAX_LIGHT_PROPAGATION_ROUNDS_PER_FRAME = 16; // whatever is left keeps its place in the list for next frame
+
+struct LightRemoval
+{
+	int		m_blockIndex;
+	uint8_t	m_oldLight;
+};
+
+// light crossing the border, m_blockIndex is in the neighbor chunk
+struct LightBorderUpdate
+{
+	uint16_t	m_blockIndex;
+	uint8_t		m_light; // the light offered to the block, or the light it may have had from us for a removal
+	uint8_t		m_channel;
+	bool		m_isRemoval;
+};
+
+// one per chunk, during a round only the chunk's own job touches it
+struct ChunkLightQueues
+{
+	void Clear();
+
+	bool		m_isQueued = false; // in the propagator's list of chunks with light work
+	bool		m_needsInitialization = false; // sky flags and light sources are set by the first job after the chunk is activated
+	uint8_t		m_borderExportMask = 0; // a neighbor was activated on these borders, the lit border blocks are handed to it again
+	std::vector<int>				m_dirtyBlocks; // blocks whose own light may have changed: dug, placed or a sky flag set or cleared
+	std::vector<LightRemoval>		m_removals[NUM_LIGHT_CHANNELS];
+	std::vector<int>				m_addBuckets[NUM_LIGHT_CHANNELS][MAX_LIGHT_VALUE + 1]; // bucket L holds blocks just set to L
+	std::vector<LightBorderUpdate>	m_outbox[NUM_CHUNK_BORDERS];
+	uint32_t	m_meshDirtySections = 0; // sections whose light changed, the main thread marks them after the round
+	uint32_t	m_neighborMeshDirtySections[NUM_CHUNK_BORDERS] = {};
+};
+
+class ChunkLightPropagator
+{
+public:
+	void	InitializeChunk(Chunk* chunk); // just activated, its neighbors are already linked
+	void	MarkBlockLightDirty(Chunk* chunk, int blockIndex);
+	void	RemoveChunk(Chunk* chunk); // before the chunk is deactivated
+	bool	HasWork() const { return !m_chunksWithWork.empty(); }
+
+	// rounds of one job per chunk until there is no light work left, returns how many rounds were run
+	int		Propagate(int maxRounds);
+
+private:
+	void	QueueChunk(Chunk* chunk);
+	void	HandOverBorderUpdates(Chunk* chunk);
+	void	MarkLitSectionsMeshDirty(Chunk* chunk);
+
+	std::vector<Chunk*> m_chunksWithWork;
+	std::vector<Chunk*> m_roundChunks;
+};
+
+// runs on a job worker, only reads and writes the chunk's own blocks and light queues
+void PropagateLightInChunk(Chunk* chunk);
@@ -0,0 +1,257 @@
+#include "Game/ChunkMesher.hpp"
+#include "Game/Chunk.hpp"
+#include <cstring>
+
+enum BlockFaceTile
+{
+	BLOCK_FACE_TILE_TOP,
+	BLOCK_FACE_TILE_SIDE,
+	BLOCK_FACE_TILE_BOTTOM,
+	NUM_BLOCK_FACE_TILES
+};
+
+// how a face's slice of the chunk is walked: the mask is over axes a and b, u runs along a and v along b,
+// the signs keep the texture the same way up as the old per block quads
+struct BlockFaceAxes
+{
+	int		m_normalAxis;
+	int		m_aAxis;
+	int		m_bAxis;
+	int		m_normalStep;
+	bool	m_isUAlongPositiveA;
+	bool	m_isVAlongPositiveB;
+	int		m_tile;
+};
+
+static BlockFaceAxes const s_blockFaceAxes[NUM_BLOCK_FACES] =
+{
+	{ 0, 1, 2,  1, true,  true,  BLOCK_FACE_TILE_SIDE },	// east
+	{ 0, 1, 2, -1, false, true,  BLOCK_FACE_TILE_SIDE },	// west
+	{ 1, 0, 2,  1, false, true,  BLOCK_FACE_TILE_SIDE },	// north
+	{ 1, 0, 2, -1, true,  true,  BLOCK_FACE_TILE_SIDE },	// south
+	{ 2, 0, 1,  1, true,  true,  BLOCK_FACE_TILE_TOP },		// top
+	{ 2, 0, 1, -1, true,  false, BLOCK_FACE_TILE_BOTTOM },	// bottom
+};
+
+static std::vector<uint16_t> s_blockFaceSpriteIndices; // NUM_BLOCK_FACE_TILES per block def
+
+struct GreedyQuad
+{
+	uint8_t		m_face;
+	uint8_t		m_slice;
+	uint8_t		m_a;
+	uint8_t		m_b;
+	uint8_t		m_width;
+	uint8_t		m_height;
+	uint32_t	m_faceKey;
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+void InitializeChunkMesherBlockTiles()
+{
+	int numBlockDefs = (int)BlockDef::s_BlockDefs.size();
+	s_blockFaceSpriteIndices.resize(numBlockDefs * NUM_BLOCK_FACE_TILES);
+	for (int defIndex = 0; defIndex < numBlockDefs; ++defIndex)
+	{
+		BlockDef const& def = BlockDef::s_BlockDefs[defIndex];
+		IntVec2 spriteCoords[NUM_BLOCK_FACE_TILES] = { def.m_topSpriteCoords, def.m_sideSpriteCoords, def.m_bottomSpriteCoords };
+		for (int tile = 0; tile < NUM_BLOCK_FACE_TILES; ++tile)
+		{
+			// invisible defs are never meshed, their sprite coords are not designated
+			int spriteIndex = def.m_isVisible ? (spriteCoords[tile].x + spriteCoords[tile].y * VOXEL_SPRITE_SHEET_CELLS) : 0;
+			s_blockFaceSpriteIndices[defIndex * NUM_BLOCK_FACE_TILES + tile] = (uint16_t)spriteIndex;
+		}
+	}
+}
+
+// a compacted neighbor is read through its palette, meshing next to it does not expand it
+static Block GetNeighborBlockForMeshing(Chunk const* neighbor, int blockIndex, Block const& missingNeighborBlock)
+{
+	if (!neighbor)
+	{
+		return missingNeighborBlock;
+	}
+	if (neighbor->IsCompacted())
+	{
+		return neighbor->m_palettedBlocks->GetBlock(blockIndex);
+	}
+	return neighbor->m_blocks[blockIndex];
+}
+
+void CopySectionBlocksForMeshing(Chunk* chunk, int sectionIndex, Block* out_snapshot)
+{
+	chunk->ExpandBlocks();
+
+	Block missingNeighborBlock;
+	missingNeighborBlock.SetVisibility(true);
+	std::fill(out_snapshot, out_snapshot + MESH_SNAPSHOT_BLOCKS_TOTAL, missingNeighborBlock);
+
+	int sectionBottomZ = sectionIndex * CHUNK_SECTION_SIZE_Z;
+	for (int snapshotZ = -1; snapshotZ <= CHUNK_SECTION_SIZE_Z; ++snapshotZ)
+	{
+		int z = sectionBottomZ + snapshotZ;
+		if (z < 0 || z >= CHUNK_SIZE_Z)
+		{
+			continue; // nothing is above the top or below the bottom of the world, those faces are never drawn
+		}
+		for (int y = 0; y < CHUNK_SIZE_Y; ++y)
+		{
+			int blockIndex = (z << CHUNK_BITSHIFT_Z) | (y << CHUNK_BITSHIFT_Y);
+			memcpy(out_snapshot + GetMeshSnapshotIndex(0, y, snapshotZ), chunk->m_blocks + blockIndex, CHUNK_SIZE_X * sizeof(Block));
+
+			// the neighbor's column touching this chunk
+			out_snapshot[GetMeshSnapshotIndex(CHUNK_SIZE_X, y, snapshotZ)] = GetNeighborBlockForMeshing(chunk->m_eastNeighbor, blockIndex, missingNeighborBlock);
+			out_snapshot[GetMeshSnapshotIndex(-1, y, snapshotZ)] = GetNeighborBlockForMeshing(chunk->m_westNeighbor, blockIndex | CHUNK_MASK_X, missingNeighborBlock);
+		}
+		for (int x = 0; x < CHUNK_SIZE_X; ++x)
+		{
+			int blockIndex = (z << CHUNK_BITSHIFT_Z) | x;
+			out_snapshot[GetMeshSnapshotIndex(x, CHUNK_SIZE_Y, snapshotZ)] = GetNeighborBlockForMeshing(chunk->m_northNeighbor, blockIndex, missingNeighborBlock);
+			out_snapshot[GetMeshSnapshotIndex(x, -1, snapshotZ)] = GetNeighborBlockForMeshing(chunk->m_southNeighbor, blockIndex | CHUNK_MASK_Y, missingNeighborBlock);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// every face of one slice goes into the mask as (sprite index | neighbor lighting << 12) + 1, 0 is no face,
+// then the mask is eaten row by row: a quad grows along a as long as the key is the same, then along b as long as whole rows are
+static void AddGreedyQuadsForFaceSlice(Block const* snapshot, int face, int slice, uint32_t* mask, std::vector<GreedyQuad>& quads)
+{
+	BlockFaceAxes const& axes = s_blockFaceAxes[face];
+	int const axisSizes[3] = { CHUNK_SIZE_X, CHUNK_SIZE_Y, CHUNK_SECTION_SIZE_Z };
+	int const snapshotStrides[3] = { 1, MESH_SNAPSHOT_SIZE_X, MESH_SNAPSHOT_BLOCKS_PER_LAYER };
+	int sizeA = axisSizes[axes.m_aAxis];
+	int sizeB = axisSizes[axes.m_bAxis];
+	int strideA = snapshotStrides[axes.m_aAxis];
+	int strideB = snapshotStrides[axes.m_bAxis];
+	int neighborOffset = axes.m_normalStep * snapshotStrides[axes.m_normalAxis];
+	int sliceStart = GetMeshSnapshotIndex(0, 0, 0) + slice * snapshotStrides[axes.m_normalAxis];
+
+	int numFaces = 0;
+	for (int b = 0; b < sizeB; ++b)
+	{
+		for (int a = 0; a < sizeA; ++a)
+		{
+			int snapshotIndex = sliceStart + a * strideA + b * strideB;
+			Block const& block = snapshot[snapshotIndex];
+			Block const& neighbor = snapshot[snapshotIndex + neighborOffset];
+			uint32_t faceKey = 0;
+			if ((block.m_blockBitFlags & BLOCK_BIT_MASK_IS_VISIBLE) && !(neighbor.m_blockBitFlags & BLOCK_BIT_MASK_IS_VISIBLE))
+			{
+				uint32_t spriteIndex = s_blockFaceSpriteIndices[block.m_blockDefIndex * NUM_BLOCK_FACE_TILES + axes.m_tile];
+				faceKey = (spriteIndex | ((uint32_t)neighbor.m_blockLighting << 12)) + 1;
+				++numFaces;
+			}
+			mask[a + b * sizeA] = faceKey;
+		}
+	}
+	if (numFaces == 0)
+	{
+		return;
+	}
+
+	for (int b = 0; b < sizeB; ++b)
+	{
+		for (int a = 0; a < sizeA;)
+		{
+			uint32_t faceKey = mask[a + b * sizeA];
+			if (faceKey == 0)
+			{
+				++a;
+				continue;
+			}
+
+			int width = 1;
+			while (a + width < sizeA && mask[a + width + b * sizeA] == faceKey)
+			{
+				++width;
+			}
+
+			int height = 1;
+			bool canGrow = true;
+			while (b + height < sizeB && canGrow)
+			{
+				uint32_t const* row = mask + (b + height) * sizeA;
+				for (int i = 0; i < width; ++i)
+				{
+					if (row[a + i] != faceKey)
+					{
+						canGrow = false;
+						break;
+					}
+				}
+				if (canGrow)
+				{
+					++height;
+				}
+			}
+
+			for (int j = 0; j < height; ++j)
+			{
+				memset(mask + a + (b + j) * sizeA, 0, width * sizeof(uint32_t));
+			}
+
+			GreedyQuad quad;
+			quad.m_face = (uint8_t)face;
+			quad.m_slice = (uint8_t)slice;
+			quad.m_a = (uint8_t)a;
+			quad.m_b = (uint8_t)b;
+			quad.m_width = (uint8_t)width;
+			quad.m_height = (uint8_t)height;
+			quad.m_faceKey = faceKey - 1;
+			quads.push_back(quad);
+			a += width;
+		}
+	}
+}
+
+void BuildGreedySectionMesh(Block const* snapshot, int sectionIndex, std::vector<Vertex_Voxel>& out_verts)
+{
+	int const axisSizes[3] = { CHUNK_SIZE_X, CHUNK_SIZE_Y, CHUNK_SECTION_SIZE_Z };
+	uint32_t mask[CHUNK_BLOCKS_PER_LAYER]; // the biggest slice, a section is as high as it is wide
+	static_assert(CHUNK_SECTION_SIZE_Z <= CHUNK_SIZE_X && CHUNK_SECTION_SIZE_Z <= CHUNK_SIZE_Y, "a vertical slice of a section has to fit in the mask");
+	std::vector<GreedyQuad> quads;
+	quads.reserve(1024);
+
+	for (int face = 0; face < NUM_BLOCK_FACES; ++face)
+	{
+		BlockFaceAxes const& axes = s_blockFaceAxes[face];
+		int numSlices = axisSizes[axes.m_normalAxis];
+		for (int slice = 0; slice < numSlices; ++slice)
+		{
+			AddGreedyQuadsForFaceSlice(snapshot, face, slice, mask, quads);
+		}
+	}
+
+	// the same corners and triangles as AddVertsForQuad3D: BL BR TR, BL TR TL
+	int const cornerU[6] = { 0, 1, 1, 0, 1, 0 };
+	int const cornerV[6] = { 0, 0, 1, 0, 1, 1 };
+	int sectionBottomZ = sectionIndex * CHUNK_SECTION_SIZE_Z;
+	out_verts.resize(quads.size() * 6);
+	Vertex_Voxel* vert = out_verts.data();
+	for (int quadIndex = 0; quadIndex < (int)quads.size(); ++quadIndex)
+	{
+		GreedyQuad const& quad = quads[quadIndex];
+		BlockFaceAxes const& axes = s_blockFaceAxes[quad.m_face];
+		uint32_t spriteIndex = quad.m_faceKey & 0xFFF;
+		uint32_t lighting = quad.m_faceKey >> 12;
+		uint32_t outdoorLight = (lighting & LIGHT_MASK_OUTDOOR) >> LIGHT_BITS_INDOOR;
+		uint32_t indoorLight = lighting & LIGHT_MASK_INDOOR;
+		uint32_t faceBits = ((uint32_t)quad.m_face << VOXEL_POSITION_SHIFT_FACE) | (outdoorLight << VOXEL_POSITION_SHIFT_OUTDOOR_LIGHT) | (indoorLight << VOXEL_POSITION_SHIFT_INDOOR_LIGHT);
+
+		int position[3];
+		position[axes.m_normalAxis] = quad.m_slice + (axes.m_normalStep > 0 ? 1 : 0);
+		for (int corner = 0; corner < 6; ++corner)
+		{
+			int u = cornerU[corner] * quad.m_width;
+			int v = cornerV[corner] * quad.m_height;
+			position[axes.m_aAxis] = axes.m_isUAlongPositiveA ? (quad.m_a + u) : (quad.m_a + quad.m_width - u);
+			position[axes.m_bAxis] = axes.m_isVAlongPositiveB ? (quad.m_b + v) : (quad.m_b + quad.m_height - v);
+			int chunkZ = position[2] + sectionBottomZ;
+
+			vert->m_packedPosition = (uint32_t)position[0] | ((uint32_t)position[1] << VOXEL_POSITION_SHIFT_Y) | ((uint32_t)chunkZ << VOXEL_POSITION_SHIFT_Z) | faceBits;
+			vert->m_packedTexture = (uint32_t)u | ((uint32_t)v << VOXEL_TEXTURE_SHIFT_V) | (spriteIndex << VOXEL_TEXTURE_SHIFT_SPRITE);
+			++vert;
+		}
+	}
+}
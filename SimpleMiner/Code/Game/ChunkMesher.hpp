@@ -0,0 +1,58 @@
+#pragma once
+#include "Game/Block.hpp"
+#include "Game/GameCommon.hpp"
+#include "Engine/core/Vertex_Voxel.hpp"
+#include <vector>
+
+class Chunk;
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// greedy chunk meshing, every face between a visible block and an invisible one is kept like the old mesher does,
+// then coplanar faces with the same tile and the same light are merged into one quad
+// every 16 high section of a chunk is meshed on its own, from a copy of the section with a one block border all around
+// (the four neighbor chunks and the sections above and below), so the mesher never follows a neighbor pointer
+
+// the copy is (CHUNK_SIZE_X + 2) x (CHUNK_SIZE_Y + 2) x (CHUNK_SECTION_SIZE_Z + 2), local x, y and z go from -1 to the size
+constexpr int MESH_SNAPSHOT_SIZE_X = CHUNK_SIZE_X + 2;
+constexpr int MESH_SNAPSHOT_SIZE_Y = CHUNK_SIZE_Y + 2;
+constexpr int MESH_SNAPSHOT_SIZE_Z = CHUNK_SECTION_SIZE_Z + 2;
+constexpr int MESH_SNAPSHOT_BLOCKS_PER_LAYER = MESH_SNAPSHOT_SIZE_X * MESH_SNAPSHOT_SIZE_Y;
+constexpr int MESH_SNAPSHOT_BLOCKS_TOTAL = MESH_SNAPSHOT_BLOCKS_PER_LAYER * MESH_SNAPSHOT_SIZE_Z;
+
+// Vertex_Voxel bits, the world shader unpacks the same layout
+// m_packedPosition: x 5 | y 5 | z 8 | face 3 | outdoor light 4 | indoor light 4, the position is local to the chunk
+// m_packedTexture:  u 8 | v 8 | sprite index 12, u and v count blocks across the merged quad so the tile repeats
+constexpr int VOXEL_POSITION_SHIFT_Y = 5;
+constexpr int VOXEL_POSITION_SHIFT_Z = 10;
+constexpr int VOXEL_POSITION_SHIFT_FACE = 18;
+constexpr int VOXEL_POSITION_SHIFT_OUTDOOR_LIGHT = 21;
+constexpr int VOXEL_POSITION_SHIFT_INDOOR_LIGHT = 25;
+constexpr int VOXEL_TEXTURE_SHIFT_V = 8;
+constexpr int VOXEL_TEXTURE_SHIFT_SPRITE = 16;
+constexpr int VOXEL_SPRITE_SHEET_CELLS = 64; // the same sprite sheet every BlockDef is created with
+
+enum BlockFace
+{
+	BLOCK_FACE_EAST,	// +x
+	BLOCK_FACE_WEST,	// -x
+	BLOCK_FACE_NORTH,	// +y
+	BLOCK_FACE_SOUTH,	// -y
+	BLOCK_FACE_TOP,		// +z
+	BLOCK_FACE_BOTTOM,	// -z
+	NUM_BLOCK_FACES
+};
+
+inline int GetMeshSnapshotIndex(int localX, int localY, int localZ)
+{
+	return (localX + 1) + (localY + 1) * MESH_SNAPSHOT_SIZE_X + (localZ + 1) * MESH_SNAPSHOT_BLOCKS_PER_LAYER;
+}
+
+// sprite index of every face of every block def, built once after the block defs are
+void InitializeChunkMesherBlockTiles();
+
+// out_snapshot holds MESH_SNAPSHOT_BLOCKS_TOTAL blocks, a missing neighbor is filled with visible blocks so no face points at it,
+// and so is the layer above the top of the world and below the bottom of it
+void CopySectionBlocksForMeshing(Chunk* chunk, int sectionIndex, Block* out_snapshot);
+
+// out_verts is resized to exactly 6 verts per merged quad, their positions are local to the chunk, not the section
+void BuildGreedySectionMesh(Block const* snapshot, int sectionIndex, std::vector<Vertex_Voxel>& out_verts);
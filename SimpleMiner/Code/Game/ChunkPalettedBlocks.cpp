@@ -0,0 +1,146 @@
+#include "Game/ChunkPalettedBlocks.hpp"
+#include <algorithm>
+
+// the three bytes of a block as one key, two blocks with the same key are the same palette entry
+static uint32_t GetBlockKey(Block const& block)
+{
+	return (uint32_t)block.m_blockDefIndex | ((uint32_t)block.m_blockLighting << 8) | ((uint32_t)block.m_blockBitFlags << 16);
+}
+
+static int GetBitsPerIndexForPaletteSize(int paletteSize)
+{
+	if (paletteSize <= 1)	return 0;
+	if (paletteSize <= 2)	return 1;
+	if (paletteSize <= 4)	return 2;
+	if (paletteSize <= 16)	return 4;
+	if (paletteSize <= 256) return 8;
+	return 16; // 4096 blocks in a section, the palette could never be bigger than that
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+void ChunkPalettedBlocks::CompressBlocks(Block const* blocks)
+{
+	std::vector<uint32_t> paletteKeys;
+	uint16_t sectionIndices[CHUNK_BLOCKS_PER_SECTION];
+
+	for (int sectionIndex = 0; sectionIndex < CHUNK_NUM_SECTIONS; ++sectionIndex)
+	{
+		PalettedBlockSection& section = m_sections[sectionIndex];
+		Block const* sectionBlocks = blocks + sectionIndex * CHUNK_BLOCKS_PER_SECTION;
+		section.m_palette.clear();
+		section.m_packedIndices.clear();
+		paletteKeys.clear();
+
+		// neighbors in index order are mostly the same block, so the last entry is tried before the palette is searched
+		uint32_t lastKey = 0;
+		int lastPaletteIndex = -1;
+		for (int i = 0; i < CHUNK_BLOCKS_PER_SECTION; ++i)
+		{
+			uint32_t key = GetBlockKey(sectionBlocks[i]);
+			if (key != lastKey || lastPaletteIndex < 0)
+			{
+				lastPaletteIndex = -1;
+				for (int paletteIndex = 0; paletteIndex < (int)paletteKeys.size(); ++paletteIndex)
+				{
+					if (paletteKeys[paletteIndex] == key)
+					{
+						lastPaletteIndex = paletteIndex;
+						break;
+					}
+				}
+				if (lastPaletteIndex < 0)
+				{
+					lastPaletteIndex = (int)paletteKeys.size();
+					paletteKeys.push_back(key);
+					section.m_palette.push_back(sectionBlocks[i]);
+				}
+				lastKey = key;
+			}
+			sectionIndices[i] = (uint16_t)lastPaletteIndex;
+		}
+
+		section.m_bitsPerIndex = GetBitsPerIndexForPaletteSize((int)section.m_palette.size());
+		section.m_palette.shrink_to_fit();
+		if (section.IsUniform())
+		{
+			section.m_packedIndices.shrink_to_fit();
+			continue;
+		}
+
+		int indicesPerWord = 32 / section.m_bitsPerIndex;
+		section.m_packedIndices.assign(CHUNK_BLOCKS_PER_SECTION / indicesPerWord, 0);
+		section.m_packedIndices.shrink_to_fit();
+		for (int i = 0; i < CHUNK_BLOCKS_PER_SECTION; ++i)
+		{
+			int shift = (i % indicesPerWord) * section.m_bitsPerIndex;
+			section.m_packedIndices[i / indicesPerWord] |= (uint32_t)sectionIndices[i] << shift;
+		}
+	}
+}
+
+void ChunkPalettedBlocks::DecompressBlocks(Block* out_blocks) const
+{
+	for (int sectionIndex = 0; sectionIndex < CHUNK_NUM_SECTIONS; ++sectionIndex)
+	{
+		PalettedBlockSection const& section = m_sections[sectionIndex];
+		Block* sectionBlocks = out_blocks + sectionIndex * CHUNK_BLOCKS_PER_SECTION;
+		if (section.IsUniform())
+		{
+			std::fill(sectionBlocks, sectionBlocks + CHUNK_BLOCKS_PER_SECTION, section.m_palette[0]);
+			continue;
+		}
+
+		// a whole word at a time, the indices in it are peeled off from the low bits
+		int indicesPerWord = 32 / section.m_bitsPerIndex;
+		uint32_t indexMask = (1u << section.m_bitsPerIndex) - 1;
+		Block const* palette = section.m_palette.data();
+		int blockIndex = 0;
+		for (int wordIndex = 0; wordIndex < (int)section.m_packedIndices.size(); ++wordIndex)
+		{
+			uint32_t word = section.m_packedIndices[wordIndex];
+			for (int i = 0; i < indicesPerWord; ++i)
+			{
+				sectionBlocks[blockIndex++] = palette[word & indexMask];
+				word >>= section.m_bitsPerIndex;
+			}
+		}
+	}
+}
+
+Block ChunkPalettedBlocks::GetBlock(int blockIndex) const
+{
+	PalettedBlockSection const& section = m_sections[blockIndex / CHUNK_BLOCKS_PER_SECTION];
+	if (section.IsUniform())
+	{
+		return section.m_palette[0];
+	}
+	int indexInSection = blockIndex % CHUNK_BLOCKS_PER_SECTION;
+	int indicesPerWord = 32 / section.m_bitsPerIndex;
+	uint32_t word = section.m_packedIndices[indexInSection / indicesPerWord];
+	uint32_t paletteIndex = (word >> ((indexInSection % indicesPerWord) * section.m_bitsPerIndex)) & ((1u << section.m_bitsPerIndex) - 1);
+	return section.m_palette[paletteIndex];
+}
+
+size_t ChunkPalettedBlocks::GetNumBytes() const
+{
+	size_t numBytes = sizeof(ChunkPalettedBlocks);
+	for (int sectionIndex = 0; sectionIndex < CHUNK_NUM_SECTIONS; ++sectionIndex)
+	{
+		numBytes += m_sections[sectionIndex].m_palette.capacity() * sizeof(Block);
+		numBytes += m_sections[sectionIndex].m_packedIndices.capacity() * sizeof(uint32_t);
+	}
+	return numBytes;
+}
+
+int ChunkPalettedBlocks::GetNumUniformSections() const
+{
+	int numUniformSections = 0;
+	for (int sectionIndex = 0; sectionIndex < CHUNK_NUM_SECTIONS; ++sectionIndex)
+	{
+		if (m_sections[sectionIndex].IsUniform())
+		{
+			++numUniformSections;
+		}
+	}
+	return numUniformSections;
+}
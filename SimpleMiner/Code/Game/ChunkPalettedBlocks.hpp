@@ -0,0 +1,34 @@
+#pragma once
+#include "Game/Block.hpp"
+#include "Game/GameCommon.hpp"
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// the compact way to keep a chunk's blocks while nothing is editing or relighting it
+// every 16 x 16 x 16 section has a palette of the distinct blocks in it (def, lighting and bit flags, so nothing is lost)
+// and one index per block into that palette, packed 1, 2, 4, 8 or 16 bits so an index never straddles two words
+// a section made of one block, all air above the terrain or all stone deep down, is only its palette
+struct PalettedBlockSection
+{
+	std::vector<Block>		m_palette;
+	std::vector<uint32_t>	m_packedIndices; // empty when the section is uniform
+	int						m_bitsPerIndex = 0;
+
+	bool IsUniform() const { return m_bitsPerIndex == 0; }
+};
+
+class ChunkPalettedBlocks
+{
+public:
+	ChunkPalettedBlocks() = default;
+	~ChunkPalettedBlocks() = default;
+
+	void	CompressBlocks(Block const* blocks); // blocks is the flat CHUNK_BLOCKS_TOTAL array
+	void	DecompressBlocks(Block* out_blocks) const;
+	Block	GetBlock(int blockIndex) const;
+
+	size_t	GetNumBytes() const; // everything the storage holds on the heap and in itself
+	int		GetNumUniformSections() const;
+
+	PalettedBlockSection m_sections[CHUNK_NUM_SECTIONS];
+};
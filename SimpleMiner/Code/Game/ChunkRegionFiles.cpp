@@ -0,0 +1,339 @@
+#include "Game/ChunkRegionFiles.hpp"
+#include "Game/GameCommon.hpp"
+#include "Engine/core/FileUtils.hpp"
+#include "Engine/core/StringUtils.hpp"
+#include "Engine/core/ErrorWarningAssert.hpp"
+#include <algorithm>
+
+static void AppendUInt32(std::vector<uint8_t>& buffer, uint32_t value)
+{
+	buffer.push_back((uint8_t)(value));
+	buffer.push_back((uint8_t)(value >> 8));
+	buffer.push_back((uint8_t)(value >> 16));
+	buffer.push_back((uint8_t)(value >> 24));
+}
+
+static uint32_t ReadUInt32(uint8_t const* bytes)
+{
+	return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+// "Chunk(x, y).chunk" or "Region(x, y).region"
+bool ChunkRegionFiles::ParseCoordsInFileName(std::string const& fileName, IntVec2& out_coords)
+{
+	size_t openBracket = fileName.find('(');
+	size_t closeBracket = fileName.find(')');
+	if (openBracket == std::string::npos || closeBracket == std::string::npos || closeBracket < openBracket)
+	{
+		return false;
+	}
+	Strings coordsStrings = SplitStringOnDelimiter(fileName.substr(openBracket + 1, closeBracket - openBracket - 1), ',');
+	if (coordsStrings.size() != 2)
+	{
+		return false;
+	}
+	out_coords = IntVec2(atoi(coordsStrings[0].c_str()), atoi(coordsStrings[1].c_str()));
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+ChunkRegionFiles::ChunkRegionFiles(std::string const& saveFolderPath)
+	: m_saveFolderPath(saveFolderPath)
+{
+}
+
+ChunkRegionFiles::~ChunkRegionFiles()
+{
+	for (int regionIndex = 0; regionIndex < m_regions.GetSize(); ++regionIndex)
+	{
+		delete m_regions.GetEntry(regionIndex).m_value;
+	}
+	m_regions.Clear();
+}
+
+// floor division, chunk -1 is in region -1
+IntVec2 ChunkRegionFiles::GetRegionCoordsForChunk(IntVec2 const& chunkCoords)
+{
+	return IntVec2(chunkCoords.x >> REGION_BITS, chunkCoords.y >> REGION_BITS);
+}
+
+int ChunkRegionFiles::GetChunkIndexInRegion(IntVec2 const& chunkCoords)
+{
+	return (chunkCoords.x & REGION_MASK) | ((chunkCoords.y & REGION_MASK) << REGION_BITS);
+}
+
+bool ChunkRegionFiles::HasChunk(IntVec2 const& chunkCoords)
+{
+	m_regionsMutex.lock();
+	ChunkRegion* region = GetOrLoadRegion(GetRegionCoordsForChunk(chunkCoords));
+	bool hasChunk = region->m_blobSizes[GetChunkIndexInRegion(chunkCoords)] > 0;
+	m_regionsMutex.unlock();
+	return hasChunk;
+}
+
+bool ChunkRegionFiles::LoadChunk(IntVec2 const& chunkCoords, std::vector<uint8_t>& out_chunkData)
+{
+	m_regionsMutex.lock();
+	ChunkRegion* region = GetOrLoadRegion(GetRegionCoordsForChunk(chunkCoords));
+	int chunkIndex = GetChunkIndexInRegion(chunkCoords);
+	uint32_t blobSize = region->m_blobSizes[chunkIndex];
+	if (blobSize == 0)
+	{
+		m_regionsMutex.unlock();
+		out_chunkData.clear();
+		return false; // never saved, and nothing was read from the disk to find that out
+	}
+
+	int numBytesRead = FileReadRangeToBuffer(out_chunkData, region->m_filePath, (int)region->m_blobOffsets[chunkIndex], (int)blobSize);
+	m_regionsMutex.unlock();
+	return numBytesRead == (int)blobSize;
+}
+
+bool ChunkRegionFiles::SaveChunk(IntVec2 const& chunkCoords, std::vector<uint8_t> const& chunkData)
+{
+	if (chunkData.empty())
+	{
+		return false;
+	}
+
+	m_regionsMutex.lock();
+	ChunkRegion* region = GetOrLoadRegion(GetRegionCoordsForChunk(chunkCoords));
+	int chunkIndex = GetChunkIndexInRegion(chunkCoords);
+	uint32_t oldBlobSize = region->m_blobSizes[chunkIndex];
+	uint32_t newBlobSize = (uint32_t)chunkData.size();
+
+	// a new file starts with an empty table, so a crash before the first table write leaves a valid region
+	if (!region->m_hasFile)
+	{
+		std::vector<uint8_t> headerAndTable;
+		AppendHeaderAndTable(region, headerAndTable);
+		if (!FileWriteFromBuffer(headerAndTable, region->m_filePath))
+		{
+			m_regionsMutex.unlock();
+			return false;
+		}
+		region->m_hasFile = true;
+	}
+
+	// the blob is always appended, never written over the old one, and the table entry is written after it
+	// so a crash leaves the table pointing at the old blob or the new one, both complete, the old one is garbage until compacted
+	uint32_t blobOffset = region->m_fileSize;
+	if (!FileWriteFromBufferAtOffset(chunkData, region->m_filePath, (int)blobOffset))
+	{
+		m_regionsMutex.unlock();
+		return false;
+	}
+	region->m_fileSize += newBlobSize;
+
+	region->m_blobOffsets[chunkIndex] = blobOffset;
+	region->m_blobSizes[chunkIndex] = newBlobSize;
+	region->m_numLiveBytes += newBlobSize - oldBlobSize;
+	bool wasSaved = WriteTableEntry(region, chunkIndex);
+
+	uint32_t numGarbageBytes = region->m_fileSize - REGION_FIRST_BLOB_OFFSET - region->m_numLiveBytes;
+	if (numGarbageBytes > (uint32_t)REGION_MIN_GARBAGE_BYTES_TO_COMPACT && numGarbageBytes > region->m_numLiveBytes)
+	{
+		CompactRegion(region);
+	}
+	m_regionsMutex.unlock();
+	return wasSaved;
+}
+
+// the mutex is locked by the caller
+ChunkRegion* ChunkRegionFiles::GetOrLoadRegion(IntVec2 const& regionCoords)
+{
+	ChunkRegion* region = m_regions.Find(regionCoords);
+	if (region)
+	{
+		return region;
+	}
+
+	region = new ChunkRegion();
+	region->m_regionCoords = regionCoords;
+	region->m_filePath = Stringf("%s/Region(%i, %i).region", m_saveFolderPath.c_str(), regionCoords.x, regionCoords.y);
+	m_regions.Set(regionCoords, region);
+
+	std::vector<uint8_t> headerAndTable;
+	int numBytesRead = FileReadRangeToBuffer(headerAndTable, region->m_filePath, 0, REGION_FIRST_BLOB_OFFSET);
+	if (numBytesRead < 0)
+	{
+		return region; // nothing saved in this region yet
+	}
+
+	bool isValidHeader = numBytesRead == REGION_FIRST_BLOB_OFFSET &&
+		headerAndTable[0] == 'G' &&
+		headerAndTable[1] == 'R' &&
+		headerAndTable[2] == 'G' &&
+		headerAndTable[3] == 'N' &&
+		headerAndTable[4] == REGION_FILE_VERSION &&
+		headerAndTable[5] == REGION_BITS;
+	if (!isValidHeader)
+	{
+		// this runs on the I/O worker, so a broken file must not take the game down
+		// it is moved aside for a look later and the region starts empty, its chunks get generated again
+		std::string badFilePath = region->m_filePath + ".bad";
+		DebuggerPrintf("%s is not a valid region file, moved to %s and the region starts empty\n", region->m_filePath.c_str(), badFilePath.c_str());
+		FileReplace(region->m_filePath, badFilePath);
+		return region;
+	}
+
+	region->m_hasFile = true;
+	for (int chunkIndex = 0; chunkIndex < CHUNKS_PER_REGION; ++chunkIndex)
+	{
+		uint8_t const* tableEntry = &headerAndTable[REGION_HEADER_BYTES + chunkIndex * 8];
+		uint32_t blobOffset = ReadUInt32(tableEntry);
+		uint32_t blobSize = ReadUInt32(tableEntry + 4);
+		region->m_blobOffsets[chunkIndex] = blobOffset;
+		region->m_blobSizes[chunkIndex] = blobSize;
+		region->m_numLiveBytes += blobSize;
+
+		// anything after the last live blob is garbage nothing in the table points to, it is ignored: the next append starts
+		// right after the last live blob, so a live blob is never written over, and compaction drops whatever is left of it
+		if (blobSize > 0 && blobOffset + blobSize > region->m_fileSize)
+		{
+			region->m_fileSize = blobOffset + blobSize;
+		}
+	}
+	return region;
+}
+
+bool ChunkRegionFiles::WriteTableEntry(ChunkRegion* region, int chunkIndex)
+{
+	std::vector<uint8_t> tableEntry;
+	AppendUInt32(tableEntry, region->m_blobOffsets[chunkIndex]);
+	AppendUInt32(tableEntry, region->m_blobSizes[chunkIndex]);
+	return FileWriteFromBufferAtOffset(tableEntry, region->m_filePath, REGION_HEADER_BYTES + chunkIndex * 8);
+}
+
+void ChunkRegionFiles::AppendHeaderAndTable(ChunkRegion const* region, std::vector<uint8_t>& out_buffer) const
+{
+	out_buffer.push_back('G');
+	out_buffer.push_back('R');
+	out_buffer.push_back('G');
+	out_buffer.push_back('N');
+	out_buffer.push_back(REGION_FILE_VERSION);
+	out_buffer.push_back(REGION_BITS);
+	out_buffer.push_back(0);
+	out_buffer.push_back(0);
+
+	for (int chunkIndex = 0; chunkIndex < CHUNKS_PER_REGION; ++chunkIndex)
+	{
+		AppendUInt32(out_buffer, region->m_blobOffsets[chunkIndex]);
+		AppendUInt32(out_buffer, region->m_blobSizes[chunkIndex]);
+	}
+}
+
+// rewrites the region with its live blobs packed one after another into a temporary file, then swaps it in
+// if anything fails the old file is still there and still valid, it just keeps its garbage
+void ChunkRegionFiles::CompactRegion(ChunkRegion* region)
+{
+	std::vector<uint8_t> oldFile;
+	FileReadToBuffer(oldFile, region->m_filePath);
+
+	uint32_t newBlobOffsets[CHUNKS_PER_REGION] = {};
+	std::vector<uint8_t> newFile;
+	newFile.reserve(REGION_FIRST_BLOB_OFFSET + region->m_numLiveBytes);
+	newFile.resize(REGION_FIRST_BLOB_OFFSET);
+	for (int chunkIndex = 0; chunkIndex < CHUNKS_PER_REGION; ++chunkIndex)
+	{
+		uint32_t blobOffset = region->m_blobOffsets[chunkIndex];
+		uint32_t blobSize = region->m_blobSizes[chunkIndex];
+		if (blobSize == 0)
+		{
+			continue;
+		}
+		if (blobOffset + blobSize > (uint32_t)oldFile.size())
+		{
+			return;
+		}
+
+		newBlobOffsets[chunkIndex] = (uint32_t)newFile.size();
+		newFile.insert(newFile.end(), oldFile.begin() + blobOffset, oldFile.begin() + blobOffset + blobSize);
+	}
+
+	ChunkRegion compactedRegion;
+	for (int chunkIndex = 0; chunkIndex < CHUNKS_PER_REGION; ++chunkIndex)
+	{
+		compactedRegion.m_blobOffsets[chunkIndex] = newBlobOffsets[chunkIndex];
+		compactedRegion.m_blobSizes[chunkIndex] = region->m_blobSizes[chunkIndex];
+	}
+	std::vector<uint8_t> headerAndTable;
+	AppendHeaderAndTable(&compactedRegion, headerAndTable);
+	std::copy(headerAndTable.begin(), headerAndTable.end(), newFile.begin());
+
+	std::string tempFilePath = region->m_filePath + ".tmp";
+	if (!FileWriteFromBuffer(newFile, tempFilePath) || !FileReplace(tempFilePath, region->m_filePath))
+	{
+		return;
+	}
+
+	for (int chunkIndex = 0; chunkIndex < CHUNKS_PER_REGION; ++chunkIndex)
+	{
+		region->m_blobOffsets[chunkIndex] = newBlobOffsets[chunkIndex];
+	}
+	region->m_fileSize = (uint32_t)newFile.size();
+}
+
+int ChunkRegionFiles::ConvertChunkFiles()
+{
+	std::vector<std::string> chunkFileNames = GetFileNamesInFolder(m_saveFolderPath, "Chunk(*).chunk");
+	int numConverted = 0;
+	for (int fileIndex = 0; fileIndex < (int)chunkFileNames.size(); ++fileIndex)
+	{
+		std::string const& fileName = chunkFileNames[fileIndex];
+		IntVec2 chunkCoords;
+		if (!ParseCoordsInFileName(fileName, chunkCoords))
+		{
+			continue;
+		}
+
+		// the blob is the same bytes as the old file, only files the game could have loaded are taken over
+		std::string filePath = m_saveFolderPath + "/" + fileName;
+		std::vector<uint8_t> chunkData;
+		FileReadToBuffer(chunkData, filePath);
+		bool isValidChunkFile = chunkData.size() >= 8 &&
+			chunkData[0] == 'G' &&
+			chunkData[1] == 'C' &&
+			chunkData[2] == 'H' &&
+			chunkData[3] == 'K' &&
+			chunkData[5] == CHUNK_BITS_X &&
+			chunkData[6] == CHUNK_BITS_Y &&
+			chunkData[7] == CHUNK_BITS_Z;
+		if (!isValidChunkFile)
+		{
+			continue;
+		}
+
+		if (SaveChunk(chunkCoords, chunkData))
+		{
+			FileDelete(filePath);
+			++numConverted;
+		}
+	}
+	return numConverted;
+}
+
+void ChunkRegionFiles::GetSavedChunkCoords(std::vector<IntVec2>& out_chunkCoords)
+{
+	out_chunkCoords.clear();
+	std::vector<std::string> regionFileNames = GetFileNamesInFolder(m_saveFolderPath, "Region(*).region");
+	m_regionsMutex.lock();
+	for (int fileIndex = 0; fileIndex < (int)regionFileNames.size(); ++fileIndex)
+	{
+		IntVec2 regionCoords;
+		if (!ParseCoordsInFileName(regionFileNames[fileIndex], regionCoords))
+		{
+			continue;
+		}
+		ChunkRegion* region = GetOrLoadRegion(regionCoords);
+		for (int chunkIndex = 0; chunkIndex < CHUNKS_PER_REGION; ++chunkIndex)
+		{
+			if (region->m_blobSizes[chunkIndex] > 0)
+			{
+				IntVec2 chunkInRegion(chunkIndex & REGION_MASK, chunkIndex >> REGION_BITS);
+				out_chunkCoords.push_back(IntVec2(regionCoords.x * REGION_SIZE + chunkInRegion.x, regionCoords.y * REGION_SIZE + chunkInRegion.y));
+			}
+		}
+	}
+	m_regionsMutex.unlock();
+}
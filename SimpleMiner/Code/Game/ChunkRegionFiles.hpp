@@ -0,0 +1,91 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include "Game/ChunkCoordsHashMap.hpp"
+#include "Game/GameCommon.hpp"
+#include "Engine/core/JobSystem.hpp"
+#include <vector>
+#include <string>
+#include <mutex>
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// region files pack REGION_SIZE x REGION_SIZE chunks into one file, "Region(x, y).region" in the world's save folder
+// the file starts with a header and an offset table, every saved chunk is a blob of its .chunk file bytes somewhere after it
+// a saved chunk is always appended to the end, the old blob becomes garbage until the region gets compacted
+constexpr int REGION_BITS = 5;
+constexpr int REGION_SIZE = 1 << REGION_BITS;
+constexpr int REGION_MASK = REGION_SIZE - 1;
+constexpr int CHUNKS_PER_REGION = REGION_SIZE * REGION_SIZE;
+
+constexpr int REGION_FILE_VERSION = 1;
+constexpr int REGION_HEADER_BYTES = 8; // "GRGN", version, REGION_BITS, 2 unused
+constexpr int REGION_TABLE_BYTES = CHUNKS_PER_REGION * 8; // offset and size per chunk, both uint32 little endian
+constexpr int REGION_FIRST_BLOB_OFFSET = REGION_HEADER_BYTES + REGION_TABLE_BYTES;
+constexpr int REGION_MIN_GARBAGE_BYTES_TO_COMPACT = 256 * 1024; // and there has to be more garbage than live blobs
+
+struct ChunkRegion
+{
+	IntVec2		m_regionCoords;
+	std::string m_filePath;
+	bool		m_hasFile = false;
+
+	// the in memory copy of the offset table, a size of 0 means the chunk has never been saved
+	uint32_t	m_blobOffsets[CHUNKS_PER_REGION] = {};
+	uint32_t	m_blobSizes[CHUNKS_PER_REGION] = {};
+
+	uint32_t	m_fileSize = REGION_FIRST_BLOB_OFFSET; // where the next blob is appended
+	uint32_t	m_numLiveBytes = 0;
+};
+
+// every region of one world, the region headers are read the first time one of their chunks is asked for
+// thread safe, but meant to be called from the disk I/O lane only
+class ChunkRegionFiles
+{
+public:
+	ChunkRegionFiles(std::string const& saveFolderPath);
+	~ChunkRegionFiles();
+
+	bool HasChunk(IntVec2 const& chunkCoords); // an index lookup, only touches the disk the first time its region is used
+	bool LoadChunk(IntVec2 const& chunkCoords, std::vector<uint8_t>& out_chunkData); // false if the chunk has never been saved
+	bool SaveChunk(IntVec2 const& chunkCoords, std::vector<uint8_t> const& chunkData);
+
+	// moves every "Chunk(x, y).chunk" file of the folder into the regions and deletes it, returns how many were converted
+	int ConvertChunkFiles();
+
+	// every chunk saved in the region files of the folder, for tools and benchmarks
+	void GetSavedChunkCoords(std::vector<IntVec2>& out_chunkCoords);
+
+	static IntVec2	GetRegionCoordsForChunk(IntVec2 const& chunkCoords);
+	static int		GetChunkIndexInRegion(IntVec2 const& chunkCoords);
+	static bool		ParseCoordsInFileName(std::string const& fileName, IntVec2& out_coords); // "Chunk(x, y).chunk" or "Region(x, y).region"
+
+private:
+	ChunkRegion*	GetOrLoadRegion(IntVec2 const& regionCoords);
+	bool			WriteTableEntry(ChunkRegion* region, int chunkIndex);
+	void			CompactRegion(ChunkRegion* region);
+	void			AppendHeaderAndTable(ChunkRegion const* region, std::vector<uint8_t>& out_buffer) const;
+
+	std::string						m_saveFolderPath;
+	ChunkCoordsHashMap<ChunkRegion>	m_regions; // keyed by region coords
+	std::mutex						m_regionsMutex;
+};
+
+// the world queues it on the I/O lane when it starts, so the old .chunk files are in the regions before the first chunk is loaded
+// that ordering only holds with a single I/O worker (JobSystemConfig::numIOWorkers = 1): the lane is FIFO, but a second worker
+// could start a chunk load while the conversion is still running
+struct ChunkFilesConversionJob : public Job
+{
+public:
+	static constexpr int JOB_TYPE = JOB_TYPE_CHUNK_FILES_CONVERSION;
+
+	ChunkFilesConversionJob(ChunkRegionFiles* regionFiles)
+		: Job(JOB_TYPE)
+		, m_regionFiles(regionFiles)
+	{
+		m_isIOJob = true;
+	}
+
+	virtual void Execute() override { m_numConverted = m_regionFiles->ConvertChunkFiles(); }
+
+	ChunkRegionFiles*	m_regionFiles = nullptr;
+	int					m_numConverted = 0;
+};
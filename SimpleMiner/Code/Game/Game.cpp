@@ -50,16 +50,16 @@ void Game::Startup()
 	// set up the clock for the game 
 	g_theGameClock = new Clock();
 
+	// create saving data folder, before the world starts loading chunks from it
+	unsigned char worldSeed = (unsigned char)g_gameConfigBlackboard.GetValue("WorldSeed", 0);
+	std::string saveFolderPathName = Stringf("Saves/World_%u", worldSeed);
+	CreateFolder(saveFolderPathName);
+
 	// create the world
 	g_theWorld = new World();
 	g_theWorld->Startup();
 
 	// SpawnProps();
-
-	// create saving data folder
-	unsigned char worldSeed = (unsigned char)g_gameConfigBlackboard.GetValue("WorldSeed", 0);
-	std::string saveFolderPathName = Stringf("Saves/World_%u", worldSeed);
-	CreateFolder(saveFolderPathName);
 }
 
 void Game::Update()
@@ -26,11 +26,21 @@ constexpr int CHUNK_SIZE_Z = (1 << CHUNK_BITS_Z); // height
 constexpr int CHUNK_BLOCKS_PER_LAYER = (CHUNK_SIZE_X * CHUNK_SIZE_Y);
 constexpr int CHUNK_BLOCKS_TOTAL = (CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z);
 
+// a chunk column is cut into 16 high sections, block indices of a section are contiguous because z is the highest bits
+constexpr int CHUNK_SECTION_BITS_Z = 4;
+constexpr int CHUNK_SECTION_SIZE_Z = (1 << CHUNK_SECTION_BITS_Z);
+constexpr int CHUNK_NUM_SECTIONS = CHUNK_SIZE_Z / CHUNK_SECTION_SIZE_Z;
+constexpr int CHUNK_BLOCKS_PER_SECTION = CHUNK_BLOCKS_PER_LAYER * CHUNK_SECTION_SIZE_Z;
+
+constexpr uint8_t CHUNK_SAVE_VERSION = 3; // version 2 saves still load, they are written back as version 3 when the chunk changes
+constexpr uint8_t CHUNK_SAVE_FLAG_LZ = 0x01;
+
 constexpr int CHUNK_MASK_X = (CHUNK_SIZE_X - 1);
 // constexpr int CHUNCK_MASK_X = 0b0000000'0000'1111; // for clear bits calculation
 constexpr int CHUNK_MASK_Y = (CHUNK_SIZE_Y - 1) << CHUNK_BITS_X;
 // constexpr int CHUNCK_MASK_Y = 0b0000000'1111'0000; // for clear bits calculation
 constexpr int CHUNK_MASK_Z = ((CHUNK_SIZE_Z - 1) << (CHUNK_BITS_X + CHUNK_BITS_Y));
+constexpr int CHUNK_MASK_COLUMN = (CHUNK_MASK_X | CHUNK_MASK_Y); // blockIndex & CHUNK_MASK_COLUMN is the column index
 // constexpr int CHUNCK_MASK_Y = 0b1111111'0000'0000; // for clear bits calculation
 
 constexpr int CHUNK_BITSHIFT_X = 0;
@@ -49,6 +59,9 @@ constexpr float CHUNK_DACTIVATE_RANGE = CHUNK_ACTIVATE_RANGE + CHUNK_SIZE_X + CH
 constexpr int MAX_CHUNK_RADIUS_X = 1 + int(CHUNK_ACTIVATE_RANGE) / CHUNK_SIZE_X;
 constexpr int MAX_CHUNK_RADIUS_Y = 1 + int(CHUNK_ACTIVATE_RANGE) / CHUNK_SIZE_Y;
 constexpr int MAX_CHUNKS = (2 * MAX_CHUNK_RADIUS_X)* (2 * MAX_CHUNK_RADIUS_Y); // neighborhood
+constexpr double CHUNK_STREAMING_BUDGET_SECONDS = 0.002; // per frame, activating and deactivating chunks stops when it is used up
+constexpr float CHUNK_COMPACT_RANGE = 96.f; // settled active chunks farther than this keep their blocks paletted, see ChunkPalettedBlocks
+constexpr int CHUNKS_TO_COMPACT_CHECKS_PER_FRAME = 64;
 // constexpr int MAX_CHUNKS = 16; // neighborhood
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------
@@ -70,13 +83,28 @@ constexpr int BLOCK_BIT_IS_VISIBLE = 5;
 constexpr int BLOCK_BIT_MASK_IS_VISIBLE = 1 << (BLOCK_BIT_IS_VISIBLE - 1);// 0b0000'0010;
 constexpr int BLOCK_BIT_IS_SOLID = 6; 
 constexpr int BLOCK_BIT_MASK_IS_SOLID = 1 << (BLOCK_BIT_IS_SOLID - 1);// 0b0010'0000;
+constexpr int BLOCK_BIT_MASK_DEF_FLAGS = BLOCK_BIT_MASK_IS_FULL_OPAQUE | BLOCK_BIT_MASK_IS_EMISSIVE | BLOCK_BIT_MASK_IS_VISIBLE | BLOCK_BIT_MASK_IS_SOLID; // the bits that come from the block def
 
 constexpr int MAX_LIGHT_VALUE = 15;
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------
 // time settings
 constexpr float HOUR_FRACTION_DAY = 1.f / 24.f;
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// job types, each type has its own completed list in the job system (JOB_TYPE_GENERIC = 0 is taken by the engine)
+constexpr int JOB_TYPE_CHUNK_GENERATION = 1;
+constexpr int JOB_TYPE_BENCHMARK = 2;
+constexpr int JOB_TYPE_CHUNK_LOAD = 3;
+constexpr int JOB_TYPE_CHUNK_SAVE = 4;
+constexpr int JOB_TYPE_CHUNK_FILES_CONVERSION = 5;
+constexpr int JOB_TYPE_CHUNK_MESH = 6;
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// chunk streaming
 constexpr int MAX_QUEUEDJOBS_CHUNKGENERATION = 4;
+constexpr int MAX_QUEUEDJOBS_CHUNKGENERATION_PRIORITIZED = 32; // nearest first and out of range ones get cancelled, so the queue could be deeper
+constexpr int REPLAY_NEARBY_CHUNK_RADIUS = 3; // chunks within this many chunks of the player count for time-to-visible
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------
 // biome
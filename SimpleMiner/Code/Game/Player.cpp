@@ -195,7 +195,9 @@ void Player::PlayerInputControls()
 	// press 'H' to reset the camera position and orientation
 	if (g_theInput->WasKeyJustPressed('H') || controller.IsButtonDown(XBOX_BUTTON_START))
 	{
-		m_position = Vec3(0.f, 0.f, 90.f);
+		// a couple of blocks above the ground under the origin, or up in the air when that chunk is not loaded yet
+		float groundHeight = g_theWorld->GetGroundHeightAtWorldPos(Vec3(0.f, 0.f, 0.f), 88.f);
+		m_position = Vec3(0.f, 0.f, groundHeight + 2.f);
 		m_orientation = EulerAngles(0.f, 0.f, 0.f);
 	}
 
@@ -0,0 +1,232 @@
+#include "Game/VoxelRaycast.hpp"
+#include "Game/Chunk.hpp"
+#include "Engine/core/JobSystem.hpp"
+#include <math.h>
+
+extern JobSystem* g_theJobSystem;
+
+constexpr float NEVER_CROSSED = 1e30f; // the distance to the next boundary of an axis the ray does not move along
+
+// compacted chunks are read through their palette
+static inline bool IsBlockSolid(Chunk const* chunk, int blockIndex)
+{
+	if (chunk->m_blocks)
+	{
+		return chunk->m_blocks[blockIndex].IsSolid();
+	}
+	return chunk->m_palettedBlocks->GetBlock(blockIndex).IsSolid();
+}
+
+// the distance along the ray to where it leaves the block at blockCoord on this axis
+static inline float GetDistToNextBoundary(int blockCoord, int step, float rayStartCoord, float oneOverFwd)
+{
+	if (step == 0)
+	{
+		return NEVER_CROSSED;
+	}
+	float boundary = float(step > 0 ? blockCoord + 1 : blockCoord);
+	return (boundary - rayStartCoord) * oneOverFwd;
+}
+
+SimpleMinerRaycastResult RaycastVoxels(ChunkCoordsHashMap<Chunk> const& chunks, VoxelRay const& ray)
+{
+	// if it misses, we will use this result
+	SimpleMinerRaycastResult result;
+	result.m_didImpact = false;
+	result.m_impactDist = ray.m_dist;
+	result.m_impactPos = ray.m_start + ray.m_fwdNormal * ray.m_dist;
+	result.m_impactNormal = ray.m_fwdNormal;
+	result.m_didExit = false;
+	result.m_travelDistInShape = 0.f;
+	result.m_exitPos = ray.m_start;
+	result.m_exitNormal = ray.m_fwdNormal;
+	result.m_rayFwdNormal = ray.m_fwdNormal;
+	result.m_rayStartPos = ray.m_start;
+	result.m_rayDist = ray.m_dist;
+
+	float rayStart[3] = { ray.m_start.x, ray.m_start.y, ray.m_start.z };
+	float rayFwd[3] = { ray.m_fwdNormal.x, ray.m_fwdNormal.y, ray.m_fwdNormal.z };
+
+	// a ray starting above or below the world skips ahead to where it comes in
+	float dist = 0.f;
+	int entryAxis = -1; // the axis of the face the ray came into the current block through, -1 for the block it starts in
+	if (rayStart[2] < 0.f || rayStart[2] >= float(CHUNK_SIZE_Z))
+	{
+		bool isBelow = rayStart[2] < 0.f;
+		if ((isBelow && rayFwd[2] <= 0.f) || (!isBelow && rayFwd[2] >= 0.f))
+		{
+			return result;
+		}
+		dist = ((isBelow ? 0.f : float(CHUNK_SIZE_Z)) - rayStart[2]) / rayFwd[2];
+		if (dist > ray.m_dist)
+		{
+			return result;
+		}
+		entryAxis = 2;
+	}
+
+	int blockCoords[3];
+	int step[3];
+	float oneOverFwd[3];
+	float distToNextBoundary[3];
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		blockCoords[axis] = int(floorf(rayStart[axis] + rayFwd[axis] * dist));
+		step[axis] = (rayFwd[axis] > 0.f) ? 1 : ((rayFwd[axis] < 0.f) ? -1 : 0);
+		oneOverFwd[axis] = (step[axis] != 0) ? 1.f / rayFwd[axis] : 0.f;
+	}
+	if (entryAxis == 2)
+	{
+		blockCoords[2] = (rayFwd[2] > 0.f) ? 0 : CHUNK_SIZE_Z - 1;
+	}
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		distToNextBoundary[axis] = GetDistToNextBoundary(blockCoords[axis], step[axis], rayStart[axis], oneOverFwd[axis]);
+	}
+
+	// the chunk is followed through the neighbor pointers from here on, the block coords stay global
+	Chunk* chunk = chunks.Find(IntVec2(blockCoords[0] >> CHUNK_BITS_X, blockCoords[1] >> CHUNK_BITS_Y));
+	if (!chunk)
+	{
+		return result;
+	}
+	int localX = blockCoords[0] & (CHUNK_SIZE_X - 1);
+	int localY = blockCoords[1] & (CHUNK_SIZE_Y - 1);
+
+	for (;;)
+	{
+		int sectionIndex = blockCoords[2] >> CHUNK_SECTION_BITS_Z;
+		if (chunk->IsSectionEmpty(sectionIndex))
+		{
+			// nothing to hit until the ray leaves this section of the chunk, so every axis is moved straight to the block it is in there
+			int boxMins[3] = { blockCoords[0] - localX, blockCoords[1] - localY, sectionIndex << CHUNK_SECTION_BITS_Z };
+			int boxSizes[3] = { CHUNK_SIZE_X, CHUNK_SIZE_Y, CHUNK_SECTION_SIZE_Z };
+			float distToLeaveBox = NEVER_CROSSED;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				int lastBlockCoord = (step[axis] > 0) ? boxMins[axis] + boxSizes[axis] - 1 : boxMins[axis];
+				float distToLeaveOnAxis = GetDistToNextBoundary(lastBlockCoord, step[axis], rayStart[axis], oneOverFwd[axis]);
+				distToLeaveBox = (distToLeaveOnAxis < distToLeaveBox) ? distToLeaveOnAxis : distToLeaveBox;
+			}
+			if (distToLeaveBox > ray.m_dist)
+			{
+				return result;
+			}
+			// the same boundaries the block by block steps would cross, so it ends in the very block they would
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				while (distToNextBoundary[axis] < distToLeaveBox)
+				{
+					blockCoords[axis] += step[axis];
+					distToNextBoundary[axis] = GetDistToNextBoundary(blockCoords[axis], step[axis], rayStart[axis], oneOverFwd[axis]);
+				}
+			}
+			localX = blockCoords[0] - boxMins[0];
+			localY = blockCoords[1] - boxMins[1];
+		}
+		else
+		{
+			int columnIndex = localX | (localY << CHUNK_BITSHIFT_Y);
+			int blockIndex = columnIndex | (blockCoords[2] << CHUNK_BITSHIFT_Z);
+			if (blockCoords[2] <= chunk->GetHighestSolidZ(columnIndex) && IsBlockSolid(chunk, blockIndex))
+			{
+				result.m_didImpact = true;
+				result.m_impactDist = dist;
+				result.m_impactPos = ray.m_start + ray.m_fwdNormal * dist;
+				result.m_aimedBlockIter = BlockIter(chunk, blockIndex);
+				if (entryAxis < 0)
+				{
+					result.m_impactNormal = ray.m_fwdNormal * (-1.f);
+				}
+				else
+				{
+					// on the face it came in through, facing the raycast
+					float impactPos[3] = { result.m_impactPos.x, result.m_impactPos.y, result.m_impactPos.z };
+					float impactNormal[3] = { 0.f, 0.f, 0.f };
+					impactPos[entryAxis] = float(step[entryAxis] > 0 ? blockCoords[entryAxis] : blockCoords[entryAxis] + 1);
+					impactNormal[entryAxis] = -float(step[entryAxis]);
+					result.m_impactPos = Vec3(impactPos[0], impactPos[1], impactPos[2]);
+					result.m_impactNormal = Vec3(impactNormal[0], impactNormal[1], impactNormal[2]);
+				}
+				return result;
+			}
+		}
+
+		// step into the next block through whichever boundary is nearest
+		int axis = 0;
+		if (distToNextBoundary[1] < distToNextBoundary[axis])
+		{
+			axis = 1;
+		}
+		if (distToNextBoundary[2] < distToNextBoundary[axis])
+		{
+			axis = 2;
+		}
+		dist = distToNextBoundary[axis];
+		if (dist > ray.m_dist)
+		{
+			return result;
+		}
+		blockCoords[axis] += step[axis];
+		distToNextBoundary[axis] = GetDistToNextBoundary(blockCoords[axis], step[axis], rayStart[axis], oneOverFwd[axis]);
+		entryAxis = axis;
+
+		if (axis == 0)
+		{
+			localX += step[0];
+			if (localX == CHUNK_SIZE_X)
+			{
+				chunk = chunk->m_eastNeighbor;
+				localX = 0;
+			}
+			else if (localX < 0)
+			{
+				chunk = chunk->m_westNeighbor;
+				localX = CHUNK_SIZE_X - 1;
+			}
+		}
+		else if (axis == 1)
+		{
+			localY += step[1];
+			if (localY == CHUNK_SIZE_Y)
+			{
+				chunk = chunk->m_northNeighbor;
+				localY = 0;
+			}
+			else if (localY < 0)
+			{
+				chunk = chunk->m_southNeighbor;
+				localY = CHUNK_SIZE_Y - 1;
+			}
+		}
+		else if (blockCoords[2] < 0 || blockCoords[2] >= CHUNK_SIZE_Z)
+		{
+			return result; // out of the top or the bottom of the world, it never comes back
+		}
+
+		if (!chunk)
+		{
+			return result; // the active chunks end here
+		}
+	}
+}
+
+void RaycastVoxels(ChunkCoordsHashMap<Chunk> const& chunks, VoxelRay const* rays, int numRays, SimpleMinerRaycastResult* out_results, bool useJobWorkers)
+{
+	if (!useJobWorkers || !g_theJobSystem)
+	{
+		for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+		{
+			out_results[rayIndex] = RaycastVoxels(chunks, rays[rayIndex]);
+		}
+		return;
+	}
+
+	g_theJobSystem->ParallelFor(0, numRays, VOXEL_RAYCAST_RAYS_PER_JOB, [&chunks, rays, out_results](int beginIndex, int endIndex)
+		{
+			for (int rayIndex = beginIndex; rayIndex < endIndex; ++rayIndex)
+			{
+				out_results[rayIndex] = RaycastVoxels(chunks, rays[rayIndex]);
+			}
+		});
+}
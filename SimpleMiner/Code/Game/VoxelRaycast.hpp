@@ -0,0 +1,31 @@
+#pragma once
+#include "Game/BlockIterator.hpp"
+#include "Game/ChunkCoordsHashMap.hpp"
+#include "Engine/core/RaycastUtils.hpp"
+
+struct SimpleMinerRaycastResult : public RaycastResult3D
+{
+	BlockIter m_aimedBlockIter;
+};
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// raycasts against the solid blocks of the active chunks, an Amanatides-Woo DDA visiting every block the ray passes through in order
+// a section with no visible block is crossed in one go without reading a block, and a block above its column's highest solid one is never read
+// the ray stops where the active chunks end or where it leaves the top or bottom of the world, those count as misses
+// only reads the chunks, so any number of rays could be traced at once on the job workers as long as nothing changes the chunks meanwhile
+
+struct VoxelRay
+{
+	Vec3	m_start;
+	Vec3	m_fwdNormal;
+	float	m_dist = 0.f;
+};
+
+constexpr int VOXEL_RAYCAST_RAYS_PER_JOB = 256;
+
+// the same result FastRaycastForVoxelGrids gives, a ray starting inside a solid block hits it at 0
+SimpleMinerRaycastResult RaycastVoxels(ChunkCoordsHashMap<Chunk> const& chunks, VoxelRay const& ray);
+
+// out_results[i] is for rays[i], ranges of VOXEL_RAYCAST_RAYS_PER_JOB rays go to the job workers when useJobWorkers,
+// returns when every ray is done
+void RaycastVoxels(ChunkCoordsHashMap<Chunk> const& chunks, VoxelRay const* rays, int numRays, SimpleMinerRaycastResult* out_results, bool useJobWorkers);
@@ -8,6 +8,7 @@
 #include "Engine/Math/Vec4.hpp"
 #include "Engine/core/JobSystem.hpp"
 #include "Engine/Core/Time.hpp"
+#include "Engine/core/FileUtils.hpp"
 #include "ThirdParty/Noise_Squirrel/SmoothNoise.hpp"
 #include "ThirdParty/Noise_Squirrel/RawNoise.hpp"
 #include "Game/Entity.hpp"
@@ -15,7 +16,9 @@
 #include "Game/Game.hpp"
 #include "Game/App.hpp"
 #include "Game/Player.hpp"
+#include "Game/ChunkMesher.hpp"
 #include <cmath>
+#include <algorithm>
 
 static const int k_lightingFogConstantsSlot = 8;
 
@@ -32,27 +35,30 @@ World::World()
 
 	BlockDef::InitializeBlockDefs();
 	BlockTemplate::InitializeBlockTemplates();
+	InitializeChunkMesherBlockTiles();
+	BuildChunkActivationOffsets();
 }
 
 World::~World()
 {
 	delete m_dataTimer;
 
-	// todo: loop the map, delete or ++iter then clear
-	std::map<IntVec2, Chunk*>::iterator iter;
-	for (iter = m_activeChunks.begin(); iter != m_activeChunks.end(); ++iter)
-	{
-		Chunk* chunk = iter->second;
-		if (chunk->m_needsSaving)
-		{
-			chunk->SaveBlocksDataToFile();
-		}
+	CancelAllQueuedChunkGenerationJobs();
 
-		delete chunk;
-		chunk = nullptr;
+	// the active chunks are saved on the I/O lane like any other deactivated chunk, then wait for every save to be written
+	m_dirtyLightBlockIters.clear();
+	for (int chunkIndex = m_activeChunks.GetSize() - 1; chunkIndex >= 0; --chunkIndex)
+	{
+		DeactivateChunk(m_activeChunks.GetEntry(chunkIndex).m_coords);
 	}
+	g_theJobSystem->WaitFor(m_pendingDiskWritesHandle);
+	g_theJobSystem->WaitFor(m_pendingChunkMeshJobsHandle);
+	RetrieveCompletedChunkSaveJobs();
+	RetrieveCompletedChunkMeshJobs();
+	RetrieveCompletedChunkFilesConversionJob();
 
-	m_activeChunks.clear();
+	delete m_chunkRegionFiles;
+	m_chunkRegionFiles = nullptr;
 }
 
 void World::Startup()
@@ -63,6 +69,13 @@ void World::Startup()
 	m_worldDay += m_worldStartTime;
 	m_seed = g_gameConfigBlackboard.GetValue("WorldSeed", 0);
 
+	// the save folder is created by the game before the world starts up
+	unsigned char worldSeed = (unsigned char)m_seed;
+	m_chunkRegionFiles = new ChunkRegionFiles(Stringf("Saves/World_%u", worldSeed));
+	// queued before any chunk load, and with the single I/O worker it finishes before the first load starts
+	m_chunkFilesConversionJob = new ChunkFilesConversionJob(m_chunkRegionFiles);
+	g_theJobSystem->QueueJobs(m_chunkFilesConversionJob, m_pendingDiskWritesHandle);
+
 	std::string spriteSheetPath = "Data/Images/BasicSprites_64x64.png";
 	m_blockTexture = g_theRenderer->CreateOrGetTextureFromFile(spriteSheetPath.c_str());
 
@@ -79,19 +92,27 @@ void World::Update()
 	double timeAtStart = GetCurrentTimeSeconds();
 	UpdateTime();
 
+	UpdateChunkStreamingReplay();
 	UpdatePlayerLocatedCoords();
 	ShootRaycastForCollisionTest(dynamic_cast<Player*>(g_theGame->m_player)->m_raycastDist);
 
-	DeactivateChunks();
-	ActivateChunks(); // 1
+	UpdateQueuedChunkGenerationJobs();
+	double chunkStreamingBudgetEndTime = GetCurrentTimeSeconds() + CHUNK_STREAMING_BUDGET_SECONDS;
+	DeactivateChunks(chunkStreamingBudgetEndTime);
+	ActivateChunks(chunkStreamingBudgetEndTime); // 1
+	RetrieveCompletedChunkSaveJobs();
+	RetrieveCompletedChunkLoadJobs();
 	RetrieveCompletedChunkGenerationJobAndActivate();
+	RetrieveCompletedChunkFilesConversionJob();
 
 	WorldInputControl();
 	g_theGame->m_player->Update(); // 2
 	UpdateSimplerMinerWorldShader();
 
 	ProcessDirtyLighting(); // 3
-	UpdateAllActiveChunks(); // 4 build new vertex buffer data after lighting is corrected
+	RetrieveCompletedChunkMeshJobs();
+	UpdateAllActiveChunks(); // 4 queue new mesh jobs after lighting is corrected
+	CompactFarChunks();
 
 	if (GetDebugRenderVisibility())
 	{
@@ -112,21 +133,29 @@ void World::Render() const
 	g_theRenderer->BindTexture(m_blockTexture);
 	g_theRenderer->SetRasterizerMode(RasterizerMode::SOLID_CULL_BACK);
 	g_theRenderer->SetDepthMode(DepthMode::ENABLED);
-	g_theRenderer->SetModelConstants(Mat44());
 	BindSimplerMinerWorldShaderData();
-	g_theRenderer->BindShader(g_theApp->g_shaders[WORLD]);
 
-	std::map<IntVec2, Chunk*>::const_iterator iter;
-	for (iter = m_activeChunks.begin(); iter != m_activeChunks.end(); ++iter)
+	// greedy meshes are local to their chunk, the old meshes are already in world space
+	g_theRenderer->BindShader(g_theApp->g_shaders[WORLD_VOXEL]);
+	for (int chunkIndex = 0; chunkIndex < m_activeChunks.GetSize(); ++chunkIndex)
+	{
+		Chunk const* chunk = m_activeChunks.GetEntry(chunkIndex).m_value;
+		g_theRenderer->SetModelConstants(chunk->GetModelMatrix());
+		chunk->Render(true);
+	}
+
+	g_theRenderer->SetModelConstants(Mat44());
+	g_theRenderer->BindShader(g_theApp->g_shaders[WORLD]);
+	for (int chunkIndex = 0; chunkIndex < m_activeChunks.GetSize(); ++chunkIndex)
 	{
-		iter->second->Render();
+		m_activeChunks.GetEntry(chunkIndex).m_value->Render(false);
 	}
 
 	if (g_theApp->m_debugMode)
 	{
-		for (iter = m_activeChunks.begin(); iter != m_activeChunks.end(); ++iter)
+		for (int chunkIndex = 0; chunkIndex < m_activeChunks.GetSize(); ++chunkIndex)
 		{
-			iter->second->DrawDebugRender();
+			m_activeChunks.GetEntry(chunkIndex).m_value->DrawDebugRender();
 		}
 	}
 
@@ -172,10 +201,9 @@ void World::UpdatePlayerLocatedCoords()
 	m_playerChunkCoords = GetChunkCoordsForWorldPos(playerWorldPos);
 
 	// get located chunk ptr
-	std::map<IntVec2, Chunk*>::iterator iter = m_activeChunks.find(m_playerChunkCoords);
-	if (iter != m_activeChunks.end())
+	m_playerLocatedChunk = m_activeChunks.Find(m_playerChunkCoords);
+	if (m_playerLocatedChunk)
 	{
-		m_playerLocatedChunk = iter->second;
 		m_playerLocalBlockCoords = m_playerLocatedChunk->GetlocalBlockCoordsForWorldPos(playerWorldPos);
 	}
 	else
@@ -281,6 +309,19 @@ IntVec2 World::GetChunkCoordsForWorldPos(Vec3 worldPos)
 	return IntVec2(chunkCoordsX, chunkCoordsY);
 }
 
+// the chunk's column heights make this a lookup, so it is fine to call every frame
+float World::GetGroundHeightAtWorldPos(Vec3 worldPos, float defaultHeight)
+{
+	Chunk* chunk = m_activeChunks.Find(GetChunkCoordsForWorldPos(worldPos));
+	if (!chunk)
+	{
+		return defaultHeight;
+	}
+	IntVec3 localCoords = chunk->GetlocalBlockCoordsForWorldPos(Vec3(worldPos.x, worldPos.y, 0.f));
+	int columnIndex = localCoords.x | (localCoords.y << CHUNK_BITSHIFT_Y);
+	return (float)(chunk->GetHighestSolidZ(columnIndex) + 1);
+}
+
 void World::StartupAllBlocks()
 {
 	// for (int i = 0; i < (int)m_activeChunks.size(); ++i)
@@ -291,28 +332,98 @@ void World::StartupAllBlocks()
 
 void World::UpdateAllActiveChunks()
 {
-	std::map<IntVec2, Chunk*>::iterator iter;
-	for (iter = m_activeChunks.begin(); iter != m_activeChunks.end(); ++iter)
+	for (int chunkIndex = 0; chunkIndex < m_activeChunks.GetSize(); ++chunkIndex)
 	{
-		iter->second->Update();
+		m_activeChunks.GetEntry(chunkIndex).m_value->Update();
 	}
 }
 
-void World::DeactivateChunks()
+// round robin over the active chunks, so every one is looked at again after a while
+void World::CompactFarChunks()
 {
-	if (m_activeChunks.size() > MAX_CHUNKS)
+	if (!m_compactFarChunks)
 	{
-		DeactivateFarthestActiveChunk();
+		return;
+	}
+
+	int numActiveChunks = m_activeChunks.GetSize();
+	int numChecks = (numActiveChunks < CHUNKS_TO_COMPACT_CHECKS_PER_FRAME) ? numActiveChunks : CHUNKS_TO_COMPACT_CHECKS_PER_FRAME;
+	for (int checkIndex = 0; checkIndex < numChecks; ++checkIndex)
+	{
+		if (m_chunkCompactionCursor >= numActiveChunks)
+		{
+			m_chunkCompactionCursor = 0;
+		}
+		Chunk* chunk = m_activeChunks.GetEntry(m_chunkCompactionCursor).m_value;
+		++m_chunkCompactionCursor;
+
+		if (CanChunkBeCompacted(chunk))
+		{
+			chunk->CompactBlocks();
+		}
+	}
+}
+
+// a chunk that is about to be meshed, or whose neighbor is, would only be expanded again right away
+bool World::CanChunkBeCompacted(Chunk const* chunk) const
+{
+	if (chunk->IsCompacted() || chunk->IsMeshDirty() || chunk->m_lightQueues.m_isQueued)
+	{
+		return false;
+	}
+
+	int distSqr = chunk->m_chunkCoords.GetLengthSquaredToThisCoords(m_playerChunkCoords) * CHUNK_SIZE_X * CHUNK_SIZE_Y;
+	if (distSqr <= int(CHUNK_COMPACT_RANGE * CHUNK_COMPACT_RANGE))
+	{
+		return false;
+	}
+
+	Chunk const* neighbors[4] = { chunk->m_eastNeighbor, chunk->m_westNeighbor, chunk->m_northNeighbor, chunk->m_southNeighbor };
+	for (int neighborIndex = 0; neighborIndex < 4; ++neighborIndex)
+	{
+		if (!neighbors[neighborIndex] || neighbors[neighborIndex]->IsMeshDirty())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void World::DeactivateChunks(double budgetEndTime)
+{
+	if (m_playerChunkCoords != m_lastDeactivationPlayerChunkCoords)
+	{
+		CollectChunksOutOfPlayerRange();
 	}
 
-	DeactivateFarthestActiveChunkOutOfPlayerRange();
+	// at least one per frame, then as many as fit in the budget
+	int maxDistSqr = int(CHUNK_DACTIVATE_RANGE * CHUNK_DACTIVATE_RANGE);
+	int numDeactivated = 0;
+	while (!m_chunksToDeactivate.empty() && (numDeactivated == 0 || GetCurrentTimeSeconds() < budgetEndTime))
+	{
+		IntVec2 chunkCoords = m_chunksToDeactivate.back();
+		m_chunksToDeactivate.pop_back();
+
+		// chunks newly activated out of range are added later, so the list could have been dealt with already
+		int distSqr = chunkCoords.GetLengthSquaredToThisCoords(m_playerChunkCoords) * CHUNK_SIZE_X * CHUNK_SIZE_Y;
+		if (distSqr > maxDistSqr && m_activeChunks.Contains(chunkCoords))
+		{
+			DeactivateChunk(chunkCoords);
+			++numDeactivated;
+		}
+	}
+
+	if (m_activeChunks.GetSize() > MAX_CHUNKS)
+	{
+		DeactivateFarthestActiveChunk();
+	}
 }
 
-void World::ActivateChunks()
+void World::ActivateChunks(double budgetEndTime)
 {
-	if (m_activeChunks.size() < MAX_CHUNKS)
+	if (m_activeChunks.GetSize() < MAX_CHUNKS)
 	{
-		ActivateNearestMissingChunkInPlayerRange();
+		ActivateMissingChunksInPlayerRange(budgetEndTime);
 	}
 }
 
@@ -322,10 +433,9 @@ void World::DeactivateFarthestActiveChunk()
 	// Get the farthest active chunk from player's located chunk
 	int minDistSqr = 0;
 	IntVec2 deactivateChunkCoords = BAD_CHUNK_COORDS;
-	std::map<IntVec2, Chunk*>::iterator iter;
-	for (iter = m_activeChunks.begin(); iter != m_activeChunks.end(); ++iter)
+	for (int chunkIndex = 0; chunkIndex < m_activeChunks.GetSize(); ++chunkIndex)
 	{
-		Chunk*& chunk = iter->second;
+		Chunk* chunk = m_activeChunks.GetEntry(chunkIndex).m_value;
 		int disSqr = chunk->m_chunkCoords.GetLengthSquaredToThisCoords(m_playerChunkCoords);
 		if (disSqr > minDistSqr)
 		{
@@ -341,219 +451,408 @@ void World::DeactivateFarthestActiveChunk()
 	}
 }
 
-// find any chunk that is too far away from the player and delete it
-void World::DeactivateFarthestActiveChunkOutOfPlayerRange()
+// find every chunk that is too far away from the player, they get deactivated over the next frames farthest first
+void World::CollectChunksOutOfPlayerRange()
 {
-	int maxDistSqr = int(CHUNK_DACTIVATE_RANGE * CHUNK_DACTIVATE_RANGE);
-	IntVec2 deactivateChunkCoords = BAD_CHUNK_COORDS;
+	m_lastDeactivationPlayerChunkCoords = m_playerChunkCoords;
+	m_chunksToDeactivate.clear();
 
-	std::map<IntVec2, Chunk*>::iterator iter;
-	for (iter = m_activeChunks.begin(); iter != m_activeChunks.end(); ++iter)
+	int maxDistSqr = int(CHUNK_DACTIVATE_RANGE * CHUNK_DACTIVATE_RANGE);
+	for (int chunkIndex = 0; chunkIndex < m_activeChunks.GetSize(); ++chunkIndex)
 	{
-		Chunk*& chunk = iter->second;
-		int disSqr = chunk->m_chunkCoords.GetLengthSquaredToThisCoords(m_playerChunkCoords) * CHUNK_SIZE_X * CHUNK_SIZE_Y;
+		IntVec2 chunkCoords = m_activeChunks.GetEntry(chunkIndex).m_coords;
+		int disSqr = chunkCoords.GetLengthSquaredToThisCoords(m_playerChunkCoords) * CHUNK_SIZE_X * CHUNK_SIZE_Y;
 		if (disSqr > maxDistSqr)
 		{
-			maxDistSqr = disSqr;
-			deactivateChunkCoords = chunk->m_chunkCoords;
+			m_chunksToDeactivate.push_back(chunkCoords);
 		}
 	}
 
-	// remove the active chunk from map
-	if (deactivateChunkCoords != BAD_CHUNK_COORDS)
-	{
-		DeactivateChunk(deactivateChunkCoords);
-	}
+	IntVec2 playerChunkCoords = m_playerChunkCoords;
+	std::sort(m_chunksToDeactivate.begin(), m_chunksToDeactivate.end(), [playerChunkCoords](IntVec2 const& a, IntVec2 const& b)
+		{
+			return a.GetLengthSquaredToThisCoords(playerChunkCoords) < b.GetLengthSquaredToThisCoords(playerChunkCoords);
+		});
 }
 
 void World::DeactivateChunk(IntVec2 chunkCoords)
 {
-	std::map<IntVec2, Chunk*>::iterator iter;
-	iter = m_activeChunks.find(chunkCoords);
-	Chunk*& chunk = iter->second;
-	chunk->m_chunkState = ChunkState::DEACTIVATING_QUEUED_SAVE;
+	Chunk* chunk = m_activeChunks.Find(chunkCoords);
+	m_activeChunks.Remove(chunkCoords);
+	m_chunkActivationCursor = 0; // it may leave a hole the cursor has already passed
+
+	// Update 2D Doubly Linked List, the chunk already points to its neighbors so nothing has to be looked up
+	if (chunk->m_eastNeighbor)
+	{
+		chunk->m_eastNeighbor->m_westNeighbor = nullptr;
+	}
+	if (chunk->m_westNeighbor)
+	{
+		chunk->m_westNeighbor->m_eastNeighbor = nullptr;
+	}
+	if (chunk->m_northNeighbor)
+	{
+		chunk->m_northNeighbor->m_southNeighbor = nullptr;
+	}
+	if (chunk->m_southNeighbor)
+	{
+		chunk->m_southNeighbor->m_northNeighbor = nullptr;
+	}
+
+	UndirtyAllBlocksInChunk(chunk);
+	m_lightPropagator.RemoveChunk(chunk);
+	CancelOrOrphanChunkMeshJobs(chunk);
 
+	// the file is written on the I/O lane, the chunk is deleted when the save job comes back
 	if (chunk->m_needsSaving)
 	{
-		chunk->SaveBlocksDataToFile();
+		chunk->m_chunkState = ChunkState::DEACTIVATING_QUEUED_SAVE;
+		ChunkSaveJob* job = new ChunkSaveJob(chunk);
+		chunk->m_pendingJob = job;
+		m_chunksBeingSaved.Set(chunkCoords, chunk);
+		g_theJobSystem->QueueJobs(job, m_pendingDiskWritesHandle);
+		return;
 	}
 
 	chunk->m_chunkState = ChunkState::DECONSTRUCTING;
 	delete chunk;
-	m_activeChunks.erase(iter);
+}
 
-	// Update 2D Doubly Linked List
-	iter = m_activeChunks.find(chunkCoords + IntVec2(1, 0));
-	if (iter != m_activeChunks.end())
+void World::DeactivateChunk(Chunk* chunkPtr)
+{
+	DeactivateChunk(chunkPtr->m_chunkCoords);
+}
+
+// every offset inside the activation range, sorted by distance, only built once
+void World::BuildChunkActivationOffsets()
+{
+	int maxDistSqr = int(CHUNK_ACTIVATE_RANGE * CHUNK_ACTIVATE_RANGE);
+	m_chunkActivationOffsets.clear();
+	for (int i = -MAX_CHUNK_RADIUS_X; i <= MAX_CHUNK_RADIUS_X; ++i)
 	{
-		iter->second->m_westNeighbor = nullptr;
+		for (int j = -MAX_CHUNK_RADIUS_Y; j <= MAX_CHUNK_RADIUS_Y; ++j)
+		{
+			IntVec2 offset(i, j);
+			int distSqr = offset.GetLengthSquaredToThisCoords(IntVec2(0, 0)) * CHUNK_SIZE_X * CHUNK_SIZE_Y;
+			if (distSqr < maxDistSqr)
+			{
+				m_chunkActivationOffsets.push_back(offset);
+			}
+		}
 	}
 
-	iter = m_activeChunks.find(chunkCoords + IntVec2(-1, 0));
-	if (iter != m_activeChunks.end())
+	std::stable_sort(m_chunkActivationOffsets.begin(), m_chunkActivationOffsets.end(), [](IntVec2 const& a, IntVec2 const& b)
+		{
+			return (a.x * a.x + a.y * a.y) < (b.x * b.x + b.y * b.y);
+		});
+}
+
+// walks the spiral from the nearest missing chunk outwards and requests as many as the budget and the job queue allow
+void World::ActivateMissingChunksInPlayerRange(double budgetEndTime)
+{
+	// when the player moves every distance changes, so start from the center again
+	if (m_playerChunkCoords != m_lastActivationPlayerChunkCoords)
 	{
-		iter->second->m_eastNeighbor = nullptr;
+		m_lastActivationPlayerChunkCoords = m_playerChunkCoords;
+		m_chunkActivationCursor = 0;
 	}
 
-	iter = m_activeChunks.find(chunkCoords + IntVec2(0, 1));
-	if (iter != m_activeChunks.end())
+	int numRequested = 0;
+	while (m_chunkActivationCursor < (int)m_chunkActivationOffsets.size())
 	{
-		iter->second->m_northNeighbor = nullptr;
+		if (numRequested > 0 && GetCurrentTimeSeconds() >= budgetEndTime)
+		{
+			return;
+		}
+
+		IntVec2 chunkCoords = m_playerChunkCoords + m_chunkActivationOffsets[m_chunkActivationCursor];
+
+		// if this chunk is not being generated or queued in the job system, and not active already
+		// a chunk that is still being saved is skipped, the cursor starts over when its save job comes back
+		if (!m_chunksBeingGeneratedOrLoaded.Contains(chunkCoords) && !m_activeChunks.Contains(chunkCoords) && !m_chunksBeingSaved.Contains(chunkCoords))
+		{
+			if (!RequestNewChunkGenerationJob(chunkCoords))
+			{
+				return; // the queue is full, try the same one again next frame
+			}
+			++numRequested;
+		}
+
+		++m_chunkActivationCursor;
 	}
+}
 
-	iter = m_activeChunks.find(chunkCoords + IntVec2(0, -1));
-	if (iter != m_activeChunks.end())
+bool World::RequestNewChunkGenerationJob(IntVec2 chunkCoords)
+{
+	// only the generate and load jobs count, the mesh jobs sharing the prioritized list must not hold back new chunks
+	// the ones the workers are running right now plus up to maxQueuedJobs waiting
+	int maxQueuedJobs = m_prioritizeChunkJobs ? MAX_QUEUEDJOBS_CHUNKGENERATION_PRIORITIZED : MAX_QUEUEDJOBS_CHUNKGENERATION;
+	if (m_chunksBeingGeneratedOrLoaded.GetSize() < maxQueuedJobs + g_theJobSystem->GetNumWorkers())
 	{
-		iter->second->m_northNeighbor = nullptr;
+		Chunk* chunk = new Chunk(chunkCoords);
+
+		chunk->Startup();
+		return true;
 	}
+	return false;
+}
 
-	UndirtyAllBlocksInChunk(chunk);
+void World::QueueChunkGenerationJob(Chunk* chunk)
+{
+	ChunkGenerateJob* job = new ChunkGenerateJob(chunk);
+	chunk->m_pendingJob = job;
+	chunk->m_chunkState = ChunkState::ACTIVATING_QUEUED_GENERATE;
+	g_theJobSystem->QueuePrioritizedJob(job, GetChunkGenerationJobPriority(chunk->m_chunkCoords));
 }
 
-void World::DeactivateChunk(Chunk* chunkPtr)
+void World::ActivateNewChunk(Chunk* chunk)
 {
-	IntVec2& chunkCoords = chunkPtr->m_chunkCoords;
-	std::map<IntVec2, Chunk*>::iterator iter;
-	iter = m_activeChunks.find(chunkCoords);
+	IntVec2 chunkCoords = chunk->m_chunkCoords;
 
-	if (chunkPtr->m_needsSaving)
+	// Update 2D Doubly Linked List
+	chunk->m_eastNeighbor = m_activeChunks.Find(chunkCoords + IntVec2(1, 0));
+	if (chunk->m_eastNeighbor)
 	{
-		chunkPtr->SaveBlocksDataToFile();
+		chunk->m_eastNeighbor->m_westNeighbor = chunk;
 	}
 
-	UndirtyAllBlocksInChunk(chunkPtr);
-	delete chunkPtr;
-	m_activeChunks.erase(iter);
+	chunk->m_westNeighbor = m_activeChunks.Find(chunkCoords + IntVec2(-1, 0));
+	if (chunk->m_westNeighbor)
+	{
+		chunk->m_westNeighbor->m_eastNeighbor = chunk;
+	}
 
-	// Update 2D Doubly Linked List
-	iter = m_activeChunks.find(chunkCoords + IntVec2(1, 0));
-	if (iter != m_activeChunks.end())
+	chunk->m_northNeighbor = m_activeChunks.Find(chunkCoords + IntVec2(0, 1));
+	if (chunk->m_northNeighbor)
 	{
-		iter->second->m_westNeighbor = nullptr;
+		chunk->m_northNeighbor->m_southNeighbor = chunk;
+	}
+
+	chunk->m_southNeighbor = m_activeChunks.Find(chunkCoords + IntVec2(0, -1));
+	if (chunk->m_southNeighbor)
+	{
+		chunk->m_southNeighbor->m_northNeighbor = chunk;
 	}
 
-	iter = m_activeChunks.find(chunkCoords + IntVec2(-1, 0));
-	if (iter != m_activeChunks.end())
+	m_activeChunks.Set(chunkCoords, chunk);
+	chunk->m_chunkState = ChunkState::ACTIVE;
+	if (m_replayIOTestPhase == 1)
 	{
-		iter->second->m_eastNeighbor = nullptr;
+		chunk->m_needsSaving = true; // the I/O test needs every chunk along the path on disk
 	}
 
-	iter = m_activeChunks.find(chunkCoords + IntVec2(0, 1));
-	if (iter != m_activeChunks.end())
+	// a job that finished after the player left is already out of range
+	int distSqr = chunkCoords.GetLengthSquaredToThisCoords(m_playerChunkCoords) * CHUNK_SIZE_X * CHUNK_SIZE_Y;
+	if (distSqr > int(CHUNK_DACTIVATE_RANGE * CHUNK_DACTIVATE_RANGE))
 	{
-		iter->second->m_northNeighbor = nullptr;
+		m_chunksToDeactivate.push_back(chunkCoords);
 	}
 
-	iter = m_activeChunks.find(chunkCoords + IntVec2(0, -1));
-	if (iter != m_activeChunks.end())
+	if (m_useWavefrontLighting)
 	{
-		iter->second->m_northNeighbor = nullptr;
+		m_lightPropagator.InitializeChunk(chunk);
+	}
+	else
+	{
+		LightInfluenceInitialization(chunk);
 	}
 }
 
-void World::ActivateNearestMissingChunkInPlayerRange()
+// every chunk finished since last frame gets activated
+void World::RetrieveCompletedChunkGenerationJobAndActivate()
 {
-	// search through the chess board to find the closest one to the player
-	IntVec2 chunkStartCoords = IntVec2((m_playerChunkCoords.x - MAX_CHUNK_RADIUS_X), (m_playerChunkCoords.y - MAX_CHUNK_RADIUS_Y));
-	IntVec2 chunkEndCoords = IntVec2((m_playerChunkCoords.x + MAX_CHUNK_RADIUS_X), (m_playerChunkCoords.y + MAX_CHUNK_RADIUS_Y));
+	m_completedChunkGenerationJobs.clear();
+	g_theJobSystem->RetrieveAllCompletedJobs(m_completedChunkGenerationJobs);
+	for (int i = 0; i < (int)m_completedChunkGenerationJobs.size(); ++i)
+	{
+		ChunkGenerateJob* chunkGenerationJob = m_completedChunkGenerationJobs[i];
+		chunkGenerationJob->m_chunk->m_pendingJob = nullptr;
+		m_chunksBeingGeneratedOrLoaded.Remove(chunkGenerationJob->m_chunk->m_chunkCoords);
+		ActivateNewChunk(chunkGenerationJob->m_chunk);
+		delete chunkGenerationJob;
+	}
+	m_completedChunkGenerationJobs.clear();
+}
 
-	IntVec2 chunkCoordsNeedToActivate = BAD_CHUNK_COORDS;
-	int minDistSqr = int(CHUNK_ACTIVATE_RANGE * CHUNK_ACTIVATE_RANGE);
+// chunks with a save file are ready to be activated, the others still have to be generated unless the player has left them behind
+void World::RetrieveCompletedChunkLoadJobs()
+{
+	m_completedChunkLoadJobs.clear();
+	g_theJobSystem->RetrieveAllCompletedJobs(m_completedChunkLoadJobs);
 
-	for (int i = chunkStartCoords.x; i <= chunkEndCoords.x; ++i)
+	int maxDistSqr = int(CHUNK_DACTIVATE_RANGE * CHUNK_DACTIVATE_RANGE);
+	for (int i = 0; i < (int)m_completedChunkLoadJobs.size(); ++i)
 	{
-		for (int j = chunkStartCoords.y; j <= chunkEndCoords.y; ++j)
-		{
-			IntVec2 chunkCoords(i, j);
-			int distSqr = chunkCoords.GetLengthSquaredToThisCoords(m_playerChunkCoords) * CHUNK_SIZE_X * CHUNK_SIZE_Y;
-			if (distSqr < minDistSqr)
-			{
-				// if this chunk is not being generated or queued in the job system
-				auto found = m_chunksBeingGeneratedOrLoaded.find(chunkCoords);
-				if (found == m_chunksBeingGeneratedOrLoaded.end())
-				{
-					// this waiting to be activate chunk also need to be not in the activate list
-					std::map<IntVec2, Chunk*>::iterator iter;
-					iter = m_activeChunks.find(chunkCoords);
-
-					if (iter == m_activeChunks.end())
-					{
-						chunkCoordsNeedToActivate = chunkCoords;
-						minDistSqr = distSqr;
-					}
-				}
+		ChunkLoadJob* chunkLoadJob = m_completedChunkLoadJobs[i];
+		Chunk* chunk = chunkLoadJob->m_chunk;
+		IntVec2 chunkCoords = chunk->m_chunkCoords;
+		chunk->m_pendingJob = nullptr;
 
-			}
+		int distSqr = chunkCoords.GetLengthSquaredToThisCoords(m_playerChunkCoords) * CHUNK_SIZE_X * CHUNK_SIZE_Y;
+		if (chunkLoadJob->m_wasLoaded)
+		{
+			++m_replayNumChunksLoaded;
+			m_chunksBeingGeneratedOrLoaded.Remove(chunkCoords);
+			ActivateNewChunk(chunk);
 		}
+		else if (m_prioritizeChunkJobs && distSqr > maxDistSqr)
+		{
+			m_chunksBeingGeneratedOrLoaded.Remove(chunkCoords);
+			delete chunk;
+		}
+		else
+		{
+			QueueChunkGenerationJob(chunk);
+		}
+		delete chunkLoadJob;
 	}
+	m_completedChunkLoadJobs.clear();
+}
 
-	// if the result has been modified
-	if (chunkCoordsNeedToActivate != BAD_CHUNK_COORDS)
+void World::RetrieveCompletedChunkSaveJobs()
+{
+	m_completedChunkSaveJobs.clear();
+	g_theJobSystem->RetrieveAllCompletedJobs(m_completedChunkSaveJobs);
+	for (int i = 0; i < (int)m_completedChunkSaveJobs.size(); ++i)
+	{
+		ChunkSaveJob* chunkSaveJob = m_completedChunkSaveJobs[i];
+		Chunk* chunk = chunkSaveJob->m_chunk;
+		m_chunksBeingSaved.Remove(chunk->m_chunkCoords);
+		chunk->m_chunkState = ChunkState::DECONSTRUCTING;
+		delete chunk;
+		delete chunkSaveJob;
+	}
+
+	if (!m_completedChunkSaveJobs.empty())
 	{
-		RequestNewChunkGenerationJob(chunkCoordsNeedToActivate);
+		m_chunkActivationCursor = 0; // the activation skipped these coords while they were being saved
 	}
+	m_completedChunkSaveJobs.clear();
 }
 
-void World::RequestNewChunkGenerationJob(IntVec2 chunkCoords)
+void World::QueueChunkMeshJob(ChunkMeshJob* job)
 {
-	if (g_theJobSystem->GetNumQueuedJobs() <= MAX_QUEUEDJOBS_CHUNKGENERATION)
-	{
-		Chunk* chunk = new Chunk(chunkCoords);
+	int priority = job->m_chunk->m_chunkCoords.GetLengthSquaredToThisCoords(m_playerChunkCoords);
+	g_theJobSystem->QueuePrioritizedJob(job, priority, m_pendingChunkMeshJobsHandle);
+}
 
-		chunk->Startup();
-		// CheckIfCaveWormStartsThisChunk(chunk);
+// a result is only uploaded if its chunk is still active and nothing has dirtied the mesh since the snapshot was taken,
+// otherwise the chunk queues a fresh job in its next update
+void World::RetrieveCompletedChunkMeshJobs()
+{
+	m_completedChunkMeshJobs.clear();
+	g_theJobSystem->RetrieveAllCompletedJobs(m_completedChunkMeshJobs);
+	for (int i = 0; i < (int)m_completedChunkMeshJobs.size(); ++i)
+	{
+		ChunkMeshJob* chunkMeshJob = m_completedChunkMeshJobs[i];
+		Chunk* chunk = chunkMeshJob->m_chunk;
+		if (chunk)
+		{
+			ChunkSection& section = chunk->m_sections[chunkMeshJob->m_sectionIndex];
+			section.m_meshJob = nullptr;
+			if (!section.m_isMeshDirty)
+			{
+				chunk->UploadMeshFromJob(chunkMeshJob);
+			}
+		}
+		delete chunkMeshJob;
 	}
+	m_completedChunkMeshJobs.clear();
 }
 
-void World::ActivateNewChunk(Chunk* chunk)
+// a job no worker has claimed yet is dropped, a running one is left to finish and thrown away when it is retrieved
+void World::CancelOrOrphanChunkMeshJobs(Chunk* chunk)
 {
-	IntVec2 chunkCoords = chunk->m_chunkCoords;
-
-	// Update 2D Doubly Linked List
-	std::map<IntVec2, Chunk*>::iterator iter;
+	for (int sectionIndex = 0; sectionIndex < CHUNK_NUM_SECTIONS; ++sectionIndex)
+	{
+		ChunkMeshJob* job = chunk->m_sections[sectionIndex].m_meshJob;
+		if (!job)
+		{
+			continue;
+		}
+		chunk->m_sections[sectionIndex].m_meshJob = nullptr;
+		if (g_theJobSystem->CancelJob(job))
+		{
+			delete job;
+			continue;
+		}
+		job->m_chunk = nullptr;
+	}
+}
 
-	iter = m_activeChunks.find(chunkCoords + IntVec2(1, 0));
-	if (iter != m_activeChunks.end())
+void World::RetrieveCompletedChunkFilesConversionJob()
+{
+	if (!m_chunkFilesConversionJob)
 	{
-		chunk->m_eastNeighbor = iter->second;
-		chunk->m_eastNeighbor->m_westNeighbor = chunk;
+		return;
 	}
 
-	iter = m_activeChunks.find(chunkCoords + IntVec2(-1, 0));
-	if (iter != m_activeChunks.end())
+	std::vector<ChunkFilesConversionJob*> completedJobs;
+	g_theJobSystem->RetrieveAllCompletedJobs(completedJobs);
+	if (!completedJobs.empty())
 	{
-		chunk->m_westNeighbor = iter->second;
-		chunk->m_westNeighbor->m_eastNeighbor = chunk;
+		if (m_chunkFilesConversionJob->m_numConverted > 0)
+		{
+			g_theDevConsole->AddLine(Stringf("Converted %i chunk files into region files", m_chunkFilesConversionJob->m_numConverted), DevConsole::INFO_MINOR);
+		}
+		delete m_chunkFilesConversionJob;
+		m_chunkFilesConversionJob = nullptr;
 	}
+}
 
-	iter = m_activeChunks.find(chunkCoords + IntVec2(0, 1));
-	if (iter != m_activeChunks.end())
+// the closer the chunk is to the player, the sooner it gets generated
+int World::GetChunkGenerationJobPriority(IntVec2 chunkCoords)
+{
+	if (!m_prioritizeChunkJobs)
 	{
-		chunk->m_northNeighbor = iter->second;
-		chunk->m_northNeighbor->m_southNeighbor = chunk;
+		return m_numChunkGenerationJobsRequested++; // first come first served
 	}
+	return chunkCoords.GetLengthSquaredToThisCoords(m_playerChunkCoords);
+}
 
-	iter = m_activeChunks.find(chunkCoords + IntVec2(0, -1));
-	if (iter != m_activeChunks.end())
+void World::UpdateQueuedChunkGenerationJobs()
+{
+	if (!m_prioritizeChunkJobs || m_playerChunkCoords == m_lastPrioritizedPlayerChunkCoords)
 	{
-		chunk->m_southNeighbor = iter->second;
-		chunk->m_southNeighbor->m_northNeighbor = chunk;
+		return; // the distances only change when the player enters another chunk
 	}
+	m_lastPrioritizedPlayerChunkCoords = m_playerChunkCoords;
 
-	m_activeChunks[chunkCoords] = chunk;
-	chunk->m_chunkState = ChunkState::ACTIVE;
+	int maxDistSqr = int(CHUNK_DACTIVATE_RANGE * CHUNK_DACTIVATE_RANGE);
+	for (int jobIndex = m_chunksBeingGeneratedOrLoaded.GetSize() - 1; jobIndex >= 0; --jobIndex) // backwards because of the removing
+	{
+		IntVec2 chunkCoords = m_chunksBeingGeneratedOrLoaded.GetEntry(jobIndex).m_coords;
+		Chunk* chunk = m_chunksBeingGeneratedOrLoaded.GetEntry(jobIndex).m_value;
+		Job* job = chunk->m_pendingJob;
+		int distSqr = chunkCoords.GetLengthSquaredToThisCoords(m_playerChunkCoords) * CHUNK_SIZE_X * CHUNK_SIZE_Y;
+
+		// a chunk that already left the range would be deactivated right after it is generated, so do not generate it at all
+		// if a worker has already claimed it, let it finish and the deactivation will take care of it
+		// load jobs on the I/O lane are cancelled the same way, their priority is not used
+		if (distSqr > maxDistSqr && g_theJobSystem->CancelJob(job))
+		{
+			delete chunk;
+			delete job;
+			m_chunksBeingGeneratedOrLoaded.Remove(chunkCoords);
+			continue;
+		}
 
-	LightInfluenceInitialization(chunk);
+		job->m_priority = GetChunkGenerationJobPriority(chunkCoords);
+	}
 }
 
-void World::RetrieveCompletedChunkGenerationJobAndActivate()
+void World::CancelAllQueuedChunkGenerationJobs()
 {
-	ChunkGenerateJob* chunkGenerationJob = dynamic_cast<ChunkGenerateJob*>(g_theJobSystem->RetrieveCompletedJobs(nullptr));
-	if (chunkGenerationJob)
+	for (int jobIndex = m_chunksBeingGeneratedOrLoaded.GetSize() - 1; jobIndex >= 0; --jobIndex)
 	{
-		m_chunksBeingGeneratedOrLoaded.erase(chunkGenerationJob->m_chunk->m_chunkCoords);
-		ActivateNewChunk(chunkGenerationJob->m_chunk);
-		delete chunkGenerationJob;
+		Chunk* chunk = m_chunksBeingGeneratedOrLoaded.GetEntry(jobIndex).m_value;
+		Job* job = chunk->m_pendingJob;
+		if (g_theJobSystem->CancelJob(job))
+		{
+			m_chunksBeingGeneratedOrLoaded.Remove(chunk->m_chunkCoords);
+			delete chunk;
+			delete job;
+		}
 	}
 }
 
@@ -563,20 +862,11 @@ void World::WorldInputControl()
 	// deactivate all the chunks and reactivate
 	if (g_theInput->WasKeyJustPressed(KEYCODE_F8))
 	{
-		std::map<IntVec2, Chunk*>::iterator iter;
-		for (iter = m_activeChunks.begin(); iter != m_activeChunks.end(); ++iter)
+		m_dirtyLightBlockIters.clear();
+		for (int chunkIndex = m_activeChunks.GetSize() - 1; chunkIndex >= 0; --chunkIndex)
 		{
-			Chunk* chunk = iter->second;
-			if (chunk->m_needsSaving)
-			{
-				chunk->SaveBlocksDataToFile();
-			}
-
-			delete chunk;
-			chunk = nullptr;
+			DeactivateChunk(m_activeChunks.GetEntry(chunkIndex).m_coords);
 		}
-
-		m_activeChunks.clear();
 	}
 
 	if (g_theInput->WasKeyJustPressed('R'))
@@ -610,18 +900,13 @@ void World::UpdateOnScreenDisplayMessages()
 
 	float		time;
 	float		timeScale = g_theGameClock->GetTimeScale();
-	int numChunks = int(m_activeChunks.size());
+	int numChunks = m_activeChunks.GetSize();
 	int numBlocks = numChunks * CHUNK_BLOCKS_TOTAL;
 	unsigned int numVerts = 0;
 
-	std::map<IntVec2, Chunk*>::iterator iter;
-	for (iter = m_activeChunks.begin(); iter != m_activeChunks.end(); ++iter)
+	for (int chunkIndex = 0; chunkIndex < m_activeChunks.GetSize(); ++chunkIndex)
 	{
-		Chunk* chunk = iter->second;
-		if (chunk->m_vertexBuffer)
-		{
-			numVerts += unsigned int(chunk->m_vertexBuffer->m_size);
-		}
+		numVerts += m_activeChunks.GetEntry(chunkIndex).m_value->GetNumVerts();
 	}
 
 	if (g_theGameClock)
@@ -672,8 +957,15 @@ void World::UpdateOnScreenDisplayMessages()
 	
 }
 
-// processes and propagates all dirty light blocks until none remain
+// the dirty block queue is drained, the wavefront runs until it settles or runs out of rounds for this frame
 void World::ProcessDirtyLighting()
+{
+	ProcessDirtyLightBlockQueue();
+	m_lightPropagator.Propagate(MAX_LIGHT_PROPAGATION_ROUNDS_PER_FRAME);
+}
+
+// processes and propagates all dirty light blocks until none remain
+void World::ProcessDirtyLightBlockQueue()
 {
 	while (!m_dirtyLightBlockIters.empty())
 	{
@@ -693,33 +985,49 @@ void World::DirtyNeighborChunkMeshWhenAnEdgeAirBlockLightIsProcessed(BlockIter&
 		Chunk* chunkNeighbor = chunkPtr->m_westNeighbor;
 		if (coords.x == 0 && chunkNeighbor)
 		{
-			MarkLightingDirty(blockIter.GetWestNeighbor());
-			chunkNeighbor->m_isMeshDirty = true;
+			MarkBlockLightDirty(blockIter.GetWestNeighbor());
+			chunkNeighbor->MarkSectionMeshDirtyForLocalZ(coords.z);
 		}
 
 		chunkNeighbor = chunkPtr->m_eastNeighbor;
 		if (coords.x == (CHUNK_SIZE_X - 1) && chunkNeighbor)
 		{
-			MarkLightingDirty(blockIter.GetEastNeighbor());
-			chunkNeighbor->m_isMeshDirty = true;
+			MarkBlockLightDirty(blockIter.GetEastNeighbor());
+			chunkNeighbor->MarkSectionMeshDirtyForLocalZ(coords.z);
 		}
 
 		chunkNeighbor = chunkPtr->m_southNeighbor;
 		if (coords.y == 0 && chunkNeighbor)
 		{
-			MarkLightingDirty(blockIter.GetSouthNeighbor());
-			chunkNeighbor->m_isMeshDirty = true;
+			MarkBlockLightDirty(blockIter.GetSouthNeighbor());
+			chunkNeighbor->MarkSectionMeshDirtyForLocalZ(coords.z);
 		}
 		
 		chunkNeighbor = chunkPtr->m_northNeighbor;
 		if (coords.y == (CHUNK_SIZE_Y - 1) && chunkNeighbor)
 		{
-			MarkLightingDirty(blockIter.GetNorthNeighbor());
-			chunkNeighbor->m_isMeshDirty = true;
+			MarkBlockLightDirty(blockIter.GetNorthNeighbor());
+			chunkNeighbor->MarkSectionMeshDirtyForLocalZ(coords.z);
 		}
 	}
 }
 
+void World::MarkBlockLightDirty(BlockIter blockIter)
+{
+	if (!blockIter.GetBlock())
+	{
+		return;
+	}
+	if (m_useWavefrontLighting)
+	{
+		m_lightPropagator.MarkBlockLightDirty(blockIter.m_chunk, blockIter.m_blockIndex);
+	}
+	else
+	{
+		MarkLightingDirty(blockIter);
+	}
+}
+
 // adds a BlockIterator to the back of the dirty light queue IF that block is not already flagged as dirty (BLOCK_BIT_IS_LIGHT_DIRTY), 
 // and also sets that flag
 void World::MarkLightingDirty(BlockIter blockIter)
@@ -789,7 +1097,7 @@ void World::ProcessNextDirtyLightBlock(BlockIter blockIter)
 	}
 
 	// define that one block's light equals to its highest neighbor's value -1
-	uint8_t selfIndoorLight = blockIter.GetBlock()->GetBlockDef().m_indoorLight;
+	uint8_t selfIndoorLight = BlockDef::s_indoorLightByType[blockIter.GetBlock()->m_blockDefIndex];
 	uint8_t selfOutdoorLight = (blockIter.GetBlock()->IsBlockSky()) ? MAX_LIGHT_VALUE : 0;
 	uint8_t correctIndoorLight = (uint8_t)GetMax((highestNeighborIndoorLight - 1), selfIndoorLight);
 	uint8_t correctOutdoorLight = (uint8_t)GetMax((highestNeighborOutdoorLight - 1), selfOutdoorLight); // underflow of uint_8
@@ -804,7 +1112,7 @@ void World::ProcessNextDirtyLightBlock(BlockIter blockIter)
 		blockIter.GetBlock()->SetIndoorLightingInfulence(correctIndoorLight);
 		blockIter.GetBlock()->SetOutdoorLightingInfulence(correctOutdoorLight);
 		MarkNeighborLightingDirtyIfTheyAreNotOpaque(blockIter); // if the block is on the edges, it will tell nearby chunk the light is dirty?
-		blockIter.m_chunk->m_isMeshDirty = true; // todo: maybe just re add verts and create buffer instead of go through all the update process?
+		blockIter.m_chunk->MarkSectionMeshDirtyForLocalZ(blockIter.m_blockIndex >> CHUNK_BITSHIFT_Z); // only the sections around the block
 	}
 }
 
@@ -872,37 +1180,39 @@ void World::MarkNeighborLightingDirtyIfTheyAreNotOpaque(BlockIter blockIter)
 // all non-sky blocks have zero outdoor light influence.
 // Light - emitting blocks(e.g.glowstone) are dirty, with(incorrect) zero light influence.
 // Edge boundary air blocks with chunk neighbors are dirty, as are non - sky air neighbors of sky blocks.
+// the empty sections above the terrain are all sky, inside the chunk only the edge columns have to look at them block by block
 void World::LightInfluenceInitialization(Chunk* chunkPtr)
 {
+	int openSkyBottomZ = chunkPtr->GetOpenSkyBottomZ();
 	for (int x = 0; x < CHUNK_SIZE_X; ++x)
 	{
 		for (int y = 0; y < CHUNK_SIZE_Y; ++y)
 		{
-			bool connectedToSky = true;
+			bool isEdgeColumn = (x == 0 || x == (CHUNK_SIZE_X - 1) || y == 0 || y == (CHUNK_SIZE_Y - 1));
+			int skyBottomZ = chunkPtr->GetSkyBottomZ(x | (y << CHUNK_BITSHIFT_Y));
+			int topZ = CHUNK_SIZE_Z - 1;
+			if (!isEdgeColumn)
+			{
+				for (; topZ >= openSkyBottomZ; --topZ)
+				{
+					chunkPtr->m_blocks[chunkPtr->GetIndexForLocalCoordinates(IntVec3(x, y, topZ))].SetIsBlockSky(true);
+				}
+			}
 
-			for (int z = (CHUNK_SIZE_Z - 1); z >= 0; --z)
+			for (int z = topZ; z >= 0; --z)
 			{
 				// Loop through each block in the chunk; if it has a block type that emits light, mark it dirty
 				int index = chunkPtr->GetIndexForLocalCoordinates(IntVec3(x, y, z));
-				BlockDef def = chunkPtr->m_blocks[index].GetBlockDef();
 				Block& block = chunkPtr->m_blocks[index];
 				BlockIter blockIter = BlockIter(chunkPtr, index);
 
-				if (def.m_isEmissive)
+				if (block.IsEmissive())
 				{
 					MarkLightingDirty(blockIter);
 				}
 
-				// Descend each column downward from the top, flagging blocks as SKY, stopping at first opaque
-				if (connectedToSky && !def.m_isOpaque)
-				{
-					block.SetIsBlockSky(true);
-				}
-				else
-				{
-					connectedToSky = false;
-					block.SetIsBlockSky(false);
-				}
+				// every block above the column's highest opaque one is SKY
+				block.SetIsBlockSky(z >= skyBottomZ);
 
 				// Mark non-opaque boundary blocks touching any existing neighboring chunk (NSEW) as dirty
 				if (block.IsBlockSky())
@@ -944,10 +1254,14 @@ void World::LightInfluenceInitialization(Chunk* chunkPtr)
 	{
 		for (int y = 0; y < CHUNK_SIZE_Y; ++y)
 		{
-			for (int z = (CHUNK_SIZE_Z - 1); z >= 0; --z)
+			// a sky block in an open sky section only has sky blocks next to it inside the chunk
+			bool isEdgeColumn = (x == 0 || x == (CHUNK_SIZE_X - 1) || y == 0 || y == (CHUNK_SIZE_Y - 1));
+			// and the blocks under the column's highest opaque one are not sky
+			int topZ = isEdgeColumn ? (CHUNK_SIZE_Z - 1) : (openSkyBottomZ - 1);
+			int skyBottomZ = chunkPtr->GetSkyBottomZ(x | (y << CHUNK_BITSHIFT_Y));
+			for (int z = topZ; z >= skyBottomZ; --z)
 			{
 				int index = chunkPtr->GetIndexForLocalCoordinates(IntVec3(x, y, z));
-				BlockDef def = chunkPtr->m_blocks[index].GetBlockDef();
 				Block& block = chunkPtr->m_blocks[index];
 				BlockIter blockIter = BlockIter(chunkPtr, index);
 
@@ -1064,94 +1378,43 @@ void World::BindSimplerMinerWorldShaderData() const
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------
-void World::CheckIfCaveWormStartsThisChunk(Chunk* chunkPtr)
+void World::DigBlock()
 {
-	IntVec2 globalCoords = chunkPtr->m_chunkCoords;
-	float caveNoise = Get2dNoiseZeroToOne(globalCoords.x, globalCoords.y, m_seed);
-
-	// calculate all neighbors tree including this point noise 3x3 to see if this one is the highest one is this one
-	float maxCaveNoise = 0.f;
-	for (int posX = (globalCoords.x - CAVE_COVER_CHUNK_TIMES); posX < (globalCoords.x + CAVE_COVER_CHUNK_TIMES); ++posX)
-	{
-		for (int posY = (globalCoords.y - CAVE_COVER_CHUNK_TIMES); posY < (globalCoords.y + CAVE_COVER_CHUNK_TIMES); ++posY)
-		{
-			float neighborNoise = Get2dNoiseZeroToOne(posX, posY, m_seed);
-			if (neighborNoise > maxCaveNoise)
-			{
-				maxCaveNoise = neighborNoise;
-			}
-		}
-	}
-
-	if (caveNoise == maxCaveNoise)
+	if (m_playerAimingRaycastResult.m_didImpact)
 	{
-		GeneratingPerlinWormCaves(chunkPtr);
+		UpdatePlayerLocatedCoords();
+		DigBlockAt(m_playerAimingRaycastResult.m_aimedBlockIter);
 	}
 }
 
-void World::GeneratingPerlinWormCaves(Chunk* chunkPtr)
-{
-	// locate the origin block of the worm from the chunk
-	IntVec2 globalCoords = chunkPtr->m_chunkCoords;
-	float posNoise = 0.5f + 0.5f * Get2dNoiseZeroToOne(globalCoords.x, globalCoords.y, m_seed);
-	IntVec2 caveStartPos(int(posNoise * float(CHUNK_SIZE_X)), int(posNoise * float(CHUNK_SIZE_Y)));
-	IntVec2 biomeCoords = chunkPtr->GetBiomeCoordsByLocalCoords(caveStartPos);
-	int biomeIndex = chunkPtr->GetBiomeIndexByTreeCoords(biomeCoords);
-	int terrainHeight = chunkPtr->m_terrainHeightZ[biomeIndex];
-	IntVec3 caveOriginPos(caveStartPos.x, caveStartPos.y, int(posNoise * float(terrainHeight)));
-
-	//
-	// float caveWormLength = 0.f;
-	// float pitchNoise = Compute1dPerlinNoise(caveWormLength, 1.f, 5, 0.5f, 2.f, true, m_seed);
-	// float pitchDeltaDegrees = RangeMapClamped(pitchNoise, -1.f, 1.f, CAVE_PITCH_MAX * (-1.f), CAVE_PITCH_MAX);
-	// 
-	// float yawNoise = Compute1dPerlinNoise(caveWormLength, 1.f, 5, 0.5f, 2.f, true, (m_seed + 1));
-	// float yawDeltaDegrees = RangeMapClamped(yawNoise, -1.f, 1.f, CAVE_YAW_MAX * (-1.f), CAVE_YAW_MAX);
-
-}
-
-//----------------------------------------------------------------------------------------------------------------------------------------------------
-void World::DigBlock()
+void World::DigBlockAt(BlockIter digIter)
 {
-	if (m_playerAimingRaycastResult.m_didImpact)
+	if (!digIter.GetBlock())
 	{
-		UpdatePlayerLocatedCoords();
-
-		// get the ptr to the chunk that the player is current at
-		m_playerAimingRaycastResult.m_aimedBlockIter.m_chunk->DigBlock(m_playerAimingRaycastResult.m_aimedBlockIter.m_blockIndex);
+		return;
+	}
 
-		// put it into the light deque
-		BlockIter digIter = m_playerAimingRaycastResult.m_aimedBlockIter;
-		IntVec3 aimedBlockCoords = m_playerAimingRaycastResult.m_aimedBlockIter.m_chunk->GetlocalBlockCoordsForIndex(digIter.m_blockIndex);
-		MarkLightingDirty(digIter);
-		// if this is an air block and it is at the edge of the chunk
-		// we need to notify the neighbor chunk that he need to rebuild
-		// otherwise the block will next to this air block will not have any mesh
-		DirtyNeighborChunkMeshWhenAnEdgeAirBlockLightIsProcessed(digIter);
+	// get the ptr to the chunk that the player is current at
+	Chunk* chunk = digIter.m_chunk;
+	int columnIndex = digIter.m_blockIndex & CHUNK_MASK_COLUMN;
+	int oldSkyBottomZ = chunk->GetSkyBottomZ(columnIndex);
+	chunk->DigBlock(digIter.m_blockIndex);
 
-		// If the block ABOVE is flagged SKY, descend downward starting here until you reach the first opaque block directly below it
-		// flagging each non-opaque block descended as SKY and dirtying it
-		// Example: break through the roof of a cave, and a beam of sunlight streams in down to the floor
+	// put it into the light deque
+	MarkBlockLightDirty(digIter);
+	// if this is an air block and it is at the edge of the chunk
+	// we need to notify the neighbor chunk that he need to rebuild
+	// otherwise the block will next to this air block will not have any mesh
+	DirtyNeighborChunkMeshWhenAnEdgeAirBlockLightIsProcessed(digIter);
 
-		BlockIter blockAboveIter = digIter.GetUpperLevelNeighbor();
-		if (blockAboveIter.GetBlock()->IsBlockSky())
-		{
-			for (int z = (aimedBlockCoords.z - 1); z >= 0; --z)
-			{
-				IntVec3 blockBelow(aimedBlockCoords.x, aimedBlockCoords.y, z);
-				int blockBelowIndex = digIter.m_chunk->GetIndexForLocalCoordinates(blockBelow);
-				BlockIter blockBelowIter(digIter.m_chunk, blockBelowIndex);
-				if (!blockBelowIter.GetBlock()->IsOpaque())
-				{
-					blockBelowIter.GetBlock()->SetIsBlockSky(true);
-					MarkLightingDirty(blockBelowIter);
-				}
-				else
-				{
-					break;
-				}
-			}
-		}
+	// If the dug block was the highest opaque one in its column, every block down to the next opaque one is now SKY, dirty them all
+	// Example: break through the roof of a cave, and a beam of sunlight streams in down to the floor
+	int newSkyBottomZ = chunk->GetSkyBottomZ(columnIndex);
+	for (int z = newSkyBottomZ; z < oldSkyBottomZ; ++z)
+	{
+		BlockIter skyBlockIter(chunk, columnIndex | (z << CHUNK_BITSHIFT_Z));
+		skyBlockIter.GetBlock()->SetIsBlockSky(true);
+		MarkBlockLightDirty(skyBlockIter);
 	}
 }
 
@@ -1191,26 +1454,32 @@ void World::BuildPlayerBlock()
 		}
 
 
-		aimedBlockIter.m_chunk->SetBlock(placeBlockIter.m_blockIndex, g_theGame->m_player->m_buildingBlockDef);
+		PlaceBlockAt(placeBlockIter, g_theGame->m_player->m_buildingBlockDef);
+	}
+}
 
-		// put it into the light deque
-		MarkLightingDirty(placeBlockIter);
+void World::PlaceBlockAt(BlockIter placeBlockIter, BlockDef const& def)
+{
+	if (!placeBlockIter.GetBlock())
+	{
+		return; // above the top or below the bottom of the world
+	}
+	Chunk* chunk = placeBlockIter.m_chunk;
+	int columnIndex = placeBlockIter.m_blockIndex & CHUNK_MASK_COLUMN;
+	int oldSkyBottomZ = chunk->GetSkyBottomZ(columnIndex);
+	chunk->SetBlock(placeBlockIter.m_blockIndex, def);
 
-		// clearing all SKY flags directly below (until you reach opaque) and dirtying their lighting
-		// If the (air) block replaced was flagged as SKY  and the new block is opaque  clear the SKY flag and descend downward, 
-		// Example: plug up" a vertical mineshaft, cutting off sunlight and plunging the cave into darkness
-		if (placeBlockIter.GetBlock()->IsBlockSky() && !placeBlockIter.IsNonOpaque())
-		{
-			placeBlockIter.GetBlock()->SetIsBlockSky(false);
+	// put it into the light deque
+	MarkBlockLightDirty(placeBlockIter);
 
-			BlockIter skyBlockIter = placeBlockIter.GetLowerLevelNeighbor();
-			while (skyBlockIter.GetBlock() && skyBlockIter.GetBlock()->IsBlockSky())
-			{
-				skyBlockIter.GetBlock()->SetIsBlockSky(false);
-				MarkLightingDirty(skyBlockIter);
-				skyBlockIter = skyBlockIter.GetLowerLevelNeighbor();
-			}
-		}
+	// If the new block is opaque and above the column's highest opaque one, clear the SKY flags from it down and dirty their lighting
+	// Example: plug up" a vertical mineshaft, cutting off sunlight and plunging the cave into darkness
+	int newSkyBottomZ = chunk->GetSkyBottomZ(columnIndex);
+	for (int z = oldSkyBottomZ; z < newSkyBottomZ; ++z)
+	{
+		BlockIter skyBlockIter(chunk, columnIndex | (z << CHUNK_BITSHIFT_Z));
+		skyBlockIter.GetBlock()->SetIsBlockSky(false);
+		MarkBlockLightDirty(skyBlockIter);
 	}
 }
  
@@ -1278,14 +1547,20 @@ SimpleMinerRaycastResult World::FastRaycastForVoxelGrids(Vec3 const& rayStart, V
 	float rayYZDist = rayDist * (Vec3(0.f, rayFwdNormal.y, rayFwdNormal.z).GetLength() / rayFwdNormal.GetLength());
 
 	// check if the raycast starts inside a solid block
-	IntVec3 blockCoords = m_playerLocalBlockCoords;
-	int blockIndex = m_playerLocatedChunk->GetIndexForLocalCoordinates(m_playerLocalBlockCoords);
-	BlockIter blockIter = BlockIter(m_playerLocatedChunk, blockIndex);
+	// the start block comes from the ray itself, so it could be cast from anywhere and not only from the player
+	Chunk* startChunk = m_activeChunks.Find(GetChunkCoordsForWorldPos(rayStart));
+	if (!startChunk)
+	{
+		return missResult;
+	}
+	IntVec3 blockCoords = startChunk->GetlocalBlockCoordsForWorldPos(rayStart);
+	int blockIndex = startChunk->GetIndexForLocalCoordinates(blockCoords);
+	BlockIter blockIter = BlockIter(startChunk, blockIndex);
 	Block* blockPtr = blockIter.GetBlock();
 
 	if (blockPtr)
 	{
-		if (blockPtr->GetBlockDef().m_isSolid)
+		if (blockPtr->IsSolid())
 		{
 			hitResult.m_didImpact = true;
 			hitResult.m_impactDist = 0.f;
@@ -1425,7 +1700,7 @@ SimpleMinerRaycastResult World::FastRaycastForVoxelGrids(Vec3 const& rayStart, V
 
 			if (tx <= 1.f && tx >= 0.f && block) // hit
 			{
-				if (block->GetBlockDef().m_isSolid)
+				if (block->IsSolid())
 				{
 					hitResult.m_didImpact = true;
 					hitResult.m_impactDist = rayDist * tx;
@@ -1466,7 +1741,7 @@ SimpleMinerRaycastResult World::FastRaycastForVoxelGrids(Vec3 const& rayStart, V
 
 			if (ty <= 1.f && ty >= 0.f && block) // hit
 			{
-				if (block->GetBlockDef().m_isSolid)
+				if (block->IsSolid())
 				{
 					hitResult.m_didImpact = true;
 					hitResult.m_impactDist = rayDist * ty;
@@ -1505,7 +1780,7 @@ SimpleMinerRaycastResult World::FastRaycastForVoxelGrids(Vec3 const& rayStart, V
 
 			if (tz <= 1.f && tz >= 0.f && block) // hit
 			{
-				if (block->GetBlockDef().m_isSolid)
+				if (block->IsSolid())
 				{
 					hitResult.m_didImpact = true;
 					hitResult.m_impactDist = rayDist * tz;
@@ -1529,6 +1804,12 @@ SimpleMinerRaycastResult World::FastRaycastForVoxelGrids(Vec3 const& rayStart, V
 	return missResult;
 }
 
+void World::RaycastVoxels(std::vector<VoxelRay> const& rays, std::vector<SimpleMinerRaycastResult>& out_results, bool useJobWorkers) const
+{
+	out_results.resize(rays.size());
+	::RaycastVoxels(m_activeChunks, rays.data(), (int)rays.size(), out_results.data(), useJobWorkers);
+}
+
 void World::RenderLockedRaycastForDebug() const
 {
 	std::vector <Vertex_PCU> debugVerts_depthOn;
@@ -1571,6 +1852,181 @@ void World::RenderLockedRaycastForDebug() const
 	g_theRenderer->DrawVertexArray((int)debugVerts_depthOn.size(), debugVerts_depthOn.data());
 }
 
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+// chunk streaming replay
+// the path is relative to the start position, every run starts far away from the last one so no chunk is left over from it
+static Vec2 const s_replayPathWaypoints[] = { Vec2(0.f, 0.f), Vec2(600.f, 0.f), Vec2(600.f, 400.f), Vec2(100.f, 700.f), Vec2(100.f, 1200.f) };
+static int const s_numReplayPathWaypoints = sizeof(s_replayPathWaypoints) / sizeof(s_replayPathWaypoints[0]);
+
+void World::RequestChunkStreamingReplay(bool prioritizeChunkJobs, float flySpeed)
+{
+	// the replay starts at the beginning of next world update, before anything in that frame holds on to a chunk
+	m_isReplayRequested = true;
+	m_replayPrioritizeChunkJobs = prioritizeChunkJobs;
+	m_replayFlySpeed = flySpeed;
+}
+
+void World::RequestChunkStreamingIOTest(float flySpeed)
+{
+	m_replayIOTestPhase = 1;
+	RequestChunkStreamingReplay(true, flySpeed);
+}
+
+void World::StartChunkStreamingReplay()
+{
+	m_isReplayRequested = false;
+	m_isReplaying = true;
+	m_prioritizeChunkJobs = m_replayPrioritizeChunkJobs;
+	m_lastPrioritizedPlayerChunkCoords = BAD_CHUNK_COORDS;
+	if (m_replayIOTestPhase != 2) // the second run of the I/O test flies over the chunks the first run has saved
+	{
+		++m_numReplaysStarted;
+	}
+	m_replayStartPos = Vec3(0.f, 20000.f * float(m_numReplaysStarted), 100.f);
+
+	// both modes start from an empty world
+	CancelAllQueuedChunkGenerationJobs();
+	std::vector<IntVec2> activeChunkCoords;
+	for (int chunkIndex = 0; chunkIndex < m_activeChunks.GetSize(); ++chunkIndex)
+	{
+		activeChunkCoords.push_back(m_activeChunks.GetEntry(chunkIndex).m_coords);
+	}
+	for (int i = 0; i < (int)activeChunkCoords.size(); ++i)
+	{
+		DeactivateChunk(activeChunkCoords[i]);
+	}
+
+	m_replayChunkNeededTimes.clear();
+	m_replayTimesToVisible.clear();
+	m_replayNumChunksLoaded = 0;
+	m_replayMainThreadFileOpsAtStart = GetNumFileOperationsOnThisThread();
+	m_replayStartTime = GetCurrentTimeSeconds();
+	g_theDevConsole->AddLine(Stringf("Chunk streaming replay started, prioritized chunk jobs = %s", m_prioritizeChunkJobs ? "true" : "false"), DevConsole::INFO_MAJOR);
+}
+
+void World::UpdateChunkStreamingReplay()
+{
+	if (m_isReplayRequested)
+	{
+		StartChunkStreamingReplay();
+	}
+	if (!m_isReplaying)
+	{
+		return;
+	}
+
+	// fly along the path at a constant speed
+	double timeNow = GetCurrentTimeSeconds();
+	float distanceLeft = float(timeNow - m_replayStartTime) * m_replayFlySpeed;
+	Vec2 pathPos = s_replayPathWaypoints[s_numReplayPathWaypoints - 1];
+	bool reachedEnd = true;
+	for (int i = 0; i < s_numReplayPathWaypoints - 1; ++i)
+	{
+		Vec2 segment = s_replayPathWaypoints[i + 1] - s_replayPathWaypoints[i];
+		float segmentLength = segment.GetLength();
+		if (distanceLeft <= segmentLength)
+		{
+			pathPos = s_replayPathWaypoints[i] + segment * (distanceLeft / segmentLength);
+			reachedEnd = false;
+			break;
+		}
+		distanceLeft -= segmentLength;
+	}
+	g_theGame->m_player->m_position = m_replayStartPos + Vec3(pathPos.x, pathPos.y, 0.f);
+
+	if (reachedEnd)
+	{
+		FinishChunkStreamingReplay();
+		return;
+	}
+
+	// a chunk starts its clock when it first comes near the player, and stops it once it has a mesh to draw
+	// the time is kept negative after that so the chunk is not counted again
+	IntVec2 playerChunkCoords = GetChunkCoordsForWorldPos(g_theGame->m_player->m_position);
+	for (int y = -REPLAY_NEARBY_CHUNK_RADIUS; y <= REPLAY_NEARBY_CHUNK_RADIUS; ++y)
+	{
+		for (int x = -REPLAY_NEARBY_CHUNK_RADIUS; x <= REPLAY_NEARBY_CHUNK_RADIUS; ++x)
+		{
+			IntVec2 chunkCoords = playerChunkCoords + IntVec2(x, y);
+			if (m_replayChunkNeededTimes.find(chunkCoords) == m_replayChunkNeededTimes.end())
+			{
+				m_replayChunkNeededTimes[chunkCoords] = timeNow;
+			}
+		}
+	}
+
+	std::map<IntVec2, double>::iterator neededIter;
+	for (neededIter = m_replayChunkNeededTimes.begin(); neededIter != m_replayChunkNeededTimes.end(); ++neededIter)
+	{
+		if (neededIter->second < 0.0)
+		{
+			continue;
+		}
+
+		Chunk* chunk = m_activeChunks.Find(neededIter->first);
+		if (chunk && !chunk->IsMeshDirty())
+		{
+			m_replayTimesToVisible.push_back(timeNow - neededIter->second);
+			neededIter->second = -1.0;
+		}
+	}
+}
+
+void World::FinishChunkStreamingReplay()
+{
+	m_isReplaying = false;
+
+	int numNeverVisible = 0;
+	std::map<IntVec2, double>::iterator neededIter;
+	for (neededIter = m_replayChunkNeededTimes.begin(); neededIter != m_replayChunkNeededTimes.end(); ++neededIter)
+	{
+		if (neededIter->second >= 0.0)
+		{
+			++numNeverVisible;
+		}
+	}
+
+	double averageMS = 0.0;
+	double percentile95MS = 0.0;
+	double maxMS = 0.0;
+	int numVisible = (int)m_replayTimesToVisible.size();
+	if (numVisible > 0)
+	{
+		std::sort(m_replayTimesToVisible.begin(), m_replayTimesToVisible.end());
+		double totalSeconds = 0.0;
+		for (int i = 0; i < numVisible; ++i)
+		{
+			totalSeconds += m_replayTimesToVisible[i];
+		}
+		averageMS = 1000.0 * totalSeconds / double(numVisible);
+		percentile95MS = 1000.0 * m_replayTimesToVisible[(numVisible * 95) / 100];
+		maxMS = 1000.0 * m_replayTimesToVisible[numVisible - 1];
+	}
+
+	g_theDevConsole->AddLine(Stringf("Chunk streaming replay done, prioritized chunk jobs = %s, fly speed = %.0f", m_prioritizeChunkJobs ? "true" : "false", m_replayFlySpeed), DevConsole::INFO_MAJOR);
+	g_theDevConsole->AddLine(Stringf("  time-to-visible within %i chunks: avg %.1f ms, p95 %.1f ms, max %.1f ms over %i chunks, %i never became visible", 
+		REPLAY_NEARBY_CHUNK_RADIUS, averageMS, percentile95MS, maxMS, numVisible, numNeverVisible), DevConsole::INFO_MINOR);
+
+	if (m_replayIOTestPhase == 1)
+	{
+		// the chunks still active get saved when the next run starts, before anything is loaded
+		m_replayIOTestPhase = 2;
+		m_isReplayRequested = true;
+		g_theDevConsole->AddLine("Chunk streaming I/O test: the path is saved, flying it again", DevConsole::INFO_MINOR);
+		return;
+	}
+	else if (m_replayIOTestPhase == 2)
+	{
+		int numMainThreadFileOps = GetNumFileOperationsOnThisThread() - m_replayMainThreadFileOpsAtStart;
+		bool hasPassed = (numMainThreadFileOps == 0 && m_replayNumChunksLoaded > 0);
+		g_theDevConsole->AddLine(Stringf("Chunk streaming I/O test %s: %i chunks loaded, %i file operations on the main thread", 
+			hasPassed ? "PASSED" : "FAILED", m_replayNumChunksLoaded, numMainThreadFileOps), hasPassed ? DevConsole::INFO_MAJOR : DevConsole::INFO_ERROR);
+		m_replayIOTestPhase = 0;
+	}
+
+	m_prioritizeChunkJobs = true;
+}
+
 void World::UpdateTime()
 {
 	// Time of day is the fractional [0,1) part of world-time, where .0=midnight, .25=dawn (6am), .5=noon, .75=dusk (6pm).  
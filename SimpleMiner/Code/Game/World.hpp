@@ -1,7 +1,10 @@
 #pragma once
 #include "Game/Chunk.hpp"
 #include "Game/BlockIterator.hpp"
-#include "Engine/core/RaycastUtils.hpp"
+#include "Game/ChunkCoordsHashMap.hpp"
+#include "Game/ChunkRegionFiles.hpp"
+#include "Game/ChunkFeatures.hpp"
+#include "Game/VoxelRaycast.hpp"
 #include "Engine/Math/Capsule3.hpp"
 #include <deque>
 #include <vector>
@@ -11,11 +14,6 @@ class Timer;
 
 bool operator<(IntVec2 const& a, IntVec2 const& b); // stand alone function
 
-struct SimpleMinerRaycastResult : public RaycastResult3D
-{
-	BlockIter m_aimedBlockIter;
-};
-
 struct SimpleMinerGPUData
 {
 	Vec4 m_indoorColor; //= Rgba8(255, 230, 204, 255);
@@ -48,6 +46,7 @@ public:
 
 	void RenderPlayerAimingSurface() const;
 	IntVec2 GetChunkCoordsForWorldPos(Vec3 worldPos);
+	float	GetGroundHeightAtWorldPos(Vec3 worldPos, float defaultHeight); // the top of the highest solid block, defaultHeight when the chunk is not active
 
 	SimpleMinerRaycastResult m_playerAimingRaycastResult;
 	IntVec2 m_playerChunkCoords = IntVec2();
@@ -62,18 +61,71 @@ public:
 	// dynamic loading
 	void UpdateAllActiveChunks();
 
-	void DeactivateChunks();
+	void DeactivateChunks(double budgetEndTime);
 	void DeactivateFarthestActiveChunk();
-	void DeactivateFarthestActiveChunkOutOfPlayerRange();
+	void CollectChunksOutOfPlayerRange();
 	void DeactivateChunk(IntVec2 chunkCoords);
 	void DeactivateChunk(Chunk* chunkPtr);
 
-	void ActivateChunks();
-	void ActivateNearestMissingChunkInPlayerRange();
+	void ActivateChunks(double budgetEndTime);
+	void BuildChunkActivationOffsets();
+	void ActivateMissingChunksInPlayerRange(double budgetEndTime);
 
-	void RequestNewChunkGenerationJob(IntVec2 chunkCoords);
+	bool RequestNewChunkGenerationJob(IntVec2 chunkCoords); // false when the job queue is full
+	void QueueChunkGenerationJob(Chunk* chunkPtr);
 	void ActivateNewChunk(Chunk* chunkPtr);
 	void RetrieveCompletedChunkGenerationJobAndActivate();
+	void RetrieveCompletedChunkLoadJobs();
+	void RetrieveCompletedChunkSaveJobs();
+	std::vector<ChunkGenerateJob*>	m_completedChunkGenerationJobs; // reused every frame
+	std::vector<ChunkLoadJob*>		m_completedChunkLoadJobs;
+	std::vector<ChunkSaveJob*>		m_completedChunkSaveJobs;
+
+	// every job writing to the disk is queued with this handle, so the world could wait for all of them before it goes away
+	JobHandle m_pendingDiskWritesHandle;
+
+	// saves live in region files, the old one file per chunk saves are converted by the first job on the I/O lane
+	void RetrieveCompletedChunkFilesConversionJob();
+
+	ChunkRegionFiles*			m_chunkRegionFiles = nullptr;
+	ChunkFilesConversionJob*	m_chunkFilesConversionJob = nullptr;
+
+	// queued generation jobs are re-prioritized by distance when the player moves to another chunk, out of range ones are cancelled
+	int  GetChunkGenerationJobPriority(IntVec2 chunkCoords);
+	void UpdateQueuedChunkGenerationJobs();
+	void CancelAllQueuedChunkGenerationJobs();
+
+	bool	m_prioritizeChunkJobs = true; // false queues chunk generation in plain FIFO order without cancelling, the way it used to be
+	int		m_numChunkGenerationJobsRequested = 0;
+	IntVec2 m_lastPrioritizedPlayerChunkCoords = BAD_CHUNK_COORDS;
+
+	// every chunk offset inside the activation range, nearest first, so activation walks it from where it stopped last frame
+	std::vector<IntVec2>	m_chunkActivationOffsets;
+	int						m_chunkActivationCursor = 0; // every offset before it is active or on its way
+	IntVec2					m_lastActivationPlayerChunkCoords = BAD_CHUNK_COORDS;
+
+	// active chunks outside the deactivation range, farthest at the back, collected when the player enters another chunk
+	std::vector<IntVec2>	m_chunksToDeactivate;
+	IntVec2					m_lastDeactivationPlayerChunkCoords = BAD_CHUNK_COORDS;
+
+	// settled chunks far from the player are compacted a few per frame, they expand again when something edits or relights them
+	void CompactFarChunks();
+	bool CanChunkBeCompacted(Chunk const* chunk) const;
+
+	bool	m_compactFarChunks = true;
+	int		m_chunkCompactionCursor = 0;
+
+	// false goes back to the Vertex_PCU quad per visible face, a chunk is remeshed the way this says next time its mesh is dirty
+	// the old mesher still runs on the main thread, it reads the neighbors through BlockIter
+	bool				m_useGreedyMesher = true;
+
+	// greedy meshes are built by ChunkMeshJobs, nearest chunk first, and only uploaded here
+	void QueueChunkMeshJob(ChunkMeshJob* job);
+	void RetrieveCompletedChunkMeshJobs();
+	void CancelOrOrphanChunkMeshJobs(Chunk* chunk);
+
+	std::vector<ChunkMeshJob*>	m_completedChunkMeshJobs;
+	JobHandle					m_pendingChunkMeshJobsHandle; // orphaned mesh jobs still have to come back before the world goes away
 
 	void WorldInputControl();
 	void UpdateOnScreenDisplayMessages();
@@ -81,7 +133,9 @@ public:
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
 	// lighting process
 	void ProcessDirtyLighting();
+	void ProcessDirtyLightBlockQueue(); // the old one block at a time propagation on the main thread
 	void DirtyNeighborChunkMeshWhenAnEdgeAirBlockLightIsProcessed(BlockIter& blockIter);
+	void MarkBlockLightDirty(BlockIter blockIter); // for edits, goes to the wavefront or to the dirty block queue, whichever is in use
 	void MarkLightingDirty(BlockIter blockIter);
 	void ProcessNextDirtyLightBlock(BlockIter blockIter);
 	void MarkNeighborLightingDirtyIfTheyAreNotOpaque(BlockIter blockIter);
@@ -94,22 +148,24 @@ public:
 
 	std::deque<BlockIter> m_dirtyLightBlockIters; // double-ended queue, called 'deck'
 
+	// false lights new chunks and edits with the dirty block queue again, the chunks already lit keep their light
+	bool					m_useWavefrontLighting = true;
+	ChunkLightPropagator	m_lightPropagator;
+
 	SimpleMinerGPUData* m_gpuShaderData = nullptr;
 	ConstantBuffer* m_lighting_Fog_CBO = nullptr;
 
-	//----------------------------------------------------------------------------------------------------------------------------------------------------
-	void CheckIfCaveWormStartsThisChunk(Chunk* chunkPtr);
-	void GeneratingPerlinWormCaves(Chunk* chunkPtr);
-
-	std::vector<Capsule3> caveLists;
-
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
 	// player game play in world
 	void DigBlock();
 	void BuildPlayerBlock();
+	void DigBlockAt(BlockIter digIter); // with the sky flags and lighting updates that go with it
+	void PlaceBlockAt(BlockIter placeBlockIter, BlockDef const& def);
 
 	void ShootRaycastForCollisionTest(float rayDist);
 	SimpleMinerRaycastResult FastRaycastForVoxelGrids(Vec3 const& rayStart, Vec3 const& rayFwdNormal, float rayDist);
+	// many rays at once through the active chunks, e.g. line of sight or occlusion checks, see VoxelRaycast
+	void RaycastVoxels(std::vector<VoxelRay> const& rays, std::vector<SimpleMinerRaycastResult>& out_results, bool useJobWorkers = true) const;
 
 	void RenderLockedRaycastForDebug() const;
 
@@ -136,6 +192,8 @@ public:
 	// biomes
 
 	int m_seed = 0;
+	bool m_useBatchNoise = true; // chunk generation fills its noise a grid at a time with SSE, false goes column by column, the terrain is the same
+	ChunkFeatureCache m_featureCache; // biome factors, trees and caves of the regions chunks are generated in, used by the generate jobs
 	bool m_enableFog = true;
 
 	//----------------------------------------------------------------------------------------------------------------------------------------------------
@@ -146,9 +204,34 @@ public:
 	std::string m_FPS;
 	std::string m_frameMS;
 
+	// chunk streaming replay, flies the player along a scripted path and measures how long nearby chunks take to become visible
+	void RequestChunkStreamingReplay(bool prioritizeChunkJobs, float flySpeed);
+	void StartChunkStreamingReplay();
+	void UpdateChunkStreamingReplay();
+	void FinishChunkStreamingReplay();
+
+	bool	m_isReplayRequested = false;
+	bool	m_isReplaying = false;
+	bool	m_replayPrioritizeChunkJobs = true;
+	int		m_numReplaysStarted = 0;
+	float	m_replayFlySpeed = 40.f;
+	double	m_replayStartTime = 0.0;
+	Vec3	m_replayStartPos;
+	std::map<IntVec2, double>	m_replayChunkNeededTimes; // when a chunk first came into the nearby range, set to -1 once it is visible so it is neither timed again nor counted as never visible
+	std::vector<double>			m_replayTimesToVisible;
+
+	// the I/O test flies the path twice from the same start, the first run saves every chunk, the second one must load them
+	// without the main thread opening a single file
+	void RequestChunkStreamingIOTest(float flySpeed);
+
+	int		m_replayIOTestPhase = 0; // 0 = not testing, 1 = saving the path, 2 = flying it again
+	int		m_replayMainThreadFileOpsAtStart = 0;
+	int		m_replayNumChunksLoaded = 0;
+
 	// dynamic loading chunks
-	std::map<IntVec2, Chunk*> m_activeChunks;
-	std::set<IntVec2> m_chunksBeingGeneratedOrLoaded;
+	ChunkCoordsHashMap<Chunk> m_activeChunks = ChunkCoordsHashMap<Chunk>(MAX_CHUNKS);
+	ChunkCoordsHashMap<Chunk> m_chunksBeingGeneratedOrLoaded; // the chunk's m_pendingJob is the load or generate job
+	ChunkCoordsHashMap<Chunk> m_chunksBeingSaved; // already out of the world, activating the same coords waits for the save
 
 		Texture* m_blockTexture = nullptr;
 };
\ No newline at end of file
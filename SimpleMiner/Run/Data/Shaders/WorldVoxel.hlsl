@@ -0,0 +1,123 @@
+float3 DiminishingAddComponents(float3 a, float3 b)
+{
+	return (1.f - (1.f - a) * (1.f - b));
+};
+
+// the greedy chunk mesh, two packed uints per vertex, see ChunkMesher.hpp for the bits
+// m_packedPosition: x 5 | y 5 | z 8 | face 3 | outdoor light 4 | indoor light 4
+// m_packedTexture:  u 8 | v 8 | sprite index 12
+struct vs_input_t
+{
+	uint	a_packedPosition	: POSITION;
+	uint	a_packedTexture		: TEXCOORD;
+};
+
+struct v2p_t // vertex to fragment
+{
+	float4 v_position : SV_Position;
+	float4 v_color : COLOR;
+	float2 v_tileUV : TEXCOORD0;						// counts blocks across the merged quad, the tile repeats every 1
+	nointerpolation float2 v_spriteCoords : TEXCOORD1;	// the same for the whole quad
+    float3 v_worldPosition : POSITION;
+};
+
+Texture2D		t_diffuseTexture : register(t0);	// Texture bound in texture constant slot #0
+SamplerState	s_diffuseSampler : register(s0);	// Sampler is bound in sampler constant slot #0
+
+cbuffer CameraConstants : register(b2)
+{
+	float4x4 c_viewMatrix;			// world-to-gameCamera
+	float4x4 c_projectionMatrix;	// gameCamera-to-clip (includes gameCamera->screenCamera axis swaps)
+};
+
+	cbuffer ModelConstants : register(b3)
+{
+	float4x4 ModelMatrix;
+	float4 ModelColor;
+};
+
+cbuffer SimpleMinerWorldConstants : register(b8)
+{
+	float4	c_indoorLightColor;		// gameCamera-to-clip (includes gameCamera->screenCamera axis swaps)
+	float4	c_outdoorLightColor;	// gameCamera-to-clip (includes gameCamera->screenCamera axis swaps)
+    float4	c_cameraWorldPos;		// world position of camera being used to render
+	float4	c_fog_Sky_Color;		// Fog and sky color to blend in
+	float   c_fogStartDistance;		// World units away where fog begins (0%)
+	float	c_fogEndDistance;		// World units away where fog maxes out (100%)
+	float	c_fogMaxAlpha;			// fog max alpha
+	float	c_dummyPadding1;
+};
+
+static const float SPRITE_SHEET_CELLS = 64.f;
+
+//------------------------------------------------------------------------------------------------
+v2p_t VertexMain( vs_input_t input )
+{
+	v2p_t v2f;
+
+	uint packedPosition = input.a_packedPosition;
+	uint packedTexture = input.a_packedTexture;
+	float3 chunkPos = float3( packedPosition & 31, (packedPosition >> 5) & 31, (packedPosition >> 10) & 255 );
+	float outdoorLight = (float)((packedPosition >> 21) & 15) / 15.f;
+	float indoorLight = (float)((packedPosition >> 25) & 15) / 15.f;
+	uint spriteIndex = (packedTexture >> 16) & 4095;
+
+	// the mesh is local to the chunk, the model matrix puts it in the world
+	float4 localPos = float4( chunkPos, 1 );
+	float4 worldPos = mul(ModelMatrix, localPos);
+	float4 cameraPos = mul( c_viewMatrix, worldPos );
+	float4 clipPos = mul( c_projectionMatrix, cameraPos );
+
+	v2f.v_position = clipPos;
+	v2f.v_color = float4( outdoorLight, indoorLight, 127.f / 255.f, 1.f ); // the same encoding the Vertex_PCU mesh has in its color
+	v2f.v_tileUV = float2( packedTexture & 255, (packedTexture >> 8) & 255 );
+	v2f.v_spriteCoords = float2( spriteIndex % 64, spriteIndex / 64 );
+    v2f.v_worldPosition = worldPos.xyz;
+
+	return v2f; // pass it on to the raster stage
+}
+
+//------------------------------------------------------------------------------------------------
+float4 PixelMain( v2p_t input ) : SV_Target0
+{
+	// the same UVs SpriteSheet::GetSpriteUVs gives, (0,0) is the top left sprite, with the same bleed on each side
+	uint textureWidth;
+	uint textureHeight;
+	t_diffuseTexture.GetDimensions( textureWidth, textureHeight );
+	float2 bleed = float2( 1.f / (2.f * textureWidth), 1.f / (2.f * textureHeight) );
+	float2 uvMins = float2( input.v_spriteCoords.x / SPRITE_SHEET_CELLS, 1.f - (input.v_spriteCoords.y + 1.f) / SPRITE_SHEET_CELLS ) + bleed;
+	float2 uvMaxs = float2( (input.v_spriteCoords.x + 1.f) / SPRITE_SHEET_CELLS, 1.f - input.v_spriteCoords.y / SPRITE_SHEET_CELLS ) - bleed;
+	float2 uvCoords = lerp( uvMins, uvMaxs, frac(input.v_tileUV) );
+
+	// frac jumps at every block edge, the gradients come from the unwrapped coords so the seams do not pick the smallest mip
+	float2 uvRange = uvMaxs - uvMins;
+	float4 texelColor = t_diffuseTexture.SampleGrad( s_diffuseSampler, uvCoords, ddx(input.v_tileUV) * uvRange, ddy(input.v_tileUV) * uvRange );
+	float4 rgbEncodedData = input.v_color;
+	if( texelColor.a <= 0.001 )
+	{
+		discard; // Skip writing color AND especially depth (if depth-writing is enabled) for transparent pixels
+	}
+
+	//  compute lit pixel color
+	float outdoorLightBrightness = rgbEncodedData.r;
+	float3 outdoorLightTint = c_outdoorLightColor.rgb * outdoorLightBrightness;
+
+	float indoorLightBrightness = rgbEncodedData.g;
+	float3 indoorLightTint = c_indoorLightColor.rgb * indoorLightBrightness;
+
+	float3 diffuseLight = DiminishingAddComponents(indoorLightTint, outdoorLightTint);
+
+	float3 diffuseColorRGB = diffuseLight * texelColor.rgb;
+
+	// compute fog
+	// get RGB by lerp the color from diffuse color to fog/sky color
+    float distCamToPixel = distance(input.v_worldPosition.xyz, c_cameraWorldPos.xyz);
+    float fogFraction = saturate((distCamToPixel - c_fogStartDistance) / (c_fogEndDistance - c_fogStartDistance));
+	float fogDensity = c_fogMaxAlpha * fogFraction;
+    float3 finalColorRGB = lerp(diffuseColorRGB, c_fog_Sky_Color.rgb, fogDensity);
+	// get alpha
+	float finalAlpha = saturate(texelColor.a + fogDensity); // or: saturate(texelColor.a * (1.f - fogFraction) + fogDensity)
+	float4 finalColor = float4(finalColorRGB, finalAlpha);
+
+	return finalColor;
+}